@@ -108,6 +108,11 @@ SCHED_TASK_CLASS arguments:
  - expected time (in MicroSeconds) that the method should take to run
  - priority (0 through 255, lower number meaning higher priority)
 
+SCHED_TASK_CLASS_OFFLOAD takes the same arguments as SCHED_TASK_CLASS,
+for a method which may run on a worker thread when SCHED_OPTIONS
+enables offloading. Only use it for methods which lock everything they
+share with the main thread.
+
  */
 const AP_Scheduler::Task Copter::scheduler_tasks[] = {
     // update INS immediately to get current gyro data populated
@@ -252,7 +257,7 @@ const AP_Scheduler::Task Copter::scheduler_tasks[] = {
     SCHED_TASK_CLASS(AP_Button,            &copter.button,              update,           5, 100, 168),
 #endif
 #if STATS_ENABLED == ENABLED
-    SCHED_TASK_CLASS(AP_Stats,             &copter.g2.stats,            update,           1, 100, 171),
+    SCHED_TASK_CLASS_OFFLOAD(AP_Stats,     &copter.g2.stats,            update,           1, 100, 171),
 #endif
 };
 
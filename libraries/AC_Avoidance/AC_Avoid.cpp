@@ -657,6 +657,23 @@ float AC_Avoid::get_max_speed(float kP, float accel_cmss, float distance_cm, flo
     }
 }
 
+/*
+ * Computes the distance beyond which get_max_speed() allows at least speed_cms, FLT_MAX if there is none
+ */
+float AC_Avoid::get_max_speed_distance(float kP, float accel_cmss, float speed_cms, float dt) const
+{
+    if (is_negative(kP) || (is_zero(kP) && !is_positive(accel_cmss))) {
+        // max speed is zero or not increasing with distance
+        return FLT_MAX;
+    }
+    float distance_cm = inv_sqrt_controller(speed_cms, kP, accel_cmss);
+    if (!is_zero(kP) && !is_zero(dt)) {
+        // sqrt_controller limits the speed so the distance is not covered in less than dt
+        distance_cm = MAX(distance_cm, speed_cms * dt);
+    }
+    return distance_cm;
+}
+
 /*
  * Adjusts the desired velocity for the circular fence.
  */
@@ -797,9 +814,10 @@ void AC_Avoid::adjust_velocity_inclusion_and_exclusion_polygons(float kP, float
     for (uint8_t i = 0; i < num_inclusion_polygons; i++) {
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
+        const PolygonEdgeBoxes<float> *edge_boxes = fence->polyfence().get_inclusion_polygon_edge_boxes(i);
         Vector2f backup_vel_inc;
         // adjust velocity
-        adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel_inc, boundary, num_points, fence->get_margin(), dt, true);
+        adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel_inc, boundary, num_points, edge_boxes, fence->get_margin(), dt, true);
         find_max_quadrant_velocity(backup_vel_inc, quad_1_back_vel, quad_2_back_vel, quad_3_back_vel, quad_4_back_vel);
     }
 
@@ -808,9 +826,10 @@ void AC_Avoid::adjust_velocity_inclusion_and_exclusion_polygons(float kP, float
     for (uint8_t i = 0; i < num_exclusion_polygons; i++) {
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
+        const PolygonEdgeBoxes<float> *edge_boxes = fence->polyfence().get_exclusion_polygon_edge_boxes(i);
         Vector2f backup_vel_exc;
         // adjust velocity
-        adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel_exc, boundary, num_points, fence->get_margin(), dt, false);
+        adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel_exc, boundary, num_points, edge_boxes, fence->get_margin(), dt, false);
         find_max_quadrant_velocity(backup_vel_exc, quad_1_back_vel, quad_2_back_vel, quad_3_back_vel, quad_4_back_vel);
     }
     // desired backup velocity is sum of maximum velocity component in each quadrant 
@@ -1105,7 +1124,7 @@ void AC_Avoid::adjust_velocity_beacon_fence(float kP, float accel_cmss, Vector2f
     if (AP::fence()) {
         margin = AP::fence()->get_margin();
     }
-    adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel, boundary, num_points, margin, dt, true);
+    adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, backup_vel, boundary, num_points, nullptr, margin, dt, true);
 }
 
 /*
@@ -1255,7 +1274,7 @@ void AC_Avoid::adjust_velocity_proximity(float kP, float accel_cmss, Vector3f &d
 /*
  * Adjusts the desired velocity for the polygon fence.
  */
-void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, Vector2f &backup_vel, const Vector2f* boundary, uint16_t num_points, float margin, float dt, bool stay_inside)
+void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, Vector2f &backup_vel, const Vector2f* boundary, uint16_t num_points, const PolygonEdgeBoxes<float> *edge_boxes, float margin, float dt, bool stay_inside)
 {
     // exit if there are no points
     if (boundary == nullptr || num_points == 0) {
@@ -1275,7 +1294,7 @@ void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &des
 
 
     // return if we have already breached polygon
-    const bool inside_polygon = !Polygon_outside(position_xy, boundary, num_points);
+    const bool inside_polygon = (edge_boxes != nullptr) ? !edge_boxes->outside(position_xy) : !Polygon_outside(position_xy, boundary, num_points);
     if (inside_polygon != stay_inside) {
         return;
     }
@@ -1296,10 +1315,30 @@ void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &des
         stopping_point_plus_margin = position_xy + safe_vel*((2.0f + margin_cm + get_stopping_distance(kP, accel_cmss, speed))/speed);
     }
 
+    // edges further than this from the vehicle cannot change the velocity. They are outside the margin,
+    // the speed allowed towards them is above the desired speed and the stopping point cannot reach them.
+    // 1cm is added to allow for rounding
+    float edge_dist_max_cm = margin_cm;
+    if (!desired_vel_cms.is_zero()) {
+        if (_behavior == BEHAVIOR_SLIDE) {
+            edge_dist_max_cm += get_max_speed_distance(kP, accel_cmss, speed, dt);
+        } else {
+            edge_dist_max_cm = MAX(edge_dist_max_cm, (stopping_point_plus_margin - position_xy).length());
+        }
+    }
+    edge_dist_max_cm += 1.0f;
+
     // for backing away
     Vector2f quad_1_back_vel, quad_2_back_vel, quad_3_back_vel, quad_4_back_vel;
    
     for (uint16_t i=0; i<num_points; i++) {
+        if (edge_boxes != nullptr) {
+            // skip to the next edge which may be close enough to change the velocity
+            i = edge_boxes->next_edge_near(position_xy, edge_dist_max_cm, i);
+            if (i >= num_points) {
+                break;
+            }
+        }
         uint16_t j = i+1;
         if (j >= num_points) {
             j = 0;
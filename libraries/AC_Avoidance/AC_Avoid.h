@@ -156,14 +156,20 @@ private:
      * The boundary must be in Earth Frame
      * margin is the distance (in meters) that the vehicle should stop short of the polygon
      * stay_inside should be true for fences, false for exclusion polygons
+     * edge_boxes may be nullptr, if provided they are used to skip edges too far away to affect the velocity
      */
-    void adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, Vector2f &backup_vel, const Vector2f* boundary, uint16_t num_points, float margin, float dt, bool stay_inside);
+    void adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, Vector2f &backup_vel, const Vector2f* boundary, uint16_t num_points, const PolygonEdgeBoxes<float> *edge_boxes, float margin, float dt, bool stay_inside);
 
     /*
      * Computes distance required to stop, given current speed.
      */
     float get_stopping_distance(float kP, float accel_cmss, float speed_cms) const;
 
+    /*
+     * Computes the distance beyond which get_max_speed() allows at least speed_cms, FLT_MAX if there is none
+     */
+    float get_max_speed_distance(float kP, float accel_cmss, float speed_cms, float dt) const;
+
    /*
     * Compute the back away velocity required to avoid breaching margin
     * INPUT: This method requires the breach in margin distance (back_distance_cm), direction towards the breach (limit_direction)
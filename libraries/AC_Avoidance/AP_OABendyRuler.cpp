@@ -105,6 +105,9 @@ bool AP_OABendyRuler::update(const Location& current_loc, const Location& destin
     // calculate lookahead dist for step2
     const float lookahead_step2_dist = _current_lookahead * OA_BENDYRULER_LOOKAHEAD_STEP2_RATIO;
 
+    // look up the fence once for all the paths checked
+    update_fence_info();
+
     // get ground course
     float ground_course_deg;
     if (ground_speed_vec.length_squared() < OA_BENDYRULER_LOW_SPEED_SQUARED) {
@@ -132,12 +135,37 @@ bool AP_OABendyRuler::update(const Location& current_loc, const Location& destin
     return ret;
 }
 
+// position distance meters from pos_NEU at bearing_deg, as an offset (in cm) from the EKF origin
+static Vector3f offset_bearing_NEU(const Vector3f &pos_NEU, float bearing_deg, float distance)
+{
+    const float bearing_rad = radians(bearing_deg);
+    return Vector3f(pos_NEU.x + cosf(bearing_rad) * distance * 100.0f, pos_NEU.y + sinf(bearing_rad) * distance * 100.0f, pos_NEU.z);
+}
+
+// index one past the last of num_probes probes in the batch starting at first. The first batch holds only
+// the first probe because it is towards the destination and usually clear
+static uint8_t probe_batch_end(uint8_t first, uint8_t num_probes)
+{
+    if (first == 0) {
+        return MIN(1, num_probes);
+    }
+    return MIN(first + OA_BENDYRULER_PROBES_MAX, num_probes);
+}
+
 // Search for path in the horizontal directions
 bool AP_OABendyRuler::search_xy_path(const Location& current_loc, const Location& destination, float ground_course_deg, Location &destination_new, float lookahead_step1_dist, float lookahead_step2_dist, float bearing_to_dest, float distance_to_dest, bool proximity_only) 
 {
     // check OA_BEARING_INC definition allows checking in all directions
     static_assert(360 % OA_BENDYRULER_BEARING_INC_XY == 0, "check 360 is a multiple of OA_BEARING_INC");
 
+    // convert current location and destination to offsets (in cm) from EKF origin
+    Vector3f current_NEU;
+    Vector2f destination_NE;
+    if (!current_loc.get_vector_from_origin_NEU(current_NEU) || !destination.get_vector_xy_from_origin_NE(destination_NE)) {
+        // should never happen because the path planner waits for the EKF origin to be set
+        return false;
+    }
+
     // search in OA_BENDYRULER_BEARING_INC degree increments around the vehicle alternating left
     // and right. For each direction check if vehicle would avoid all obstacles
     float best_bearing = bearing_to_dest;
@@ -146,25 +174,32 @@ bool AP_OABendyRuler::search_xy_path(const Location& current_loc, const Location
     float best_margin = -FLT_MAX;
     float best_margin_bearing = best_bearing;
 
-    for (uint8_t i = 0; i <= (170 / OA_BENDYRULER_BEARING_INC_XY); i++) {
-        for (uint8_t bdir = 0; bdir <= 1; bdir++) {
-            // skip duplicate check of bearing straight towards destination
-            if ((i==0) && (bdir > 0)) {
-                continue;
-            }
-            // bearing that we are probing
-            const float bearing_delta = i * OA_BENDYRULER_BEARING_INC_XY * (bdir == 0 ? -1.0f : 1.0f);
-            const float bearing_test = wrap_180(bearing_to_dest + bearing_delta);
+    // the bearings are checked against the obstacles in batches
+    const uint8_t num_bearings = 2 * (170 / OA_BENDYRULER_BEARING_INC_XY) + 1;
+    ProbeBatch batch;
+    float bearings[OA_BENDYRULER_PROBES_MAX];
+    for (uint8_t first = 0; first < num_bearings; first = probe_batch_end(first, num_bearings)) {
+        const uint8_t last = probe_batch_end(first, num_bearings);
+        batch.init(current_NEU);
+        for (uint8_t n = first; n < last; n++) {
+            // bearing that we are probing, n = 0 is towards the destination then alternately left and right
+            const float bearing_delta = ((n + 1) / 2) * OA_BENDYRULER_BEARING_INC_XY * ((n % 2) == 1 ? -1.0f : 1.0f);
+            bearings[n - first] = wrap_180(bearing_to_dest + bearing_delta);
 
             // ToDo: add effective groundspeed calculations using airspeed
             // ToDo: add prediction of vehicle's position change as part of turn to desired heading
 
             // test location is projected from current location at test bearing
-            Location test_loc = current_loc;
-            test_loc.offset_bearing(bearing_test, lookahead_step1_dist);
+            batch.add(offset_bearing_NEU(current_NEU, bearings[n - first], lookahead_step1_dist));
+        }
 
-            // calculate margin from obstacles for this scenario
-            float margin = calc_avoidance_margin(current_loc, test_loc, proximity_only);
+        // calculate margin from obstacles for these scenarios
+        calc_avoidance_margins(batch, proximity_only);
+
+        for (uint8_t n = first; n < last; n++) {
+            const uint8_t i = (n + 1) / 2;
+            const float bearing_test = bearings[n - first];
+            const float margin = batch.margin[n - first];
             if (margin > best_margin) {
                 best_margin_bearing = bearing_test;
                 best_margin = margin;
@@ -184,32 +219,23 @@ bool AP_OABendyRuler::search_xy_path(const Location& current_loc, const Location
                 }
 
                 // perform second stage test in three directions looking for obstacles
-                const float test_bearings[] { 0.0f, 45.0f, -45.0f };
-                const float bearing_to_dest2 = test_loc.get_bearing_to(destination) * 0.01f;
-                float distance2 = constrain_float(lookahead_step2_dist, OA_BENDYRULER_LOOKAHEAD_STEP2_MIN, test_loc.get_distance(destination));
-                for (uint8_t j = 0; j < ARRAY_SIZE(test_bearings); j++) {
-                    float bearing_test2 = wrap_180(bearing_to_dest2 + test_bearings[j]);
-                    Location test_loc2 = test_loc;
-                    test_loc2.offset_bearing(bearing_test2, distance2);
-
-                    // calculate minimum margin to fence and obstacles for this scenario
-                    float margin2 = calc_avoidance_margin(test_loc, test_loc2, proximity_only);
-                    if (margin2 > _margin_max) {
-                        // if the chosen direction is directly towards the destination avoidance can be turned off
-                        // i == 0 && j == 0 implies no deviation from bearing to destination 
-                        const bool active = (i != 0 || j != 0);
-                        float final_bearing = bearing_test;
-                        float final_margin = margin;
-                        // check if we need ignore test_bearing and continue on previous bearing
-                        const bool ignore_bearing_change = resist_bearing_change(destination, current_loc, active, bearing_test, lookahead_step1_dist, margin, _destination_prev,_bearing_prev, final_bearing, final_margin, proximity_only);
-
-                        // all good, now project in the chosen direction by the full distance
-                        destination_new = current_loc;
-                        destination_new.offset_bearing(final_bearing, MIN(distance_to_dest, lookahead_step1_dist));
-                        _current_lookahead = MIN(_lookahead, _current_lookahead * 1.1f);
-                        Write_OABendyRuler((uint8_t)OABendyType::OA_BENDY_HORIZONTAL, active, bearing_to_dest, 0.0f, ignore_bearing_change, final_margin, destination, destination_new);
-                        return active;
-                    }
+                const Vector3f test_NEU(batch.end_x[n - first], batch.end_y[n - first], batch.end_z[n - first]);
+                const int8_t j = search_xy_path_step2(test_NEU, destination_NE, lookahead_step2_dist, proximity_only);
+                if (j >= 0) {
+                    // if the chosen direction is directly towards the destination avoidance can be turned off
+                    // i == 0 && j == 0 implies no deviation from bearing to destination 
+                    const bool active = (i != 0 || j != 0);
+                    float final_bearing = bearing_test;
+                    float final_margin = margin;
+                    // check if we need ignore test_bearing and continue on previous bearing
+                    const bool ignore_bearing_change = resist_bearing_change(destination, current_loc, active, bearing_test, lookahead_step1_dist, margin, _destination_prev,_bearing_prev, final_bearing, final_margin, proximity_only);
+
+                    // all good, now project in the chosen direction by the full distance
+                    destination_new = current_loc;
+                    destination_new.offset_bearing(final_bearing, MIN(distance_to_dest, lookahead_step1_dist));
+                    _current_lookahead = MIN(_lookahead, _current_lookahead * 1.1f);
+                    Write_OABendyRuler((uint8_t)OABendyType::OA_BENDY_HORIZONTAL, active, bearing_to_dest, 0.0f, ignore_bearing_change, final_margin, destination, destination_new);
+                    return active;
                 }
             }
         }
@@ -241,6 +267,35 @@ bool AP_OABendyRuler::search_xy_path(const Location& current_loc, const Location
     return true;
 }
 
+// second stage of the horizontal search, checking for a clear path in three directions towards the destination from test_NEU
+// returns index of the first clear direction or -1 if none are clear
+int8_t AP_OABendyRuler::search_xy_path_step2(const Vector3f &test_NEU, const Vector2f &destination_NE, float lookahead_step2_dist, bool proximity_only) const
+{
+    const float test_bearings[] { 0.0f, 45.0f, -45.0f };
+    const Vector2f test_to_dest = destination_NE - Vector2f(test_NEU.x, test_NEU.y);
+    const float bearing_to_dest2 = degrees(test_to_dest.angle());
+    const float distance2 = constrain_float(lookahead_step2_dist, OA_BENDYRULER_LOOKAHEAD_STEP2_MIN, test_to_dest.length() * 0.01f);
+
+    ProbeBatch batch;
+    for (uint8_t first = 0; first < ARRAY_SIZE(test_bearings); first = probe_batch_end(first, ARRAY_SIZE(test_bearings))) {
+        const uint8_t last = probe_batch_end(first, ARRAY_SIZE(test_bearings));
+        batch.init(test_NEU);
+        for (uint8_t j = first; j < last; j++) {
+            const float bearing_test2 = wrap_180(bearing_to_dest2 + test_bearings[j]);
+            batch.add(offset_bearing_NEU(test_NEU, bearing_test2, distance2));
+        }
+
+        // calculate minimum margin to fence and obstacles for these scenarios
+        calc_avoidance_margins(batch, proximity_only);
+        for (uint8_t j = first; j < last; j++) {
+            if (batch.margin[j - first] > _margin_max) {
+                return j;
+            }
+        }
+    }
+    return -1;
+}
+
 // Search for path in the vertical directions
 bool AP_OABendyRuler::search_vertical_path(const Location &current_loc, const Location &destination, Location &destination_new, float lookahead_step1_dist, float lookahead_step2_dist, float bearing_to_dest, float distance_to_dest, bool proximity_only)
 {
@@ -411,52 +466,135 @@ bool AP_OABendyRuler::resist_bearing_change(const Location &destination, const L
     return resisted_change;
 }
 
+// remove all paths and set the start
+void AP_OABendyRuler::ProbeBatch::init(const Vector3f &start_NEU)
+{
+    start = start_NEU;
+    length_max = 0.0f;
+    num = 0;
+}
+
+// add a path to end_NEU. Returns false if the batch is full
+bool AP_OABendyRuler::ProbeBatch::add(const Vector3f &end_NEU)
+{
+    if (num >= OA_BENDYRULER_PROBES_MAX) {
+        return false;
+    }
+    end_x[num] = end_NEU.x;
+    end_y[num] = end_NEU.y;
+    end_z[num] = end_NEU.z;
+    length_max = MAX(length_max, (end_NEU - start).length());
+    num++;
+    return true;
+}
+
+// update fence information shared by all the paths checked
+void AP_OABendyRuler::update_fence_info()
+{
+    _fence_info.circular_fence = false;
+    _fence_info.polygon_fence = false;
+
+    const AC_Fence *fence = AC_Fence::get_singleton();
+    if (fence == nullptr) {
+        return;
+    }
+    const uint8_t enabled_fences = fence->get_enabled_fences();
+    _fence_info.margin = fence->get_margin();
+    _fence_info.polygon_fence = (enabled_fences & AC_FENCE_TYPE_POLYGON) != 0;
+
+    // circular fence radius minus margin
+    if ((enabled_fences & AC_FENCE_TYPE_CIRCLE) != 0) {
+        _fence_info.circular_fence = AP::ahrs().get_home().get_vector_xy_from_origin_NE(_fence_info.home_NE);
+        _fence_info.circular_radius = fence->get_radius() - _fence_info.margin;
+    }
+}
+
 // calculate minimum distance between a segment and any obstacle
 float AP_OABendyRuler::calc_avoidance_margin(const Location &start, const Location &end, bool proximity_only) const
 {
     float margin_min = FLT_MAX;
 
-    float latest_margin;
-    
-    if (calc_margin_from_object_database(start, end, latest_margin)) {
-        margin_min = MIN(margin_min, latest_margin);
+    // convert start and end to offsets (in cm) from EKF origin
+    Vector3f start_NEU, end_NEU;
+    if (start.get_vector_from_origin_NEU(start_NEU) && end.get_vector_from_origin_NEU(end_NEU)) {
+        ProbeBatch batch;
+        batch.init(start_NEU);
+        batch.add(end_NEU);
+        calc_avoidance_margins(batch, proximity_only);
+        margin_min = batch.margin[0];
+    } else if (!proximity_only) {
+        // without offsets from the EKF origin the circular fence can still be checked using distances from home
+        float latest_margin;
+        if (calc_margin_from_circular_fence(start, end, latest_margin)) {
+            margin_min = MIN(margin_min, latest_margin);
+        }
     }
-    
+
     if (proximity_only) {
         // only need margin from proximity data
         return margin_min;
     }
-    
-    if (calc_margin_from_circular_fence(start, end, latest_margin)) {
-        margin_min = MIN(margin_min, latest_margin);
-    }
-    
+
     #if VERTICAL_ENABLED 
     // alt fence only is only needed in vertical avoidance
     if (get_type() == OABendyType::OA_BENDY_VERTICAL) {
+        float latest_margin;
         if (calc_margin_from_alt_fence(start, end, latest_margin)) {
             margin_min = MIN(margin_min, latest_margin);
         }
     }
     #endif
 
-    if (calc_margin_from_inclusion_and_exclusion_polygons(start, end, latest_margin)) {
-        margin_min = MIN(margin_min, latest_margin);
+    // return smallest margin from any obstacle
+    return margin_min;
+}
+
+// calculate minimum distance between each path in a batch and any obstacle. Each obstacle is checked against
+// all the paths together so work which depends only on the obstacle or the common start is done once
+void AP_OABendyRuler::calc_avoidance_margins(ProbeBatch &batch, bool proximity_only) const
+{
+    for (uint8_t k = 0; k < batch.num; k++) {
+        batch.margin[k] = FLT_MAX;
     }
 
-    if (calc_margin_from_inclusion_and_exclusion_circles(start, end, latest_margin)) {
-        margin_min = MIN(margin_min, latest_margin);
+    calc_margins_from_object_database(batch);
+
+    if (proximity_only) {
+        // only need margin from proximity data
+        return;
     }
 
-    // return smallest margin from any obstacle
-    return margin_min;
+    calc_margins_from_circular_fence(batch);
+    calc_margins_from_inclusion_and_exclusion_circles(batch);
+
+    // polygons are checked last because the smaller the margins already found the more polygon edges can be skipped
+    calc_margins_from_inclusion_and_exclusion_polygons(batch);
+}
+
+// reduce each path's margin to its minimum distance from the circular fence (centered on home)
+void AP_OABendyRuler::calc_margins_from_circular_fence(ProbeBatch &batch) const
+{
+    // exit immediately if circular fence is not enabled
+    if (!_fence_info.circular_fence) {
+        return;
+    }
+
+    // calculate start and end point's distance from home
+    const float start_dist_sq = Vector2f(batch.start.x - _fence_info.home_NE.x, batch.start.y - _fence_info.home_NE.y).length_squared();
+    for (uint8_t k = 0; k < batch.num; k++) {
+        const float end_dist_sq = Vector2f(batch.end_x[k] - _fence_info.home_NE.x, batch.end_y[k] - _fence_info.home_NE.y).length_squared();
+
+        // margin is fence radius minus the longer of start or end distance
+        const float margin = _fence_info.circular_radius - sqrtf(MAX(start_dist_sq, end_dist_sq)) * 0.01f;
+        batch.margin[k] = MIN(batch.margin[k], margin);
+    }
 }
 
 // calculate minimum distance between a path and the circular fence (centered on home)
 // on success returns true and updates margin
 bool AP_OABendyRuler::calc_margin_from_circular_fence(const Location &start, const Location &end, float &margin) const
 {
-    // exit immediately if polygon fence is not enabled
+    // exit immediately if circular fence is not enabled
     const AC_Fence *fence = AC_Fence::get_singleton();
     if (fence == nullptr) {
         return false;
@@ -510,184 +648,213 @@ bool AP_OABendyRuler::calc_margin_from_alt_fence(const Location &start, const Lo
     return true;
 }
 
-// calculate minimum distance between a path and all inclusion and exclusion polygons
-// on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_polygons(const Location &start, const Location &end, float &margin) const
+// reduce each path's margin to its minimum distance from all inclusion and exclusion polygons
+void AP_OABendyRuler::calc_margins_from_inclusion_and_exclusion_polygons(ProbeBatch &batch) const
 {
-    const AC_Fence *fence = AC_Fence::get_singleton();
-    if (fence == nullptr) {
-        return false;
-    }
-
     // exclusion polygons enabled along with polygon fences
-    if ((fence->get_enabled_fences() & AC_FENCE_TYPE_POLYGON) == 0) {
-        return false;
+    const AC_Fence *fence = AC_Fence::get_singleton();
+    if ((fence == nullptr) || !_fence_info.polygon_fence) {
+        return;
     }
 
-    // return immediately if no inclusion nor exclusion polygons
+    // iterate through inclusion polygons
     const uint8_t num_inclusion_polygons = fence->polyfence().get_inclusion_polygon_count();
-    const uint8_t num_exclusion_polygons = fence->polyfence().get_exclusion_polygon_count();
-    if ((num_inclusion_polygons == 0) && (num_exclusion_polygons == 0)) {
-        return false;
-    }
-
-    // convert start and end to offsets from EKF origin
-    Vector2f start_NE, end_NE;
-    if (!start.get_vector_xy_from_origin_NE(start_NE) || !end.get_vector_xy_from_origin_NE(end_NE)) {
-        return false;
-    }
-
-    // get fence margin
-    const float fence_margin = fence->get_margin();
-
-    // iterate through inclusion polygons and calculate minimum margin
-    bool margin_updated = false;
     for (uint8_t i = 0; i < num_inclusion_polygons; i++) {
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
-     
-        // if outside the fence margin is the closest distance but with negative sign
-        const float sign = Polygon_outside(start_NE, boundary, num_points) ? -1.0f : 1.0f;
-
-        // calculate min distance (in meters) from line to polygon
-        float margin_new = (sign * Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE) * 0.01f) - fence_margin;
-        if (!margin_updated || (margin_new < margin)) {
-            margin_updated = true;
-            margin = margin_new;
-        }
+        calc_margins_from_polygon(batch, boundary, num_points, true, _fence_info.margin);
     }
 
-    // iterate through exclusion polygons and calculate minimum margin
+    // iterate through exclusion polygons
+    const uint8_t num_exclusion_polygons = fence->polyfence().get_exclusion_polygon_count();
     for (uint8_t i = 0; i < num_exclusion_polygons; i++) {
         uint16_t num_points;
         const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
-   
-        // if start is inside the polygon the margin's sign is reversed
-        const float sign = Polygon_outside(start_NE, boundary, num_points) ? 1.0f : -1.0f;
-
-        // calculate min distance (in meters) from line to polygon
-        float margin_new = (sign * Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE) * 0.01f) - fence_margin;
-        if (!margin_updated || (margin_new < margin)) {
-            margin_updated = true;
-            margin = margin_new;
-        }
+        calc_margins_from_polygon(batch, boundary, num_points, false, _fence_info.margin);
     }
-
-    return margin_updated;
 }
 
-// calculate minimum distance between a path and all inclusion and exclusion circles
-// on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_inclusion_and_exclusion_circles(const Location &start, const Location &end, float &margin) const
+// reduce each path's margin to its minimum distance from a single inclusion or exclusion polygon.  Gives the same
+// result as Polygon_closest_distance_line() on each path but skips edges which are too far from the start to lower
+// any path's margin, which is most of them when the vehicle is not close to the polygon
+void AP_OABendyRuler::calc_margins_from_polygon(ProbeBatch &batch, const Vector2f *boundary, uint16_t num_points, bool inclusion, float fence_margin)
 {
-    // exit immediately if fence is not enabled
-    const AC_Fence *fence = AC_Fence::get_singleton();
-    if (fence == nullptr) {
-        return false;
+    if ((boundary == nullptr) || (num_points < 3)) {
+        return;
+    }
+
+    // margin is positive if start is inside an inclusion polygon or outside an exclusion polygon
+    const Vector2f start(batch.start.x, batch.start.y);
+    const bool start_outside = Polygon_outside(start, boundary, num_points);
+    const bool start_safe = (inclusion != start_outside);
+
+    for (uint8_t k = 0; k < batch.num; k++) {
+        batch.intersect_dist_sq[k] = FLT_MAX;
+        batch.closest_sq[k] = FLT_MAX;
+    }
+
+    // the last point of a complete polygon is the same as the first. Edges are checked for intersections
+    // with the paths all the way around the polygon but only up to the last point for distance, as
+    // Polygon_intersects() and Polygon_closest_distance_line() do
+    const uint16_t num_edges = Polygon_complete(boundary, num_points) ? num_points - 1 : num_points;
+
+    // check the edge nearest the start first so the distances found can be used to skip the other edges
+    uint16_t nearest_edge = 0;
+    float nearest_dist_sq = FLT_MAX;
+    for (uint16_t e = 0; e < num_edges; e++) {
+        const uint16_t e_next = (e + 1 < num_edges) ? e + 1 : 0;
+        const float dist_sq = Vector2f::closest_distance_between_line_and_point_squared(boundary[e], boundary[e_next], start);
+        if (dist_sq < nearest_dist_sq) {
+            nearest_dist_sq = dist_sq;
+            nearest_edge = e;
+        }
     }
+    check_polygon_edge(batch, boundary[nearest_edge], boundary[(nearest_edge + 1 < num_edges) ? nearest_edge + 1 : 0], nearest_edge < num_points - 1);
 
-    // inclusion/exclusion circles enabled along with polygon fences
-    if ((fence->get_enabled_fences() & AC_FENCE_TYPE_POLYGON) == 0) {
-        return false;
+    // an edge can only lower a path's margin if it comes closer to the path than the distance already found,
+    // or on the safe side of the polygon if it gives a smaller margin than already found from other obstacles.
+    // Only edges within the path's length of the start can intersect it
+    float skip_dist = 0.0f;
+    for (uint8_t k = 0; k < batch.num; k++) {
+        if (batch.intersect_dist_sq[k] < FLT_MAX) {
+            continue;
+        }
+        float dist = sqrtf(batch.closest_sq[k]);
+        if (start_safe) {
+            dist = MIN(dist, (batch.margin[k] + fence_margin) * 100.0f);
+        }
+        skip_dist = MAX(skip_dist, dist);
     }
+    // no part of a path is further than its length from the start, 1cm is added to allow for rounding
+    skip_dist += batch.length_max + 1.0f;
+    const float skip_dist_sq = sq(skip_dist);
 
-    // return immediately if no inclusion nor exclusion circles
-    const uint8_t num_inclusion_circles = fence->polyfence().get_inclusion_circle_count();
-    const uint8_t num_exclusion_circles = fence->polyfence().get_exclusion_circle_count();
-    if ((num_inclusion_circles == 0) && (num_exclusion_circles == 0)) {
-        return false;
+    for (uint16_t e = 0; e < num_edges; e++) {
+        const uint16_t e_next = (e + 1 < num_edges) ? e + 1 : 0;
+        if ((e == nearest_edge) ||
+            (Vector2f::closest_distance_between_line_and_point_squared(boundary[e], boundary[e_next], start) > skip_dist_sq)) {
+            continue;
+        }
+        check_polygon_edge(batch, boundary[e], boundary[e_next], e < num_points - 1);
+    }
+
+    // calculate min distance (in meters) from each path to polygon. Paths crossing into the polygon have a
+    // negative distance from their end to the intersection closest to the start. If start is on the wrong
+    // side of the polygon the margin's sign is reversed
+    const float sign = start_safe ? 1.0f : -1.0f;
+    for (uint8_t k = 0; k < batch.num; k++) {
+        float dist;
+        if (batch.intersect_dist_sq[k] < FLT_MAX) {
+            dist = -sqrtf(sq(batch.intersect_x[k] - batch.end_x[k]) + sq(batch.intersect_y[k] - batch.end_y[k]));
+        } else {
+            dist = sqrtf(batch.closest_sq[k]);
+        }
+        const float margin = (sign * dist * 0.01f) - fence_margin;
+        batch.margin[k] = MIN(batch.margin[k], margin);
     }
+}
 
-    // convert start and end to offsets from EKF origin
-    Vector2f start_NE, end_NE;
-    if (!start.get_vector_xy_from_origin_NE(start_NE) || !end.get_vector_xy_from_origin_NE(end_NE)) {
-        return false;
+// check each path against the polygon edge from v1 to v2, updating the closest intersection to the start and,
+// if check_distance is true, the closest distance to an edge
+void AP_OABendyRuler::check_polygon_edge(ProbeBatch &batch, const Vector2f &v1, const Vector2f &v2, bool check_distance)
+{
+    const Vector2f p1(batch.start.x, batch.start.y);
+    for (uint8_t k = 0; k < batch.num; k++) {
+        const Vector2f p2(batch.end_x[k], batch.end_y[k]);
+
+        // the edge cannot intersect the path if it is entirely to one side of it
+        if (!(v1.x > p1.x && v2.x > p1.x && v1.x > p2.x && v2.x > p2.x) &&
+            !(v1.y > p1.y && v2.y > p1.y && v1.y > p2.y && v2.y > p2.y) &&
+            !(v1.x < p1.x && v2.x < p1.x && v1.x < p2.x && v2.x < p2.x) &&
+            !(v1.y < p1.y && v2.y < p1.y && v1.y < p2.y && v2.y < p2.y)) {
+            Vector2f intersection;
+            if (Vector2f::segment_intersection(v1, v2, p1, p2, intersection)) {
+                const float dist_sq = sq(intersection.x - p1.x) + sq(intersection.y - p1.y);
+                if (dist_sq < batch.intersect_dist_sq[k]) {
+                    batch.intersect_dist_sq[k] = dist_sq;
+                    batch.intersect_x[k] = intersection.x;
+                    batch.intersect_y[k] = intersection.y;
+                }
+            }
+        }
+
+        // distance is not needed once the path is known to cross into the polygon
+        if (check_distance && (batch.intersect_dist_sq[k] == FLT_MAX)) {
+            batch.closest_sq[k] = MIN(batch.closest_sq[k], Vector2f::closest_distance_between_lines_squared(v1, v2, p1, p2));
+        }
     }
+}
 
-    // get fence margin
-    const float fence_margin = fence->get_margin();
+// reduce each path's margin to its minimum distance from all inclusion and exclusion circles
+void AP_OABendyRuler::calc_margins_from_inclusion_and_exclusion_circles(ProbeBatch &batch) const
+{
+    // inclusion/exclusion circles enabled along with polygon fences
+    const AC_Fence *fence = AC_Fence::get_singleton();
+    if ((fence == nullptr) || !_fence_info.polygon_fence) {
+        return;
+    }
+
+    const Vector2f start(batch.start.x, batch.start.y);
 
-    // iterate through inclusion circles and calculate minimum margin
-    bool margin_updated = false;
+    // iterate through inclusion circles
+    const uint8_t num_inclusion_circles = fence->polyfence().get_inclusion_circle_count();
     for (uint8_t i = 0; i < num_inclusion_circles; i++) {
         Vector2f center_pos_cm;
         float radius;
-        if (fence->polyfence().get_inclusion_circle(i, center_pos_cm, radius)) {
+        if (!fence->polyfence().get_inclusion_circle(i, center_pos_cm, radius)) {
+            continue;
+        }
 
-            // calculate start and ends distance from the center of the circle
-            const float start_dist_sq = (start_NE - center_pos_cm).length_squared();
-            const float end_dist_sq = (end_NE - center_pos_cm).length_squared();
+        // calculate start and ends distance from the center of the circle
+        const float start_dist_sq = (start - center_pos_cm).length_squared();
+        for (uint8_t k = 0; k < batch.num; k++) {
+            const float end_dist_sq = (Vector2f(batch.end_x[k], batch.end_y[k]) - center_pos_cm).length_squared();
 
             // margin is fence radius minus the longer of start or end distance
-            const float margin_new = (radius + fence_margin) - (sqrtf(MAX(start_dist_sq, end_dist_sq)) * 0.01f);
-
-            // update margin with lowest value so far
-            if (!margin_updated || (margin_new < margin)) {
-                margin_updated = true;
-                margin = margin_new;
-            }
+            const float margin = (radius + _fence_info.margin) - (sqrtf(MAX(start_dist_sq, end_dist_sq)) * 0.01f);
+            batch.margin[k] = MIN(batch.margin[k], margin);
         }
     }
 
-    // iterate through exclusion circles and calculate minimum margin
+    // iterate through exclusion circles
+    const uint8_t num_exclusion_circles = fence->polyfence().get_exclusion_circle_count();
     for (uint8_t i = 0; i < num_exclusion_circles; i++) {
         Vector2f center_pos_cm;
         float radius;
-        if (fence->polyfence().get_exclusion_circle(i, center_pos_cm, radius)) {
+        if (!fence->polyfence().get_exclusion_circle(i, center_pos_cm, radius)) {
+            continue;
+        }
 
+        for (uint8_t k = 0; k < batch.num; k++) {
             // first calculate distance between circle's center and segment
-            const float dist_cm = Vector2f::closest_distance_between_line_and_point(start_NE, end_NE, center_pos_cm);
+            const float dist_cm = Vector2f::closest_distance_between_line_and_point(start, Vector2f(batch.end_x[k], batch.end_y[k]), center_pos_cm);
 
             // margin is distance to the center minus the radius
-            const float margin_new = (dist_cm * 0.01f) - (radius + fence_margin);
-
-            // update margin with lowest value so far
-            if (!margin_updated || (margin_new < margin)) {
-                margin_updated = true;
-                margin = margin_new;
-            }
+            const float margin = (dist_cm * 0.01f) - (radius + _fence_info.margin);
+            batch.margin[k] = MIN(batch.margin[k], margin);
         }
     }
-
-    return margin_updated;
 }
 
-// calculate minimum distance between a path and proximity sensor obstacles
-// on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_object_database(const Location &start, const Location &end, float &margin) const
+// reduce each path's margin to its minimum distance from proximity sensor obstacles
+void AP_OABendyRuler::calc_margins_from_object_database(ProbeBatch &batch) const
 {
     // exit immediately if db is empty
     AP_OADatabase *oaDb = AP::oadatabase();
     if (oaDb == nullptr || !oaDb->healthy()) {
-        return false;
+        return;
     }
 
-    // convert start and end to offsets (in cm) from EKF origin
-    Vector3f start_NEU,end_NEU;
-    if (!start.get_vector_from_origin_NEU(start_NEU) || !end.get_vector_from_origin_NEU(end_NEU)) {
-        return false;
-    }
-    if (start_NEU == end_NEU) {
-        return false;
-    }
-
-    // check each obstacle's distance from segment
-    float smallest_margin = FLT_MAX;
-    for (uint16_t i=0; i<oaDb->database_count(); i++) {
-        const AP_OADatabase::OA_DbItem& item = oaDb->get_item(i);
-        const Vector3f point_cm = item.pos * 100.0f;
-        // margin is distance between line segment and obstacle minus obstacle's radius
-        const float m = Vector3f::closest_distance_between_line_and_point(start_NEU, end_NEU, point_cm) * 0.01f - item.radius;
-        if (m < smallest_margin) {
-            smallest_margin = m;
+    // the database works in meters
+    const Vector3f start_m = batch.start * 0.01f;
+    for (uint8_t k = 0; k < batch.num; k++) {
+        const Vector3f end_NEU(batch.end_x[k], batch.end_y[k], batch.end_z[k]);
+        if (end_NEU == batch.start) {
+            continue;
+        }
+        float margin;
+        if (oaDb->get_margin_from_segment(start_m, end_NEU * 0.01f, margin)) {
+            batch.margin[k] = MIN(batch.margin[k], margin);
         }
     }
-
-    // return smallest margin
-    if (smallest_margin < FLT_MAX) {
-        margin = smallest_margin;
-        return true;
-    }
-
-    return false;
 }
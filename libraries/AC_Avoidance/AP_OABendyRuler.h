@@ -4,6 +4,8 @@
 #include <AP_Common/Location.h>
 #include <AP_Math/AP_Math.h>
 
+#define OA_BENDYRULER_PROBES_MAX    8   // maximum number of paths checked against the obstacles together
+
 /*
  * BendyRuler avoidance algorithm for avoiding the polygon and circular fence and dynamic objects detected by the proximity sensor
  */
@@ -28,6 +30,32 @@ public:
 
     static const struct AP_Param::GroupInfo var_info[];
 
+    // paths from a common start which are checked against each obstacle together. Positions are offsets (in cm) from the EKF origin
+    struct ProbeBatch {
+        // remove all paths and set the start
+        void init(const Vector3f &start_NEU);
+
+        // add a path to end_NEU. Returns false if the batch is full
+        bool add(const Vector3f &end_NEU);
+
+        Vector3f start;                             // start of every path
+        float end_x[OA_BENDYRULER_PROBES_MAX];      // end of each path
+        float end_y[OA_BENDYRULER_PROBES_MAX];
+        float end_z[OA_BENDYRULER_PROBES_MAX];
+        float margin[OA_BENDYRULER_PROBES_MAX];     // minimum distance (in meters) between each path and any obstacle
+        float length_max;                           // length of the longest path
+        uint8_t num;                                // number of paths
+
+        // working values for each path while checking a polygon
+        float intersect_x[OA_BENDYRULER_PROBES_MAX];        // intersection with the polygon closest to the start
+        float intersect_y[OA_BENDYRULER_PROBES_MAX];
+        float intersect_dist_sq[OA_BENDYRULER_PROBES_MAX];  // squared distance from the start to the intersection
+        float closest_sq[OA_BENDYRULER_PROBES_MAX];         // squared closest distance to an edge
+    };
+
+    // reduce each path's margin to its minimum distance from a single inclusion or exclusion polygon, less fence_margin (in meters)
+    static void calc_margins_from_polygon(ProbeBatch &batch, const Vector2f *boundary, uint16_t num_points, bool inclusion, float fence_margin);
+
 private:
 
     // return type of BendyRuler in use
@@ -39,13 +67,26 @@ private:
     // search for path in the Vertical directions
     bool search_vertical_path(const Location &current_loc, const Location &destination, Location &destination_new, float lookahead_step1_dist, float lookahead_step2_dist, float bearing_to_dest, float distance_to_dest, bool proximity_only);
 
+    // find clear path in the second stage of the horizontal search. returns index into test bearings of first clear path or -1 if none
+    int8_t search_xy_path_step2(const Vector3f &test_NEU, const Vector2f &destination_NE, float lookahead_step2_dist, bool proximity_only) const;
+
+    // update fence information shared by all the paths checked
+    void update_fence_info();
+
     // calculate minimum distance between a path and any obstacle
     float calc_avoidance_margin(const Location &start, const Location &end, bool proximity_only) const;
 
+    // calculate minimum distance between each path in a batch and any obstacle
+    void calc_avoidance_margins(ProbeBatch &batch, bool proximity_only) const;
+
     // determine if BendyRuler should accept the new bearing or try and resist it. Returns true if bearing is not changed  
     bool resist_bearing_change(const Location &destination, const Location &current_loc, bool active, float bearing_test, float lookahead_step1_dist, float margin, Location &prev_dest, float &prev_bearing, float &final_bearing, float &final_margin, bool proximity_only) const;    
 
-    // calculate minimum distance between a path and the circular fence (centered on home)
+    // reduce each path's margin to its minimum distance from the circular fence (centered on home)
+    void calc_margins_from_circular_fence(ProbeBatch &batch) const;
+
+    // calculate minimum distance between a path and the circular fence using Locations, for when
+    // they cannot be converted to offsets from the EKF origin
     // on success returns true and updates margin
     bool calc_margin_from_circular_fence(const Location &start, const Location &end, float &margin) const;
 
@@ -53,17 +94,17 @@ private:
     // on success returns true and updates margin
     bool calc_margin_from_alt_fence(const Location &start, const Location &end, float &margin) const;
 
-    // calculate minimum distance between a path and all inclusion and exclusion polygons
-    // on success returns true and updates margin
-    bool calc_margin_from_inclusion_and_exclusion_polygons(const Location &start, const Location &end, float &margin) const;
+    // reduce each path's margin to its minimum distance from all inclusion and exclusion polygons
+    void calc_margins_from_inclusion_and_exclusion_polygons(ProbeBatch &batch) const;
 
-    // calculate minimum distance between a path and all inclusion and exclusion circles
-    // on success returns true and updates margin
-    bool calc_margin_from_inclusion_and_exclusion_circles(const Location &start, const Location &end, float &margin) const;
+    // check each path against one polygon edge, updating the batch's polygon working values
+    static void check_polygon_edge(ProbeBatch &batch, const Vector2f &v1, const Vector2f &v2, bool check_distance);
 
-    // calculate minimum distance between a path and proximity sensor obstacles
-    // on success returns true and updates margin
-    bool calc_margin_from_object_database(const Location &start, const Location &end, float &margin) const;
+    // reduce each path's margin to its minimum distance from all inclusion and exclusion circles
+    void calc_margins_from_inclusion_and_exclusion_circles(ProbeBatch &batch) const;
+
+    // reduce each path's margin to its minimum distance from proximity sensor obstacles
+    void calc_margins_from_object_database(ProbeBatch &batch) const;
 
     // Logging function
     void Write_OABendyRuler(const uint8_t type, const bool active, const float target_yaw, const float target_pitch, const bool resist_chg, const float margin, const Location &final_dest, const Location &oa_dest) const;
@@ -81,4 +122,13 @@ private:
     float _current_lookahead;       // distance (in meters) ahead of the vehicle we are looking for obstacles
     float _bearing_prev;            // stored bearing in degrees 
     Location _destination_prev;     // previous destination, to check if there has been a change in destination
+
+    // fence information found once per update so it is not looked up for every path checked
+    struct {
+        bool circular_fence;        // true if the circular fence is enabled
+        Vector2f home_NE;           // home as an offset (in cm) from the EKF origin
+        float circular_radius;      // circular fence radius minus fence margin in meters
+        bool polygon_fence;         // true if inclusion and exclusion polygons and circles are enabled
+        float margin;               // fence margin in meters
+    } _fence_info {};
 };
@@ -35,11 +35,15 @@ extern const AP_HAL::HAL& hal;
     #define AP_OADATABASE_DISTANCE_FROM_HOME 3
 #endif
 
+#ifndef AP_OADATABASE_GRID_CELL_SIZE
+    #define AP_OADATABASE_GRID_CELL_SIZE 2.0f   // size in meters of the grid cells used to look up objects by position
+#endif
+
 const AP_Param::GroupInfo AP_OADatabase::var_info[] = {
 
     // @Param: SIZE
     // @DisplayName: OADatabase maximum number of points
-    // @Description: OADatabase maximum number of points. Set to 0 to disable the OA Database. Larger means more points but is more cpu intensive to process
+    // @Description: OADatabase maximum number of points. Set to 0 to disable the OA Database. Larger means more points but uses more memory. Points are looked up by position so cpu use depends mostly on how many points are near the vehicle
     // @Range: 0 10000
     // @User: Advanced
     // @RebootRequired: True
@@ -172,10 +176,7 @@ void AP_OADatabase::queue_push(const Vector3f &pos, uint32_t timestamp_ms, float
     }
 
     const OA_DbItem item = {pos, timestamp_ms, MAX(_radius_min, distance * dist_to_radius_scalar), 0, AP_OADatabase::OA_DbItemImportance::Normal};
-    {
-        WITH_SEMAPHORE(_queue.sem);
-        _queue.items->push(item);
-    }
+    _queue.items->push(item);
 }
 
 void AP_OADatabase::init_queue()
@@ -185,7 +186,7 @@ void AP_OADatabase::init_queue()
         return;
     }
 
-    _queue.items = new ObjectBuffer<OA_DbItem>(_queue.size);
+    _queue.items = new ObjectBuffer_MPSC<OA_DbItem>(_queue.size);
 }
 
 void AP_OADatabase::init_database()
@@ -196,6 +197,13 @@ void AP_OADatabase::init_database()
     }
 
     _database.items = new OA_DbItem[_database.size];
+    if (_database.items == nullptr) {
+        return;
+    }
+    if (!_grid.init(_database.size, AP_OADATABASE_GRID_CELL_SIZE)) {
+        delete[] _database.items;
+        _database.items = nullptr;
+    }
 }
 
 // get bitmask of gcs channels item should be sent to based on its importance
@@ -244,28 +252,17 @@ bool AP_OADatabase::process_queue()
     for (uint16_t queue_index=0; queue_index<queue_available; queue_index++) {
         OA_DbItem item;
 
-        bool pop_success;
-        {
-            WITH_SEMAPHORE(_queue.sem);
-            pop_success = _queue.items->pop(item);
-        }
-        if (!pop_success) {
+        if (!_queue.items->pop(item)) {
             return false;
         }
 
         item.send_to_gcs = get_send_to_gcs_flags(item.importance);
 
-        // compare item to all items in database. If found a similar item, update the existing, else add it as a new one
-        bool found = false;
-        for (uint16_t i=0; i<_database.count; i++) {
-            if (is_close_to_item_in_database(i, item)) {
-                database_item_refresh(i, item.timestamp_ms, item.radius);
-                found = true;
-                break;
-            }
-        }
-
-        if (!found) {
+        // compare item to nearby items in database. If found a similar item, update the existing, else add it as a new one
+        uint16_t index;
+        if (find_close_item_in_database(item, index)) {
+            database_item_refresh(index, item.timestamp_ms, item.radius);
+        } else {
             database_item_add(item);
         }
     }
@@ -279,9 +276,26 @@ void AP_OADatabase::database_item_add(const OA_DbItem &item)
     }
     _database.items[_database.count] = item;
     _database.items[_database.count].send_to_gcs = get_send_to_gcs_flags(_database.items[_database.count].importance);
+    _grid.add(_database.count, item.pos);
+    database_extent_add(item, _database.count == 0);
     _database.count++;
 }
 
+// expand the extent of the database to cover item, or start again from item if first is true
+void AP_OADatabase::database_extent_add(const OA_DbItem &item, bool first)
+{
+    if (first) {
+        _database.pos_min = _database.pos_max = item.pos.xy();
+        _database.radius_max = item.radius;
+        return;
+    }
+    _database.pos_min.x = MIN(_database.pos_min.x, item.pos.x);
+    _database.pos_min.y = MIN(_database.pos_min.y, item.pos.y);
+    _database.pos_max.x = MAX(_database.pos_max.x, item.pos.x);
+    _database.pos_max.y = MAX(_database.pos_max.y, item.pos.y);
+    _database.radius_max = MAX(_database.radius_max, item.radius);
+}
+
 void AP_OADatabase::database_item_remove(const uint16_t index)
 {
     if (index >= _database.count || _database.count == 0) {
@@ -289,6 +303,8 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
         return;
     }
 
+    _grid.remove(index, _database.items[index].pos);
+
     // radius of 0 tells the GCS we don't care about it any more (aka it expired)
     _database.items[index].radius = 0;
     _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
@@ -300,6 +316,7 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
 
     if (index != _database.count) {
         // copy last object in array over expired object
+        _grid.move(_database.count, index, _database.items[_database.count].pos);
         _database.items[index] = _database.items[_database.count];
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
     }
@@ -321,6 +338,7 @@ void AP_OADatabase::database_item_refresh(const uint16_t index, const uint32_t t
         // and trigger resending to GCS
         _database.items[index].timestamp_ms = timestamp_ms;
         _database.items[index].radius = radius;
+        _database.radius_max = MAX(_database.radius_max, radius);
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
     }
 }
@@ -337,6 +355,7 @@ void AP_OADatabase::database_items_remove_all_expired()
 
     const uint32_t now_ms = AP_HAL::millis();
     const uint32_t expiry_ms = (uint32_t)_database_expiry_seconds * 1000;
+    const uint16_t count = _database.count;
     uint16_t index = 0;
     while (index < _database.count) {
         if (now_ms - _database.items[index].timestamp_ms > expiry_ms) {
@@ -345,6 +364,13 @@ void AP_OADatabase::database_items_remove_all_expired()
             index++;
         }
     }
+
+    // shrink the extent of the database to the remaining objects
+    if (_database.count < count) {
+        for (uint16_t i=0; i<_database.count; i++) {
+            database_extent_add(_database.items[i], i == 0);
+        }
+    }
 }
 
 // returns true if a similar object already exists in database. When true, the object timer is also reset
@@ -359,6 +385,105 @@ bool AP_OADatabase::is_close_to_item_in_database(const uint16_t index, const OA_
     return ((distance_sq < sq(item.radius)) || (distance_sq < sq(_database.items[index].radius)));
 }
 
+// find an item in the database close to "item". Returns true and sets index if found
+bool AP_OADatabase::find_close_item_in_database(const OA_DbItem &item, uint16_t &index) const
+{
+    if (_database.count == 0) {
+        return false;
+    }
+
+    // only items within the larger of the two radii can be close
+    const float range = MAX(item.radius, _database.radius_max);
+    const int32_t x_lo = _grid.cell(item.pos.x - range);
+    const int32_t x_hi = _grid.cell(item.pos.x + range);
+    const int32_t y_lo = _grid.cell(item.pos.y - range);
+    const int32_t y_hi = _grid.cell(item.pos.y + range);
+
+    if (!_grid.worth_searching(x_lo, x_hi, y_lo, y_hi)) {
+        for (uint16_t i=0; i<_database.count; i++) {
+            if (is_close_to_item_in_database(i, item)) {
+                index = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    for (int32_t x=x_lo; x<=x_hi; x++) {
+        for (int32_t y=y_lo; y<=y_hi; y++) {
+            for (uint16_t i=_grid.first(x, y); i!=AP_OASpatialIndex::END; i=_grid.next(i)) {
+                if (is_close_to_item_in_database(i, item)) {
+                    index = i;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// calculate the smallest distance between a line segment and the edge of any object in the database
+// returns false if the database is empty
+bool AP_OADatabase::get_margin_from_segment(const Vector3f &start, const Vector3f &end, float &margin) const
+{
+    if (!healthy() || (_database.count == 0)) {
+        return false;
+    }
+
+    // search a band around the segment, widening it until it is certain no object outside the band could be
+    // closer. An object outside the band is at least the band's width from the segment
+    const Vector2f seg_min(MIN(start.x, end.x), MIN(start.y, end.y));
+    const Vector2f seg_max(MAX(start.x, end.x), MAX(start.y, end.y));
+    float band = AP_OADATABASE_GRID_CELL_SIZE;
+    while (true) {
+        const int32_t x_lo = _grid.cell(seg_min.x - band);
+        const int32_t x_hi = _grid.cell(seg_max.x + band);
+        const int32_t y_lo = _grid.cell(seg_min.y - band);
+        const int32_t y_hi = _grid.cell(seg_max.y + band);
+        if (!_grid.worth_searching(x_lo, x_hi, y_lo, y_hi)) {
+            margin = margin_from_segment_all_items(start, end);
+            return true;
+        }
+        const float m = margin_from_segment_in_cells(start, end, x_lo, x_hi, y_lo, y_hi);
+        const bool all_searched = (seg_min.x - band <= _database.pos_min.x) && (seg_min.y - band <= _database.pos_min.y) &&
+                                  (seg_max.x + band >= _database.pos_max.x) && (seg_max.y + band >= _database.pos_max.y);
+        if (all_searched || (m <= band - _database.radius_max)) {
+            margin = m;
+            return true;
+        }
+        band *= 2.0f;
+    }
+}
+
+// smallest margin between a segment and the items in the grid cells from x_lo,y_lo to x_hi,y_hi
+float AP_OADatabase::margin_from_segment_in_cells(const Vector3f &start, const Vector3f &end, int32_t x_lo, int32_t x_hi, int32_t y_lo, int32_t y_hi) const
+{
+    float smallest_margin = FLT_MAX;
+    for (int32_t x=x_lo; x<=x_hi; x++) {
+        for (int32_t y=y_lo; y<=y_hi; y++) {
+            for (uint16_t i=_grid.first(x, y); i!=AP_OASpatialIndex::END; i=_grid.next(i)) {
+                const OA_DbItem &item = _database.items[i];
+                // margin is distance between line segment and obstacle minus obstacle's radius
+                const float m = Vector3f::closest_distance_between_line_and_point(start, end, item.pos) - item.radius;
+                smallest_margin = MIN(smallest_margin, m);
+            }
+        }
+    }
+    return smallest_margin;
+}
+
+// smallest margin between a segment and every item in the database
+float AP_OADatabase::margin_from_segment_all_items(const Vector3f &start, const Vector3f &end) const
+{
+    float smallest_margin = FLT_MAX;
+    for (uint16_t i=0; i<_database.count; i++) {
+        const OA_DbItem &item = _database.items[i];
+        const float m = Vector3f::closest_distance_between_line_and_point(start, end, item.pos) - item.radius;
+        smallest_margin = MIN(smallest_margin, m);
+    }
+    return smallest_margin;
+}
+
 // send ADSB_VEHICLE mavlink messages
 void AP_OADatabase::send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_ms)
 {
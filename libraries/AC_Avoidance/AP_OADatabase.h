@@ -5,6 +5,8 @@
 #include <GCS_MAVLink/GCS_MAVLink.h>
 #include <AP_Param/AP_Param.h>
 
+#include "AP_OASpatialIndex.h"
+
 class AP_OADatabase {
 public:
 
@@ -36,7 +38,7 @@ public:
     void queue_push(const Vector3f &pos, uint32_t timestamp_ms, float distance);
 
     // returns true if database is healthy
-    bool healthy() const { return (_queue.items != nullptr) && (_database.items != nullptr); }
+    bool healthy() const { return (_queue.items != nullptr) && (_database.items != nullptr) && _grid.initialised(); }
 
     // fetch an item in database. Undefined result when i >= _database.count.
     const OA_DbItem& get_item(uint32_t i) const { return _database.items[i]; }
@@ -47,6 +49,11 @@ public:
     // empty queue and try and put into database. Return true if there's more work to do
     bool process_queue();
 
+    // calculate the smallest distance between the line segment from start to end and the edge of any object in
+    // the database. start and end are offsets in meters from the EKF origin in the same frame as the items.
+    // returns false if the database is empty
+    bool get_margin_from_segment(const Vector3f &start, const Vector3f &end, float &margin) const;
+
     // send ADSB_VEHICLE mavlink messages
     void send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_ms);
 
@@ -71,6 +78,18 @@ private:
     // returns true if database item "index" is close to "item"
     bool is_close_to_item_in_database(const uint16_t index, const OA_DbItem &item) const;
 
+    // find an item in the database close to "item". Returns true and sets index if found
+    bool find_close_item_in_database(const OA_DbItem &item, uint16_t &index) const;
+
+    // smallest margin between a segment and the items in the grid cells from x_lo,y_lo to x_hi,y_hi
+    float margin_from_segment_in_cells(const Vector3f &start, const Vector3f &end, int32_t x_lo, int32_t x_hi, int32_t y_lo, int32_t y_hi) const;
+
+    // smallest margin between a segment and every item in the database
+    float margin_from_segment_all_items(const Vector3f &start, const Vector3f &end) const;
+
+    // expand the extent of the database to cover item, or start again from item if first is true
+    void database_extent_add(const OA_DbItem &item, bool first);
+
     // enum for use with _OUTPUT parameter
     enum class OA_DbOutputLevel {
         OUTPUT_LEVEL_DISABLED = 0,
@@ -90,9 +109,8 @@ private:
     AP_Float        _min_alt;                               // OADatabase minimum vehicle height check (in meters)
 
     struct {
-        ObjectBuffer<OA_DbItem> *items;                     // thread safe incoming queue of points from proximity sensor to be put into database
+        ObjectBuffer_MPSC<OA_DbItem> *items;                // lock free incoming queue of points from proximity sensors to be put into database
         uint16_t        size;                               // cached value of _queue_size_param.
-        HAL_Semaphore   sem;                                // semaphore for multi-thread use of queue
     } _queue;
     float dist_to_radius_scalar;                            // scalar to convert the distance and beam width to an object radius
 
@@ -100,8 +118,13 @@ private:
         OA_DbItem       *items;                             // array of objects in the database
         uint16_t        count;                              // number of objects in the items array
         uint16_t        size;                               // cached value of _database_size_param that sticks after initialized
+        Vector2f        pos_min;                            // lower corner of a horizontal box holding all objects (may be larger than needed)
+        Vector2f        pos_max;                            // upper corner of a horizontal box holding all objects (may be larger than needed)
+        float           radius_max;                         // largest radius of any object (may be larger than needed)
     } _database;
 
+    AP_OASpatialIndex _grid;                                // grid of objects' horizontal positions used to find objects near a point or path
+
     uint16_t _next_index_to_send[MAVLINK_COMM_NUM_BUFFERS]; // index of next object in _database to send to GCS
     uint16_t _highest_index_sent[MAVLINK_COMM_NUM_BUFFERS]; // highest index in _database sent to GCS
     uint32_t _last_send_to_gcs_ms[MAVLINK_COMM_NUM_BUFFERS];// system time that send_adsb_vehicle was last called
@@ -15,6 +15,7 @@
 
 #include "AP_OADijkstra.h"
 #include "AP_OAPathPlanner.h"
+#include "AP_OADatabase.h"
 
 #include <AC_Fence/AC_Fence.h>
 #include <AP_AHRS/AP_AHRS.h>
@@ -23,6 +24,10 @@
 #define OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK  32      // expanding arrays for fence points and paths to destination will grow in increments of 20 elements
 #define OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX        255     // index use to indicate we do not have a tentative short path for a node
 #define OA_DIJKSTRA_ERROR_REPORTING_INTERVAL_MS         5000    // failure messages sent to GCS every 5 seconds
+#define OA_DIJKSTRA_VISGRAPH_INDEX_ELEMENTS_PER_CHUNK   256     // index of fence visgraph items grows in increments of 256 elements
+#define OA_DIJKSTRA_DATABASE_SEARCH_US                  5000    // time each update may spend searching for a path when using the object database
+#define OA_DIJKSTRA_DATABASE_REPLAN_MS                  1000    // path is searched for again at this interval while there are database objects
+#define OA_DIJKSTRA_OBSTACLE_POINTS                     6       // number of points around each database obstacle
 
 /// Constructor
 AP_OADijkstra::AP_OADijkstra(AP_Int16 &options) :
@@ -30,7 +35,11 @@ AP_OADijkstra::AP_OADijkstra(AP_Int16 &options) :
         _inclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_polygon_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _exclusion_circle_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _fence_visgraph_item_start(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _fence_visgraph_items(OA_DIJKSTRA_VISGRAPH_INDEX_ELEMENTS_PER_CHUNK),
+        _obstacle_pts(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _short_path_data(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+        _heap(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
         _path(OA_DIJKSTRA_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK)
 {
 }
@@ -41,8 +50,16 @@ AP_OADijkstra::AP_OADijkstra_State AP_OADijkstra::update(const Location &current
 {
     WITH_SEMAPHORE(AP::fence()->polyfence().get_loaded_fence_semaphore());
 
-    // avoidance is not required if no fences
-    if (!some_fences_enabled()) {
+    // avoidance is not required if no fences, unless avoiding objects in the object database
+    const bool fence_enabled = some_fences_enabled();
+    if (fence_enabled != _fence_enabled) {
+        // fence points are used or ignored from now on so previous results are no longer valid
+        _fence_enabled = fence_enabled;
+        _destination_visgraph_ok = false;
+        _shortest_path_ok = false;
+        _search_in_progress = false;
+    }
+    if (!_fence_enabled && !_use_database) {
         Write_OADijkstra(DIJKSTRA_STATE_NOT_REQUIRED, 0, 0, 0, destination, destination);
         return DIJKSTRA_STATE_NOT_REQUIRED;
     }
@@ -53,70 +70,33 @@ AP_OADijkstra::AP_OADijkstra_State AP_OADijkstra::update(const Location &current
         return DIJKSTRA_STATE_NOT_REQUIRED;
     }
 
-    // check for inclusion polygon updates
-    if (check_inclusion_polygon_updated()) {
-        _inclusion_polygon_with_margin_ok = false;
-        _polyfence_visgraph_ok = false;
-        _shortest_path_ok = false;
-    }
-
-    // check for exclusion polygon updates
-    if (check_exclusion_polygon_updated()) {
-        _exclusion_polygon_with_margin_ok = false;
-        _polyfence_visgraph_ok = false;
-        _shortest_path_ok = false;
-    }
-
-    // check for exclusion circle updates
-    if (check_exclusion_circle_updated()) {
-        _exclusion_circle_with_margin_ok = false;
-        _polyfence_visgraph_ok = false;
-        _shortest_path_ok = false;
-    }
-
-    // create inner polygon fence
+    // create inner polygon fence, outer exclusion polygons and circles and their visgraph
     AP_OADijkstra_Error error_id;
-    if (!_inclusion_polygon_with_margin_ok) {
-        _inclusion_polygon_with_margin_ok = create_inclusion_polygon_with_margin(_polyfence_margin * 100.0f, error_id);
-        if (!_inclusion_polygon_with_margin_ok) {
-            report_error(error_id);
-            Write_OADijkstra(DIJKSTRA_STATE_ERROR, (uint8_t)error_id, 0, 0, destination, destination);
-            return DIJKSTRA_STATE_ERROR;
-        }
+    if (_fence_enabled && !update_fence(error_id)) {
+        report_error(error_id);
+        Write_OADijkstra(DIJKSTRA_STATE_ERROR, (uint8_t)error_id, 0, 0, destination, destination);
+        return DIJKSTRA_STATE_ERROR;
     }
 
-    // create exclusion polygon outer fence
-    if (!_exclusion_polygon_with_margin_ok) {
-        _exclusion_polygon_with_margin_ok = create_exclusion_polygon_with_margin(_polyfence_margin * 100.0f, error_id);
-        if (!_exclusion_polygon_with_margin_ok) {
+    // get the objects to avoid from the object database
+    Vector2f current_pos;
+    if (_use_database) {
+        Vector2f destination_pos;
+        if (!current_loc.get_vector_xy_from_origin_NE(current_pos) || !destination.get_vector_xy_from_origin_NE(destination_pos)) {
+            error_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_NO_POSITION_ESTIMATE;
             report_error(error_id);
             Write_OADijkstra(DIJKSTRA_STATE_ERROR, (uint8_t)error_id, 0, 0, destination, destination);
             return DIJKSTRA_STATE_ERROR;
         }
-    }
+        update_database_obstacles(current_pos, destination_pos);
 
-    // create exclusion circle points
-    if (!_exclusion_circle_with_margin_ok) {
-        _exclusion_circle_with_margin_ok = create_exclusion_circle_with_margin(_polyfence_margin * 100.0f, error_id);
-        if (!_exclusion_circle_with_margin_ok) {
-            report_error(error_id);
-            Write_OADijkstra(DIJKSTRA_STATE_ERROR, (uint8_t)error_id, 0, 0, destination, destination);
-            return DIJKSTRA_STATE_ERROR;
-        }
-    }
-
-    // create visgraph for all fence (with margin) points
-    if (!_polyfence_visgraph_ok) {
-        _polyfence_visgraph_ok = create_fence_visgraph(error_id);
-        if (!_polyfence_visgraph_ok) {
+        // avoidance is not required if no fences and no objects
+        if (!_fence_enabled && (_db_obstacles_num == 0)) {
             _shortest_path_ok = false;
-            report_error(error_id);
-            Write_OADijkstra(DIJKSTRA_STATE_ERROR, (uint8_t)error_id, 0, 0, destination, destination);
-            return DIJKSTRA_STATE_ERROR;
+            _search_in_progress = false;
+            Write_OADijkstra(DIJKSTRA_STATE_NOT_REQUIRED, 0, 0, 0, destination, destination);
+            return DIJKSTRA_STATE_NOT_REQUIRED;
         }
-        // reset logging count to restart logging updated graph
-        _log_num_points = 0;
-        _log_visgraph_version++;
     }
 
     // Log one visgraph point per loop
@@ -133,6 +113,46 @@ AP_OADijkstra::AP_OADijkstra_State AP_OADijkstra::update(const Location &current
     if (!destination.same_latlon_as(_destination_prev)) {
         _destination_prev = destination;
         _shortest_path_ok = false;
+        _search_in_progress = false;
+    }
+
+    if (_use_database) {
+        // the current path can no longer be used if objects have moved onto it
+        if (_shortest_path_ok && path_blocked_by_obstacles(current_pos)) {
+            _shortest_path_ok = false;
+        }
+
+        // search for a new path if required, or periodically while there are objects so the path follows them as they
+        // move or are cleared. The current path continues to be used until the search is complete
+        const uint32_t now_ms = AP_HAL::millis();
+        const bool replan = (_db_obstacles_num > 0 || _search_obstacles_num > 0) && (now_ms - _search_start_ms > OA_DIJKSTRA_DATABASE_REPLAN_MS);
+        bool search_ok = true;
+        if (!_search_in_progress && (!_shortest_path_ok || replan)) {
+            _search_start_ms = now_ms;
+            search_ok = start_shortest_path(current_loc, destination, error_id);
+        }
+
+        // continue search for a limited time so results are returned at a regular rate
+        if (search_ok && _search_in_progress) {
+            search_ok = search_shortest_path(OA_DIJKSTRA_DATABASE_SEARCH_US, error_id);
+            if (search_ok && !_search_in_progress) {
+                _shortest_path_ok = true;
+                // start from 2nd point on path (first is the original origin)
+                _path_idx_returned = 1;
+            }
+        }
+        if (!search_ok) {
+            _search_in_progress = false;
+            report_error(error_id);
+            if (!_shortest_path_ok) {
+                Write_OADijkstra(DIJKSTRA_STATE_ERROR, (uint8_t)error_id, 0, 0, destination, destination);
+                return DIJKSTRA_STATE_ERROR;
+            }
+        }
+        if (!_shortest_path_ok) {
+            Write_OADijkstra(DIJKSTRA_STATE_PROCESSING, 0, 0, 0, destination, destination);
+            return DIJKSTRA_STATE_PROCESSING;
+        }
     }
 
     // calculate shortest path from current_loc to destination
@@ -184,6 +204,70 @@ AP_OADijkstra::AP_OADijkstra_State AP_OADijkstra::update(const Location &current
     return DIJKSTRA_STATE_NOT_REQUIRED;
 }
 
+// check for fence updates and recreate the fence points with margin and their visibility graph if required
+// returns true on success.  returns false on failure and err_id is updated
+bool AP_OADijkstra::update_fence(AP_OADijkstra_Error &err_id)
+{
+    // check for inclusion polygon updates
+    if (check_inclusion_polygon_updated()) {
+        _inclusion_polygon_with_margin_ok = false;
+        _polyfence_visgraph_ok = false;
+        _shortest_path_ok = false;
+    }
+
+    // check for exclusion polygon updates
+    if (check_exclusion_polygon_updated()) {
+        _exclusion_polygon_with_margin_ok = false;
+        _polyfence_visgraph_ok = false;
+        _shortest_path_ok = false;
+    }
+
+    // check for exclusion circle updates
+    if (check_exclusion_circle_updated()) {
+        _exclusion_circle_with_margin_ok = false;
+        _polyfence_visgraph_ok = false;
+        _shortest_path_ok = false;
+    }
+
+    // create inner polygon fence
+    if (!_inclusion_polygon_with_margin_ok) {
+        _inclusion_polygon_with_margin_ok = create_inclusion_polygon_with_margin(_polyfence_margin * 100.0f, err_id);
+        if (!_inclusion_polygon_with_margin_ok) {
+            return false;
+        }
+    }
+
+    // create exclusion polygon outer fence
+    if (!_exclusion_polygon_with_margin_ok) {
+        _exclusion_polygon_with_margin_ok = create_exclusion_polygon_with_margin(_polyfence_margin * 100.0f, err_id);
+        if (!_exclusion_polygon_with_margin_ok) {
+            return false;
+        }
+    }
+
+    // create exclusion circle points
+    if (!_exclusion_circle_with_margin_ok) {
+        _exclusion_circle_with_margin_ok = create_exclusion_circle_with_margin(_polyfence_margin * 100.0f, err_id);
+        if (!_exclusion_circle_with_margin_ok) {
+            return false;
+        }
+    }
+
+    // create visgraph for all fence (with margin) points
+    if (!_polyfence_visgraph_ok) {
+        _polyfence_visgraph_ok = create_fence_visgraph(err_id);
+        if (!_polyfence_visgraph_ok) {
+            _shortest_path_ok = false;
+            return false;
+        }
+        // reset logging count to restart logging updated graph
+        _log_num_points = 0;
+        _log_visgraph_version++;
+    }
+
+    return true;
+}
+
 // returns true if at least one inclusion or exclusion zone is enabled
 bool AP_OADijkstra::some_fences_enabled() const
 {
@@ -519,14 +603,23 @@ bool AP_OADijkstra::create_exclusion_circle_with_margin(float margin_cm, AP_OADi
 // returns total number of points across all fence types
 uint16_t AP_OADijkstra::total_numpoints() const
 {
+    // fence points are not used while the fence is disabled
+    if (!_fence_enabled) {
+        return 0;
+    }
     return _inclusion_polygon_numpoints + _exclusion_polygon_numpoints + _exclusion_circle_numpoints;
 }
 
 // get a single point across the total list of points from all fence types
 bool AP_OADijkstra::get_point(uint16_t index, Vector2f &point) const
 {
-    // sanity check index
+    // return a point around a database obstacle
     if (index >= total_numpoints()) {
+        index -= total_numpoints();
+        if (index < _obstacle_numpoints) {
+            point = _obstacle_pts[index];
+            return true;
+        }
         return false;
     }
 
@@ -559,31 +652,13 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
 {
     // return immediately if fence is not enabled
     const AC_Fence *fence = AC_Fence::get_singleton();
-    if (fence == nullptr) {
+    if ((fence == nullptr) || !_fence_enabled) {
         return false;
     }
 
-    // determine if segment crosses any of the inclusion polygons
-    uint16_t num_points = 0;
-    for (uint8_t i = 0; i < fence->polyfence().get_inclusion_polygon_count(); i++) {
-        const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
-        if (boundary != nullptr) {
-            Vector2f intersection;
-            if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
-                return true;
-            }
-        }
-    }
-
-    // determine if segment crosses any of the exclusion polygons
-    for (uint8_t i = 0; i < fence->polyfence().get_exclusion_polygon_count(); i++) {
-        const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
-        if (boundary != nullptr) {
-            Vector2f intersection;
-            if (Polygon_intersects(boundary, num_points, seg_start, seg_end, intersection)) {
-                return true;
-            }
-        }
+    // determine if segment crosses any of the inclusion or exclusion polygons
+    if (_fence_edges.intersects(seg_start, seg_end)) {
+        return true;
     }
 
     // determine if segment crosses any of the inclusion circles
@@ -621,6 +696,142 @@ bool AP_OADijkstra::intersects_fence(const Vector2f &seg_start, const Vector2f &
     return false;
 }
 
+// merge the objects in the object database into _db_obstacles, ignoring any which cover the vehicle or destination
+// current_pos and destination are offsets (in cm) from the ekf origin
+void AP_OADijkstra::update_database_obstacles(const Vector2f &current_pos, const Vector2f &destination)
+{
+    _db_obstacles_num = 0;
+
+    const AP_OADatabase *oaDb = AP::oadatabase();
+    if ((oaDb == nullptr) || !oaDb->healthy()) {
+        return;
+    }
+
+    const uint8_t obstacles_max = get_obstacles_max();
+    if (obstacles_max == 0) {
+        return;
+    }
+
+    for (uint16_t i = 0; i < oaDb->database_count(); i++) {
+        const AP_OADatabase::OA_DbItem& item = oaDb->get_item(i);
+        add_database_object(item.pos.xy() * 100.0f, item.radius * 100.0f, obstacles_max);
+    }
+
+    remove_obstacles_covering(current_pos, destination);
+}
+
+// remove obstacles from _db_obstacles which cover the vehicle or destination as no path around them can be found
+void AP_OADijkstra::remove_obstacles_covering(const Vector2f &current_pos, const Vector2f &destination)
+{
+    uint8_t num_obstacles = 0;
+    for (uint8_t j = 0; j < _db_obstacles_num; j++) {
+        const Obstacle &obstacle = _db_obstacles[j];
+        if (((current_pos - obstacle.center_cm).length() > obstacle.radius_cm) &&
+            ((destination - obstacle.center_cm).length() > obstacle.radius_cm)) {
+            _db_obstacles[num_obstacles++] = obstacle;
+        }
+    }
+    _db_obstacles_num = num_obstacles;
+}
+
+// add an object (position and radius in cm) to _db_obstacles. Objects are merged with an obstacle if there is not
+// room to pass between them with the margin, or if there are already obstacles_max obstacles
+void AP_OADijkstra::add_database_object(const Vector2f &item_pos, float item_radius, uint8_t obstacles_max)
+{
+    // find the obstacle the object is closest to
+    uint8_t closest = 0;
+    float closest_gap = FLT_MAX;
+    for (uint8_t j = 0; j < _db_obstacles_num; j++) {
+        const float gap = (item_pos - _db_obstacles[j].center_cm).length() - item_radius - _db_obstacles[j].radius_cm;
+        if (gap < closest_gap) {
+            closest = j;
+            closest_gap = gap;
+        }
+    }
+
+    // add a new obstacle if the object is not close to any, or if there is no room merge it with the closest
+    const float margin_cm = _polyfence_margin * 100.0f;
+    if ((closest_gap > margin_cm) && (_db_obstacles_num < obstacles_max)) {
+        _db_obstacles[_db_obstacles_num++] = {item_pos, item_radius};
+        return;
+    }
+
+    // grow the obstacle to the smallest circle holding both the obstacle and the object
+    Obstacle &obstacle = _db_obstacles[closest];
+    const Vector2f offset = item_pos - obstacle.center_cm;
+    const float dist = offset.length();
+    if (dist + item_radius <= obstacle.radius_cm) {
+        // object is already inside the obstacle
+        return;
+    }
+    if (dist + obstacle.radius_cm <= item_radius) {
+        // obstacle is inside the object
+        obstacle = {item_pos, item_radius};
+        return;
+    }
+    const float radius = (dist + obstacle.radius_cm + item_radius) * 0.5f;
+    obstacle.center_cm += offset * ((radius - obstacle.radius_cm) / dist);
+    obstacle.radius_cm = radius;
+}
+
+// maximum number of obstacles. Each obstacle's points are nodes so this keeps within the number of nodes supported
+uint8_t AP_OADijkstra::get_obstacles_max() const
+{
+    const uint16_t nodes_used = 2 + total_numpoints();
+    if (nodes_used >= OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
+        return 0;
+    }
+    return MIN((OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX - nodes_used) / OA_DIJKSTRA_OBSTACLE_POINTS, OA_DIJKSTRA_DATABASE_OBSTACLES_MAX);
+}
+
+// returns true if line segment passes through any of num_obstacles obstacles
+bool AP_OADijkstra::intersects_obstacles(const Obstacle *obstacles, uint8_t num_obstacles, const Vector2f &seg_start, const Vector2f &seg_end)
+{
+    for (uint8_t i = 0; i < num_obstacles; i++) {
+        if (Vector2f::closest_distance_between_line_and_point(seg_start, seg_end, obstacles[i].center_cm) <= obstacles[i].radius_cm) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// copy _db_obstacles to be used by the next search and create points around them, as if they were exclusion circles
+void AP_OADijkstra::create_obstacle_points()
+{
+    _search_obstacles_num = 0;
+    _obstacle_numpoints = 0;
+    const uint8_t num_obstacles = MIN(_db_obstacles_num, get_obstacles_max());
+    if (!_obstacle_pts.expand_to_hold(num_obstacles * OA_DIJKSTRA_OBSTACLE_POINTS)) {
+        return;
+    }
+
+    // scaler to ensure lines between points do not intersect the obstacle
+    const float scaler = 1.0f / cosf(radians(180.0f / OA_DIJKSTRA_OBSTACLE_POINTS));
+    const float margin_cm = _polyfence_margin * 100.0f;
+    for (uint8_t i = 0; i < num_obstacles; i++) {
+        const Obstacle &obstacle = _db_obstacles[i];
+        _search_obstacles[_search_obstacles_num++] = obstacle;
+        for (uint8_t j = 0; j < OA_DIJKSTRA_OBSTACLE_POINTS; j++) {
+            const float angle = radians(30.0f + j * (360.0f / OA_DIJKSTRA_OBSTACLE_POINTS));
+            _obstacle_pts[_obstacle_numpoints++] = obstacle.center_cm + Vector2f(cosf(angle), sinf(angle)) * (scaler * (obstacle.radius_cm + margin_cm));
+        }
+    }
+}
+
+// returns true if the remaining part of the current path, starting from position, passes through any of _db_obstacles
+bool AP_OADijkstra::path_blocked_by_obstacles(const Vector2f &position) const
+{
+    Vector2f seg_start = position;
+    Vector2f seg_end;
+    for (uint8_t i = _path_idx_returned; get_shortest_path_point(i, seg_end); i++) {
+        if (intersects_obstacles(_db_obstacles, _db_obstacles_num, seg_start, seg_end)) {
+            return true;
+        }
+        seg_start = seg_end;
+    }
+    return false;
+}
+
 // create visibility graph for all fence (with margin) points
 // returns true on success.  returns false on failure and err_id is updated
 // requires these functions to have been run create_inclusion_polygon_with_margin, create_exclusion_polygon_with_margin, create_exclusion_circle_with_margin
@@ -639,8 +850,15 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
         return false;
     }
 
+    // load polygon edges used to check if segments between points cross the fence
+    if (!create_fence_edges(err_id)) {
+        return false;
+    }
+
     // clear fence points visibility graph
     _fence_visgraph.clear();
+    _destination_visgraph_ok = false;
+    _search_in_progress = false;
 
     // calculate distance from each point to all other points
     for (uint8_t i = 0; i < total_numpoints() - 1; i++) {
@@ -664,6 +882,82 @@ bool AP_OADijkstra::create_fence_visgraph(AP_OADijkstra_Error &err_id)
         }
     }
 
+    if (!index_fence_visgraph()) {
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+
+    return true;
+}
+
+// load the inclusion and exclusion polygon edges into _fence_edges
+// returns true on success.  returns false on failure and err_id is updated
+bool AP_OADijkstra::create_fence_edges(AP_OADijkstra_Error &err_id)
+{
+    const AC_Fence *fence = AC_Fence::get_singleton();
+    if (fence == nullptr) {
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_FENCE_DISABLED;
+        return false;
+    }
+
+    _fence_edges.clear();
+    uint16_t num_points = 0;
+    for (uint8_t i = 0; i < fence->polyfence().get_inclusion_polygon_count(); i++) {
+        const Vector2f* boundary = fence->polyfence().get_inclusion_polygon(i, num_points);
+        if (!_fence_edges.add_polygon(boundary, num_points)) {
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
+    }
+    for (uint8_t i = 0; i < fence->polyfence().get_exclusion_polygon_count(); i++) {
+        const Vector2f* boundary = fence->polyfence().get_exclusion_polygon(i, num_points);
+        if (!_fence_edges.add_polygon(boundary, num_points)) {
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
+    }
+    if (!_fence_edges.build()) {
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+        return false;
+    }
+    return true;
+}
+
+// index the fence visgraph's items by the fence point at either end
+// returns true on success, false if out of memory
+bool AP_OADijkstra::index_fence_visgraph()
+{
+    const uint16_t num_points = total_numpoints();
+    const uint32_t num_entries = 2 * (uint32_t)_fence_visgraph.num_items();
+    if ((num_entries > UINT16_MAX) ||
+        !_fence_visgraph_item_start.expand_to_hold(num_points + 1) ||
+        !_fence_visgraph_items.expand_to_hold(num_entries)) {
+        return false;
+    }
+
+    // count the items involving each point, then convert the counts to start positions
+    for (uint16_t i = 0; i <= num_points; i++) {
+        _fence_visgraph_item_start[i] = 0;
+    }
+    for (uint16_t i = 0; i < _fence_visgraph.num_items(); i++) {
+        _fence_visgraph_item_start[_fence_visgraph[i].id1.id_num + 1]++;
+        _fence_visgraph_item_start[_fence_visgraph[i].id2.id_num + 1]++;
+    }
+    for (uint16_t i = 0; i < num_points; i++) {
+        _fence_visgraph_item_start[i + 1] += _fence_visgraph_item_start[i];
+    }
+
+    // fill in each point's items using its start as the write position, which leaves it at the start of the
+    // following point, then move the starts back
+    for (uint16_t i = 0; i < _fence_visgraph.num_items(); i++) {
+        _fence_visgraph_items[_fence_visgraph_item_start[_fence_visgraph[i].id1.id_num]++] = i;
+        _fence_visgraph_items[_fence_visgraph_item_start[_fence_visgraph[i].id2.id_num]++] = i;
+    }
+    for (uint16_t i = num_points; i > 0; i--) {
+        _fence_visgraph_item_start[i] = _fence_visgraph_item_start[i - 1];
+    }
+    _fence_visgraph_item_start[0] = 0;
+
     return true;
 }
 
@@ -713,36 +1007,133 @@ void AP_OADijkstra::update_visible_node_distances(node_index curr_node_idx)
     // get current node for convenience
     const ShortPathNode &curr_node = _short_path_data[curr_node_idx];
 
-    // for each visibility graph
-    const AP_OAVisGraph* visgraphs[] = {&_fence_visgraph, &_destination_visgraph};
-    for (uint8_t v=0; v<ARRAY_SIZE(visgraphs); v++) {
-
-        // skip if empty
-        const AP_OAVisGraph &curr_visgraph = *visgraphs[v];
-        if (curr_visgraph.num_items() == 0) {
-            continue;
-        }
-
-        // search visibility graph for items visible from current_node
-        for (uint16_t i = 0; i < curr_visgraph.num_items(); i++) {
-            const AP_OAVisGraph::VisGraphItem &item = curr_visgraph[i];
-            // match if current node's id matches either of the id's in the graph (i.e. either end of the vector)
-            if ((curr_node.id == item.id1) || (curr_node.id == item.id2)) {
-                AP_OAVisGraph::OAItemID matching_id = (curr_node.id == item.id1) ? item.id2 : item.id1;
-                // find item's id in node array
-                node_index item_node_idx;
-                if (find_node_from_id(matching_id, item_node_idx)) {
-                    // if current node's distance + distance to item is less than item's current distance, update item's distance
-                    const float dist_to_item_via_current_node = _short_path_data[curr_node_idx].distance_cm + item.distance_cm;
-                    if (dist_to_item_via_current_node < _short_path_data[item_node_idx].distance_cm) {
-                        // update item's distance and set "distance_from_idx" to current node's index
-                        _short_path_data[item_node_idx].distance_cm = dist_to_item_via_current_node;
-                        _short_path_data[item_node_idx].distance_from_idx = curr_node_idx;
-                    }
-                }
+    // update fence points visible from current node, found from the fence visgraph's index
+    const bool curr_node_is_fence_point = (curr_node.id.id_type == AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT) && (curr_node.id.id_num < total_numpoints());
+    const bool check_obstacles = (_search_obstacles_num > 0);
+    if (curr_node_is_fence_point) {
+        const uint16_t start = _fence_visgraph_item_start[curr_node.id.id_num];
+        const uint16_t end = _fence_visgraph_item_start[curr_node.id.id_num + 1];
+        for (uint16_t i = start; i < end; i++) {
+            const AP_OAVisGraph::VisGraphItem &item = _fence_visgraph[_fence_visgraph_items[i]];
+            // the matching id is the other end of the vector
+            const AP_OAVisGraph::OAItemID &matching_id = (curr_node.id == item.id1) ? item.id2 : item.id1;
+            node_index item_node_idx;
+            if (find_node_from_id(matching_id, item_node_idx)) {
+                update_node_distance(item_node_idx, curr_node_idx, curr_node.distance_cm + item.distance_cm, check_obstacles);
             }
         }
     }
+
+    // update points around obstacles, and fence points if current node is around an obstacle. These are not in the
+    // fence visgraph so whether they are visible is only checked when they might be reached by a shorter path
+    if (_obstacle_numpoints > 0) {
+        const uint16_t first_point = curr_node_is_fence_point ? total_numpoints() : 0;
+        const uint16_t last_point = total_numpoints() + _obstacle_numpoints;
+        for (uint16_t i = first_point; i < last_point; i++) {
+            node_index item_node_idx;
+            if (find_node_from_id({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)i}, item_node_idx) && (item_node_idx != curr_node_idx)) {
+                const float distance_cm = curr_node.distance_cm + (_short_path_data[item_node_idx].pos - curr_node.pos).length();
+                update_node_distance(item_node_idx, curr_node_idx, distance_cm, true, true);
+            }
+        }
+    }
+
+    // update destination if visible from current node
+    if (curr_node.distance_to_dest_cm < FLT_MAX) {
+        node_index dest_node_idx;
+        if (find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION, 0}, dest_node_idx)) {
+            update_node_distance(dest_node_idx, curr_node_idx, curr_node.distance_cm + curr_node.distance_to_dest_cm);
+        }
+    }
+}
+
+// set a node's distance to distance_cm via from_idx if that is shorter than its current distance
+// if check_obstacles is true the line between the nodes is checked against the search's obstacles and, if check_fence
+// is also true, the fence before the distance is updated
+void AP_OADijkstra::update_node_distance(node_index node_idx, node_index from_idx, float distance_cm, bool check_obstacles, bool check_fence)
+{
+    ShortPathNode &node = _short_path_data[node_idx];
+    if (node.visited || (distance_cm >= node.distance_cm)) {
+        return;
+    }
+    if (check_obstacles) {
+        const Vector2f &from_pos = _short_path_data[from_idx].pos;
+        if (intersects_obstacles(_search_obstacles, _search_obstacles_num, from_pos, node.pos) ||
+            (check_fence && intersects_fence(from_pos, node.pos))) {
+            return;
+        }
+    }
+    // update item's distance and set "distance_from_idx" to current node's index
+    node.distance_cm = distance_cm;
+    node.distance_from_idx = from_idx;
+    heap_update(node_idx);
+}
+
+// value a node is ordered by in the heap
+float AP_OADijkstra::heap_key(node_index node_idx) const
+{
+    // heuristics is simple Euclidean distance from the node to the destination
+    // This should be admissible, therefore optimal path is guaranteed
+    const ShortPathNode &node = _short_path_data[node_idx];
+    return node.distance_cm + node.heuristic_cm;
+}
+
+// add node to the heap, or move it up if it is already in the heap and its distance has reduced
+void AP_OADijkstra::heap_update(node_index node_idx)
+{
+    node_index heap_pos = _short_path_data[node_idx].heap_idx;
+    if (heap_pos == OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) {
+        heap_pos = _heap_numpoints++;
+        _heap[heap_pos] = node_idx;
+        _short_path_data[node_idx].heap_idx = heap_pos;
+    }
+    heap_sift_up(heap_pos);
+}
+
+// move the heap element at heap_pos towards the top of the heap until it is in order
+void AP_OADijkstra::heap_sift_up(node_index heap_pos)
+{
+    const node_index node_idx = _heap[heap_pos];
+    const float key = heap_key(node_idx);
+    while (heap_pos > 0) {
+        const node_index parent_pos = (heap_pos - 1) / 2;
+        const node_index parent_idx = _heap[parent_pos];
+        if (heap_key(parent_idx) <= key) {
+            break;
+        }
+        _heap[heap_pos] = parent_idx;
+        _short_path_data[parent_idx].heap_idx = heap_pos;
+        heap_pos = parent_pos;
+    }
+    _heap[heap_pos] = node_idx;
+    _short_path_data[node_idx].heap_idx = heap_pos;
+}
+
+// move the heap element at heap_pos towards the bottom of the heap until it is in order
+void AP_OADijkstra::heap_sift_down(node_index heap_pos)
+{
+    const node_index node_idx = _heap[heap_pos];
+    const float key = heap_key(node_idx);
+    while (true) {
+        const uint16_t left_pos = 2 * (uint16_t)heap_pos + 1;
+        if (left_pos >= _heap_numpoints) {
+            break;
+        }
+        // pick the smaller of the children
+        node_index child_pos = left_pos;
+        if ((left_pos + 1 < _heap_numpoints) && (heap_key(_heap[left_pos + 1]) < heap_key(_heap[left_pos]))) {
+            child_pos = left_pos + 1;
+        }
+        const node_index child_idx = _heap[child_pos];
+        if (key <= heap_key(child_idx)) {
+            break;
+        }
+        _heap[heap_pos] = child_idx;
+        _short_path_data[child_idx].heap_idx = heap_pos;
+        heap_pos = child_pos;
+    }
+    _heap[heap_pos] = node_idx;
+    _short_path_data[node_idx].heap_idx = heap_pos;
 }
 
 // find a node's index into _short_path_data array from it's id (i.e. id type and id number)
@@ -777,45 +1168,24 @@ bool AP_OADijkstra::find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_in
     return false;
 }
 
-// find index of node with lowest tentative distance (ignore visited nodes)
+// find index of node with lowest tentative distance (ignore visited nodes) and remove it from the heap
 // returns true if successful and node_idx argument is updated
-bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx) const
-{
-    node_index lowest_idx = 0;
-    float lowest_dist = FLT_MAX;
-
-    // scan through all nodes looking for closest
-    for (node_index i=0; i<_short_path_data_numpoints; i++) {
-        const ShortPathNode &node = _short_path_data[i];
-        if (node.visited || is_equal(_short_path_data[i].distance_cm, FLT_MAX)) {
-            // if node is already visited OR cannot be reached yet, we can't use it
-            continue;
-        }
-        // figure out the pos of this node
-        Vector2f node_pos;
-        float dist_with_heuristics = FLT_MAX;
-        if (convert_node_to_point(node.id, node_pos)) {
-            // heuristics is is simple Euclidean distance from the node to the destination
-            // This should be admissible, therefore optimal path is guaranteed
-            const float heuristics = (node_pos-_path_destination).length();
-            dist_with_heuristics = node.distance_cm + heuristics;
-        } else {
-            // shouldn't happen
-            return false;
-        }
-        if (dist_with_heuristics < lowest_dist) {
-            // for NOW, this is the closest node
-            lowest_idx = i;
-            lowest_dist = dist_with_heuristics;
-        }
+bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx)
+{
+    if (_heap_numpoints == 0) {
+        return false;
     }
 
-    if (lowest_dist < FLT_MAX) {
-        // found the closest node
-        node_idx = lowest_idx;
-        return true;
+    // the closest node is at the top of the heap, replace it with the last element
+    node_idx = _heap[0];
+    _short_path_data[node_idx].heap_idx = OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX;
+    _heap_numpoints--;
+    if (_heap_numpoints > 0) {
+        _heap[0] = _heap[_heap_numpoints];
+        _short_path_data[_heap[0]].heap_idx = 0;
+        heap_sift_down(0);
     }
-    return false;
+    return true;
 }
 
 // calculate shortest path from origin to destination
@@ -824,60 +1194,143 @@ bool AP_OADijkstra::find_closest_node_idx(node_index &node_idx) const
 // resulting path is stored in _shortest_path array as vector offsets from EKF origin
 bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &destination, AP_OADijkstra_Error &err_id)
 {
+    return start_shortest_path(origin, destination, err_id) && search_shortest_path(0, err_id);
+}
+
+// set up a search for the shortest path from origin to destination which is then run by search_shortest_path
+// returns true on success.  returns false on failure and err_id is updated
+bool AP_OADijkstra::start_shortest_path(const Location &origin, const Location &destination, AP_OADijkstra_Error &err_id)
+{
+    _search_in_progress = false;
+
     // convert origin and destination to offsets from EKF origin
-    if (!origin.get_vector_xy_from_origin_NE(_path_source) || !destination.get_vector_xy_from_origin_NE(_path_destination)) {
+    Vector2f origin_pos, destination_pos;
+    if (!origin.get_vector_xy_from_origin_NE(origin_pos) || !destination.get_vector_xy_from_origin_NE(destination_pos)) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_NO_POSITION_ESTIMATE;
         return false;
     }
+    return start_shortest_path(origin_pos, destination_pos, err_id);
+}
+
+// set up a search between origin and destination given as offsets (in cm) from the ekf origin
+bool AP_OADijkstra::start_shortest_path(const Vector2f &origin, const Vector2f &destination, AP_OADijkstra_Error &err_id)
+{
+    _search_in_progress = false;
+    _path_source = origin;
+    _path_destination = destination;
 
     // create visgraphs of origin and destination to fence points
     if (!update_visgraph(_source_visgraph, {AP_OAVisGraph::OATYPE_SOURCE, 0}, _path_source, true, _path_destination)) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
         return false;
     }
-    if (!update_visgraph(_destination_visgraph, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, _path_destination)) {
-        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
-        return false;
+    // the destination's visgraph only changes with the destination or the fence
+    if (!_destination_visgraph_ok || (_destination_visgraph_pos != _path_destination)) {
+        _destination_visgraph_ok = false;
+        if (!update_visgraph(_destination_visgraph, {AP_OAVisGraph::OATYPE_DESTINATION, 0}, _path_destination)) {
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
+            return false;
+        }
+        _destination_visgraph_pos = _path_destination;
+        _destination_visgraph_ok = true;
+    }
+
+    // add points around the latest database obstacles
+    if (_use_database) {
+        create_obstacle_points();
     }
+    const bool check_obstacles = (_search_obstacles_num > 0);
+    const uint16_t num_points = total_numpoints() + _obstacle_numpoints;
 
-    // expand _short_path_data if necessary
-    if (!_short_path_data.expand_to_hold(2 + total_numpoints())) {
+    // expand _short_path_data and _heap if necessary
+    if (!_short_path_data.expand_to_hold(2 + num_points) || !_heap.expand_to_hold(2 + num_points)) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
         return false;
     }
 
-    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm) to short_path_data array
-    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0};
-    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+    // add origin and destination (node_type, id, visited, distance_from_idx, distance_cm, heuristic_cm, distance_to_dest_cm, heap_idx, pos) to short_path_data array
+    _short_path_data[0] = {{AP_OAVisGraph::OATYPE_SOURCE, 0}, false, 0, 0, (_path_source - _path_destination).length(), FLT_MAX, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, _path_source};
+    _short_path_data[1] = {{AP_OAVisGraph::OATYPE_DESTINATION, 0}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, 0, FLT_MAX, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, _path_destination};
     _short_path_data_numpoints = 2;
 
-    // add all inclusion and exclusion fence points to short_path_data array (node_type, id, visited, distance_from_idx, distance_cm)
-    for (uint8_t i=0; i<total_numpoints(); i++) {
-        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX};
+    // add all inclusion and exclusion fence points, and points around obstacles, to short_path_data array
+    for (uint8_t i=0; i<num_points; i++) {
+        Vector2f point;
+        if (!get_point(i, point)) {
+            err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
+            return false;
+        }
+        _short_path_data[_short_path_data_numpoints++] = {{AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, i}, false, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, FLT_MAX, (point - _path_destination).length(), FLT_MAX, OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX, point};
+    }
+
+    // record distance to destination from points visible from it
+    for (uint16_t i = 0; i < _destination_visgraph.num_items(); i++) {
+        node_index node_idx;
+        if (find_node_from_id(_destination_visgraph[i].id2, node_idx)) {
+            if (!check_obstacles || !intersects_obstacles(_search_obstacles, _search_obstacles_num, _short_path_data[node_idx].pos, _path_destination)) {
+                _short_path_data[node_idx].distance_to_dest_cm = _destination_visgraph[i].distance_cm;
+            }
+        }
+    }
+    for (uint16_t i = total_numpoints(); i < num_points; i++) {
+        node_index node_idx;
+        if (find_node_from_id({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)i}, node_idx)) {
+            ShortPathNode &node = _short_path_data[node_idx];
+            if (!intersects_obstacles(_search_obstacles, _search_obstacles_num, node.pos, _path_destination) && !intersects_fence(node.pos, _path_destination)) {
+                node.distance_to_dest_cm = (node.pos - _path_destination).length();
+            }
+        }
     }
 
     // start algorithm from source point
     node_index current_node_idx = 0;
+    _heap_numpoints = 0;
 
     // update nodes visible from source point
     for (uint16_t i = 0; i < _source_visgraph.num_items(); i++) {
         node_index node_idx;
         if (find_node_from_id(_source_visgraph[i].id2, node_idx)) {
-            _short_path_data[node_idx].distance_cm = _source_visgraph[i].distance_cm;
-            _short_path_data[node_idx].distance_from_idx = current_node_idx;
+            update_node_distance(node_idx, current_node_idx, _source_visgraph[i].distance_cm, check_obstacles);
         } else {
             err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
             return false;
         }
     }
+    for (uint16_t i = total_numpoints(); i < num_points; i++) {
+        node_index node_idx;
+        if (find_node_from_id({AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT, (AP_OAVisGraph::oaid_num)i}, node_idx)) {
+            update_node_distance(node_idx, current_node_idx, (_short_path_data[node_idx].pos - _path_source).length(), true, true);
+        }
+    }
     // mark source node as visited
     _short_path_data[current_node_idx].visited = true;
 
+    _search_in_progress = true;
+    return true;
+}
+
+// continue the search started by start_shortest_path for up to time_budget_us microseconds (or until complete if zero)
+// _search_in_progress is cleared once the search is complete and the path has been stored in _path
+// returns true on success or if the search is incomplete.  returns false on failure and err_id is updated
+bool AP_OADijkstra::search_shortest_path(uint32_t time_budget_us, AP_OADijkstra_Error &err_id)
+{
+    if (!_search_in_progress) {
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
+        return false;
+    }
+    const uint32_t start_us = AP_HAL::micros();
+
     // move current_node_idx to node with lowest distance
+    node_index dest_node;
+    if (!find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION,0}, dest_node)) {
+        _search_in_progress = false;
+        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
+        return false;
+    }
+    node_index current_node_idx;
     while (find_closest_node_idx(current_node_idx)) {
-        node_index dest_node;
         // See if this next "closest" node is actually the destination
-        if (find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION,0}, dest_node) && current_node_idx == dest_node) {
+        if (current_node_idx == dest_node) {
             // We have discovered destination.. Don't bother with the rest of the graph
             break;
         }
@@ -886,76 +1339,81 @@ bool AP_OADijkstra::calc_shortest_path(const Location &origin, const Location &d
 
         // mark current node as visited
         _short_path_data[current_node_idx].visited = true;
+
+        // continue with the next update if out of time
+        if ((time_budget_us > 0) && (AP_HAL::micros() - start_us >= time_budget_us)) {
+            return true;
+        }
     }
+    _search_in_progress = false;
 
-    // extract path starting from destination
-    bool success = false;
-    node_index nidx;
-    if (!find_node_from_id({AP_OAVisGraph::OATYPE_DESTINATION,0}, nidx)) {
+    // fail if the destination was not reached, leaving any previous path unchanged
+    if ((_short_path_data[dest_node].distance_from_idx == OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) ||
+        (_short_path_data[dest_node].distance_cm >= FLT_MAX)) {
         err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
         return false;
     }
+
+    // extract path starting from destination
+    node_index nidx = dest_node;
     _path_numpoints = 0;
     while (true) {
         if (!_path.expand_to_hold(_path_numpoints + 1)) {
+            _path_numpoints = 0;
             err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_OUT_OF_MEMORY;
             return false;
         }
-        // fail if newest node has invalid distance_from_index
-        if ((_short_path_data[nidx].distance_from_idx == OA_DIJKSTRA_POLYGON_SHORTPATH_NOTSET_IDX) ||
-            (_short_path_data[nidx].distance_cm >= FLT_MAX)) {
-            break;
-        } else {
-            // add node's id to path array
-            _path[_path_numpoints] = _short_path_data[nidx].id;
-            _path_numpoints++;
-
-            // we are done if node is the source
-            if (_short_path_data[nidx].id.id_type == AP_OAVisGraph::OATYPE_SOURCE) {
-                success = true;
-                break;
-            } else {
-                // follow node's "distance_from_idx" to previous node on path
-                nidx = _short_path_data[nidx].distance_from_idx;
-            }
+        // add node's position to path array
+        _path[_path_numpoints] = _short_path_data[nidx].pos;
+        _path_numpoints++;
+
+        // we are done if node is the source
+        if (_short_path_data[nidx].id.id_type == AP_OAVisGraph::OATYPE_SOURCE) {
+            return true;
         }
+        // follow node's "distance_from_idx" to previous node on path
+        nidx = _short_path_data[nidx].distance_from_idx;
     }
-    // report error incase path not found
-    if (!success) {
-        err_id = AP_OADijkstra_Error::DIJKSTRA_ERROR_COULD_NOT_FIND_PATH;
-    }
-
-    return success;
 }
 
-// return point from final path as an offset (in cm) from the ekf origin
-bool AP_OADijkstra::get_shortest_path_point(uint8_t point_num, Vector2f& pos)
+// search for the shortest path from origin to destination (offsets in cm from the EKF origin) around objects which are
+// merged into obstacles as update() merges those from the object database
+// returns the number of points on the path, or zero if no path was found
+uint8_t AP_OADijkstra::search_around_objects(const Obstacle *objects, uint8_t num_objects, const Vector2f &origin, const Vector2f &destination, uint32_t time_budget_us, uint16_t &num_calls)
 {
-    if ((_path_numpoints == 0) || (point_num >= _path_numpoints)) {
-        return false;
+    num_calls = 0;
+    _use_database = true;
+    _shortest_path_ok = false;
+
+    _db_obstacles_num = 0;
+    const uint8_t obstacles_max = get_obstacles_max();
+    for (uint8_t i = 0; (obstacles_max > 0) && (i < num_objects); i++) {
+        add_database_object(objects[i].center_cm, objects[i].radius_cm, obstacles_max);
     }
+    remove_obstacles_covering(origin, destination);
 
-    // get id from path
-    AP_OAVisGraph::OAItemID id = _path[_path_numpoints - point_num - 1];
-
-    return convert_node_to_point(id, pos);
+    AP_OADijkstra_Error err_id;
+    if (!start_shortest_path(origin, destination, err_id)) {
+        return 0;
+    }
+    while (_search_in_progress) {
+        num_calls++;
+        if (!search_shortest_path(time_budget_us, err_id)) {
+            _search_in_progress = false;
+            return 0;
+        }
+    }
+    return _path_numpoints;
 }
 
-// find the position of a node as an offset (in cm) from the ekf origin
-bool AP_OADijkstra::convert_node_to_point(const AP_OAVisGraph::OAItemID& id, Vector2f& pos) const
+// return point from final path as an offset (in cm) from the ekf origin
+bool AP_OADijkstra::get_shortest_path_point(uint8_t point_num, Vector2f& pos) const
 {
-    // convert id to a position offset from EKF origin
-    switch (id.id_type) {
-    case AP_OAVisGraph::OATYPE_SOURCE:
-        pos = _path_source;
-        return true;
-    case AP_OAVisGraph::OATYPE_DESTINATION:
-        pos = _path_destination;
-        return true;
-    case AP_OAVisGraph::OATYPE_INTERMEDIATE_POINT:
-        return get_point(id.id_num, pos);
+    if ((_path_numpoints == 0) || (point_num >= _path_numpoints)) {
+        return false;
     }
 
-    // we should never reach here but just in case
-    return false;
+    // get position from path
+    pos = _path[_path_numpoints - point_num - 1];
+    return true;
 }
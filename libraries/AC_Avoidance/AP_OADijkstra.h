@@ -4,6 +4,9 @@
 #include <AP_Common/Location.h>
 #include <AP_Math/AP_Math.h>
 #include "AP_OAVisGraph.h"
+#include "AP_OASegmentGrid.h"
+
+#define OA_DIJKSTRA_DATABASE_OBSTACLES_MAX  16  // maximum number of circles the object database's objects are merged into
 
 /*
  * Dijkstra's algorithm for path planning around polygon fence
@@ -22,17 +25,38 @@ public:
     // trigger Dijkstra's to recalculate shortest path based on current location 
     void recalculate_path() { _shortest_path_ok = false; }
 
+    // avoid objects in the object database as well as the fence. The search for a path is then spread over
+    // several calls to update and repeated as the objects move
+    void set_use_database(bool use_database) { _use_database = use_database; }
+
     // update return status enum
     enum AP_OADijkstra_State : uint8_t {
         DIJKSTRA_STATE_NOT_REQUIRED = 0,
         DIJKSTRA_STATE_ERROR,
-        DIJKSTRA_STATE_SUCCESS
+        DIJKSTRA_STATE_SUCCESS,
+        DIJKSTRA_STATE_PROCESSING
     };
 
     // calculate a destination to avoid the polygon fence
     // returns DIJKSTRA_STATE_SUCCESS and populates origin_new and destination_new if avoidance is required
+    // returns DIJKSTRA_STATE_PROCESSING if using the object database and no path clear of objects has been found yet
     AP_OADijkstra_State update(const Location &current_loc, const Location &destination, Location& origin_new, Location& destination_new);
 
+    // circle holding one or more objects from the object database
+    struct Obstacle {
+        Vector2f center_cm;     // offset from the EKF origin
+        float radius_cm;
+    };
+
+    // search for the shortest path from origin to destination (offsets in cm from the EKF origin) around objects which are
+    // merged into obstacles as update() merges those from the object database. The search is spread over calls to
+    // search_shortest_path of up to time_budget_us microseconds each (or run to completion if zero) and num_calls is set
+    // to the number of calls taken. Returns the number of points on the path, or zero if no path was found
+    uint8_t search_around_objects(const Obstacle *objects, uint8_t num_objects, const Vector2f &origin, const Vector2f &destination, uint32_t time_budget_us, uint16_t &num_calls);
+
+    // return point from final path as an offset (in cm) from the ekf origin
+    bool get_shortest_path_point(uint8_t point_num, Vector2f& pos) const;
+
 private:
 
     // returns true if at least one inclusion or exclusion zone is enabled
@@ -96,32 +120,82 @@ private:
     // other methods
     //
 
+    // check for fence updates and recreate the fence points with margin and their visibility graph if required
+    // returns true on success.  returns false on failure and err_id is updated
+    bool update_fence(AP_OADijkstra_Error &err_id);
+
     // returns total number of points across all fence types
     uint16_t total_numpoints() const;
 
     // get a single point across the total list of points from all fence types
-    // also returns the type of point
+    // followed by the points around the obstacles used by the current search
     bool get_point(uint16_t index, Vector2f& point) const;
 
     // returns true if line segment intersects polygon or circular fence
     bool intersects_fence(const Vector2f &seg_start, const Vector2f &seg_end) const;
 
+    //
+    // object database methods
+    //
+
+    // merge the objects in the object database into _db_obstacles, ignoring any which cover the vehicle or destination
+    // current_pos and destination are offsets (in cm) from the ekf origin
+    void update_database_obstacles(const Vector2f &current_pos, const Vector2f &destination);
+
+    // remove obstacles from _db_obstacles which cover the vehicle or destination as no path around them can be found
+    void remove_obstacles_covering(const Vector2f &current_pos, const Vector2f &destination);
+
+    // add an object (position and radius in cm) to _db_obstacles, merging it with the closest obstacle if required
+    void add_database_object(const Vector2f &item_pos, float item_radius, uint8_t obstacles_max);
+
+    // maximum number of obstacles, limited so their points stay within the number of nodes supported
+    uint8_t get_obstacles_max() const;
+
+    // returns true if line segment passes through any of num_obstacles obstacles
+    static bool intersects_obstacles(const Obstacle *obstacles, uint8_t num_obstacles, const Vector2f &seg_start, const Vector2f &seg_end);
+
+    // copy _db_obstacles to be used by the next search and create points around them, as if they were exclusion circles
+    void create_obstacle_points();
+
+    // returns true if the remaining part of the current path, starting from position, passes through any of _db_obstacles
+    bool path_blocked_by_obstacles(const Vector2f &position) const;
+
     // create visibility graph for all fence (with margin) points
     // returns true on success.  returns false on failure and err_id is updated
     bool create_fence_visgraph(AP_OADijkstra_Error &err_id);
 
+    // load the inclusion and exclusion polygon edges into _fence_edges
+    // returns true on success.  returns false on failure and err_id is updated
+    bool create_fence_edges(AP_OADijkstra_Error &err_id);
+
+    // index the fence visgraph's items by the fence point at either end
+    // returns true on success, false if out of memory
+    bool index_fence_visgraph();
+
     // calculate shortest path from origin to destination
     // returns true on success.  returns false on failure and err_id is updated
     // requires create_polygon_fence_with_margin and create_polygon_fence_visgraph to have been run
     // resulting path is stored in _shortest_path array as vector offsets from EKF origin
     bool calc_shortest_path(const Location &origin, const Location &destination, AP_OADijkstra_Error &err_id);
 
+    // set up a search for the shortest path from origin to destination which is then run by search_shortest_path
+    // returns true on success.  returns false on failure and err_id is updated
+    bool start_shortest_path(const Location &origin, const Location &destination, AP_OADijkstra_Error &err_id);
+    bool start_shortest_path(const Vector2f &origin, const Vector2f &destination, AP_OADijkstra_Error &err_id);
+
+    // continue the search started by start_shortest_path for up to time_budget_us microseconds (or until complete if zero)
+    // _search_in_progress is cleared once the search is complete and the path has been stored in _path
+    // returns true on success or if the search is incomplete.  returns false on failure and err_id is updated
+    bool search_shortest_path(uint32_t time_budget_us, AP_OADijkstra_Error &err_id);
+
     // shortest path state variables
     bool _inclusion_polygon_with_margin_ok;
     bool _exclusion_polygon_with_margin_ok;
     bool _exclusion_circle_with_margin_ok;
     bool _polyfence_visgraph_ok;
     bool _shortest_path_ok;
+    bool _search_in_progress;       // true if a search has been started by start_shortest_path but not completed
+    bool _fence_enabled = true;     // true if fence is enabled, the fence is ignored when only avoiding database objects
 
     Location _destination_prev;     // destination of previous iterations (used to determine if path should be re-calculated)
     uint8_t _path_idx_returned;     // index into _path array which gives location vehicle should be currently moving towards
@@ -146,6 +220,25 @@ private:
     AP_OAVisGraph _fence_visgraph;          // holds distances between all inclusion/exclusion fence points (with margin)
     AP_OAVisGraph _source_visgraph;         // holds distances from source point to all other nodes
     AP_OAVisGraph _destination_visgraph;    // holds distances from the destination to all other nodes
+    bool _destination_visgraph_ok;          // true if _destination_visgraph is up to date with the fence and _destination_visgraph_pos
+    Vector2f _destination_visgraph_pos;     // destination used to create _destination_visgraph (offset in cm from EKF origin)
+
+    // fence visgraph items involving each fence point. Items for point i are at
+    // _fence_visgraph_items[_fence_visgraph_item_start[i]] up to but not including _fence_visgraph_item_start[i+1]
+    AP_ExpandingArray<uint16_t> _fence_visgraph_item_start;
+    AP_ExpandingArray<uint16_t> _fence_visgraph_items;
+
+    AP_OASegmentGrid _fence_edges;          // inclusion and exclusion polygon edges for checking if segments cross the fence
+
+    // object database related variables
+    bool _use_database;                     // true if avoiding objects in the object database
+    Obstacle _db_obstacles[OA_DIJKSTRA_DATABASE_OBSTACLES_MAX];     // latest objects from the object database
+    uint8_t _db_obstacles_num;              // number of obstacles held in above array
+    Obstacle _search_obstacles[OA_DIJKSTRA_DATABASE_OBSTACLES_MAX]; // obstacles used by the latest search
+    uint8_t _search_obstacles_num;          // number of obstacles held in above array
+    AP_ExpandingArray<Vector2f> _obstacle_pts;  // array of nodes surrounding _search_obstacles plus a margin
+    uint8_t _obstacle_numpoints;            // number of points held in above array
+    uint32_t _search_start_ms;              // system time the latest search was started
 
     // updates visibility graph for a given position which is an offset (in cm) from the ekf origin
     // to add an additional position (i.e. the destination) set add_extra_position = true and provide the position in the extra_position argument
@@ -159,10 +252,34 @@ private:
         bool visited;                   // true if all this node's neighbour's distances have been updated
         node_index distance_from_idx;   // index into _short_path_data from where distance was updated (or 255 if not set)
         float distance_cm;              // distance from source (number is tentative until this node is the current node and/or visited = true)
+        float heuristic_cm;             // straight line distance from node to destination
+        float distance_to_dest_cm;      // distance to destination if visible from this node, FLT_MAX if not
+        node_index heap_idx;            // index into _heap of this node (or 255 if not in the heap)
+        Vector2f pos;                   // position of node as an offset (in cm) from the ekf origin
     };
     AP_ExpandingArray<ShortPathNode> _short_path_data;
     node_index _short_path_data_numpoints;  // number of elements in _short_path_data array
 
+    // binary min-heap of indices into _short_path_data of nodes which have been reached but not visited,
+    // ordered by distance plus heuristic
+    AP_ExpandingArray<node_index> _heap;
+    node_index _heap_numpoints;             // number of elements in _heap array
+
+    // add node to the heap, or move it up if it is already in the heap and its distance has reduced
+    void heap_update(node_index node_idx);
+
+    // move the heap element at heap_pos towards the top or bottom of the heap until it is in order
+    void heap_sift_up(node_index heap_pos);
+    void heap_sift_down(node_index heap_pos);
+
+    // value a node is ordered by in the heap
+    float heap_key(node_index node_idx) const;
+
+    // set a node's distance to distance_cm via from_idx if that is shorter than its current distance
+    // if check_obstacles is true the line between the nodes is checked against the search's obstacles and, if
+    // check_fence is also true, the fence before the distance is updated
+    void update_node_distance(node_index node_idx, node_index from_idx, float distance_cm, bool check_obstacles = false, bool check_fence = false);
+
     // update total distance for all nodes visible from current node
     // curr_node_idx is an index into the _short_path_data array
     void update_visible_node_distances(node_index curr_node_idx);
@@ -171,23 +288,16 @@ private:
     // returns true if successful and node_idx is updated
     bool find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const;
 
-    // find index of node with lowest tentative distance (ignore visited nodes)
+    // find index of node with lowest tentative distance (ignore visited nodes) and remove it from the heap
     // returns true if successful and node_idx argument is updated
-    bool find_closest_node_idx(node_index &node_idx) const;
+    bool find_closest_node_idx(node_index &node_idx);
 
     // final path variables and functions
-    AP_ExpandingArray<AP_OAVisGraph::OAItemID> _path;   // ids of points on return path in reverse order (i.e. destination is first element)
+    AP_ExpandingArray<Vector2f> _path;                  // positions (offsets in cm from EKF origin) of points on return path in reverse order (i.e. destination is first element)
     uint8_t _path_numpoints;                            // number of points on return path
     Vector2f _path_source;                              // source point used in shortest path calculations (offset in cm from EKF origin)
     Vector2f _path_destination;                         // destination position used in shortest path calculations (offset in cm from EKF origin)
 
-    // return point from final path as an offset (in cm) from the ekf origin
-    bool get_shortest_path_point(uint8_t point_num, Vector2f& pos);
-
-    // find the position of a node as an offset (in cm) from the ekf origin
-    // returns true if successful and pos is updated
-    bool convert_node_to_point(const AP_OAVisGraph::OAItemID& id, Vector2f& pos) const;
-
     AP_OADijkstra_Error _error_last_id;                 // last error id sent to GCS
     uint32_t _error_last_report_ms;                     // last time an error message was sent to GCS
 
@@ -28,6 +28,7 @@ const float OA_MARGIN_MAX_DEFAULT = 5;
 const int16_t OA_OPTIONS_DEFAULT = 1;
 
 const int16_t OA_UPDATE_MS = 1000;      // path planning updates run at 1hz
+const int16_t OA_DATABASE_UPDATE_MS = 100;  // path planning updates run at 10hz when Dijkstra's is avoiding database objects
 const int16_t OA_TIMEOUT_MS = 3000;     // results over 3 seconds old are ignored
 
 const AP_Param::GroupInfo AP_OAPathPlanner::var_info[] = {
@@ -35,7 +36,7 @@ const AP_Param::GroupInfo AP_OAPathPlanner::var_info[] = {
     // @Param: TYPE
     // @DisplayName: Object Avoidance Path Planning algorithm to use
     // @Description: Enabled/disable path planning around obstacles
-    // @Values: 0:Disabled,1:BendyRuler,2:Dijkstra,3:Dijkstra with BendyRuler
+    // @Values: 0:Disabled,1:BendyRuler,2:Dijkstra,3:Dijkstra with BendyRuler,4:Dijkstra with object database
     // @User: Standard
     AP_GROUPINFO_FLAGS("TYPE", 1,  AP_OAPathPlanner, _type, OA_PATHPLAN_DISABLED, AP_PARAM_FLAG_ENABLE),
 
@@ -97,6 +98,14 @@ void AP_OAPathPlanner::init()
             _oadijkstra = new AP_OADijkstra(_options);
         }
         break;
+    case OA_PATHPLAN_DIJKSTRA_DATABASE:
+        if (_oadijkstra == nullptr) {
+            _oadijkstra = new AP_OADijkstra(_options);
+        }
+        if (_oadijkstra != nullptr) {
+            _oadijkstra->set_use_database(true);
+        }
+        break;
     case OA_PATHPLAN_DJIKSTRA_BENDYRULER:
         if (_oadijkstra == nullptr) {
             _oadijkstra = new AP_OADijkstra(_options);
@@ -127,6 +136,7 @@ bool AP_OAPathPlanner::pre_arm_check(char *failure_msg, uint8_t failure_msg_len)
         }
         break;
     case OA_PATHPLAN_DIJKSTRA:
+    case OA_PATHPLAN_DIJKSTRA_DATABASE:
         if (_oadijkstra == nullptr) {
             hal.util->snprintf(failure_msg, failure_msg_len, "Dijkstra OA requires reboot");
             return false;
@@ -181,6 +191,24 @@ AP_OAPathPlanner::OAPathPlannerUsed AP_OAPathPlanner::map_bendytype_to_pathplann
     }
 }
 
+// helper function to map AP_OADijkstra_State to OA_RetState
+AP_OAPathPlanner::OA_RetState AP_OAPathPlanner::map_dijkstra_state_to_retstate(AP_OADijkstra::AP_OADijkstra_State dijkstra_state)
+{
+    switch (dijkstra_state) {
+    case AP_OADijkstra::DIJKSTRA_STATE_NOT_REQUIRED:
+        return OA_NOT_REQUIRED;
+    case AP_OADijkstra::DIJKSTRA_STATE_ERROR:
+        return OA_ERROR;
+    case AP_OADijkstra::DIJKSTRA_STATE_SUCCESS:
+        return OA_SUCCESS;
+    case AP_OADijkstra::DIJKSTRA_STATE_PROCESSING:
+        return OA_PROCESSING;
+    }
+
+    // we should never reach here but just in case
+    return OA_ERROR;
+}
+
 // provides an alternative target location if path planning around obstacles is required
 // returns true and updates result_loc with an intermediate location
 AP_OAPathPlanner::OA_RetState AP_OAPathPlanner::mission_avoidance(const Location &current_loc,
@@ -252,8 +280,10 @@ void AP_OAPathPlanner::avoidance_thread()
             hal.scheduler->delay(20);
         }
 
+        // Dijkstra's spreads its search over several updates when avoiding database objects so runs more often
         const uint32_t now = AP_HAL::millis();
-        if (now - avoidance_latest_ms < OA_UPDATE_MS) {
+        const uint32_t update_ms = (_type == OA_PATHPLAN_DIJKSTRA_DATABASE) ? OA_DATABASE_UPDATE_MS : OA_UPDATE_MS;
+        if (now - avoidance_latest_ms < update_ms) {
             continue;
         }
         avoidance_latest_ms = now;
@@ -297,23 +327,14 @@ void AP_OAPathPlanner::avoidance_thread()
             break;
         }
 
-        case OA_PATHPLAN_DIJKSTRA: {
+        case OA_PATHPLAN_DIJKSTRA:
+        case OA_PATHPLAN_DIJKSTRA_DATABASE: {
             if (_oadijkstra == nullptr) {
                 continue;
             }
             _oadijkstra->set_fence_margin(_margin_max);
             const AP_OADijkstra::AP_OADijkstra_State dijkstra_state = _oadijkstra->update(avoidance_request2.current_loc, avoidance_request2.destination, origin_new, destination_new);
-            switch (dijkstra_state) {
-            case AP_OADijkstra::DIJKSTRA_STATE_NOT_REQUIRED:
-                res = OA_NOT_REQUIRED;
-                break;
-            case AP_OADijkstra::DIJKSTRA_STATE_ERROR:
-                res = OA_ERROR;
-                break;
-            case AP_OADijkstra::DIJKSTRA_STATE_SUCCESS:
-                res = OA_SUCCESS;
-                break;
-            }
+            res = map_dijkstra_state_to_retstate(dijkstra_state);
             path_planner_used = OAPathPlannerUsed::Dijkstras;
             break;
         }
@@ -340,17 +361,7 @@ void AP_OAPathPlanner::avoidance_thread()
             }
             _oadijkstra->set_fence_margin(_margin_max);
             const AP_OADijkstra::AP_OADijkstra_State dijkstra_state = _oadijkstra->update(avoidance_request2.current_loc, avoidance_request2.destination, origin_new, destination_new);
-            switch (dijkstra_state) {
-            case AP_OADijkstra::DIJKSTRA_STATE_NOT_REQUIRED:
-                res = OA_NOT_REQUIRED;
-                break;
-            case AP_OADijkstra::DIJKSTRA_STATE_ERROR:
-                res = OA_ERROR;
-                break;
-            case AP_OADijkstra::DIJKSTRA_STATE_SUCCESS:
-                res = OA_SUCCESS;
-                break;
-            }
+            res = map_dijkstra_state_to_retstate(dijkstra_state);
             path_planner_used = OAPathPlannerUsed::Dijkstras;
             break;
         }
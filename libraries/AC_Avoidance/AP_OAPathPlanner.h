@@ -64,6 +64,7 @@ public:
         OA_PATHPLAN_BENDYRULER = 1,
         OA_PATHPLAN_DIJKSTRA = 2,
         OA_PATHPLAN_DJIKSTRA_BENDYRULER = 3,
+        OA_PATHPLAN_DIJKSTRA_DATABASE = 4,
     };
 
     // enumeration for _OPTION parameter
@@ -86,6 +87,9 @@ private:
     // helper function to map OABendyType to OAPathPlannerUsed
     OAPathPlannerUsed map_bendytype_to_pathplannerused(AP_OABendyRuler::OABendyType bendy_type);
 
+    // helper function to map AP_OADijkstra_State to OA_RetState
+    OA_RetState map_dijkstra_state_to_retstate(AP_OADijkstra::AP_OADijkstra_State dijkstra_state);
+
     // an avoidance request from the navigation code
     struct avoidance_info {
         Location current_loc;
@@ -0,0 +1,303 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_OASegmentGrid.h"
+
+#define OA_SEGMENT_GRID_EDGES_PER_CELL      8       // grid is coarsened until cells hold no more than this many edges on average
+#define OA_SEGMENT_GRID_CELL_MARGIN         0.01f   // edges are added to cells they come within this fraction of a cell width of
+
+AP_OASegmentGrid::~AP_OASegmentGrid()
+{
+    delete[] _edges;
+    delete[] _cell_start;
+    delete[] _cell_edges;
+}
+
+// remove all edges
+void AP_OASegmentGrid::clear()
+{
+    _num_edges = 0;
+    _built = false;
+}
+
+// add the edges of a polygon. build() must be called after all polygons have been added
+bool AP_OASegmentGrid::add_polygon(const Vector2f *points, uint16_t num_points)
+{
+    _built = false;
+    if ((points == nullptr) || (num_points < 2)) {
+        return true;
+    }
+
+    // treat a closed polygon as if the last point wasn't passed in, as Polygon_intersects does
+    if (Polygon_complete(points, num_points)) {
+        num_points--;
+    }
+
+    // grow the edge array if necessary
+    const uint32_t required = (uint32_t)_num_edges + num_points;
+    if (required > UINT16_MAX) {
+        return false;
+    }
+    if (required > _max_edges) {
+        Edge *new_edges = new Edge[required];
+        if (new_edges == nullptr) {
+            return false;
+        }
+        for (uint16_t i = 0; i < _num_edges; i++) {
+            new_edges[i] = _edges[i];
+        }
+        delete[] _edges;
+        _edges = new_edges;
+        _max_edges = required;
+    }
+
+    for (uint16_t i = 0; i < num_points; i++) {
+        const uint16_t j = (i + 1 < num_points) ? i + 1 : 0;
+        _edges[_num_edges++] = {points[i], points[j]};
+    }
+    return true;
+}
+
+// cell holding a position
+uint16_t AP_OASegmentGrid::cell_x(float x) const
+{
+    return constrain_float(floorf((x - _origin.x) / _cell_size), 0, _cells_x - 1);
+}
+uint16_t AP_OASegmentGrid::cell_y(float y) const
+{
+    return constrain_float(floorf((y - _origin.y) / _cell_size), 0, _cells_y - 1);
+}
+
+// range of cells covered by the box around an edge, expanded slightly so an edge which lies along a cell
+// boundary, or crosses a segment close to one, is in the cells on both sides
+void AP_OASegmentGrid::edge_cells(const Edge &edge, uint16_t &x_lo, uint16_t &x_hi, uint16_t &y_lo, uint16_t &y_hi) const
+{
+    const float margin = _cell_size * OA_SEGMENT_GRID_CELL_MARGIN;
+    x_lo = cell_x(MIN(edge.start.x, edge.end.x) - margin);
+    x_hi = cell_x(MAX(edge.start.x, edge.end.x) + margin);
+    y_lo = cell_y(MIN(edge.start.y, edge.end.y) - margin);
+    y_hi = cell_y(MAX(edge.start.y, edge.end.y) + margin);
+}
+
+// place the edges in the grid
+bool AP_OASegmentGrid::build()
+{
+    _built = false;
+    if (_num_edges == 0) {
+        _built = true;
+        return true;
+    }
+
+    // find the extent of the edges
+    Vector2f lo = _edges[0].start;
+    Vector2f hi = _edges[0].start;
+    for (uint16_t i = 0; i < _num_edges; i++) {
+        lo.x = MIN(lo.x, MIN(_edges[i].start.x, _edges[i].end.x));
+        lo.y = MIN(lo.y, MIN(_edges[i].start.y, _edges[i].end.y));
+        hi.x = MAX(hi.x, MAX(_edges[i].start.x, _edges[i].end.x));
+        hi.y = MAX(hi.y, MAX(_edges[i].start.y, _edges[i].end.y));
+    }
+    const float width = MAX(hi.x - lo.x, 1.0f);
+    const float height = MAX(hi.y - lo.y, 1.0f);
+    _origin = lo;
+
+    // start with about one cell per edge. Long edges cross many cells so coarsen the grid until the edges
+    // are not spread over too many cells
+    float cell_size = MAX(sqrtf(width * height / _num_edges), MAX(width, height) / _num_edges);
+    uint32_t num_cell_edges;
+    while (true) {
+        _cell_size = cell_size;
+        _cells_x = MIN(width / cell_size + 1, UINT8_MAX);
+        _cells_y = MIN(height / cell_size + 1, UINT8_MAX);
+        if ((_cells_x == UINT8_MAX) || (_cells_y == UINT8_MAX)) {
+            cell_size *= 2.0f;
+            continue;
+        }
+        num_cell_edges = 0;
+        for (uint16_t i = 0; i < _num_edges; i++) {
+            uint16_t x_lo, x_hi, y_lo, y_hi;
+            edge_cells(_edges[i], x_lo, x_hi, y_lo, y_hi);
+            num_cell_edges += (uint32_t)(x_hi - x_lo + 1) * (y_hi - y_lo + 1);
+        }
+        if (((_cells_x == 1) && (_cells_y == 1)) ||
+            ((num_cell_edges <= (uint32_t)OA_SEGMENT_GRID_EDGES_PER_CELL * _cells_x * _cells_y) && (num_cell_edges <= UINT16_MAX))) {
+            break;
+        }
+        cell_size *= 2.0f;
+    }
+    if (num_cell_edges > UINT16_MAX) {
+        // only possible with a single cell and more edges than can be held
+        return false;
+    }
+
+    // allocate cell arrays
+    const uint16_t num_cells = _cells_x * _cells_y;
+    delete[] _cell_start;
+    delete[] _cell_edges;
+    _cell_start = new uint16_t[num_cells + 1];
+    _cell_edges = new uint16_t[num_cell_edges];
+    if ((_cell_start == nullptr) || (_cell_edges == nullptr)) {
+        delete[] _cell_start;
+        delete[] _cell_edges;
+        _cell_start = nullptr;
+        _cell_edges = nullptr;
+        return false;
+    }
+
+    // count the edges in each cell then convert the counts to start positions
+    memset(_cell_start, 0, sizeof(uint16_t) * (num_cells + 1));
+    for (uint16_t i = 0; i < _num_edges; i++) {
+        uint16_t x_lo, x_hi, y_lo, y_hi;
+        edge_cells(_edges[i], x_lo, x_hi, y_lo, y_hi);
+        for (uint16_t x = x_lo; x <= x_hi; x++) {
+            for (uint16_t y = y_lo; y <= y_hi; y++) {
+                _cell_start[y * _cells_x + x + 1]++;
+            }
+        }
+    }
+    for (uint16_t c = 0; c < num_cells; c++) {
+        _cell_start[c + 1] += _cell_start[c];
+    }
+
+    // fill in the edges of each cell using its start as the write position, which leaves it at the start of
+    // the following cell, then move the starts back
+    for (uint16_t i = 0; i < _num_edges; i++) {
+        uint16_t x_lo, x_hi, y_lo, y_hi;
+        edge_cells(_edges[i], x_lo, x_hi, y_lo, y_hi);
+        for (uint16_t x = x_lo; x <= x_hi; x++) {
+            for (uint16_t y = y_lo; y <= y_hi; y++) {
+                _cell_edges[_cell_start[y * _cells_x + x]++] = i;
+            }
+        }
+    }
+    for (uint16_t c = num_cells; c > 0; c--) {
+        _cell_start[c] = _cell_start[c - 1];
+    }
+    _cell_start[0] = 0;
+
+    _built = true;
+    return true;
+}
+
+// returns true if the line segment crosses any edge in cell x,y
+bool AP_OASegmentGrid::intersects_in_cell(uint16_t x, uint16_t y, const Vector2f &seg_start, const Vector2f &seg_end) const
+{
+    const uint16_t c = y * _cells_x + x;
+    for (uint16_t k = _cell_start[c]; k < _cell_start[c + 1]; k++) {
+        const Edge &e = _edges[_cell_edges[k]];
+        Vector2f intersection;
+        if (Vector2f::segment_intersection(e.start, e.end, seg_start, seg_end, intersection)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// returns true if the line segment from seg_start to seg_end crosses any edge
+bool AP_OASegmentGrid::intersects(const Vector2f &seg_start, const Vector2f &seg_end) const
+{
+    if (_num_edges == 0) {
+        return false;
+    }
+
+    if (!_built) {
+        // check every edge
+        for (uint16_t i = 0; i < _num_edges; i++) {
+            Vector2f intersection;
+            if (Vector2f::segment_intersection(_edges[i].start, _edges[i].end, seg_start, seg_end, intersection)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // clip the segment to the grid, nothing outside the grid can cross an edge
+    const Vector2f grid_lo = _origin;
+    const Vector2f grid_hi = _origin + Vector2f(_cells_x * _cell_size, _cells_y * _cell_size);
+    const Vector2f delta = seg_end - seg_start;
+    float t_start = 0.0f;
+    float t_end = 1.0f;
+    for (uint8_t axis = 0; axis < 2; axis++) {
+        const float p = seg_start[axis];
+        const float d = delta[axis];
+        if (is_zero(d)) {
+            if ((p < grid_lo[axis]) || (p > grid_hi[axis])) {
+                return false;
+            }
+            continue;
+        }
+        float t_lo = (grid_lo[axis] - p) / d;
+        float t_hi = (grid_hi[axis] - p) / d;
+        if (t_lo > t_hi) {
+            const float tmp = t_lo;
+            t_lo = t_hi;
+            t_hi = tmp;
+        }
+        t_start = MAX(t_start, t_lo);
+        t_end = MIN(t_end, t_hi);
+        if (t_start > t_end) {
+            return false;
+        }
+    }
+    const Vector2f clip_start = seg_start + delta * t_start;
+    const Vector2f clip_end = seg_start + delta * t_end;
+
+    // walk along the cells the clipped segment passes through
+    uint16_t x = cell_x(clip_start.x);
+    uint16_t y = cell_y(clip_start.y);
+    const uint16_t x_end = cell_x(clip_end.x);
+    const uint16_t y_end = cell_y(clip_end.y);
+
+    const Vector2f clip_delta = clip_end - clip_start;
+    const int8_t step_x = (clip_delta.x > 0) ? 1 : -1;
+    const int8_t step_y = (clip_delta.y > 0) ? 1 : -1;
+    // distance along the clipped segment, as a fraction of its length, to the next cell boundary on each axis
+    // and between boundaries
+    float t_next_x = FLT_MAX, t_step_x = FLT_MAX;
+    float t_next_y = FLT_MAX, t_step_y = FLT_MAX;
+    if (!is_zero(clip_delta.x)) {
+        const float boundary = _origin.x + (x + (step_x > 0 ? 1 : 0)) * _cell_size;
+        t_next_x = (boundary - clip_start.x) / clip_delta.x;
+        t_step_x = _cell_size / fabsf(clip_delta.x);
+    }
+    if (!is_zero(clip_delta.y)) {
+        const float boundary = _origin.y + (y + (step_y > 0 ? 1 : 0)) * _cell_size;
+        t_next_y = (boundary - clip_start.y) / clip_delta.y;
+        t_step_y = _cell_size / fabsf(clip_delta.y);
+    }
+
+    for (uint16_t n = 0; n < _cells_x + _cells_y; n++) {
+        if (intersects_in_cell(x, y, seg_start, seg_end)) {
+            return true;
+        }
+        if ((x == x_end) && (y == y_end)) {
+            break;
+        }
+        if (t_next_x < t_next_y) {
+            if ((step_x < 0) ? (x == 0) : (x == _cells_x - 1)) {
+                break;
+            }
+            x += step_x;
+            t_next_x += t_step_x;
+        } else {
+            if ((step_y < 0) ? (y == 0) : (y == _cells_y - 1)) {
+                break;
+            }
+            y += step_y;
+            t_next_y += t_step_y;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+/*
+ * Polygon fence edges held in a uniform grid so a line segment can be checked for crossing the fence by
+ * looking only at the edges in the grid cells it passes through, rather than at every edge of every polygon
+ */
+class AP_OASegmentGrid {
+public:
+    AP_OASegmentGrid() {}
+    ~AP_OASegmentGrid();
+
+    CLASS_NO_COPY(AP_OASegmentGrid);  /* Do not allow copies */
+
+    // remove all edges
+    void clear();
+
+    // add the edges of a polygon of num_points points, which may or may not be closed. build() must be
+    // called after all polygons have been added. Returns false if out of memory
+    bool add_polygon(const Vector2f *points, uint16_t num_points);
+
+    // place the edges in the grid. Returns false if out of memory
+    bool build();
+
+    // number of edges held
+    uint16_t num_edges() const { return _num_edges; }
+
+    // returns true if the line segment from seg_start to seg_end crosses any edge. Gives the same result as
+    // calling Polygon_intersects() on each polygon
+    bool intersects(const Vector2f &seg_start, const Vector2f &seg_end) const;
+
+private:
+
+    struct Edge {
+        Vector2f start;
+        Vector2f end;
+    };
+
+    // returns true if the line segment crosses any edge in cell x,y
+    bool intersects_in_cell(uint16_t x, uint16_t y, const Vector2f &seg_start, const Vector2f &seg_end) const;
+
+    // cell holding a position, clamped to the grid
+    uint16_t cell_x(float x) const;
+    uint16_t cell_y(float y) const;
+
+    // range of cells an edge is placed in
+    void edge_cells(const Edge &edge, uint16_t &x_lo, uint16_t &x_hi, uint16_t &y_lo, uint16_t &y_hi) const;
+
+    Edge *_edges = nullptr;         // all edges
+    uint16_t _num_edges = 0;        // number of edges in use
+    uint16_t _max_edges = 0;        // size of _edges array
+
+    uint16_t *_cell_start = nullptr;// index into _cell_edges of the first edge in each cell, plus one past the last cell
+    uint16_t *_cell_edges = nullptr;// edges in each cell one after the other
+    uint16_t _cells_x = 0;          // number of cells along the x axis
+    uint16_t _cells_y = 0;          // number of cells along the y axis
+    Vector2f _origin;               // lower corner of the grid
+    float _cell_size = 0;           // width of each cell
+    bool _built = false;            // true once build() has placed the edges in the grid
+};
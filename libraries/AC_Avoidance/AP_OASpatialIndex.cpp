@@ -0,0 +1,132 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_OASpatialIndex.h"
+
+const uint16_t AP_OASpatialIndex::END;
+
+AP_OASpatialIndex::~AP_OASpatialIndex()
+{
+    delete[] _head;
+    delete[] _next;
+}
+
+// allocate memory for up to max_items items in cells of cell_size meters. Returns false on failure
+bool AP_OASpatialIndex::init(uint16_t max_items, float cell_size)
+{
+    delete[] _head;
+    delete[] _next;
+    _head = nullptr;
+    _next = nullptr;
+
+    if ((max_items == 0) || (max_items == END) || !is_positive(cell_size)) {
+        return false;
+    }
+
+    // at least one bucket per item so buckets rarely hold more than one cell
+    uint16_t num_buckets = 16;
+    while ((num_buckets < max_items) && (num_buckets < 0x8000)) {
+        num_buckets <<= 1;
+    }
+
+    _head = new uint16_t[num_buckets];
+    _next = new uint16_t[max_items];
+    if ((_head == nullptr) || (_next == nullptr)) {
+        delete[] _head;
+        delete[] _next;
+        _head = nullptr;
+        _next = nullptr;
+        return false;
+    }
+    _num_buckets = num_buckets;
+    _max_items = max_items;
+    _cell_size_inv = 1.0f / cell_size;
+    clear();
+    return true;
+}
+
+// remove all items
+void AP_OASpatialIndex::clear()
+{
+    if (!initialised()) {
+        return;
+    }
+    for (uint16_t i = 0; i < _num_buckets; i++) {
+        _head[i] = END;
+    }
+    for (uint16_t i = 0; i < _max_items; i++) {
+        _next[i] = END;
+    }
+}
+
+// add item index at pos
+void AP_OASpatialIndex::add(uint16_t index, const Vector3f &pos)
+{
+    if (!initialised() || (index >= _max_items)) {
+        return;
+    }
+    const uint16_t b = bucket(pos);
+    _next[index] = _head[b];
+    _head[b] = index;
+}
+
+// remove item index which was added at pos
+void AP_OASpatialIndex::remove(uint16_t index, const Vector3f &pos)
+{
+    if (!initialised() || (index >= _max_items)) {
+        return;
+    }
+    unlink(bucket(pos), index);
+}
+
+// renumber the item at pos from index from to index to
+void AP_OASpatialIndex::move(uint16_t from, uint16_t to, const Vector3f &pos)
+{
+    if (!initialised() || (from >= _max_items) || (to >= _max_items) || (from == to)) {
+        return;
+    }
+    const uint16_t b = bucket(pos);
+    unlink(b, from);
+    _next[to] = _head[b];
+    _head[b] = to;
+}
+
+// remove index from a bucket's list
+void AP_OASpatialIndex::unlink(uint16_t bucket_index, uint16_t index)
+{
+    uint16_t *link = &_head[bucket_index];
+    while (*link != END) {
+        if (*link == index) {
+            *link = _next[index];
+            _next[index] = END;
+            return;
+        }
+        link = &_next[*link];
+    }
+}
+
+// number of cells in the range of cells from lo to hi inclusive, saturating rather than overflowing
+uint32_t AP_OASpatialIndex::num_cells(int32_t x_lo, int32_t x_hi, int32_t y_lo, int32_t y_hi)
+{
+    if ((x_hi < x_lo) || (y_hi < y_lo)) {
+        return 0;
+    }
+    const uint64_t x_cells = (uint64_t)((int64_t)x_hi - x_lo) + 1;
+    const uint64_t y_cells = (uint64_t)((int64_t)y_hi - y_lo) + 1;
+    if (y_cells > UINT32_MAX / x_cells) {
+        return UINT32_MAX;
+    }
+    return (uint32_t)(x_cells * y_cells);
+}
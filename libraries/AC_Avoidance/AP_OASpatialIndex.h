@@ -0,0 +1,73 @@
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+/*
+ * Uniform grid over the horizontal plane used by the object database to find items near a point or path
+ * without looking at every item. Items are identified by their index in the caller's array and are linked
+ * into the bucket of the grid cell holding their North-East position. Cells are hashed into a fixed number of
+ * buckets so the grid is unbounded, which means a bucket can also hold items from far away cells and callers
+ * must still check the distance to each item returned
+ */
+class AP_OASpatialIndex {
+public:
+    AP_OASpatialIndex() {}
+    ~AP_OASpatialIndex();
+
+    CLASS_NO_COPY(AP_OASpatialIndex);  /* Do not allow copies */
+
+    // value returned by first() and next() when there are no more items
+    static const uint16_t END = UINT16_MAX;
+
+    // allocate memory for up to max_items items in cells of cell_size meters. Returns false on failure
+    bool init(uint16_t max_items, float cell_size);
+
+    // returns true if init has succeeded
+    bool initialised() const { return _next != nullptr; }
+
+    // remove all items
+    void clear();
+
+    // add item index at pos. Only the x and y (North and East) axes of pos are used
+    void add(uint16_t index, const Vector3f &pos);
+
+    // remove item index which was added at pos
+    void remove(uint16_t index, const Vector3f &pos);
+
+    // renumber the item at pos from index from to index to. to must not be in use
+    void move(uint16_t from, uint16_t to, const Vector3f &pos);
+
+    // cell holding a position along one axis
+    int32_t cell(float pos) const { return (int32_t)floorf(pos * _cell_size_inv); }
+
+    // number of cells in the range of cells from lo to hi inclusive, saturating rather than overflowing
+    static uint32_t num_cells(int32_t x_lo, int32_t x_hi, int32_t y_lo, int32_t y_hi);
+
+    // returns true if looking through the cells in a range is quicker than looking through every bucket
+    bool worth_searching(int32_t x_lo, int32_t x_hi, int32_t y_lo, int32_t y_hi) const {
+        return num_cells(x_lo, x_hi, y_lo, y_hi) < _num_buckets;
+    }
+
+    // first item in the bucket holding cell x,y or END if it is empty. May also return items from other cells
+    uint16_t first(int32_t x, int32_t y) const { return _head[bucket(x, y)]; }
+
+    // next item in the same bucket as index or END
+    uint16_t next(uint16_t index) const { return _next[index]; }
+
+private:
+
+    uint16_t bucket(int32_t x, int32_t y) const {
+        return (uint16_t)(((uint32_t)x * 73856093U) ^ ((uint32_t)y * 19349663U)) & (_num_buckets - 1);
+    }
+    uint16_t bucket(const Vector3f &pos) const { return bucket(cell(pos.x), cell(pos.y)); }
+
+    // remove index from a bucket's list
+    void unlink(uint16_t bucket_index, uint16_t index);
+
+    uint16_t *_head = nullptr;  // first item in each bucket
+    uint16_t *_next = nullptr;  // next item in the same bucket as each item
+    uint16_t _num_buckets;      // number of buckets, always a power of two
+    uint16_t _max_items;        // size of _next array
+    float _cell_size_inv;       // inverse of the cell size in meters
+};
@@ -0,0 +1,110 @@
+#include <AP_gbenchmark.h>
+
+#include <AC_Avoidance/AP_OASegmentGrid.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  a 200 point inclusion fence 2km across with eight exclusion zones
+  inside it, in cm as Dijkstra's uses them. Building the fence
+  visibility graph checks every pair of points against the fence
+ */
+static const uint16_t inclusion_points = 200;
+static const uint8_t exclusion_polygons = 8;
+static const uint8_t exclusion_points = 8;
+
+struct SyntheticFence {
+    Vector2f inclusion[inclusion_points];
+    Vector2f exclusion[exclusion_polygons][exclusion_points];
+
+    SyntheticFence() {
+        for (uint16_t i = 0; i < inclusion_points; i++) {
+            const float angle = M_2PI * i / inclusion_points;
+            // wobble the boundary so points are not all visible from each other
+            const float radius = 100000 * (0.85f + 0.15f * sinf(7 * angle));
+            inclusion[i] = Vector2f(cosf(angle), sinf(angle)) * radius;
+        }
+        for (uint8_t p = 0; p < exclusion_polygons; p++) {
+            const float angle = M_2PI * p / exclusion_polygons;
+            const Vector2f centre = Vector2f(cosf(angle), sinf(angle)) * 45000;
+            for (uint8_t i = 0; i < exclusion_points; i++) {
+                const float a = M_2PI * i / exclusion_points;
+                exclusion[p][i] = centre + Vector2f(cosf(a), sinf(a)) * 8000;
+            }
+        }
+    }
+
+    // fence point by index over all polygons
+    const Vector2f &point(uint16_t i) const {
+        if (i < inclusion_points) {
+            return inclusion[i];
+        }
+        i -= inclusion_points;
+        return exclusion[i / exclusion_points][i % exclusion_points];
+    }
+    uint16_t num_points() const { return inclusion_points + exclusion_polygons * exclusion_points; }
+};
+
+static const SyntheticFence fence;
+
+// visibility between all pairs of fence points checking every polygon edge
+static void BM_FenceVisgraphPolygonIntersects(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        uint32_t visible = 0;
+        for (uint16_t i = 0; i < fence.num_points() - 1; i++) {
+            for (uint16_t j = i + 1; j < fence.num_points(); j++) {
+                Vector2f intersection;
+                bool crosses = Polygon_intersects(fence.inclusion, inclusion_points, fence.point(i), fence.point(j), intersection);
+                for (uint8_t p = 0; (p < exclusion_polygons) && !crosses; p++) {
+                    crosses = Polygon_intersects(fence.exclusion[p], exclusion_points, fence.point(i), fence.point(j), intersection);
+                }
+                visible += crosses ? 0 : 1;
+            }
+        }
+        gbenchmark_escape(&visible);
+    }
+}
+
+// visibility between all pairs of fence points using the grid of edges
+static void BM_FenceVisgraphSegmentGrid(benchmark::State& state)
+{
+    AP_OASegmentGrid grid;
+    grid.add_polygon(fence.inclusion, inclusion_points);
+    for (uint8_t p = 0; p < exclusion_polygons; p++) {
+        grid.add_polygon(fence.exclusion[p], exclusion_points);
+    }
+    grid.build();
+
+    while (state.KeepRunning()) {
+        uint32_t visible = 0;
+        for (uint16_t i = 0; i < fence.num_points() - 1; i++) {
+            for (uint16_t j = i + 1; j < fence.num_points(); j++) {
+                visible += grid.intersects(fence.point(i), fence.point(j)) ? 0 : 1;
+            }
+        }
+        gbenchmark_escape(&visible);
+    }
+}
+
+// loading the fence into the grid, done whenever the fence changes
+static void BM_SegmentGridBuild(benchmark::State& state)
+{
+    AP_OASegmentGrid grid;
+
+    while (state.KeepRunning()) {
+        grid.clear();
+        grid.add_polygon(fence.inclusion, inclusion_points);
+        for (uint8_t p = 0; p < exclusion_polygons; p++) {
+            grid.add_polygon(fence.exclusion[p], exclusion_points);
+        }
+        grid.build();
+        gbenchmark_escape(&grid);
+    }
+}
+
+BENCHMARK(BM_FenceVisgraphPolygonIntersects);
+BENCHMARK(BM_FenceVisgraphSegmentGrid);
+BENCHMARK(BM_SegmentGridBuild);
+
+BENCHMARK_MAIN();
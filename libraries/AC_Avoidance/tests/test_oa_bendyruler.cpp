@@ -0,0 +1,69 @@
+#include <AP_gtest.h>
+#include <AP_gtest_random.h>
+
+#include <AC_Avoidance/AP_OABendyRuler.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// margins from inclusion and exclusion polygons, closed and not, checked against Polygon_closest_distance_line()
+// on random paths. Paths start near and far from the polygons and some already have a smaller margin from
+// another obstacle, so edges are skipped in different ways
+TEST(AP_OABendyRuler, polygon_margins_match_closest_distance_line)
+{
+    const float fence_margin = 2.0f;
+    AP_OABendyRuler::ProbeBatch batch;
+
+    static const uint8_t num_polygons = 4;
+    static const uint16_t num_points[num_polygons] = { 200, 201, 8, 13 };
+    static const bool inclusion[num_polygons] = { true, true, false, false };
+    Vector2f polygons[num_polygons][201];
+    for (uint8_t p = 0; p < num_polygons; p++) {
+        const Vector2f centre = inclusion[p] ? Vector2f() : Vector2f(test_rand(20000), test_rand(20000));
+        const float radius = inclusion[p] ? 30000 : 2000 + fabsf(test_rand(3000));
+        const bool closed = (p % 2) == 1;
+        make_star_polygon(polygons[p], closed ? num_points[p] - 1 : num_points[p], centre, 0.6f * radius, radius, closed);
+    }
+
+    uint32_t num_crossing = 0;
+    uint32_t num_paths = 0;
+    for (uint16_t n = 0; n < 3000; n++) {
+        const uint8_t p = n % num_polygons;
+        const Vector2f *boundary = polygons[p];
+
+        // start near a polygon point or anywhere, including outside the inclusion polygons
+        Vector2f start;
+        if (n % 3 == 0) {
+            start = boundary[n % num_points[p]] + Vector2f(test_rand(1500), test_rand(1500));
+        } else {
+            start = Vector2f(test_rand(35000), test_rand(35000));
+        }
+        const float length = (n % 5 == 0) ? 20000 : 500 + fabsf(test_rand(3000));
+
+        batch.init(Vector3f(start.x, start.y, 0));
+        float expected[OA_BENDYRULER_PROBES_MAX];
+        const bool start_outside = Polygon_outside(start, boundary, num_points[p]);
+        const float sign = (inclusion[p] != start_outside) ? 1.0f : -1.0f;
+        while (batch.num < OA_BENDYRULER_PROBES_MAX) {
+            const float bearing = test_rand(M_PI);
+            const Vector2f end = start + Vector2f(cosf(bearing), sinf(bearing)) * (length * (0.5f + 0.5f * fabsf(test_rand(1.0f))));
+            const float margin_before = (n % 2 == 0) ? FLT_MAX : test_rand(50);
+            ASSERT_TRUE(batch.add(Vector3f(end.x, end.y, 0)));
+            batch.margin[batch.num - 1] = margin_before;
+
+            const float dist = Polygon_closest_distance_line(boundary, num_points[p], start, end);
+            expected[batch.num - 1] = MIN(margin_before, (sign * dist * 0.01f) - fence_margin);
+            num_crossing += (dist < 0) ? 1 : 0;
+        }
+
+        AP_OABendyRuler::calc_margins_from_polygon(batch, boundary, num_points[p], inclusion[p], fence_margin);
+        for (uint8_t k = 0; k < batch.num; k++) {
+            EXPECT_NEAR(expected[k], batch.margin[k], 0.01f);
+            num_paths++;
+        }
+    }
+    // check paths which cross the polygons were tested
+    EXPECT_GT(num_crossing, num_paths / 20);
+    EXPECT_LT(num_crossing, num_paths / 2);
+}
+
+AP_GTEST_MAIN()
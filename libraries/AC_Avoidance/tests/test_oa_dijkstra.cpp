@@ -0,0 +1,132 @@
+#include <AP_gtest.h>
+#include <AP_gtest_random.h>
+
+#include <AC_Avoidance/AP_OADijkstra.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// searches for a path around objects, without a fence
+class DijkstraSearch
+{
+public:
+    DijkstraSearch() : dijkstra(options)
+    {
+        dijkstra.set_fence_margin(2);
+    }
+
+    // add an object with position and radius in cm
+    void add_object(const Vector2f &pos_cm, float radius_cm)
+    {
+        if (num_objects < ARRAY_SIZE(objects)) {
+            objects[num_objects++] = {pos_cm, radius_cm};
+        }
+    }
+
+    // search from origin to destination, giving search_shortest_path time_budget_us on each call
+    // returns the number of calls needed, or zero if no path was found
+    uint16_t search(const Vector2f &origin, const Vector2f &destination, uint32_t time_budget_us)
+    {
+        uint16_t calls;
+        numpoints = dijkstra.search_around_objects(objects, num_objects, origin, destination, time_budget_us, calls);
+        return (numpoints > 0) ? calls : 0;
+    }
+
+    uint8_t path_numpoints() const { return numpoints; }
+
+    Vector2f path_point(uint8_t i) const
+    {
+        Vector2f pos;
+        EXPECT_TRUE(dijkstra.get_shortest_path_point(i, pos));
+        return pos;
+    }
+
+    // true if no segment of the path passes through any of the circles, which are the objects if not given
+    bool path_clear(const AP_OADijkstra::Obstacle *circles = nullptr, uint8_t num_circles = 0) const
+    {
+        if (circles == nullptr) {
+            circles = objects;
+            num_circles = num_objects;
+        }
+        for (uint8_t i = 1; i < path_numpoints(); i++) {
+            for (uint8_t j = 0; j < num_circles; j++) {
+                if (Vector2f::closest_distance_between_line_and_point(path_point(i-1), path_point(i), circles[j].center_cm) <= circles[j].radius_cm) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    float path_length() const
+    {
+        float length = 0;
+        for (uint8_t i = 1; i < path_numpoints(); i++) {
+            length += (path_point(i) - path_point(i-1)).length();
+        }
+        return length;
+    }
+
+private:
+    AP_Int16 options;
+    AP_OADijkstra dijkstra;
+    AP_OADijkstra::Obstacle objects[40];
+    uint8_t num_objects;
+    uint8_t numpoints;
+};
+
+// a search spread over many calls finds the same path as one run to completion
+TEST(AP_OADijkstra, resumed_search_matches)
+{
+    static DijkstraSearch test;
+    const Vector2f origin(0, 0);
+    const Vector2f destination(60000, 0);
+    for (uint8_t i = 0; i < 30; i++) {
+        const Vector2f pos(30000 + test_rand(25000), test_rand(20000));
+        test.add_object(pos, 200 + fabsf(test_rand(600)));
+    }
+
+    ASSERT_EQ(test.search(origin, destination, 0), 1);
+    const uint8_t numpoints = test.path_numpoints();
+    ASSERT_GT(numpoints, 2);
+    EXPECT_TRUE(test.path_clear());
+    Vector2f path[OA_DIJKSTRA_DATABASE_OBSTACLES_MAX * 6 + 2];
+    for (uint8_t i = 0; i < numpoints; i++) {
+        path[i] = test.path_point(i);
+    }
+
+    // a tiny budget stops the search after each node, the update loop's 5ms budget may finish it in one call
+    const uint32_t budgets_us[] { 1, 5000 };
+    for (const uint32_t budget_us : budgets_us) {
+        const uint16_t calls = test.search(origin, destination, budget_us);
+        ASSERT_GT(calls, 0);
+        if (budget_us == 1) {
+            EXPECT_GT(calls, 2);
+        }
+        ASSERT_EQ(test.path_numpoints(), numpoints);
+        for (uint8_t i = 0; i < numpoints; i++) {
+            EXPECT_EQ(test.path_point(i), path[i]);
+        }
+    }
+}
+
+// two objects too close to pass between are merged into one obstacle which the path goes around, not between them
+TEST(AP_OADijkstra, merged_obstacle_avoided)
+{
+    static DijkstraSearch test;
+    test.add_object(Vector2f(2000, -150), 100);
+    test.add_object(Vector2f(2000, 150), 100);
+
+    const Vector2f origin(0, 0);
+    const Vector2f destination(4000, 0);
+    ASSERT_GT(test.search(origin, destination, 1), 0);
+    ASSERT_GT(test.path_numpoints(), 2);
+    EXPECT_EQ(test.path_point(0), origin);
+    EXPECT_EQ(test.path_point(test.path_numpoints() - 1), destination);
+
+    // the merged obstacle is the smallest circle holding both objects
+    const AP_OADijkstra::Obstacle merged { Vector2f(2000, 0), 250 };
+    EXPECT_TRUE(test.path_clear(&merged, 1));
+    EXPECT_GT(test.path_length(), (destination - origin).length());
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,74 @@
+#include <AP_gtest.h>
+#include <AP_gtest_random.h>
+
+#include <AC_Avoidance/AP_OASegmentGrid.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// a large inclusion fence with exclusion zones inside it, checked against Polygon_intersects() on random segments
+TEST(AP_OASegmentGrid, matches_polygon_intersects)
+{
+    static const uint8_t num_polygons = 6;
+    static const uint16_t num_points[num_polygons] = { 200, 8, 8, 12, 4, 30 };
+    Vector2f polygons[num_polygons][200];
+
+    AP_OASegmentGrid grid;
+    for (uint8_t p = 0; p < num_polygons; p++) {
+        const Vector2f centre = (p == 0) ? Vector2f() : Vector2f(test_rand(50000), test_rand(50000));
+        const float radius = (p == 0) ? 100000 : 2000 + fabsf(test_rand(10000));
+        make_star_polygon(polygons[p], num_points[p], centre, 0.6f * radius, radius, false);
+        EXPECT_TRUE(grid.add_polygon(polygons[p], num_points[p]));
+    }
+    EXPECT_TRUE(grid.build());
+    EXPECT_EQ(grid.num_edges(), 262);
+
+    uint16_t num_intersecting = 0;
+    for (uint16_t n = 0; n < 20000; n++) {
+        Vector2f seg_start(test_rand(130000), test_rand(130000));
+        Vector2f seg_end;
+        if (n % 4 == 0) {
+            // short segments
+            seg_end = seg_start + Vector2f(test_rand(5000), test_rand(5000));
+        } else if (n % 4 == 1) {
+            // between polygon points, which is how the visibility graph is built
+            seg_start = polygons[0][n % 200];
+            seg_end = polygons[n % num_polygons][(n / 7) % num_points[n % num_polygons]];
+        } else if (n % 4 == 2) {
+            // along an axis
+            seg_end = seg_start + Vector2f(test_rand(100000), 0);
+        } else {
+            seg_end = Vector2f(test_rand(130000), test_rand(130000));
+        }
+
+        bool expected = false;
+        for (uint8_t p = 0; p < num_polygons; p++) {
+            Vector2f intersection;
+            expected |= Polygon_intersects(polygons[p], num_points[p], seg_start, seg_end, intersection);
+        }
+        EXPECT_EQ(grid.intersects(seg_start, seg_end), expected);
+        num_intersecting += expected ? 1 : 0;
+    }
+    // check both results were tested
+    EXPECT_GT(num_intersecting, 1000);
+    EXPECT_LT(num_intersecting, 19000);
+}
+
+// closed polygons have their repeated last point ignored
+TEST(AP_OASegmentGrid, closed_polygon)
+{
+    const Vector2f square[] = { {0, 0}, {100, 0}, {100, 100}, {0, 100}, {0, 0} };
+    AP_OASegmentGrid grid;
+    EXPECT_TRUE(grid.add_polygon(square, ARRAY_SIZE(square)));
+    EXPECT_TRUE(grid.build());
+    EXPECT_EQ(grid.num_edges(), 4);
+    EXPECT_TRUE(grid.intersects(Vector2f(50, 50), Vector2f(150, 50)));
+    EXPECT_TRUE(grid.intersects(Vector2f(-50, 50), Vector2f(50, 50)));
+    EXPECT_FALSE(grid.intersects(Vector2f(10, 10), Vector2f(90, 90)));
+    EXPECT_FALSE(grid.intersects(Vector2f(200, 0), Vector2f(200, 100)));
+
+    grid.clear();
+    EXPECT_EQ(grid.num_edges(), 0);
+    EXPECT_FALSE(grid.intersects(Vector2f(50, 50), Vector2f(150, 50)));
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,108 @@
+#include <AP_gtest.h>
+#include <AP_gtest_random.h>
+
+#include <AC_Avoidance/AP_OASpatialIndex.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const uint16_t max_items = 500;
+static const float cell_size = 2.0f;
+
+// items within range of pos found by searching the cells around it
+static uint16_t count_near(const AP_OASpatialIndex &grid, const Vector3f *pos, const Vector3f &centre, float range)
+{
+    bool *seen = new bool[max_items]{};
+    uint16_t count = 0;
+    for (int32_t x = grid.cell(centre.x - range); x <= grid.cell(centre.x + range); x++) {
+        for (int32_t y = grid.cell(centre.y - range); y <= grid.cell(centre.y + range); y++) {
+            for (uint16_t i = grid.first(x, y); i != AP_OASpatialIndex::END; i = grid.next(i)) {
+                if (!seen[i] && ((pos[i] - centre).xy().length() <= range)) {
+                    seen[i] = true;
+                    count++;
+                }
+            }
+        }
+    }
+    delete[] seen;
+    return count;
+}
+
+// items within range of pos found by looking at all of them
+static uint16_t count_near_all(const Vector3f *pos, uint16_t count, const Vector3f &centre, float range)
+{
+    uint16_t near = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        if ((pos[i] - centre).xy().length() <= range) {
+            near++;
+        }
+    }
+    return near;
+}
+
+TEST(AP_OASpatialIndex, init)
+{
+    AP_OASpatialIndex grid;
+    EXPECT_FALSE(grid.initialised());
+    EXPECT_FALSE(grid.init(0, cell_size));
+    EXPECT_FALSE(grid.init(max_items, 0.0f));
+    EXPECT_TRUE(grid.init(max_items, cell_size));
+    EXPECT_TRUE(grid.initialised());
+
+    EXPECT_EQ(grid.cell(0.0f), 0);
+    EXPECT_EQ(grid.cell(1.9f), 0);
+    EXPECT_EQ(grid.cell(2.0f), 1);
+    EXPECT_EQ(grid.cell(-0.1f), -1);
+    EXPECT_EQ(grid.first(0, 0), AP_OASpatialIndex::END);
+}
+
+// add and remove items the way the object database does, moving the last item into the gap left by a removed
+// one, and check searches of nearby cells find the same items as looking at every item
+TEST(AP_OASpatialIndex, matches_linear_search)
+{
+    AP_OASpatialIndex grid;
+    ASSERT_TRUE(grid.init(max_items, cell_size));
+
+    Vector3f pos[max_items];
+    uint16_t count = 0;
+
+    for (uint16_t step = 0; step < 3000; step++) {
+        if ((count < max_items) && ((count < 50) || (test_rand(1.0f) > -0.2f))) {
+            pos[count] = Vector3f(test_rand(60.0f), test_rand(60.0f), test_rand(5.0f));
+            grid.add(count, pos[count]);
+            count++;
+        } else {
+            const uint16_t index = (uint16_t)(fabsf(test_rand(1.0f)) * (count - 1));
+            grid.remove(index, pos[index]);
+            count--;
+            if (index != count) {
+                grid.move(count, index, pos[count]);
+                pos[index] = pos[count];
+            }
+        }
+
+        if (step % 100 == 0) {
+            for (uint8_t n = 0; n < 20; n++) {
+                const Vector3f centre(test_rand(70.0f), test_rand(70.0f), 0.0f);
+                const float range = fabsf(test_rand(8.0f));
+                EXPECT_EQ(count_near(grid, pos, centre, range), count_near_all(pos, count, centre, range));
+            }
+        }
+    }
+
+    grid.clear();
+    EXPECT_EQ(count_near(grid, pos, Vector3f(), 100.0f), 0);
+}
+
+TEST(AP_OASpatialIndex, worth_searching)
+{
+    AP_OASpatialIndex grid;
+    ASSERT_TRUE(grid.init(100, cell_size));
+
+    // 128 buckets for 100 items
+    EXPECT_TRUE(grid.worth_searching(-5, 5, -5, 5));
+    EXPECT_FALSE(grid.worth_searching(-10, 10, -10, 10));
+    EXPECT_EQ(AP_OASpatialIndex::num_cells(1, 0, 0, 0), 0U);
+    EXPECT_EQ(AP_OASpatialIndex::num_cells(INT32_MIN, INT32_MAX, INT32_MIN, INT32_MAX), UINT32_MAX);
+}
+
+AP_GTEST_MAIN()
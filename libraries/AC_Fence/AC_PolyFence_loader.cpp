@@ -218,7 +218,7 @@ bool AC_PolyFence_loader::breached(const Location& loc) const
     // check we are inside each inclusion zone:
     for (uint8_t i=0; i<_num_loaded_inclusion_boundaries; i++) {
         const InclusionBoundary &boundary = _loaded_inclusion_boundary[i];
-        if (Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+        if (boundary.edge_boxes_lla.outside(pos)) {
             return true;
         }
     }
@@ -226,7 +226,7 @@ bool AC_PolyFence_loader::breached(const Location& loc) const
     // check we are outside each exclusion zone:
     for (uint8_t i=0; i<_num_loaded_exclusion_boundaries; i++) {
         const ExclusionBoundary &boundary = _loaded_exclusion_boundary[i];
-        if (!Polygon_outside(pos, boundary.points_lla, boundary.count)) {
+        if (!boundary.edge_boxes_lla.outside(pos)) {
             return true;
         }
     }
@@ -759,6 +759,9 @@ bool AC_PolyFence_loader::load_from_eeprom()
                 storage_valid = false;
                 break;
             }
+            // boxes around runs of edges speed up breach and avoidance checks on polygons with many points
+            boundary.edge_boxes.init(boundary.points, boundary.count);
+            boundary.edge_boxes_lla.init(boundary.points_lla, boundary.count);
             _num_loaded_inclusion_boundaries++;
             break;
         }
@@ -778,6 +781,9 @@ bool AC_PolyFence_loader::load_from_eeprom()
                 storage_valid = false;
                 break;
             }
+            // boxes around runs of edges speed up breach and avoidance checks on polygons with many points
+            boundary.edge_boxes.init(boundary.points, boundary.count);
+            boundary.edge_boxes_lla.init(boundary.points_lla, boundary.count);
             _num_loaded_exclusion_boundaries++;
             break;
         }
@@ -891,6 +897,15 @@ Vector2f* AC_PolyFence_loader::get_exclusion_polygon(uint16_t index, uint16_t &n
     return boundary.points;
 }
 
+/// returns boxes around runs of edges of the exclusion polygon for faster point in polygon and nearest edge checks
+const PolygonEdgeBoxes<float> *AC_PolyFence_loader::get_exclusion_polygon_edge_boxes(uint16_t index) const
+{
+    if (index >= _num_loaded_exclusion_boundaries) {
+        return nullptr;
+    }
+    return &_loaded_exclusion_boundary[index].edge_boxes;
+}
+
 /// returns pointer to array of inclusion polygon points and num_points is filled in with the number of points in the polygon
 /// points are offsets in cm from EKF origin in NE frame
 Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &num_points) const
@@ -905,6 +920,15 @@ Vector2f* AC_PolyFence_loader::get_inclusion_polygon(uint16_t index, uint16_t &n
     return boundary.points;
 }
 
+/// returns boxes around runs of edges of the inclusion polygon for faster point in polygon and nearest edge checks
+const PolygonEdgeBoxes<float> *AC_PolyFence_loader::get_inclusion_polygon_edge_boxes(uint16_t index) const
+{
+    if (index >= _num_loaded_inclusion_boundaries) {
+        return nullptr;
+    }
+    return &_loaded_inclusion_boundary[index].edge_boxes;
+}
+
 /// returns the specified exclusion circle
 /// circle center offsets in cm from EKF origin in NE frame, radius is in meters
 bool AC_PolyFence_loader::get_exclusion_circle(uint8_t index, Vector2f &center_pos_cm, float &radius) const
@@ -67,6 +67,10 @@ public:
     /// points are offsets in cm from EKF origin in NE frame
     Vector2f* get_exclusion_polygon(uint16_t index, uint16_t &num_points) const;
 
+    /// returns boxes around runs of edges of the exclusion polygon for faster point in polygon and nearest edge checks
+    /// returns nullptr if index is invalid
+    const PolygonEdgeBoxes<float> *get_exclusion_polygon_edge_boxes(uint16_t index) const;
+
     /// return system time of last update to the exclusion polygon points
     uint32_t get_exclusion_polygon_update_ms() const {
         return _load_time_ms;
@@ -84,6 +88,10 @@ public:
     /// points are offsets in cm from EKF origin in NE frame
     Vector2f* get_inclusion_polygon(uint16_t index, uint16_t &num_points) const;
 
+    /// returns boxes around runs of edges of the inclusion polygon for faster point in polygon and nearest edge checks
+    /// returns nullptr if index is invalid
+    const PolygonEdgeBoxes<float> *get_inclusion_polygon_edge_boxes(uint16_t index) const;
+
     /// return system time of last update to the inclusion polygon points
     uint32_t get_inclusion_polygon_update_ms() const {
         return _load_time_ms;
@@ -281,6 +289,8 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla array
         uint8_t count; // count of points in the boundary
+        PolygonEdgeBoxes<float> edge_boxes; // boxes around runs of edges of points
+        PolygonEdgeBoxes<int32_t> edge_boxes_lla; // boxes around runs of edges of points_lla
     };
     InclusionBoundary *_loaded_inclusion_boundary;
 
@@ -291,6 +301,8 @@ private:
         Vector2f *points; // pointer into the _loaded_offsets_from_origin array
         Vector2l *points_lla; // pointer into the _loaded_points_lla_lla array
         uint8_t count; // count of points in the boundary
+        PolygonEdgeBoxes<float> edge_boxes; // boxes around runs of edges of points
+        PolygonEdgeBoxes<int32_t> edge_boxes_lla; // boxes around runs of edges of points_lla
     };
     ExclusionBoundary *_loaded_exclusion_boundary;
 
@@ -35,9 +35,15 @@
 #define ADSB_SQUAWK_OCTAL_DEFAULT       1200
 
 #ifndef ADSB_VEHICLE_LIST_SIZE_DEFAULT
-    #define ADSB_VEHICLE_LIST_SIZE_DEFAULT  25
+    #if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+        #define ADSB_VEHICLE_LIST_SIZE_DEFAULT  100
+    #else
+        #define ADSB_VEHICLE_LIST_SIZE_DEFAULT  25
+    #endif
 #endif
 
+#define ADSB_ICAO_TABLE_SIZE_MIN        16     // smallest ICAO hash table, the table has at least twice as many slots as the vehicle list
+
 #ifndef ADSB_LIST_RADIUS_DEFAULT
     #if APM_BUILD_TYPE(APM_BUILD_ArduPlane)
         #define ADSB_LIST_RADIUS_DEFAULT        10000 // in meters
@@ -200,6 +206,17 @@ void AP_ADSB::init(void)
             return;
         }
         in_state.list_size_allocated = in_state.list_size_param;
+
+        // allocate the ICAO hash table.  If this fails the vehicle list is searched instead
+        uint32_t table_size = ADSB_ICAO_TABLE_SIZE_MIN;
+        while (table_size < in_state.list_size_allocated * 2U) {
+            table_size *= 2;
+        }
+        in_state.icao_table = new uint16_t[table_size];
+        if (in_state.icao_table != nullptr) {
+            memset(in_state.icao_table, 0xFF, table_size * sizeof(uint16_t));
+            in_state.icao_table_mask = table_size - 1;
+        }
     }
 
     if (detected_num_instances == 0) {
@@ -436,7 +453,13 @@ void AP_ADSB::delete_vehicle(const uint16_t index)
         in_state.furthest_vehicle_distance = 0;
         in_state.furthest_vehicle_index = 0;
     }
+    icao_table_remove(in_state.vehicle_list[index].info.ICAO_address);
     if (index != (in_state.vehicle_count-1)) {
+        // point the hash table at the vehicle's new index
+        uint16_t slot;
+        if (icao_table_find(in_state.vehicle_list[in_state.vehicle_count-1].info.ICAO_address, slot)) {
+            in_state.icao_table[slot] = index;
+        }
         in_state.vehicle_list[index] = in_state.vehicle_list[in_state.vehicle_count-1];
     }
     // TODO: is memset needed? When we decrement the index we essentially forget about it
@@ -451,6 +474,15 @@ void AP_ADSB::delete_vehicle(const uint16_t index)
  */
 bool AP_ADSB::find_index(const adsb_vehicle_t &vehicle, uint16_t *index) const
 {
+    if (in_state.icao_table != nullptr) {
+        uint16_t slot;
+        if (!icao_table_find(vehicle.info.ICAO_address, slot)) {
+            return false;
+        }
+        *index = in_state.icao_table[slot];
+        return true;
+    }
+
     for (uint16_t i = 0; i < in_state.vehicle_count; i++) {
         if (in_state.vehicle_list[i].info.ICAO_address == vehicle.info.ICAO_address) {
             *index = i;
@@ -460,6 +492,78 @@ bool AP_ADSB::find_index(const adsb_vehicle_t &vehicle, uint16_t *index) const
     return false;
 }
 
+/*
+ * ICAO hash table slot a vehicle's search starts from
+ */
+uint16_t AP_ADSB::icao_table_slot(const uint32_t icao) const
+{
+    return ((icao * 2654435761U) >> 16) & in_state.icao_table_mask;
+}
+
+/*
+ * Search the ICAO hash table using linear probing.  Returns true and
+ * the slot holding the vehicle's index if found.  Otherwise, return
+ * false.
+ */
+bool AP_ADSB::icao_table_find(const uint32_t icao, uint16_t &slot) const
+{
+    if (in_state.icao_table == nullptr) {
+        return false;
+    }
+    slot = icao_table_slot(icao);
+    while (in_state.icao_table[slot] != UINT16_MAX) {
+        if (in_state.vehicle_list[in_state.icao_table[slot]].info.ICAO_address == icao) {
+            return true;
+        }
+        slot = (slot + 1) & in_state.icao_table_mask;
+    }
+    return false;
+}
+
+/*
+ * Add the vehicle at index in vehicle_list to the ICAO hash table.
+ * The table always has empty slots as it is at least twice the size
+ * of the list
+ */
+void AP_ADSB::icao_table_insert(const uint16_t index)
+{
+    if (in_state.icao_table == nullptr) {
+        return;
+    }
+    uint16_t slot = icao_table_slot(in_state.vehicle_list[index].info.ICAO_address);
+    while (in_state.icao_table[slot] != UINT16_MAX) {
+        slot = (slot + 1) & in_state.icao_table_mask;
+    }
+    in_state.icao_table[slot] = index;
+}
+
+/*
+ * Remove a vehicle from the ICAO hash table.  Later vehicles in the
+ * same run of slots are shifted back so searches never stop early at
+ * the emptied slot
+ */
+void AP_ADSB::icao_table_remove(const uint32_t icao)
+{
+    uint16_t hole;
+    if (!icao_table_find(icao, hole)) {
+        return;
+    }
+    uint16_t slot = hole;
+    while (true) {
+        slot = (slot + 1) & in_state.icao_table_mask;
+        if (in_state.icao_table[slot] == UINT16_MAX) {
+            break;
+        }
+        // move the entry back if its search passes over the hole on the way to it
+        const uint16_t home = icao_table_slot(in_state.vehicle_list[in_state.icao_table[slot]].info.ICAO_address);
+        if (((slot - home) & in_state.icao_table_mask) >= ((slot - hole) & in_state.icao_table_mask)) {
+            in_state.icao_table[hole] = in_state.icao_table[slot];
+            hole = slot;
+        }
+    }
+    in_state.icao_table[hole] = UINT16_MAX;
+}
+
 /*
  * Update the vehicle list. If the vehicle is already in the
  * list then it will update it, otherwise it will be added.
@@ -554,7 +658,17 @@ void AP_ADSB::set_vehicle(const uint16_t index, const adsb_vehicle_t &vehicle)
         // out of range
         return;
     }
-    in_state.vehicle_list[index] = vehicle;
+    if (index < in_state.vehicle_count && in_state.vehicle_list[index].info.ICAO_address == vehicle.info.ICAO_address) {
+        // updating a tracked vehicle, the hash table is unchanged
+        in_state.vehicle_list[index] = vehicle;
+    } else {
+        // new vehicle, which may replace a tracked one
+        if (index < in_state.vehicle_count) {
+            icao_table_remove(in_state.vehicle_list[index].info.ICAO_address);
+        }
+        in_state.vehicle_list[index] = vehicle;
+        icao_table_insert(index);
+    }
 
     write_log(vehicle);
 }
@@ -178,6 +178,12 @@ private:
     // return index of given vehicle if ICAO_ADDRESS matches. return -1 if no match
     bool find_index(const adsb_vehicle_t &vehicle, uint16_t *index) const;
 
+    // ICAO hash table, maps ICAO_address to index in vehicle_list
+    uint16_t icao_table_slot(const uint32_t icao) const;
+    bool icao_table_find(const uint32_t icao, uint16_t &slot) const;
+    void icao_table_insert(const uint16_t index);
+    void icao_table_remove(const uint32_t icao);
+
     // remove a vehicle from the list
     void delete_vehicle(const uint16_t index);
 
@@ -213,6 +219,8 @@ private:
         uint16_t    list_size_allocated;
         adsb_vehicle_t *vehicle_list;
         uint16_t    vehicle_count;
+        uint16_t    *icao_table;        // vehicle_list index for each ICAO_address, UINT16_MAX if slot is empty
+        uint16_t    icao_table_mask;    // table size minus one, table size is a power of two
         AP_Int32    list_radius;
         AP_Int16    list_altitude;
 
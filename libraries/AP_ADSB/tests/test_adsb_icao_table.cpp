@@ -0,0 +1,136 @@
+#include <AP_gtest.h>
+
+#include <AP_ADSB/AP_ADSB.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static AP_ADSB adsb;
+
+static const uint16_t list_size = 20;
+
+// the ICAO hash table AP_ADSB allocates for list_size vehicles has 64
+// slots; addresses which hash near the end of it make probe runs
+// which wrap around to the start
+static const uint16_t table_mask = 63;
+
+static uint16_t table_slot(uint32_t icao)
+{
+    return ((icao * 2654435761U) >> 16) & table_mask;
+}
+
+// enable ADSB-in with a small vehicle list, before the list is allocated
+static void setup_adsb()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    done = true;
+    AP_Param::set_object_value(&adsb, AP_ADSB::var_info, "TYPE", 1);
+    AP_Param::set_object_value(&adsb, AP_ADSB::var_info, "LIST_MAX", list_size);
+}
+
+// a vehicle report. With no position of our own every valid report
+// is in range
+static AP_ADSB::adsb_vehicle_t make_vehicle(uint32_t icao, int32_t altitude)
+{
+    AP_ADSB::adsb_vehicle_t vehicle {};
+    vehicle.info.ICAO_address = icao;
+    vehicle.info.lat = -353632610;
+    vehicle.info.lon = 1491652370;
+    vehicle.info.altitude = altitude;
+    vehicle.info.flags = ADSB_FLAGS_VALID_COORDS | ADSB_FLAGS_VALID_ALTITUDE;
+    vehicle.last_update_ms = AP_HAL::millis();
+    return vehicle;
+}
+
+// the vehicles we expect to be tracked, searched linearly
+struct Reference {
+    uint32_t icao[list_size];
+    int32_t altitude[list_size];
+    uint16_t count;
+
+    int16_t find(uint32_t address) const {
+        for (uint16_t i=0; i<count; i++) {
+            if (icao[i] == address) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    void remove(uint16_t i) {
+        count--;
+        icao[i] = icao[count];
+        altitude[i] = altitude[count];
+    }
+};
+
+// random reports of a pool of vehicles, which are added, updated and
+// dropped, give the same list as a linear search would
+TEST(AP_ADSB, icao_table_matches_linear_search)
+{
+    setup_adsb();
+
+    // half the pool hashes to the last few slots of the table or the
+    // first one, so many probe runs wrap around
+    static const uint8_t pool_size = 48;
+    uint32_t pool[pool_size];
+    uint8_t n = 0;
+    for (uint32_t icao=1; n<pool_size/2; icao++) {
+        const uint16_t slot = table_slot(icao);
+        if (slot >= table_mask - 3 || slot == 0) {
+            pool[n++] = icao;
+        }
+    }
+    while (n < pool_size) {
+        pool[n++] = ((uint32_t)get_random16() << 8 | get_random16()) & 0x00FFFFFF;
+    }
+
+    Reference reference {};
+    for (uint16_t step=0; step<10000; step++) {
+        const uint32_t icao = pool[get_random16() % pool_size];
+        const int16_t tracked = reference.find(icao);
+        AP_ADSB::adsb_vehicle_t vehicle = make_vehicle(icao, step);
+        switch (get_random16() % 8) {
+        case 0:
+            // report without a position, which drops the vehicle
+            vehicle.info.flags = 0;
+            if (tracked >= 0) {
+                reference.remove(tracked);
+            }
+            break;
+        case 1:
+            // stale report, which also drops the vehicle
+            vehicle.last_update_ms -= 10000;
+            if (tracked >= 0) {
+                reference.remove(tracked);
+            }
+            break;
+        default:
+            if (tracked >= 0) {
+                reference.altitude[tracked] = step;
+            } else if (reference.count < list_size) {
+                reference.icao[reference.count] = icao;
+                reference.altitude[reference.count] = step;
+                reference.count++;
+            }
+            // with the list full and no position of our own the
+            // vehicle is ignored
+            break;
+        }
+        adsb.handle_adsb_vehicle(vehicle);
+
+        for (const uint32_t address : pool) {
+            const int16_t i = reference.find(address);
+            AP_ADSB::adsb_vehicle_t found;
+            ASSERT_EQ(i >= 0, adsb.get_vehicle_by_ICAO(address, found)) << "step " << step << " icao " << address;
+            if (i >= 0) {
+                EXPECT_EQ(address, found.info.ICAO_address);
+                EXPECT_EQ(reference.altitude[i], found.info.altitude);
+            }
+        }
+    }
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,64 @@
+#include <AP_gtest.h>
+#include <AP_gtest_random.h>
+
+#include <AP_Avoidance/AP_Avoidance.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const uint8_t batch_size = 50;
+
+// the batched closest approach of random obstacles, given relative to
+// us the way AP_Avoidance works them out, matches that of each obstacle
+TEST(AP_Avoidance, closest_approach_batch_matches_scalar)
+{
+    Location my_loc;
+    my_loc.lat = -353632610;
+    my_loc.lng = 1491652370;
+    my_loc.alt = 58400;
+
+    for (uint8_t run=0; run<20; run++) {
+        float pos_n[batch_size], pos_e[batch_size], pos_d[batch_size];
+        float vel_n[batch_size], vel_e[batch_size], vel_d[batch_size];
+        float time_horizon[batch_size];
+        float xy[batch_size], z[batch_size];
+        float expected_xy[batch_size], expected_z[batch_size];
+
+        const Vector3f my_vel(test_rand(30), test_rand(30), test_rand(5));
+        for (uint8_t i=0; i<batch_size; i++) {
+            Location obstacle_loc = my_loc;
+            obstacle_loc.offset(test_rand(5000), test_rand(5000));
+            obstacle_loc.alt += test_rand(50000);
+            Vector3f obstacle_vel(test_rand(100), test_rand(100), test_rand(10));
+            if (i % 10 == 0) {
+                // obstacles with our velocity, and ones at our height
+                obstacle_vel = my_vel;
+            } else if (i % 10 == 1) {
+                obstacle_loc.alt = my_loc.alt;
+            }
+            const uint8_t horizon = get_random16() % 31;
+
+            expected_xy[i] = closest_approach_xy(my_loc, my_vel, obstacle_loc, obstacle_vel, horizon);
+            expected_z[i] = closest_approach_z(my_loc, my_vel, obstacle_loc, obstacle_vel, horizon);
+
+            const Vector2f delta_pos_ne = obstacle_loc.get_distance_NE(my_loc);
+            pos_n[i] = delta_pos_ne.x;
+            pos_e[i] = delta_pos_ne.y;
+            pos_d[i] = obstacle_loc.alt - my_loc.alt;
+            vel_n[i] = obstacle_vel.x - my_vel.x;
+            vel_e[i] = obstacle_vel.y - my_vel.y;
+            vel_d[i] = obstacle_vel.z - my_vel.z;
+            time_horizon[i] = horizon;
+        }
+
+        closest_approach_xy_batch(pos_n, pos_e, vel_n, vel_e, time_horizon, batch_size, xy);
+        closest_approach_z_batch(pos_d, vel_d, time_horizon, batch_size, z);
+
+        for (uint8_t i=0; i<batch_size; i++) {
+            EXPECT_NEAR(expected_xy[i], xy[i], 1e-3 * MAX(1.0f, expected_xy[i])) << "run " << (int)run << " obstacle " << (int)i;
+            EXPECT_NEAR(expected_z[i], z[i], 1e-4 * MAX(1.0f, expected_z[i])) << "run " << (int)run << " obstacle " << (int)i;
+        }
+    }
+}
+
+AP_GTEST_MAIN()
@@ -30,6 +30,14 @@ extern const AP_HAL::HAL& hal;
     #define AP_AVOIDANCE_FAIL_ACTION_DEFAULT            MAV_COLLISION_ACTION_REPORT
 #endif
 
+#ifndef AP_AVOIDANCE_OBSTACLES_MAX_DEFAULT
+    #if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+        #define AP_AVOIDANCE_OBSTACLES_MAX_DEFAULT      100
+    #else
+        #define AP_AVOIDANCE_OBSTACLES_MAX_DEFAULT      20
+    #endif
+#endif
+
 #if AVOIDANCE_DEBUGGING
 #include <stdio.h>
 #define debug(fmt, args ...)  do {::fprintf(stderr,"%s:%d: " fmt "\n", __FUNCTION__, __LINE__, ## args); } while(0)
@@ -71,8 +79,9 @@ const AP_Param::GroupInfo AP_Avoidance::var_info[] = {
     // @Param: OBS_MAX
     // @DisplayName: Maximum number of obstacles to track
     // @Description: Maximum number of obstacles to track
+    // @Range: 1 127
     // @User: Advanced
-    AP_GROUPINFO("OBS_MAX",     5, AP_Avoidance, _obstacles_max, 20),
+    AP_GROUPINFO("OBS_MAX",     5, AP_Avoidance, _obstacles_max, AP_AVOIDANCE_OBSTACLES_MAX_DEFAULT),
 
     // @Param: W_TIME
     // @DisplayName: Time Horizon Warn
@@ -331,57 +340,94 @@ float closest_approach_z(const Location &my_loc,
     return ret/100.0f;
 }
 
-void AP_Avoidance::update_threat_level(const Location &my_loc,
-                                       const Vector3f &my_vel,
-                                       AP_Avoidance::Obstacle &obstacle)
+// closest approach in the horizontal plane for each obstacle in a batch, see closest_approach_xy.
+// Written without branches on the data so the loop can be vectorised
+void closest_approach_xy_batch(const float *pos_n,
+                               const float *pos_e,
+                               const float *vel_n,
+                               const float *vel_e,
+                               const float *time_horizon,
+                               const uint8_t count,
+                               float *ret)
 {
+    for (uint8_t i = 0; i < count; i++) {
+        // closest point to us on the line segment the obstacle travels along
+        const float line_n = vel_n[i] * time_horizon[i];
+        const float line_e = vel_e[i] * time_horizon[i];
+        const float length_sq = line_n * line_n + line_e * line_e;
+        float t = (pos_n[i] * line_n + pos_e[i] * line_e) / MAX(length_sq, FLT_EPSILON);
+        t = MIN(MAX(t, 0.0f), 1.0f);
+        t = (length_sq < FLT_EPSILON) ? 1.0f : t;
+        const float dist_n = line_n * t - pos_n[i];
+        const float dist_e = line_e * t - pos_e[i];
+        ret[i] = sqrtf(dist_n * dist_n + dist_e * dist_e);
+    }
+}
 
-    Location &obstacle_loc = obstacle._location;
-    Vector3f &obstacle_vel = obstacle._velocity;
+// closest approach in the vertical axis for each obstacle in a batch, see closest_approach_z
+void closest_approach_z_batch(const float *pos_d,
+                              const float *vel_d,
+                              const float *time_horizon,
+                              const uint8_t count,
+                              float *ret)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        // obstacles moving away from us vertically are closest now
+        const bool separating = (pos_d[i] >= 0 && vel_d[i] >= 0) || (pos_d[i] <= 0 && vel_d[i] <= 0);
+        const float closest = separating ? fabsf(pos_d[i]) : fabsf(pos_d[i] - vel_d[i] * time_horizon[i]);
+        ret[i] = closest / 100.0f;
+    }
+}
 
-    obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
+// set the threat level and closest approach of each obstacle in a batch
+void AP_Avoidance::update_threat_levels(ThreatBatch &batch)
+{
+    closest_approach_xy_batch(batch.pos_n, batch.pos_e, batch.vel_n, batch.vel_e, batch.fail_time_horizon, batch.count, batch.fail_xy);
+    closest_approach_xy_batch(batch.pos_n, batch.pos_e, batch.vel_n, batch.vel_e, batch.warn_time_horizon, batch.count, batch.warn_xy);
+    closest_approach_z_batch(batch.pos_d, batch.vel_d, batch.fail_time_horizon, batch.count, batch.fail_z);
+    closest_approach_z_batch(batch.pos_d, batch.vel_d, batch.warn_time_horizon, batch.count, batch.warn_z);
 
-    const uint32_t obstacle_age = AP_HAL::millis() - obstacle.timestamp_ms;
-    float closest_xy = closest_approach_xy(my_loc, my_vel, obstacle_loc, obstacle_vel, _fail_time_horizon + obstacle_age/1000);
-    if (closest_xy < _fail_distance_xy) {
-        obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_HIGH;
-    } else {
-        closest_xy = closest_approach_xy(my_loc, my_vel, obstacle_loc, obstacle_vel, _warn_time_horizon + obstacle_age/1000);
-        if (closest_xy < _warn_distance_xy) {
-            obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_LOW;
-        }
-    }
+    for (uint8_t i = 0; i < batch.count; i++) {
+        AP_Avoidance::Obstacle &obstacle = _obstacles[batch.index[i]];
 
-    // check for vertical separation; our threat level is the minimum
-    // of vertical and horizontal threat levels
-    float closest_z = closest_approach_z(my_loc, my_vel, obstacle_loc, obstacle_vel, _warn_time_horizon + obstacle_age/1000);
-    if (obstacle.threat_level != MAV_COLLISION_THREAT_LEVEL_NONE) {
-        if (closest_z > _warn_distance_z) {
-            obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
+        obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
+
+        float closest_xy = batch.fail_xy[i];
+        if (closest_xy < _fail_distance_xy) {
+            obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_HIGH;
         } else {
-            closest_z = closest_approach_z(my_loc, my_vel, obstacle_loc, obstacle_vel, _fail_time_horizon + obstacle_age/1000);
-            if (closest_z > _fail_distance_z) {
+            closest_xy = batch.warn_xy[i];
+            if (closest_xy < _warn_distance_xy) {
                 obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_LOW;
             }
         }
-    }
 
-    // If we haven't heard from a vehicle then assume it is no threat
-    if (obstacle_age > MAX_OBSTACLE_AGE_MS) {
-        obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
-    }
+        // check for vertical separation; our threat level is the minimum
+        // of vertical and horizontal threat levels
+        float closest_z = batch.warn_z[i];
+        if (obstacle.threat_level != MAV_COLLISION_THREAT_LEVEL_NONE) {
+            if (closest_z > _warn_distance_z) {
+                obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
+            } else {
+                closest_z = batch.fail_z[i];
+                if (closest_z > _fail_distance_z) {
+                    obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_LOW;
+                }
+            }
+        }
 
-    // could optimise this to not calculate a lot of this if threat
-    // level is none - but only *once the GCS has been informed*!
-    obstacle.closest_approach_xy = closest_xy;
-    obstacle.closest_approach_z = closest_z;
-    float current_distance = my_loc.get_distance(obstacle_loc);
-    obstacle.distance_to_closest_approach = current_distance - closest_xy;
-    Vector2f net_velocity_ne = Vector2f(my_vel[0] - obstacle_vel[0], my_vel[1] - obstacle_vel[1]);
-    obstacle.time_to_closest_approach = 0.0f;
-    if (!is_zero(obstacle.distance_to_closest_approach) &&
-        ! is_zero(net_velocity_ne.length())) {
-        obstacle.time_to_closest_approach = obstacle.distance_to_closest_approach / net_velocity_ne.length();
+        // could optimise this to not calculate a lot of this if threat
+        // level is none - but only *once the GCS has been informed*!
+        obstacle.closest_approach_xy = closest_xy;
+        obstacle.closest_approach_z = closest_z;
+        const float current_distance = norm(batch.pos_n[i], batch.pos_e[i]);
+        obstacle.distance_to_closest_approach = current_distance - closest_xy;
+        const float net_speed_ne = norm(batch.vel_n[i], batch.vel_e[i]);
+        obstacle.time_to_closest_approach = 0.0f;
+        if (!is_zero(obstacle.distance_to_closest_approach) &&
+            ! is_zero(net_speed_ne)) {
+            obstacle.time_to_closest_approach = obstacle.distance_to_closest_approach / net_speed_ne;
+        }
     }
 }
 
@@ -474,26 +520,48 @@ void AP_Avoidance::check_for_threats()
     // is most likely our own position and/or velocity have changed
     // determine the current most-serious-threat
     _current_most_serious_threat = -1;
+    const uint32_t now = AP_HAL::millis();
+    ThreatBatch batch;
+    batch.count = 0;
     for (uint8_t i=0; i<_obstacle_count; i++) {
 
         AP_Avoidance::Obstacle &obstacle = _obstacles[i];
-        const uint32_t obstacle_age = AP_HAL::millis() - obstacle.timestamp_ms;
+        const uint32_t obstacle_age = now - obstacle.timestamp_ms;
         debug("i=%d src_id=%d timestamp=%u age=%d", i, obstacle.src_id, obstacle.timestamp_ms, obstacle_age);
 
-        update_threat_level(my_loc, my_vel, obstacle);
-        debug("   threat-level=%d", obstacle.threat_level);
-
-        // ignore any really old data:
+        // ignore any really old data.  If we haven't heard from a
+        // vehicle then assume it is no threat
         if (obstacle_age > MAX_OBSTACLE_AGE_MS) {
+            obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
             // shrink list if this is the last entry:
             if (i == _obstacle_count-1) {
                 _obstacle_count -= 1;
             }
-            continue;
+        } else {
+            // add obstacle to the batch, relative to us
+            const uint8_t n = batch.count++;
+            const Vector2f delta_pos_ne = obstacle._location.get_distance_NE(my_loc);
+            batch.index[n] = i;
+            batch.pos_n[n] = delta_pos_ne.x;
+            batch.pos_e[n] = delta_pos_ne.y;
+            batch.pos_d[n] = obstacle._location.alt - my_loc.alt;
+            batch.vel_n[n] = obstacle._velocity.x - my_vel.x;
+            batch.vel_e[n] = obstacle._velocity.y - my_vel.y;
+            batch.vel_d[n] = obstacle._velocity.z - my_vel.z;
+            batch.fail_time_horizon[n] = (uint8_t)(_fail_time_horizon + obstacle_age/1000);
+            batch.warn_time_horizon[n] = (uint8_t)(_warn_time_horizon + obstacle_age/1000);
         }
 
-        if (obstacle_is_more_serious_threat(obstacle)) {
-            _current_most_serious_threat = i;
+        // evaluate the batch once it is full or all obstacles have been added
+        if (batch.count == AP_AVOIDANCE_THREAT_BATCH || (i+1 >= _obstacle_count && batch.count > 0)) {
+            update_threat_levels(batch);
+            for (uint8_t n=0; n<batch.count; n++) {
+                debug("   i=%d threat-level=%d", batch.index[n], _obstacles[batch.index[n]].threat_level);
+                if (obstacle_is_more_serious_threat(_obstacles[batch.index[n]])) {
+                    _current_most_serious_threat = batch.index[n];
+                }
+            }
+            batch.count = 0;
         }
     }
     if (_current_most_serious_threat != -1) {
@@ -33,6 +33,8 @@
 
 #define AP_AVOIDANCE_ESCAPE_TIME_SEC                        2       // vehicle runs from thread for 2 seconds
 
+#define AP_AVOIDANCE_THREAT_BATCH                           16      // number of obstacles check_for_threats evaluates together
+
 class AP_Avoidance {
 public:
 
@@ -171,10 +173,27 @@ private:
     // get unique id for adsb
     uint32_t src_id_for_adsb_vehicle(const AP_ADSB::adsb_vehicle_t &vehicle) const;
 
+    // obstacles relative to us, held as a structure of arrays so the closest approach of a whole
+    // batch can be calculated in one pass
+    struct ThreatBatch {
+        uint8_t count;
+        uint8_t index[AP_AVOIDANCE_THREAT_BATCH];           // index in _obstacles
+        float pos_n[AP_AVOIDANCE_THREAT_BATCH];             // metres, from obstacle to us
+        float pos_e[AP_AVOIDANCE_THREAT_BATCH];             // metres, from obstacle to us
+        float pos_d[AP_AVOIDANCE_THREAT_BATCH];             // centimetres, obstacle altitude above ours
+        float vel_n[AP_AVOIDANCE_THREAT_BATCH];             // m/s, obstacle velocity relative to ours
+        float vel_e[AP_AVOIDANCE_THREAT_BATCH];
+        float vel_d[AP_AVOIDANCE_THREAT_BATCH];
+        float fail_time_horizon[AP_AVOIDANCE_THREAT_BATCH]; // seconds, including obstacle age
+        float warn_time_horizon[AP_AVOIDANCE_THREAT_BATCH];
+        float fail_xy[AP_AVOIDANCE_THREAT_BATCH];           // closest approach results in metres
+        float warn_xy[AP_AVOIDANCE_THREAT_BATCH];
+        float fail_z[AP_AVOIDANCE_THREAT_BATCH];
+        float warn_z[AP_AVOIDANCE_THREAT_BATCH];
+    };
+
     void check_for_threats();
-    void update_threat_level(const Location &my_loc,
-                             const Vector3f &my_vel,
-                             AP_Avoidance::Obstacle &obstacle);
+    void update_threat_levels(ThreatBatch &batch);
 
     // calls into the AP_ADSB library to retrieve vehicle data
     void get_adsb_samples();
@@ -227,6 +246,21 @@ float closest_approach_z(const Location &my_loc,
                          const Vector3f &obstacle_vel,
                          uint8_t time_horizon);
 
+// closest approach of a batch of obstacles given their positions and velocities relative to us
+void closest_approach_xy_batch(const float *pos_n,
+                               const float *pos_e,
+                               const float *vel_n,
+                               const float *vel_e,
+                               const float *time_horizon,
+                               uint8_t count,
+                               float *ret);
+
+void closest_approach_z_batch(const float *pos_d,
+                              const float *vel_d,
+                              const float *time_horizon,
+                              uint8_t count,
+                              float *ret);
+
 
 namespace AP {
     AP_Avoidance *ap_avoidance();
@@ -37,6 +37,9 @@ static const SysFileList sysfs_file_list[] = {
     {"memory.txt"},
     {"uarts.txt"},
     {"timers.txt"},
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    {"thread_trace.json"},
+#endif
 #if HAL_MAX_CAN_PROTOCOL_DRIVERS
     {"can_log.txt"},
 #endif
@@ -114,6 +117,11 @@ int AP_Filesystem_Sys::open(const char *fname, int flags, bool allow_absolute_pa
     if (strcmp(fname, "timers.txt") == 0) {
         hal.util->timer_info(*r.str);
     }
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    if (strcmp(fname, "thread_trace.json") == 0) {
+        hal.util->thread_trace(*r.str);
+    }
+#endif
 #if HAL_CANMANAGER_ENABLED
     if (strcmp(fname, "can_log.txt") == 0) {
         AP::can().log_retrieve(*r.str);
@@ -91,7 +91,7 @@ const AP_Param::GroupInfo AP_GyroFFT::var_info[] = {
 
     // @Param: WINDOW_SIZE
     // @DisplayName: FFT window size
-    // @Description: Size of window to be used in FFT calculations. Takes effect on reboot. Must be a power of 2 and between 32 and 512. Larger windows give greater frequency resolution but poorer time resolution, consume more CPU time and may not be appropriate for all vehicles. Time and frequency resolution are given by the sample-rate / window-size. Windows of 256 are only really recommended for F7 class boards, windows of 512 or more H7 class.
+    // @Description: Size of window to be used in FFT calculations. Takes effect on reboot. Must be a power of 2 and between 32 and 512, or 1024 on Linux and SITL. Larger windows give greater frequency resolution but poorer time resolution, consume more CPU time and may not be appropriate for all vehicles. Time and frequency resolution are given by the sample-rate / window-size. Windows of 256 are only really recommended for F7 class boards, windows of 512 H7 class and windows of 1024 Linux flight computers.
     // @Range: 32 1024
     // @User: Advanced
     // @RebootRequired: True
@@ -196,7 +196,9 @@ void AP_GyroFFT::init(uint16_t loop_rate_hz)
 
     // check that we support the window size requested and it is a power of 2
     _window_size = 1 << lrintf(log2f(_window_size.get()));
-#if defined(STM32H7) || CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    _window_size = constrain_int16(_window_size, 32, 1024);
+#elif defined(STM32H7)
     _window_size = constrain_int16(_window_size, 32, 512);
 #else
     _window_size = constrain_int16(_window_size, 32, 256);
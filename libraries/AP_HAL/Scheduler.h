@@ -29,6 +29,20 @@ public:
      */
     virtual void     delay_microseconds_boost(uint16_t us) { delay_microseconds(us); }
 
+    /*
+      delay the main thread for up to the given number of
+      microseconds, returning early if another thread calls
+      wakeup_main_thread(). This lets the main thread start as soon
+      as new sensor data arrives. Platforms without a wakeup mechanism
+      delay for the full time
+     */
+    virtual void     delay_microseconds_wakeable(uint16_t us) { delay_microseconds_boost(us); }
+
+    /*
+      wake the main thread from delay_microseconds_wakeable()
+     */
+    virtual void     wakeup_main_thread(void) {}
+
     /*
       inform the scheduler that we are calling an operation from the
       main thread that may take an extended amount of time. This can
@@ -28,6 +28,25 @@ public:
     virtual ~Semaphore(void) {}
 };
 
+/*
+  a binary semaphore for one thread to wake another. A signal() with
+  no thread waiting is kept until the next wait()
+ */
+class AP_HAL::BinarySemaphore {
+public:
+    BinarySemaphore(bool initial_state=false) {}
+
+    // do not allow copying
+    BinarySemaphore(const BinarySemaphore &other) = delete;
+    BinarySemaphore &operator=(const BinarySemaphore&) = delete;
+
+    virtual bool wait(uint32_t timeout_us) WARN_IF_UNUSED = 0;
+    virtual bool wait_blocking() = 0;
+    virtual void signal() = 0;
+
+    virtual ~BinarySemaphore(void) {}
+};
+
 /*
   a method to make semaphores less error prone. The WITH_SEMAPHORE()
   macro will block forever for a semaphore, and will automatically
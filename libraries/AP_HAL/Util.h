@@ -171,6 +171,9 @@ public:
     // request information on running threads
     virtual void thread_info(ExpandingString &str) {}
 
+    // request a trace of recent thread scheduling as Chrome trace JSON
+    virtual void thread_trace(ExpandingString &str) {}
+
     // request information on dma contention
     virtual void dma_info(ExpandingString &str) {}
 
@@ -0,0 +1,36 @@
+#include <AP_gbenchmark.h>
+
+#include <math.h>
+#include <AP_HAL/utility/RealFFT.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  real FFT of a noisy two tone signal for the window sizes AP_GyroFFT
+  accepts on Linux and SITL
+ */
+static void BM_RealFFT(benchmark::State& state)
+{
+    const uint16_t length = state.range(0);
+    RealFFT fft;
+    fft.init(length);
+
+    float *in = new float[length];
+    float *out = new float[length + 2];
+    for (uint16_t n = 0; n < length; n++) {
+        in[n] = sinf(0.37f * n) + 0.25f * cosf(1.9f * n) + 0.01f * (n % 7);
+    }
+
+    for (auto _ : state) {
+        fft.forward(in, out);
+        gbenchmark_escape(out);
+    }
+    state.SetItemsProcessed(state.iterations() * length);
+
+    delete[] in;
+    delete[] out;
+}
+
+BENCHMARK(BM_RealFFT)->RangeMultiplier(2)->Range(32, 1024);
+
+BENCHMARK_MAIN();
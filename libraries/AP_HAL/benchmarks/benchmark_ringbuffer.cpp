@@ -0,0 +1,135 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_HAL/utility/RingBuffer.h>
+
+#include <atomic>
+#include <string.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  throughput of moving 64 byte chunks through a ByteBuffer by copying
+  and by filling the reserved segments in place
+ */
+static void BM_ByteBufferWriteRead(benchmark::State& state)
+{
+    ByteBuffer buf(1024);
+    uint8_t data[64] {};
+    uint8_t out[64];
+
+    for (auto _ : state) {
+        buf.write(data, sizeof(data));
+        gbenchmark_escape(out);
+        buf.read(out, sizeof(out));
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(data));
+}
+
+static void BM_ByteBufferReserveCommit(benchmark::State& state)
+{
+    ByteBuffer buf(1024);
+    uint8_t sum = 0;
+
+    for (auto _ : state) {
+        ByteBuffer::IoVec vec[2];
+        uint8_t n_vec = buf.reserve(vec, 64);
+        for (uint8_t i = 0; i < n_vec; i++) {
+            memset(vec[i].data, 0x55, vec[i].len);
+        }
+        buf.commit(64);
+        n_vec = buf.peekiovec(vec, 64);
+        for (uint8_t i = 0; i < n_vec; i++) {
+            sum += vec[i].data[0];
+        }
+        buf.advance(64);
+    }
+    gbenchmark_escape(&sum);
+    state.SetBytesProcessed(state.iterations() * 64);
+}
+
+struct BenchItem {
+    float x, y, z;
+    uint32_t t;
+};
+
+static void BM_ObjectBufferPushPop(benchmark::State& state)
+{
+    ObjectBuffer<BenchItem> buf(64);
+    BenchItem item {};
+
+    for (auto _ : state) {
+        buf.push(item);
+        gbenchmark_escape(&item);
+        UNUSED_RESULT(buf.pop(item));
+    }
+}
+
+static void BM_ObjectBufferTSPushPop(benchmark::State& state)
+{
+    ObjectBuffer_TS<BenchItem> buf(64);
+    BenchItem item {};
+
+    for (auto _ : state) {
+        buf.push(item);
+        gbenchmark_escape(&item);
+        UNUSED_RESULT(buf.pop(item));
+    }
+}
+
+static void BM_ObjectBufferMPSCPushPop(benchmark::State& state)
+{
+    ObjectBuffer_MPSC<BenchItem> buf(64);
+    BenchItem item {};
+
+    for (auto _ : state) {
+        buf.push(item);
+        gbenchmark_escape(&item);
+        UNUSED_RESULT(buf.pop(item));
+    }
+}
+
+/*
+  every thread pushes, and whichever thread finds the queue full drains
+  it, so the queues see contention from all threads on the push side
+  and a single consumer at a time
+ */
+static ObjectBuffer_TS<BenchItem> contended_ts(256);
+static ObjectBuffer_MPSC<BenchItem> contended_mpsc(256);
+static std::atomic<bool> draining;
+
+static void BM_ObjectBufferTSContended(benchmark::State& state)
+{
+    const BenchItem item {};
+
+    for (auto _ : state) {
+        if (!contended_ts.push(item)) {
+            BenchItem out;
+            while (contended_ts.pop(out)) {
+            }
+        }
+    }
+}
+
+static void BM_ObjectBufferMPSCContended(benchmark::State& state)
+{
+    const BenchItem item {};
+
+    for (auto _ : state) {
+        if (!contended_mpsc.push(item) && !draining.exchange(true)) {
+            BenchItem out;
+            while (contended_mpsc.pop(out)) {
+            }
+            draining = false;
+        }
+    }
+}
+
+BENCHMARK(BM_ByteBufferWriteRead);
+BENCHMARK(BM_ByteBufferReserveCommit);
+BENCHMARK(BM_ObjectBufferPushPop);
+BENCHMARK(BM_ObjectBufferTSPushPop);
+BENCHMARK(BM_ObjectBufferMPSCPushPop);
+BENCHMARK(BM_ObjectBufferTSContended)->ThreadRange(1, 4)->UseRealTime();
+BENCHMARK(BM_ObjectBufferMPSCContended)->ThreadRange(1, 4)->UseRealTime();
+
+BENCHMARK_MAIN();
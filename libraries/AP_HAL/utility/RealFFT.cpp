@@ -0,0 +1,219 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_DEBUG_BUILD
+#pragma GCC optimize("O2")
+#endif
+
+#include "RealFFT.h"
+
+#include <math.h>
+
+#if AP_HAL_REALFFT_SIMD
+#if defined(__SSE__)
+#include <xmmintrin.h>
+typedef __m128 v4f;
+static inline v4f v4f_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void v4f_store(float *p, v4f v) { _mm_storeu_ps(p, v); }
+static inline v4f v4f_mul(v4f a, v4f b) { return _mm_mul_ps(a, b); }
+static inline v4f v4f_add(v4f a, v4f b) { return _mm_add_ps(a, b); }
+static inline v4f v4f_sub(v4f a, v4f b) { return _mm_sub_ps(a, b); }
+#else
+#include <arm_neon.h>
+typedef float32x4_t v4f;
+static inline v4f v4f_load(const float *p) { return vld1q_f32(p); }
+static inline void v4f_store(float *p, v4f v) { vst1q_f32(p, v); }
+static inline v4f v4f_mul(v4f a, v4f b) { return vmulq_f32(a, b); }
+static inline v4f v4f_add(v4f a, v4f b) { return vaddq_f32(a, b); }
+static inline v4f v4f_sub(v4f a, v4f b) { return vsubq_f32(a, b); }
+#endif
+#endif // AP_HAL_REALFFT_SIMD
+
+RealFFT::~RealFFT()
+{
+    free_tables();
+}
+
+void RealFFT::free_tables()
+{
+    delete[] _bitrev;
+    delete[] _re;
+    delete[] _im;
+    delete[] _tw_re;
+    delete[] _tw_im;
+    delete[] _split_re;
+    delete[] _split_im;
+    _bitrev = nullptr;
+    _re = _im = nullptr;
+    _tw_re = _tw_im = nullptr;
+    _split_re = _split_im = nullptr;
+    _length = 0;
+    _half = 0;
+}
+
+bool RealFFT::init(uint16_t length)
+{
+    free_tables();
+
+    if (length < 8 || (length & (length - 1)) != 0) {
+        return false;
+    }
+    const uint16_t half = length / 2;
+
+    _bitrev = new uint16_t[half];
+    _re = new float[half];
+    _im = new float[half];
+    _tw_re = new float[half];
+    _tw_im = new float[half];
+    _split_re = new float[half];
+    _split_im = new float[half];
+    if (_bitrev == nullptr || _re == nullptr || _im == nullptr ||
+        _tw_re == nullptr || _tw_im == nullptr ||
+        _split_re == nullptr || _split_im == nullptr) {
+        free_tables();
+        return false;
+    }
+    _length = length;
+    _half = half;
+
+    uint8_t bits = 0;
+    while ((1U << bits) < half) {
+        bits++;
+    }
+    for (uint16_t i = 0; i < half; i++) {
+        uint16_t r = 0;
+        for (uint8_t b = 0; b < bits; b++) {
+            r |= ((i >> b) & 1U) << (bits - 1 - b);
+        }
+        _bitrev[i] = r;
+    }
+
+    // the twiddles of each stage are e^-2πij/(2*half) for j < half,
+    // computed in double so the long transforms stay accurate
+    for (uint16_t h = 4; h < half; h <<= 1) {
+        for (uint16_t j = 0; j < h; j++) {
+            const double angle = -M_PI * j / h;
+            _tw_re[h + j] = cos(angle);
+            _tw_im[h + j] = sin(angle);
+        }
+    }
+    for (uint16_t k = 0; k < half; k++) {
+        const double angle = -2.0 * M_PI * k / length;
+        _split_re[k] = cos(angle);
+        _split_im[k] = sin(angle);
+    }
+
+    return true;
+}
+
+/*
+  the first two radix-2 stages together, on each group of four bit
+  reversed samples. Their twiddles are 1 and -i so this is only adds
+ */
+void RealFFT::radix4_pass()
+{
+    for (uint16_t i = 0; i < _half; i += 4) {
+        float *re = &_re[i];
+        float *im = &_im[i];
+
+        const float r0 = re[0] + re[1], i0 = im[0] + im[1];
+        const float r1 = re[0] - re[1], i1 = im[0] - im[1];
+        const float r2 = re[2] + re[3], i2 = im[2] + im[3];
+        const float r3 = re[2] - re[3], i3 = im[2] - im[3];
+
+        re[0] = r0 + r2;
+        im[0] = i0 + i2;
+        re[2] = r0 - r2;
+        im[2] = i0 - i2;
+        // multiplying by -i swaps the parts and negates the new imaginary
+        re[1] = r1 + i3;
+        im[1] = i1 - r3;
+        re[3] = r1 - i3;
+        im[3] = i1 + r3;
+    }
+}
+
+/*
+  one radix-2 stage with butterflies half apart, half being at least 4
+ */
+void RealFFT::radix2_stage(uint16_t half, const float *tw_re, const float *tw_im)
+{
+    for (uint16_t base = 0; base < _half; base += 2 * half) {
+        float *are = &_re[base];
+        float *aim = &_im[base];
+        float *bre = &_re[base + half];
+        float *bim = &_im[base + half];
+
+#if AP_HAL_REALFFT_SIMD
+        for (uint16_t j = 0; j < half; j += 4) {
+            const v4f wr = v4f_load(&tw_re[j]);
+            const v4f wi = v4f_load(&tw_im[j]);
+            const v4f br = v4f_load(&bre[j]);
+            const v4f bi = v4f_load(&bim[j]);
+            const v4f tr = v4f_sub(v4f_mul(wr, br), v4f_mul(wi, bi));
+            const v4f ti = v4f_add(v4f_mul(wr, bi), v4f_mul(wi, br));
+            const v4f ar = v4f_load(&are[j]);
+            const v4f ai = v4f_load(&aim[j]);
+            v4f_store(&bre[j], v4f_sub(ar, tr));
+            v4f_store(&bim[j], v4f_sub(ai, ti));
+            v4f_store(&are[j], v4f_add(ar, tr));
+            v4f_store(&aim[j], v4f_add(ai, ti));
+        }
+#else
+        for (uint16_t j = 0; j < half; j++) {
+            const float tr = tw_re[j] * bre[j] - tw_im[j] * bim[j];
+            const float ti = tw_re[j] * bim[j] + tw_im[j] * bre[j];
+            bre[j] = are[j] - tr;
+            bim[j] = aim[j] - ti;
+            are[j] += tr;
+            aim[j] += ti;
+        }
+#endif
+    }
+}
+
+void RealFFT::forward(const float *in, float *out)
+{
+    // pack even samples as real and odd as imaginary parts, in bit
+    // reversed order
+    for (uint16_t n = 0; n < _half; n++) {
+        const uint16_t r = _bitrev[n];
+        _re[r] = in[2*n];
+        _im[r] = in[2*n+1];
+    }
+
+    radix4_pass();
+    for (uint16_t h = 4; h < _half; h <<= 1) {
+        radix2_stage(h, &_tw_re[h], &_tw_im[h]);
+    }
+
+    /*
+      separate the spectra of the even and odd samples, E[k] and O[k],
+      from Z[k] and Z[N/2-k], then combine them as X[k] = E[k] + e^-2πik/N O[k]
+     */
+    out[0] = _re[0] + _im[0];
+    out[1] = 0.0f;
+    out[_length] = _re[0] - _im[0];
+    out[_length+1] = 0.0f;
+    for (uint16_t k = 1; k < _half; k++) {
+        const uint16_t m = _half - k;
+        const float er = 0.5f * (_re[k] + _re[m]);
+        const float ei = 0.5f * (_im[k] - _im[m]);
+        const float or_ = 0.5f * (_im[k] + _im[m]);
+        const float oi = 0.5f * (_re[m] - _re[k]);
+        out[2*k] = er + _split_re[k] * or_ - _split_im[k] * oi;
+        out[2*k+1] = ei + _split_re[k] * oi + _split_im[k] * or_;
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifndef AP_HAL_REALFFT_SIMD
+#if defined(__SSE__) || defined(__ARM_NEON)
+#define AP_HAL_REALFFT_SIMD 1
+#else
+#define AP_HAL_REALFFT_SIMD 0
+#endif
+#endif
+
+/*
+  FFT of real input for the software DSP.
+
+  A real transform of length N is done as a complex transform of
+  length N/2 on the even samples as real parts and the odd samples as
+  imaginary parts, followed by a pass separating the two halves of the
+  spectrum again. The complex transform is an iterative radix-2
+  decimation in time with the first two stages merged into a radix-4
+  pass that needs no multiplies. All twiddle factors and the bit
+  reversal permutation are computed once in init(). Real and imaginary
+  parts are held in separate arrays with each stage's twiddles
+  contiguous, so the butterflies of a stage run four at a time on SSE
+  or NEON.
+ */
+class RealFFT {
+public:
+    RealFFT() {}
+    ~RealFFT();
+
+    RealFFT(const RealFFT &other) = delete;
+    RealFFT &operator=(const RealFFT&) = delete;
+
+    // prepare for transforms of length samples, which must be a power
+    // of two of at least 8. Returns false on a bad length or if memory
+    // could not be allocated
+    bool init(uint16_t length);
+
+    uint16_t get_length() const { return _length; }
+
+    /*
+      transform length real samples. out is filled with length/2+1
+      complex bins from DC to Nyquist, as interleaved real and
+      imaginary parts, so must have room for length+2 floats. The
+      result is the unnormalised forward DFT, X[k] = sum x[n]e^-2πikn/N
+     */
+    void forward(const float *in, float *out);
+
+private:
+    void free_tables();
+    void radix4_pass();
+    void radix2_stage(uint16_t half, const float *tw_re, const float *tw_im);
+
+    uint16_t _length = 0;
+    // length of the complex transform
+    uint16_t _half = 0;
+
+    // bit reversed position of each complex sample
+    uint16_t *_bitrev = nullptr;
+    // complex work buffer
+    float *_re = nullptr;
+    float *_im = nullptr;
+    // twiddles for the radix-2 stages, stage with butterflies half
+    // apart uses entries half to 2*half-1
+    float *_tw_re = nullptr;
+    float *_tw_im = nullptr;
+    // e^-2πik/N for separating the real spectrum, k < N/2
+    float *_split_re = nullptr;
+    float *_split_im = nullptr;
+};
@@ -41,16 +41,23 @@ bool ByteBuffer::set_size(uint32_t _size)
     return true;
 }
 
+/*
+  the producer only writes tail and the consumer only writes head. Each
+  side loads the other's index with acquire ordering, which pairs with
+  the release store in commit() or advance(), so the bytes behind the
+  index are visible before the index is
+ */
 uint32_t ByteBuffer::available(void) const
 {
-    /* use a copy on stack to avoid race conditions of @tail being updated by
-     * the writer thread */
-    uint32_t _tail = tail;
+    /* use copies on stack to avoid race conditions of @tail being
+     * updated by the writer thread or @head by the reader thread */
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+    const uint32_t _head = head.load(std::memory_order_acquire);
 
-    if (head > _tail) {
-        return size - head + _tail;
+    if (_head > _tail) {
+        return size - _head + _tail;
     }
-    return _tail - head;
+    return _tail - _head;
 }
 
 void ByteBuffer::clear(void)
@@ -64,23 +71,24 @@ uint32_t ByteBuffer::space(void) const
         return 0;
     }
 
-    /* use a copy on stack to avoid race conditions of @head being updated by
-     * the reader thread */
-    uint32_t _head = head;
+    /* use copies on stack to avoid race conditions of @head being
+     * updated by the reader thread or @tail by the writer thread */
+    const uint32_t _head = head.load(std::memory_order_acquire);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
     uint32_t ret = 0;
 
-    if (_head <= tail) {
+    if (_head <= _tail) {
         ret = size;
     }
 
-    ret += _head - tail - 1;
+    ret += _head - _tail - 1;
 
     return ret;
 }
 
 bool ByteBuffer::is_empty(void) const
 {
-    return head == tail;
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
 }
 
 uint32_t ByteBuffer::write(const uint8_t *data, uint32_t len)
@@ -107,12 +115,13 @@ bool ByteBuffer::update(const uint8_t *data, uint32_t len)
     if (len > available()) {
         return false;
     }
+    const uint32_t _head = head.load(std::memory_order_relaxed);
     // perform as two memcpy calls
-    uint32_t n = size - head;
+    uint32_t n = size - _head;
     if (n > len) {
         n = len;
     }
-    memcpy(&buf[head], data, n);
+    memcpy(&buf[_head], data, n);
     data += n;
     if (len > n) {
         memcpy(&buf[0], data, len-n);
@@ -125,7 +134,8 @@ bool ByteBuffer::advance(uint32_t n)
     if (n > available()) {
         return false;
     }
-    head = (head + n) % size;
+    // release the bytes back to the producer
+    head.store((head.load(std::memory_order_relaxed) + n) % size, std::memory_order_release);
     return true;
 }
 
@@ -194,9 +204,10 @@ uint8_t ByteBuffer::reserve(ByteBuffer::IoVec iovec[2], uint32_t len)
         return 0;
     }
 
-    iovec[0].data = &buf[tail];
+    const uint32_t _tail = tail.load(std::memory_order_relaxed);
+    iovec[0].data = &buf[_tail];
 
-    n = size - tail;
+    n = size - _tail;
     if (len <= n) {
         iovec[0].len = len;
         return 1;
@@ -219,7 +230,8 @@ bool ByteBuffer::commit(uint32_t len)
         return false; //Someone broke the agreement
     }
 
-    tail = (tail + len) % size;
+    // publish the bytes to the consumer
+    tail.store((tail.load(std::memory_order_relaxed) + len) % size, std::memory_order_release);
     return true;
 }
 
@@ -251,10 +263,11 @@ bool ByteBuffer::read_byte(uint8_t *data)
  */
 const uint8_t *ByteBuffer::readptr(uint32_t &available_bytes)
 {
-    uint32_t _tail = tail;
-    available_bytes = (head > _tail) ? size - head : _tail - head;
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    available_bytes = (_head > _tail) ? size - _head : _tail - _head;
 
-    return available_bytes ? &buf[head] : nullptr;
+    return available_bytes ? &buf[_head] : nullptr;
 }
 
 int16_t ByteBuffer::peek(uint32_t ofs) const
@@ -262,5 +275,5 @@ int16_t ByteBuffer::peek(uint32_t ofs) const
     if (ofs >= available()) {
         return -1;
     }
-    return buf[(head+ofs)%size];
+    return buf[(head.load(std::memory_order_relaxed)+ofs)%size];
 }
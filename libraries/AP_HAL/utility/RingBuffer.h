@@ -8,6 +8,17 @@
 
 /*
  * Circular buffer of bytes.
+ *
+ * One producer thread and one consumer thread may use a ByteBuffer at
+ * the same time without a lock. The producer may call write(),
+ * reserve(), commit() and space(). The consumer may call read(),
+ * read_byte(), peek(), peekbytes(), peekiovec(), readptr(), advance(),
+ * update() and available(). clear() and set_size() need both sides to
+ * be stopped or locked.
+ *
+ * For bulk transfers without a copy, the producer fills the segments
+ * from reserve() and then calls commit(), and the consumer reads the
+ * segments from peekiovec() and then calls advance().
  */
 class ByteBuffer {
 public:
@@ -265,9 +276,50 @@ public:
         return buffer->update((uint8_t*)&object, sizeof(T));
     }
 
+    /*
+      bulk access without copying, following the ByteBuffer rules for
+      one producer and one consumer. reserve() returns up to two runs
+      of free slots for up to n objects, to be filled and then passed
+      to commit(). peekiovec() returns up to two runs of up to n queued
+      objects, to be used and then passed to advance(). Both return the
+      number of runs filled in. There is no ObjectBuffer_TS version as
+      the pointers would outlive its semaphore
+     */
+    struct IoVec {
+        T *data;
+        uint32_t len;
+    };
+    uint8_t reserve(IoVec vec[2], uint32_t n) {
+        // limit to whole objects so each run is whole objects
+        ByteBuffer::IoVec bvec[2];
+        const uint32_t _space = space();
+        const uint8_t n_vec = buffer->reserve(bvec, (n < _space ? n : _space) * sizeof(T));
+        return to_objects(bvec, n_vec, vec);
+    }
+    bool commit(uint32_t n) {
+        return buffer->commit(n * sizeof(T));
+    }
+    uint8_t peekiovec(IoVec vec[2], uint32_t n) {
+        ByteBuffer::IoVec bvec[2];
+        const uint32_t _available = available();
+        const uint8_t n_vec = buffer->peekiovec(bvec, (n < _available ? n : _available) * sizeof(T));
+        return to_objects(bvec, n_vec, vec);
+    }
+
 private:
     ByteBuffer *buffer = nullptr;
     bool external_buf = true;
+
+    uint8_t to_objects(const ByteBuffer::IoVec bvec[2], uint8_t n_vec, IoVec vec[2]) const {
+        for (uint8_t i = 0; i < n_vec; i++) {
+            #pragma GCC diagnostic push
+            #pragma GCC diagnostic ignored "-Wcast-align"
+            vec[i].data = (T *)bvec[i].data;
+            #pragma GCC diagnostic pop
+            vec[i].len = bvec[i].len / sizeof(T);
+        }
+        return n_vec;
+    }
 };
 
 /*
@@ -452,6 +504,139 @@ private:
     HAL_Semaphore sem;
 };
 
+/*
+  ring buffer class for objects of fixed size which any number of
+  threads may push to while one thread pops, without a lock.
+
+  Each slot carries a sequence number. A producer claims a slot by
+  advancing the write position with a compare and swap, copies the
+  object in and then publishes the slot through its sequence number.
+  The consumer only takes a slot once it has been published, so a
+  producer which is preempted after claiming a slot holds up the
+  objects behind it until it runs again. The size is rounded up to a
+  power of two
+ */
+template <class T>
+class ObjectBuffer_MPSC {
+public:
+    ObjectBuffer_MPSC(uint32_t _size = 0) {
+        set_size(_size);
+    }
+    ~ObjectBuffer_MPSC(void) {
+        delete[] slots;
+    }
+
+    /* Do not allow copies */
+    ObjectBuffer_MPSC(const ObjectBuffer_MPSC &other) = delete;
+    ObjectBuffer_MPSC &operator=(const ObjectBuffer_MPSC&) = delete;
+
+    // return size of ringbuffer
+    uint32_t get_size(void) const {
+        return size;
+    }
+
+    // set size of ringbuffer, no other thread may be using it
+    bool set_size(uint32_t _size) {
+        delete[] slots;
+        slots = nullptr;
+        size = 0;
+        head = 0;
+        tail = 0;
+        if (_size == 0) {
+            return true;
+        }
+        uint32_t new_size = 1;
+        while (new_size < _size) {
+            new_size <<= 1;
+        }
+        slots = new slot[new_size];
+        if (slots == nullptr) {
+            return false;
+        }
+        for (uint32_t i = 0; i < new_size; i++) {
+            slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+        size = new_size;
+        return true;
+    }
+
+    // return number of objects claimed by producers and not yet
+    // popped. Only a hint while producers are running
+    uint32_t available(void) const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    // return number of objects that could be pushed. Only a hint
+    // while other threads are running
+    uint32_t space(void) const {
+        return size - available();
+    }
+
+    // true if there is nothing for the consumer to pop
+    bool is_empty(void) const WARN_IF_UNUSED {
+        return available() == 0;
+    }
+
+    // push one object onto the back of the queue. May be called from
+    // any thread
+    bool push(const T &object) {
+        if (size == 0) {
+            return false;
+        }
+        uint32_t pos = tail.load(std::memory_order_relaxed);
+        while (true) {
+            slot &s = slots[pos & (size-1)];
+            const int32_t diff = int32_t(s.seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                // the slot is free, try to claim it
+                if (tail.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
+                    s.object = object;
+                    s.seq.store(pos+1, std::memory_order_release);
+                    return true;
+                }
+                // pos now holds the new write position
+            } else if (diff < 0) {
+                // the consumer has not popped this slot yet, we are full
+                return false;
+            } else {
+                // another producer claimed the slot
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /*
+      pop earliest object off the front of the queue. Only one thread
+      may pop
+     */
+    bool pop(T &object) WARN_IF_UNUSED {
+        if (size == 0) {
+            return false;
+        }
+        const uint32_t pos = head.load(std::memory_order_relaxed);
+        slot &s = slots[pos & (size-1)];
+        if (int32_t(s.seq.load(std::memory_order_acquire) - (pos+1)) < 0) {
+            // empty, or the producer has not finished writing
+            return false;
+        }
+        object = s.object;
+        // free the slot for the producer one lap later
+        s.seq.store(pos + size, std::memory_order_release);
+        head.store(pos+1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct slot {
+        std::atomic<uint32_t> seq;
+        T object;
+    };
+    slot *slots = nullptr;
+    uint32_t size = 0;
+    std::atomic<uint32_t> head{0}; // next position to pop, consumer only
+    std::atomic<uint32_t> tail{0}; // next position to claim
+};
+
 /*
   ring buffer class for objects of fixed size with pointer
   access. Note that this is not thread safe, buf offers efficient
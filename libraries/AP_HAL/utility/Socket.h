@@ -62,6 +62,9 @@ public:
     // listen has been used. A new socket is returned
     SocketAPM *accept(uint32_t timeout_ms);
 
+    // return the file descriptor, for waiting on input with poll() or epoll
+    int get_read_fd(void) const { return fd; }
+
 private:
     bool datagram;
     struct sockaddr_in in_addr {};
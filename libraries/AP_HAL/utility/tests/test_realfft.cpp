@@ -0,0 +1,66 @@
+#include <AP_gtest.h>
+
+#include <math.h>
+#include <AP_HAL/utility/RealFFT.h>
+
+// forward() matches a directly evaluated DFT for every supported length
+TEST(RealFFTTest, MatchesDFT)
+{
+    for (uint16_t length = 8; length <= 1024; length <<= 1) {
+        RealFFT fft;
+        ASSERT_TRUE(fft.init(length));
+        EXPECT_EQ(length, fft.get_length());
+
+        float in[1024];
+        float out[1026];
+        for (uint16_t n = 0; n < length; n++) {
+            in[n] = sinf(0.37f * n) + 0.25f * cosf(1.9f * n + 0.3f) + ((n % 3) - 1) * 0.1f;
+        }
+        fft.forward(in, out);
+
+        for (uint16_t k = 0; k <= length / 2; k++) {
+            double re = 0, im = 0;
+            for (uint16_t n = 0; n < length; n++) {
+                const double angle = -2.0 * M_PI * k * n / length;
+                re += in[n] * cos(angle);
+                im += in[n] * sin(angle);
+            }
+            EXPECT_NEAR(re, out[2*k], 2e-5 * length);
+            EXPECT_NEAR(im, out[2*k+1], 2e-5 * length);
+        }
+    }
+}
+
+// a sinusoid centred on a bin puts all its energy in that bin
+TEST(RealFFTTest, SingleTone)
+{
+    const uint16_t length = 256;
+    const uint16_t bin = 19;
+    RealFFT fft;
+    ASSERT_TRUE(fft.init(length));
+
+    float in[length];
+    float out[length + 2];
+    for (uint16_t n = 0; n < length; n++) {
+        in[n] = cosf(2.0f * M_PI * bin * n / length);
+    }
+    fft.forward(in, out);
+
+    for (uint16_t k = 0; k <= length / 2; k++) {
+        const float mag = sqrtf(out[2*k] * out[2*k] + out[2*k+1] * out[2*k+1]);
+        EXPECT_NEAR(k == bin ? length / 2 : 0.0f, mag, 1e-3f);
+    }
+}
+
+TEST(RealFFTTest, BadLength)
+{
+    RealFFT fft;
+    EXPECT_FALSE(fft.init(4));
+    EXPECT_FALSE(fft.init(100));
+    EXPECT_EQ(0U, fft.get_length());
+    EXPECT_TRUE(fft.init(32));
+    EXPECT_FALSE(fft.init(48));
+    EXPECT_EQ(0U, fft.get_length());
+}
+
+AP_GTEST_MAIN()
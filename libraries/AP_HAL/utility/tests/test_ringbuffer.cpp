@@ -16,6 +16,7 @@
  */
 #include <AP_gtest.h>
 
+#include <thread>
 #include <utility>
 #include <AP_HAL/utility/RingBuffer.h>
 
@@ -122,4 +123,148 @@ TEST(ObjectBufferTest, PeekTest)
     }
 }
 
+// bytes written through reserve() and commit() come back out of
+// peekiovec() across the end of the buffer
+TEST(ByteBufferTest, ReserveCommitWrap)
+{
+    ByteBuffer buf(16);
+    uint8_t tmp[10] {};
+
+    // move the indexes near the end of the buffer
+    EXPECT_EQ(10U, buf.write(tmp, 10));
+    EXPECT_TRUE(buf.advance(10));
+
+    ByteBuffer::IoVec vec[2];
+    const uint8_t n_vec = buf.reserve(vec, 12);
+    ASSERT_EQ(2, n_vec);
+    EXPECT_EQ(6U, vec[0].len);
+    EXPECT_EQ(6U, vec[1].len);
+    uint8_t v = 0;
+    for (uint8_t i = 0; i < n_vec; i++) {
+        for (uint32_t k = 0; k < vec[i].len; k++) {
+            vec[i].data[k] = v++;
+        }
+    }
+    EXPECT_TRUE(buf.commit(12));
+    EXPECT_EQ(12U, buf.available());
+    EXPECT_EQ(3U, buf.space());
+
+    ASSERT_EQ(2, buf.peekiovec(vec, 12));
+    v = 0;
+    for (uint8_t i = 0; i < 2; i++) {
+        for (uint32_t k = 0; k < vec[i].len; k++) {
+            EXPECT_EQ(v++, vec[i].data[k]);
+        }
+    }
+    EXPECT_TRUE(buf.advance(12));
+    EXPECT_TRUE(buf.is_empty());
+}
+
+// bulk object access only hands out whole objects
+TEST(ObjectBufferTest, ReservePeekWrap)
+{
+    struct item {
+        uint32_t a;
+        uint16_t b;
+    };
+    ObjectBuffer<item> buf(5);
+    EXPECT_EQ(5U, buf.get_size());
+
+    for (uint32_t i = 0; i < 3; i++) {
+        EXPECT_TRUE(buf.push(item{i, 0}));
+        EXPECT_TRUE(buf.pop());
+    }
+
+    ObjectBuffer<item>::IoVec vec[2];
+    uint8_t n_vec = buf.reserve(vec, 10);
+    ASSERT_EQ(2, n_vec);
+    EXPECT_EQ(5U, vec[0].len + vec[1].len);
+    uint32_t v = 0;
+    for (uint8_t i = 0; i < n_vec; i++) {
+        for (uint32_t k = 0; k < vec[i].len; k++) {
+            vec[i].data[k] = item{v++, 7};
+        }
+    }
+    EXPECT_TRUE(buf.commit(5));
+    EXPECT_EQ(0U, buf.space());
+
+    n_vec = buf.peekiovec(vec, 4);
+    ASSERT_EQ(2, n_vec);
+    EXPECT_EQ(4U, vec[0].len + vec[1].len);
+    v = 0;
+    for (uint8_t i = 0; i < n_vec; i++) {
+        for (uint32_t k = 0; k < vec[i].len; k++) {
+            EXPECT_EQ(v++, vec[i].data[k].a);
+        }
+    }
+    EXPECT_TRUE(buf.advance(4));
+
+    item it;
+    EXPECT_TRUE(buf.pop(it));
+    EXPECT_EQ(4U, it.a);
+    EXPECT_TRUE(buf.is_empty());
+}
+
+TEST(ObjectBufferMPSCTest, PushPop)
+{
+    ObjectBuffer_MPSC<uint32_t> buf(5);
+    EXPECT_EQ(8U, buf.get_size());
+
+    uint32_t v;
+    EXPECT_FALSE(buf.pop(v));
+    for (uint32_t i = 0; i < 8; i++) {
+        EXPECT_TRUE(buf.push(i));
+    }
+    EXPECT_FALSE(buf.push(8));
+    EXPECT_EQ(8U, buf.available());
+
+    // go round several times to check the sequence numbers
+    for (uint32_t i = 0; i < 100; i++) {
+        EXPECT_TRUE(buf.pop(v));
+        EXPECT_EQ(i, v);
+        EXPECT_TRUE(buf.push(i + 8));
+    }
+    EXPECT_EQ(8U, buf.available());
+}
+
+// objects from several producers all arrive, in order per producer
+TEST(ObjectBufferMPSCTest, Producers)
+{
+    const uint8_t num_producers = 4;
+    const uint32_t per_producer = 100000;
+    ObjectBuffer_MPSC<uint32_t> buf(64);
+
+    std::thread producers[num_producers];
+    for (uint8_t p = 0; p < num_producers; p++) {
+        producers[p] = std::thread([&buf, p]() {
+            for (uint32_t i = 0; i < per_producer; i++) {
+                while (!buf.push((uint32_t(p) << 24) | i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    uint32_t next[num_producers] {};
+    uint32_t received = 0;
+    while (received < num_producers * per_producer) {
+        uint32_t v;
+        if (!buf.pop(v)) {
+            std::this_thread::yield();
+            continue;
+        }
+        const uint8_t p = v >> 24;
+        ASSERT_LT(p, num_producers);
+        EXPECT_EQ(next[p], v & 0xFFFFFF);
+        next[p] = (v & 0xFFFFFF) + 1;
+        received++;
+    }
+
+    for (uint8_t p = 0; p < num_producers; p++) {
+        producers[p].join();
+        EXPECT_EQ(per_producer, next[p]);
+    }
+    EXPECT_TRUE(buf.is_empty());
+}
+
 AP_GTEST_MAIN()
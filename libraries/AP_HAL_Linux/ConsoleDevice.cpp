@@ -76,6 +76,24 @@ ssize_t ConsoleDevice::write(const uint8_t *buf, uint16_t n)
     return ::write(_wr_fd, buf, n);
 }
 
+ssize_t ConsoleDevice::readv(const struct iovec *iov, int iovcnt)
+{
+    if (_closed) {
+        return -EAGAIN;
+    }
+
+    return ::readv(_rd_fd, iov, iovcnt);
+}
+
+ssize_t ConsoleDevice::writev(const struct iovec *iov, int iovcnt)
+{
+    if (_closed) {
+        return -EAGAIN;
+    }
+
+    return ::writev(_wr_fd, iov, iovcnt);
+}
+
 void ConsoleDevice::set_blocking(bool blocking)
 {
     int rd_flags;
@@ -12,6 +12,10 @@ public:
     virtual bool close() override;
     virtual ssize_t write(const uint8_t *buf, uint16_t n) override;
     virtual ssize_t read(uint8_t *buf, uint16_t n) override;
+    virtual ssize_t writev(const struct iovec *iov, int iovcnt) override;
+    virtual ssize_t readv(const struct iovec *iov, int iovcnt) override;
+    virtual int get_read_fd() const override { return _closed ? -1 : _rd_fd; }
+    virtual int get_write_fd() const override { return _closed ? -1 : _wr_fd; }
     virtual void set_blocking(bool blocking) override;
     virtual void set_speed(uint32_t speed) override;
 
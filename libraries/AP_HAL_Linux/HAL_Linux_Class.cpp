@@ -9,6 +9,7 @@
 
 #include <AP_HAL/AP_HAL.h>
 #include <AP_HAL/utility/RCOutput_Tap.h>
+#include <AP_HAL/utility/SoftwareDSP.h>
 #include <AP_HAL/utility/getopt_cpp.h>
 #include <AP_HAL_Empty/AP_HAL_Empty.h>
 #include <AP_HAL_Empty/AP_HAL_Empty_Private.h>
@@ -42,6 +43,7 @@
 #include "SPIUARTDriver.h"
 #include "Scheduler.h"
 #include "Storage.h"
+#include "ThreadTrace.h"
 #include "UARTDriver.h"
 #include "Util.h"
 #include "Util_RPI.h"
@@ -229,7 +231,11 @@ static OpticalFlow_Onboard opticalFlow;
 static Empty::OpticalFlow opticalFlow;
 #endif
 
+#if AP_HAL_SOFTWARE_DSP_ENABLED
+static SoftwareDSP dspDriver;
+#else
 static Empty::DSP dspDriver;
+#endif
 static Empty::Flash flashDriver;
 static Empty::QSPIDeviceManager qspi_mgr_instance;
 
@@ -454,6 +460,11 @@ void HAL_Linux::setup_signal_handlers() const
     sa.sa_handler = HAL_Linux::exit_signal_handler;
     sigaction(SIGTERM, &sa, NULL);
     sigaction(SIGINT, &sa, NULL);
+
+#if AP_LINUX_THREAD_TRACE_ENABLED
+    sa.sa_handler = ThreadTrace::signal_handler;
+    sigaction(SIGUSR1, &sa, NULL);
+#endif
 }
 
 HAL_Linux hal_linux;
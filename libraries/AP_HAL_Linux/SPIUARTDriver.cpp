@@ -136,6 +136,26 @@ int SPIUARTDriver::_read_fd(uint8_t *buf, uint16_t n)
     return n;
 }
 
+/*
+  the SPI transfers work on one buffer at a time, a short transfer
+  leaves the rest for the next call
+ */
+int SPIUARTDriver::_writev_fd(const struct iovec *iov, int iovcnt)
+{
+    if (_external) {
+        return UARTDriver::_writev_fd(iov, iovcnt);
+    }
+    return _write_fd((const uint8_t *)iov[0].iov_base, iov[0].iov_len);
+}
+
+int SPIUARTDriver::_readv_fd(const struct iovec *iov, int iovcnt)
+{
+    if (_external) {
+        return UARTDriver::_readv_fd(iov, iovcnt);
+    }
+    return _read_fd((uint8_t *)iov[0].iov_base, iov[0].iov_len);
+}
+
 void SPIUARTDriver::_timer_tick(void)
 {
     if (_external) {
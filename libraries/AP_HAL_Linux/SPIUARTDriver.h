@@ -15,6 +15,8 @@ public:
 protected:
     int _write_fd(const uint8_t *buf, uint16_t n) override;
     int _read_fd(uint8_t *buf, uint16_t n) override;
+    int _writev_fd(const struct iovec *iov, int iovcnt) override;
+    int _readv_fd(const struct iovec *iov, int iovcnt) override;
 
     AP_HAL::OwnPtr<AP_HAL::SPIDevice> _dev;
 
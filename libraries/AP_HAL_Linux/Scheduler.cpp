@@ -5,8 +5,10 @@
 #include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/eventfd.h>
 #include <sys/mman.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <AP_HAL/AP_HAL.h>
@@ -115,6 +117,15 @@ void Scheduler::init()
 
     _main_ctx = pthread_self();
 
+    _wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_wakeup_fd == -1) {
+        fprintf(stderr, "Scheduler: unable to create eventfd, main loop waits will poll: %m\n");
+    }
+
+#if AP_LINUX_THREAD_TRACE_ENABLED
+    _main_trace = ThreadTrace::create("ap-main");
+#endif
+
     init_realtime();
     init_cpu_affinity();
 
@@ -157,12 +168,18 @@ void Scheduler::_debug_stack()
     }
 }
 
+/*
+  sleep until an absolute time on the same clock as AP_HAL::micros(),
+  so that interrupted sleeps do not add up to a longer delay
+ */
 void Scheduler::microsleep(uint32_t usec)
 {
     struct timespec ts;
-    ts.tv_sec = 0;
-    ts.tv_nsec = usec*1000UL;
-    while (nanosleep(&ts, &ts) == -1 && errno == EINTR) ;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const uint64_t deadline_ns = ts.tv_sec * 1000000000ULL + ts.tv_nsec + usec * 1000ULL;
+    ts.tv_sec = deadline_ns / 1000000000ULL;
+    ts.tv_nsec = deadline_ns % 1000000000ULL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) ;
 }
 
 void Scheduler::delay(uint16_t ms)
@@ -190,6 +207,60 @@ void Scheduler::delay_microseconds(uint16_t us)
     microsleep(us);
 }
 
+/*
+  wait on the eventfd so that a sensor thread can wake us as soon as
+  new data is ready, falling back to a plain sleep
+ */
+void Scheduler::delay_microseconds_wakeable(uint16_t us)
+{
+    if (_stopped_clock_usec) {
+        return;
+    }
+    if (_wakeup_fd == -1 || !in_main_thread()) {
+        microsleep(us);
+        return;
+    }
+
+#if AP_LINUX_THREAD_TRACE_ENABLED
+    const uint64_t sleep_usec = AP_HAL::micros64();
+    if (_main_trace != nullptr && _main_wake_usec != 0) {
+        _main_trace->record(_main_due_usec, _main_wake_usec, sleep_usec);
+    }
+    _wakeup_request_usec = 0;
+#endif
+
+    _main_waiting = true;
+    struct pollfd fds { _wakeup_fd, POLLIN, 0 };
+    const struct timespec ts { 0, long(us) * 1000L };
+    const bool woken = ppoll(&fds, 1, &ts, nullptr) > 0;
+    if (woken) {
+        uint64_t count;
+        UNUSED_RESULT(read(_wakeup_fd, &count, sizeof(count)));
+    }
+    _main_waiting = false;
+
+#if AP_LINUX_THREAD_TRACE_ENABLED
+    // the latency is from the wakeup, or from the end of the timeout
+    _main_wake_usec = AP_HAL::micros64();
+    _main_due_usec = (woken && _wakeup_request_usec != 0) ? _wakeup_request_usec : sleep_usec + us;
+#endif
+}
+
+void Scheduler::wakeup_main_thread(void)
+{
+    // only make the system call when the main thread is waiting. A
+    // wakeup missed while it starts to wait costs one timeout
+    if (_main_waiting && _wakeup_fd != -1) {
+#if AP_LINUX_THREAD_TRACE_ENABLED
+        if (_wakeup_request_usec == 0) {
+            _wakeup_request_usec = AP_HAL::micros64();
+        }
+#endif
+        const uint64_t one = 1;
+        UNUSED_RESULT(write(_wakeup_fd, &one, sizeof(one)));
+    }
+}
+
 void Scheduler::register_timer_process(AP_HAL::MemberProc proc)
 {
     for (uint8_t i = 0; i < _num_timer_procs; i++) {
@@ -294,6 +365,11 @@ void Scheduler::_io_task()
 
     // run registered IO processes
     _run_io();
+
+#if AP_LINUX_THREAD_TRACE_ENABLED
+    // write the thread trace if SIGUSR1 asked for it
+    ThreadTrace::update();
+#endif
 }
 
 bool Scheduler::in_main_thread() const
@@ -352,6 +428,37 @@ bool Scheduler::SchedulerThread::_run()
     return PeriodicThread::_run();
 }
 
+/*
+  wait for serial data until the next tick, handing each port its data
+  as soon as it arrives. Pending writes are still pushed out at the
+  thread rate
+ */
+void Scheduler::UARTThread::_sleep(uint64_t usec)
+{
+    Poller &poller = _sched._serial_poller;
+    if (!poller) {
+        PeriodicThread::_sleep(usec);
+        return;
+    }
+
+    const uint64_t deadline_usec = AP_HAL::micros64() + usec;
+    while (!_should_exit) {
+        const uint64_t now_usec = AP_HAL::micros64();
+        if (now_usec >= deadline_usec) {
+            break;
+        }
+        const uint64_t remaining_usec = deadline_usec - now_usec;
+        if (remaining_usec < 1000) {
+            // epoll has millisecond resolution, sleep for the rest
+            _sched.microsleep(remaining_usec);
+            break;
+        }
+        if (poller.poll(remaining_usec / 1000) > 0) {
+            _sched._run_uarts();
+        }
+    }
+}
+
 void Scheduler::teardown()
 {
     _timer_thread.stop();
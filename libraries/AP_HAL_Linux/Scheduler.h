@@ -4,8 +4,10 @@
 
 #include "AP_HAL_Linux.h"
 
+#include "Poller.h"
 #include "Semaphores.h"
 #include "Thread.h"
+#include "ThreadTrace.h"
 
 #define LINUX_SCHEDULER_MAX_TIMER_PROCS 10
 #define LINUX_SCHEDULER_MAX_TIMESLICED_PROCS 10
@@ -28,6 +30,8 @@ public:
     void     init() override;
     void     delay(uint16_t ms) override;
     void     delay_microseconds(uint16_t us) override;
+    void     delay_microseconds_wakeable(uint16_t us) override;
+    void     wakeup_main_thread(void) override;
 
     void     register_timer_process(AP_HAL::MemberProc) override;
     void     register_io_process(AP_HAL::MemberProc) override;
@@ -60,6 +64,13 @@ public:
      */
     void set_cpu_affinity(const cpu_set_t &cpu_affinity) { _cpu_affinity = cpu_affinity; }
 
+    /*
+      poller used by the UART thread. Serial ports register their file
+      descriptors here so the thread services them as soon as they
+      have data rather than at its next tick
+     */
+    Poller &get_serial_poller() { return _serial_poller; }
+
 private:
     class SchedulerThread : public PeriodicThread {
     public:
@@ -74,6 +85,17 @@ private:
         Scheduler &_sched;
     };
 
+    class UARTThread : public SchedulerThread {
+    public:
+        UARTThread(Thread::task_t t, Scheduler &sched)
+            : SchedulerThread(t, sched)
+        { }
+
+    protected:
+        // wait on the serial poller rather than sleeping
+        void _sleep(uint64_t usec) override;
+    };
+
     void     init_realtime();
 
     void     init_cpu_affinity();
@@ -101,7 +123,7 @@ private:
     SchedulerThread _timer_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_timer_task, void), *this};
     SchedulerThread _io_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_io_task, void), *this};
     SchedulerThread _rcin_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_rcin_task, void), *this};
-    SchedulerThread _uart_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_uart_task, void), *this};
+    UARTThread _uart_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_uart_task, void), *this};
 
     void _timer_task();
     void _io_task();
@@ -116,7 +138,20 @@ private:
     pthread_t _main_ctx;
 
     Semaphore _io_semaphore;
+    Poller _serial_poller;
     cpu_set_t _cpu_affinity;
+
+    // eventfd used to wake the main thread, and whether it is waiting
+    int _wakeup_fd = -1;
+    volatile bool _main_waiting = false;
+
+#if AP_LINUX_THREAD_TRACE_ENABLED
+    // the main thread is traced from one wakeable delay to the next
+    ThreadTrace *_main_trace;
+    volatile uint64_t _wakeup_request_usec;
+    uint64_t _main_due_usec;
+    uint64_t _main_wake_usec;
+#endif
 };
 
 }
@@ -2,6 +2,8 @@
 
 #include "Semaphores.h"
 
+#include <time.h>
+
 extern const AP_HAL::HAL& hal;
 
 using namespace Linux;
@@ -43,3 +45,58 @@ bool Semaphore::take_nonblocking()
     return pthread_mutex_trylock(&_lock) == 0;
 }
 
+// construct a binary semaphore. The condition uses the monotonic
+// clock so timeouts are not changed by setting the system time
+BinarySemaphore::BinarySemaphore(bool initial_state) :
+    AP_HAL::BinarySemaphore(initial_state),
+    _pending(initial_state)
+{
+    pthread_mutex_init(&_lock, nullptr);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+bool BinarySemaphore::wait(uint32_t timeout_us)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeout_us / 1000000U;
+    ts.tv_nsec += (timeout_us % 1000000U) * 1000U;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&_lock);
+    while (!_pending) {
+        if (pthread_cond_timedwait(&_cond, &_lock, &ts) != 0 && !_pending) {
+            pthread_mutex_unlock(&_lock);
+            return false;
+        }
+    }
+    _pending = false;
+    pthread_mutex_unlock(&_lock);
+    return true;
+}
+
+bool BinarySemaphore::wait_blocking()
+{
+    pthread_mutex_lock(&_lock);
+    while (!_pending) {
+        pthread_cond_wait(&_cond, &_lock);
+    }
+    _pending = false;
+    pthread_mutex_unlock(&_lock);
+    return true;
+}
+
+void BinarySemaphore::signal()
+{
+    pthread_mutex_lock(&_lock);
+    _pending = true;
+    pthread_cond_signal(&_cond);
+    pthread_mutex_unlock(&_lock);
+}
@@ -14,6 +14,13 @@ public:
     virtual void set_speed(uint32_t speed) override;
     virtual ssize_t write(const uint8_t *buf, uint16_t n) override;
     virtual ssize_t read(uint8_t *buf, uint16_t n) override;
+    // until a client connects, input means a connection is waiting
+    virtual int get_read_fd() const override {
+        return sock != nullptr ? sock->get_read_fd() : listener.get_read_fd();
+    }
+    virtual int get_write_fd() const override {
+        return sock != nullptr ? sock->get_read_fd() : -1;
+    }
 
 private:
     SocketAPM listener{false};
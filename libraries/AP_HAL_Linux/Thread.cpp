@@ -26,6 +26,7 @@
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Math/AP_Math.h>
 #include "Scheduler.h"
+#include "ThreadTrace.h"
 
 #define STACK_POISON 0xBEBACAFE
 
@@ -190,6 +191,9 @@ bool Thread::start(const char *name, int policy, int prio)
         }
     }
 
+    // the new thread may use its name at once
+    _name = name;
+
     r = pthread_create(&_ctx, &attr, &Thread::_run_trampoline, this);
     if (r != 0) {
         AP_HAL::panic("Failed to create thread '%s': %s",
@@ -256,6 +260,10 @@ bool PeriodicThread::_run()
         return false;
     }
 
+#if AP_LINUX_THREAD_TRACE_ENABLED
+    ThreadTrace *trace = ThreadTrace::create(_name);
+#endif
+
     uint64_t next_run_usec = AP_HAL::micros64() + _period_usec;
 
     while (!_should_exit) {
@@ -264,11 +272,21 @@ bool PeriodicThread::_run()
             // we've lost sync - restart
             next_run_usec = AP_HAL::micros64();
         } else {
-            Scheduler::from(hal.scheduler)->microsleep(dt);
+            _sleep(dt);
         }
+#if AP_LINUX_THREAD_TRACE_ENABLED
+        const uint64_t due_usec = next_run_usec;
+        const uint64_t wake_usec = AP_HAL::micros64();
+#endif
         next_run_usec += _period_usec;
 
         _task();
+
+#if AP_LINUX_THREAD_TRACE_ENABLED
+        if (trace != nullptr) {
+            trace->record(due_usec, wake_usec, AP_HAL::micros64());
+        }
+#endif
     }
 
     _started = false;
@@ -277,6 +295,11 @@ bool PeriodicThread::_run()
     return true;
 }
 
+void PeriodicThread::_sleep(uint64_t usec)
+{
+    Scheduler::from(hal.scheduler)->microsleep(usec);
+}
+
 bool PeriodicThread::stop()
 {
     if (!is_started()) {
@@ -64,6 +64,7 @@ protected:
     void _poison_stack();
 
     task_t _task;
+    const char *_name = nullptr;
     bool _started = false;
     bool _should_exit = false;
     bool _auto_free = false;
@@ -90,6 +91,9 @@ public:
 protected:
     bool _run() override;
 
+    // wait until the next period is due
+    virtual void _sleep(uint64_t usec);
+
     uint64_t _period_usec = 0;
 };
 
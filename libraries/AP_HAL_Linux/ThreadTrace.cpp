@@ -0,0 +1,181 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ThreadTrace.h"
+
+#if AP_LINUX_THREAD_TRACE_ENABLED
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <AP_Common/ExpandingString.h>
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+
+#define THREAD_TRACE_FILE "thread_trace.json"
+
+namespace Linux {
+
+ThreadTrace *ThreadTrace::_traces[max_traces];
+std::atomic<uint8_t> ThreadTrace::_num_traces;
+volatile sig_atomic_t ThreadTrace::_dump_requested;
+
+ThreadTrace *ThreadTrace::create(const char *name)
+{
+    if (_num_traces.load() >= max_traces) {
+        return nullptr;
+    }
+    const uint8_t idx = _num_traces.fetch_add(1);
+    if (idx >= max_traces) {
+        return nullptr;
+    }
+    ThreadTrace *trace = new ThreadTrace();
+    if (trace == nullptr) {
+        return nullptr;
+    }
+    strncpy(trace->_name, name != nullptr ? name : "unknown", sizeof(trace->_name)-1);
+    _traces[idx] = trace;
+    return trace;
+}
+
+void ThreadTrace::record(uint64_t due_us, uint64_t wake_us, uint64_t sleep_us)
+{
+    const uint32_t latency_us = wake_us > due_us ? wake_us - due_us : 0;
+
+    // only this thread writes the ring, readers use the count to find
+    // which cycles are complete
+    const uint32_t count = _count.load(std::memory_order_relaxed);
+    cycle &c = _ring[count % trace_length];
+    c.wake_us = wake_us;
+    c.latency_us = latency_us;
+    c.run_us = sleep_us - wake_us;
+    _count.store(count + 1, std::memory_order_release);
+
+    const uint8_t bucket = latency_us == 0 ? 0 : 32 - __builtin_clz(latency_us);
+    _histogram[MIN(bucket, num_buckets-1)]++;
+    _max_latency_us = MAX(_max_latency_us, latency_us);
+}
+
+uint16_t ThreadTrace::snapshot(cycle *cycles) const
+{
+    const uint32_t end = _count.load(std::memory_order_acquire);
+    const uint32_t start = end > trace_length ? end - trace_length : 0;
+    for (uint32_t i = start; i < end; i++) {
+        cycles[i - start] = _ring[i % trace_length];
+    }
+
+    // drop the cycles the thread may have written over while we copied
+    const uint32_t now = _count.load(std::memory_order_acquire);
+    uint32_t first = start;
+    if (now + 1 > trace_length) {
+        first = MAX(first, now + 1 - trace_length);
+    }
+    if (first >= end) {
+        return 0;
+    }
+    memmove(cycles, &cycles[first - start], (end - first) * sizeof(cycle));
+    return end - first;
+}
+
+void ThreadTrace::thread_info(ExpandingString &str)
+{
+    str.printf("ThreadLatency (us: count)\n");
+    for (uint8_t i = 0; i < max_traces; i++) {
+        const ThreadTrace *trace = _traces[i];
+        if (trace == nullptr) {
+            continue;
+        }
+        str.printf("%-16.16s N=%u MAX=%u",
+                   trace->_name,
+                   (unsigned)trace->_count.load(),
+                   (unsigned)trace->_max_latency_us);
+        for (uint8_t b = 0; b < num_buckets; b++) {
+            if (trace->_histogram[b] != 0) {
+                const unsigned lower_us = b == 0 ? 0 : 1U << (b-1);
+                str.printf(" %s%u:%u", b == num_buckets-1 ? ">=" : "",
+                           lower_us, (unsigned)trace->_histogram[b]);
+            }
+        }
+        str.printf("\n");
+    }
+}
+
+/*
+  each cycle becomes a complete event from when the thread woke to
+  when it slept again, with its wake latency as an argument
+ */
+void ThreadTrace::chrome_trace(ExpandingString &str)
+{
+    cycle *cycles = new cycle[trace_length];
+    if (cycles == nullptr) {
+        return;
+    }
+
+    str.printf("{\"traceEvents\":[\n");
+    bool first = true;
+    for (uint8_t i = 0; i < max_traces; i++) {
+        const ThreadTrace *trace = _traces[i];
+        if (trace == nullptr) {
+            continue;
+        }
+        str.printf("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                   first ? "" : ",\n", unsigned(i), trace->_name);
+        first = false;
+        const uint16_t n = trace->snapshot(cycles);
+        for (uint16_t k = 0; k < n; k++) {
+            const cycle &c = cycles[k];
+            str.printf(",\n{\"name\":\"run\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%u,\"args\":{\"latency_us\":%u}}",
+                       unsigned(i), (unsigned long long)c.wake_us,
+                       (unsigned)c.run_us, (unsigned)c.latency_us);
+        }
+    }
+    str.printf("\n]}\n");
+
+    delete[] cycles;
+}
+
+void ThreadTrace::update()
+{
+    if (!_dump_requested) {
+        return;
+    }
+    _dump_requested = false;
+
+    ExpandingString str {};
+    chrome_trace(str);
+    if (str.has_failed_allocation()) {
+        fprintf(stderr, "ThreadTrace: out of memory\n");
+        return;
+    }
+
+    const int fd = open(THREAD_TRACE_FILE, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        fprintf(stderr, "ThreadTrace: unable to open " THREAD_TRACE_FILE ": %s\n", strerror(errno));
+        return;
+    }
+    const ssize_t ret = write(fd, str.get_string(), str.get_length());
+    close(fd);
+    if (ret != (ssize_t)str.get_length()) {
+        fprintf(stderr, "ThreadTrace: short write to " THREAD_TRACE_FILE "\n");
+        return;
+    }
+    fprintf(stderr, "ThreadTrace: written to " THREAD_TRACE_FILE "\n");
+}
+
+}
+
+#endif  // AP_LINUX_THREAD_TRACE_ENABLED
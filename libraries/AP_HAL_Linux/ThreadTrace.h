@@ -0,0 +1,100 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <inttypes.h>
+#include <signal.h>
+
+#ifndef AP_LINUX_THREAD_TRACE_ENABLED
+#define AP_LINUX_THREAD_TRACE_ENABLED 1
+#endif
+
+#if AP_LINUX_THREAD_TRACE_ENABLED
+
+class ExpandingString;
+
+namespace Linux {
+
+/*
+  scheduling trace of one thread.
+
+  Each cycle of a traced thread records when it was due to wake, when
+  it actually woke and when it went back to sleep. The last
+  trace_length cycles are kept in a ring written only by the traced
+  thread, and every wake latency is counted in a histogram with power
+  of two buckets.
+
+  The rings can be exported as Chrome trace JSON, which chrome://tracing
+  and Perfetto both load, through @SYS/thread_trace.json or by sending
+  the process SIGUSR1, which writes thread_trace.json to the current
+  directory. The histograms are part of @SYS/threads.txt
+ */
+class ThreadTrace {
+public:
+    // create the trace for the calling thread, nullptr if there are
+    // already too many
+    static ThreadTrace *create(const char *name);
+
+    // record one cycle of the thread
+    void record(uint64_t due_us, uint64_t wake_us, uint64_t sleep_us);
+
+    // print the latency histograms of all threads
+    static void thread_info(ExpandingString &str);
+
+    // print the rings of all threads as Chrome trace JSON
+    static void chrome_trace(ExpandingString &str);
+
+    // SIGUSR1 handler, asking for the trace to be written to a file
+    static void signal_handler(int signum) { _dump_requested = true; }
+
+    // write the trace if it has been asked for. Called from the IO thread
+    static void update();
+
+private:
+    ThreadTrace() {}
+
+    static const uint16_t trace_length = 1024;
+    static const uint8_t num_buckets = 16;
+    static const uint8_t max_traces = 16;
+
+    struct cycle {
+        uint64_t wake_us;
+        uint32_t latency_us;
+        uint32_t run_us;
+    };
+
+    char _name[16];
+    cycle _ring[trace_length];
+    // number of cycles ever recorded, the ring index is this modulo
+    // the ring length
+    std::atomic<uint32_t> _count;
+
+    // bucket n counts latencies from 2^(n-1) to 2^n-1 microseconds,
+    // the last bucket counts everything longer
+    uint32_t _histogram[num_buckets];
+    uint32_t _max_latency_us;
+
+    // copy out the cycles still in the ring, oldest first
+    uint16_t snapshot(cycle *cycles) const;
+
+    static ThreadTrace *_traces[max_traces];
+    static std::atomic<uint8_t> _num_traces;
+    static volatile sig_atomic_t _dump_requested;
+};
+
+}
+
+#endif  // AP_LINUX_THREAD_TRACE_ENABLED
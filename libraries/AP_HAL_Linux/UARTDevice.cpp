@@ -2,7 +2,6 @@
 
 #include <errno.h>
 #include <fcntl.h>
-#include <poll.h>
 #include <stdio.h>
 #include <termios.h>
 #include <unistd.h>
@@ -51,20 +50,23 @@ ssize_t UARTDevice::read(uint8_t *buf, uint16_t n)
     return ::read(_fd, buf, n);
 }
 
+/*
+  the port is non-blocking, so a full output buffer shows up as
+  EAGAIN and the UART thread waits for it to drain
+ */
 ssize_t UARTDevice::write(const uint8_t *buf, uint16_t n)
 {
-    struct pollfd fds;
-    fds.fd = _fd;
-    fds.events = POLLOUT;
-    fds.revents = 0;
-
-    int ret = 0;
+    return ::write(_fd, buf, n);
+}
 
-    if (poll(&fds, 1, 0) == 1) {
-        ret = ::write(_fd, buf, n);
-    }
+ssize_t UARTDevice::writev(const struct iovec *iov, int iovcnt)
+{
+    return ::writev(_fd, iov, iovcnt);
+}
 
-    return ret;
+ssize_t UARTDevice::readv(const struct iovec *iov, int iovcnt)
+{
+    return ::readv(_fd, iov, iovcnt);
 }
 
 void UARTDevice::set_blocking(bool blocking)
@@ -10,16 +10,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <termios.h>
 #include <unistd.h>
 
 #include <AP_HAL/AP_HAL.h>
 
 #include "ConsoleDevice.h"
+#include "Scheduler.h"
 #include "TCPServerDevice.h"
 #include "UARTDevice.h"
 #include "UDPDevice.h"
@@ -222,6 +225,9 @@ void UARTDriver::end()
         hal.scheduler->delay(1);
     }
 
+    // a closed descriptor leaves epoll by itself, but its number may
+    // be reused when the device opens again
+    _unregister_pollable();
     _device->close();
     _deallocate_buffers();
 }
@@ -356,18 +362,23 @@ size_t UARTDriver::write(const uint8_t *buffer, size_t size)
 }
 
 /*
-  try writing n bytes, handling an unresponsive port
+  allow for delayed connection. This allows ArduPilot to start
+  before a network interface is available.
  */
-int UARTDriver::_write_fd(const uint8_t *buf, uint16_t n)
+bool UARTDriver::_check_connected(void)
 {
-    /*
-      allow for delayed connection. This allows ArduPilot to start
-      before a network interface is available.
-     */
     if (!_connected) {
         _connected = _device->open();
     }
-    if (!_connected) {
+    return _connected;
+}
+
+/*
+  try writing n bytes, handling an unresponsive port
+ */
+int UARTDriver::_write_fd(const uint8_t *buf, uint16_t n)
+{
+    if (!_check_connected()) {
         return 0;
     }
 
@@ -382,6 +393,71 @@ int UARTDriver::_read_fd(uint8_t *buf, uint16_t n)
     return _device->read(buf, n);
 }
 
+/*
+  try writing the buffers with a single call to the device
+ */
+int UARTDriver::_writev_fd(const struct iovec *iov, int iovcnt)
+{
+    if (!_check_connected()) {
+        return 0;
+    }
+
+    return _device->writev(iov, iovcnt);
+}
+
+/*
+  try filling the buffers with a single call to the device
+ */
+int UARTDriver::_readv_fd(const struct iovec *iov, int iovcnt)
+{
+    return _device->readv(iov, iovcnt);
+}
+
+/*
+  keep the poller watching the current file descriptors of the
+  device. Called from the UART thread, which is the only thread
+  waiting on the poller
+ */
+void UARTDriver::_update_pollable(void)
+{
+    const int fd = _connected ? _device->get_read_fd() : -1;
+    if (fd == _pollable.get_fd()) {
+        return;
+    }
+
+    _unregister_pollable();
+    if (fd == -1) {
+        return;
+    }
+
+    // write readiness can only be waited for on a shared descriptor
+    uint32_t events = EPOLLIN | EPOLLET;
+    if (_device->get_write_fd() == fd) {
+        events |= EPOLLOUT;
+    }
+    _pollable.set_fd(fd);
+    if (!Scheduler::from(hal.scheduler)->get_serial_poller().register_pollable(&_pollable, events)) {
+        // fall back to trying the device every tick
+        _pollable.set_fd(-1);
+        return;
+    }
+    _poll_writes = (events & EPOLLOUT) != 0;
+}
+
+void UARTDriver::_unregister_pollable(void)
+{
+    if (_pollable.get_fd() != -1) {
+        Scheduler::from(hal.scheduler)->get_serial_poller().unregister_pollable(&_pollable);
+        _pollable.set_fd(-1);
+    }
+    _poll_writes = false;
+
+    // try the device first, the poller only reports changes from
+    // when the descriptor is registered
+    _pollable.can_read = true;
+    _pollable.can_write = true;
+}
+
 
 /*
   try to push out one lump of pending bytes
@@ -408,32 +484,61 @@ bool UARTDriver::_write_pending_bytes(void)
             uint8_t tmpbuf[n];
             _writebuf.peekbytes(tmpbuf, n);
             ret = _write_fd(tmpbuf, n);
-            if (ret > 0)
-                _writebuf.advance(ret);
         } else {
             ByteBuffer::IoVec vec[2];
+            struct iovec iov[2];
             const auto n_vec = _writebuf.peekiovec(vec, n);
             for (int i = 0; i < n_vec; i++) {
-                ret = _write_fd(vec[i].data, (uint16_t)vec[i].len);
-                if (ret < 0) {
-                    break;
-                }
-                _writebuf.advance(ret);
-
-                /* We wrote less than we asked for, stop */
-                if ((unsigned)ret != vec[i].len) {
-                    break;
-                }
+                iov[i].iov_base = vec[i].data;
+                iov[i].iov_len = vec[i].len;
             }
+            ret = _writev_fd(iov, n_vec);
         }
+        if (ret > 0) {
+            _writebuf.advance(ret);
+        }
+
+        // a short write means the device is full, wait for the poller
+        // to say it has drained
+        _pollable.can_write = (ret == n);
     }
 
     return _writebuf.available() != available_bytes;
 }
 
 /*
-  push any pending bytes to/from the serial port. This is called at
-  1kHz in the timer thread. Doing it this way reduces the system call
+  try to fill the read buffer, returning the number of bytes read
+ */
+int UARTDriver::_read_pending_bytes(void)
+{
+    ByteBuffer::IoVec vec[2];
+    struct iovec iov[2];
+
+    const auto n_vec = _readbuf.reserve(vec, _readbuf.space());
+    if (n_vec == 0) {
+        return 0;
+    }
+    for (int i = 0; i < n_vec; i++) {
+        iov[i].iov_base = vec[i].data;
+        iov[i].iov_len = vec[i].len;
+    }
+    const int ret = _readv_fd(iov, n_vec);
+    if (ret <= 0) {
+        return ret;
+    }
+    _readbuf.commit((unsigned)ret);
+
+    // update receive timestamp
+    _receive_timestamp[_receive_timestamp_idx^1] = AP_HAL::micros64();
+    _receive_timestamp_idx ^= 1;
+
+    return ret;
+}
+
+/*
+  push any pending bytes to/from the serial port. This is called from
+  the UART thread at its rate and whenever the poller reports one of
+  the ports is ready. Doing it this way reduces the system call
   overhead in the main task enormously.
  */
 void UARTDriver::_timer_tick(void)
@@ -442,33 +547,32 @@ void UARTDriver::_timer_tick(void)
 
     _in_timer = true;
 
-    uint8_t num_send = 10;
-    while (num_send != 0 && _write_pending_bytes()) {
-        num_send--;
-    }
+    _update_pollable();
 
-    // try to fill the read buffer
-    int ret;
-    ByteBuffer::IoVec vec[2];
+    if (!_poll_writes || _pollable.can_write) {
+        uint8_t num_send = 10;
+        while (num_send != 0 && _write_pending_bytes()) {
+            num_send--;
+        }
+    }
 
-    const auto n_vec = _readbuf.reserve(vec, _readbuf.space());
-    for (int i = 0; i < n_vec; i++) {
-        ret = _read_fd(vec[i].data, vec[i].len);
-        if (ret < 0) {
-            break;
+    if (_pollable.get_fd() == -1) {
+        // nothing tells us when there is data, just try
+        _read_pending_bytes();
+    } else if (_pollable.can_read) {
+        // only a new arrival sets the flag again, so read until the
+        // device is empty
+        _pollable.can_read = false;
+        while (_read_pending_bytes() > 0) {
         }
-        _readbuf.commit((unsigned)ret);
-
-        // update receive timestamp
-        _receive_timestamp[_receive_timestamp_idx^1] = AP_HAL::micros64();
-        _receive_timestamp_idx ^= 1;
-        
-        /* stop reading as we read less than we asked for */
-        if ((unsigned)ret < vec[i].len) {
-            break;
+        if (_readbuf.space() == 0) {
+            _pollable.can_read = true;
         }
     }
 
+    // a TCP device changes descriptor when a client connects or leaves
+    _update_pollable();
+
     _in_timer = false;
 }
 
@@ -4,6 +4,7 @@
 #include <AP_HAL/utility/RingBuffer.h>
 
 #include "AP_HAL_Linux.h"
+#include "Poller.h"
 #include "SerialDevice.h"
 #include "Semaphores.h"
 
@@ -84,6 +85,34 @@ private:
     void _allocate_buffers(uint16_t rxS, uint16_t txS);
     void _deallocate_buffers();
 
+    /*
+      readiness of the device, set by the UART thread's poller. The
+      device is registered edge triggered, so each flag stays set until
+      a transfer shows the device has nothing more to give or take
+     */
+    class DevicePollable : public Pollable {
+    public:
+        // the file descriptor belongs to the device
+        ~DevicePollable() { _fd = -1; }
+
+        void set_fd(int fd) { _fd = fd; }
+
+        void on_can_read() override { can_read = true; }
+        void on_can_write() override { can_write = true; }
+        void on_error() override { can_read = can_write = true; }
+        void on_hang_up() override { can_read = true; }
+
+        bool can_read;
+        bool can_write;
+    };
+    DevicePollable _pollable;
+    bool _poll_writes; // true if write readiness is reported by the poller
+
+    void _update_pollable(void);
+    void _unregister_pollable(void);
+    bool _check_connected(void);
+    int _read_pending_bytes(void);
+
     AP_HAL::OwnPtr<SerialDevice> _parseDevicePath(const char *arg);
 
     // timestamp for receiving data on the UART, avoiding a lock
@@ -101,6 +130,8 @@ protected:
 
     virtual int _write_fd(const uint8_t *buf, uint16_t n);
     virtual int _read_fd(uint8_t *buf, uint16_t n);
+    virtual int _writev_fd(const struct iovec *iov, int iovcnt);
+    virtual int _readv_fd(const struct iovec *iov, int iovcnt);
 
     Linux::Semaphore _write_mutex;
 };
@@ -18,11 +18,11 @@ UDPDevice::~UDPDevice()
 {
 }
 
+/*
+  the socket is non-blocking, so a full send buffer fails with EAGAIN
+ */
 ssize_t UDPDevice::write(const uint8_t *buf, uint16_t n)
 {
-    if (!socket.pollout(0)) {
-        return -1;
-    }
     if (_connected) {
         return socket.send(buf, n);
     }
@@ -14,6 +14,10 @@ public:
     virtual void set_speed(uint32_t speed) override;
     virtual ssize_t write(const uint8_t *buf, uint16_t n) override;
     virtual ssize_t read(uint8_t *buf, uint16_t n) override;
+    virtual int get_read_fd() const override { return socket.get_read_fd(); }
+    // a UDP socket rarely fills, and writes fail before the first
+    // packet arrives on an input port, so writes are just tried
+    virtual int get_write_fd() const override { return -1; }
 private:
     SocketAPM socket{true};
     const char *_ip;
@@ -10,6 +10,7 @@
 #include <AP_HAL/AP_HAL.h>
 
 #include "Heat_Pwm.h"
+#include "ThreadTrace.h"
 #include "ToneAlarm_Disco.h"
 #include "Util.h"
 
@@ -317,6 +318,23 @@ bool Util::get_random_vals(uint8_t* data, size_t size)
     return true;
 }
 
+/*
+  wake latency histograms of the traced threads
+ */
+void Util::thread_info(ExpandingString &str)
+{
+#if AP_LINUX_THREAD_TRACE_ENABLED
+    ThreadTrace::thread_info(str);
+#endif
+}
+
+void Util::thread_trace(ExpandingString &str)
+{
+#if AP_LINUX_THREAD_TRACE_ENABLED
+    ThreadTrace::chrome_trace(str);
+#endif
+}
+
 bool Util::parse_cpu_set(const char *str, cpu_set_t *cpu_set) const
 {
     unsigned long cpu1, cpu2;
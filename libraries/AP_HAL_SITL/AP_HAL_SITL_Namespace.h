@@ -16,6 +16,6 @@ class Util;
 class Semaphore;
 class GPIO;
 class DigitalSource;
-class DSP;
 class CANIface;
+class Snapshot;
 }  // namespace HALSITL
@@ -7,4 +7,3 @@
 #include "SITL_State.h"
 #include "Semaphores.h"
 #include "CANSocketIface.h"
-#include "DSP.h"
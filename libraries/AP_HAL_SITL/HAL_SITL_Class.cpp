@@ -20,13 +20,14 @@
 #include "GPIO.h"
 #include "SITL_State.h"
 #include "Util.h"
-#include "DSP.h"
 #include "CANSocketIface.h"
 #include "SPIDevice.h"
+#include "Snapshot.h"
 
 #include <AP_BoardConfig/AP_BoardConfig.h>
 #include <AP_HAL_Empty/AP_HAL_Empty.h>
 #include <AP_HAL_Empty/AP_HAL_Empty_Private.h>
+#include <AP_HAL/utility/SoftwareDSP.h>
 #include <AP_InternalError/AP_InternalError.h>
 #include <AP_Logger/AP_Logger.h>
 
@@ -47,7 +48,11 @@ static Empty::RCOutput sitlRCOutput;
 static Empty::GPIO sitlGPIO;
 #endif
 static AnalogIn sitlAnalogIn(&sitlState);
-static DSP dspDriver;
+#if AP_HAL_SOFTWARE_DSP_ENABLED
+static SoftwareDSP dspDriver;
+#else
+static Empty::DSP dspDriver;
+#endif
 
 
 // use the Empty HAL for hardware we don't emulate
@@ -270,6 +275,10 @@ void HAL_SITL::run(int argc, char * const argv[], Callbacks* callbacks) const
         callbacks->loop();
         HALSITL::Scheduler::_run_io_procs();
 
+#if AP_SIM_SNAPSHOT_ENABLED
+        HALSITL::Snapshot::update();
+#endif
+
         uint32_t now = AP_HAL::millis();
         if (now - last_watchdog_save >= 100 && using_watchdog) {
             // save persistent data every 100ms
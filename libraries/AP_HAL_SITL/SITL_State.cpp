@@ -180,6 +180,7 @@ void SITL_State::wait_clock(uint64_t wait_time_usec)
             Scheduler::from(hal.scheduler)->semaphore_wait_hack_required()) {
             _fdm_input_step();
         } else {
+            Scheduler::from(hal.scheduler)->snapshot_check_park();
             usleep(1000);
         }
     }
@@ -894,24 +895,20 @@ void SITL_State::set_height_agl(void)
         home_alt = _sitl->state.altitude;
     }
 
-#if AP_TERRAIN_AVAILABLE
     if (_sitl != nullptr &&
         _sitl->terrain_enable) {
-        // get height above terrain from AP_Terrain. This assumes
-        // AP_Terrain is working
+        // get height above terrain from the source selected by
+        // SIM_TERRAIN
         float terrain_height_amsl;
         struct Location location;
         location.lat = _sitl->state.latitude*1.0e7;
         location.lng = _sitl->state.longitude*1.0e7;
 
-        AP_Terrain *_terrain = AP_Terrain::get_singleton();
-        if (_terrain != nullptr &&
-            _terrain->height_amsl(location, terrain_height_amsl, false)) {
+        if (_sitl->terrain_height_amsl(location, terrain_height_amsl)) {
             _sitl->height_agl = _sitl->state.altitude - terrain_height_amsl;
             return;
         }
     }
-#endif
 
     if (_sitl != nullptr) {
         // fall back to flat earth model
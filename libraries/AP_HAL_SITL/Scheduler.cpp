@@ -5,6 +5,7 @@
 #include "Scheduler.h"
 #include "UARTDriver.h"
 #include <sys/time.h>
+#include <unistd.h>
 #include <fenv.h>
 #include <AP_BoardConfig/AP_BoardConfig.h>
 #if defined (__clang__) || (defined (__APPLE__) && defined (__MACH__))
@@ -13,6 +14,7 @@
 #include <malloc.h>
 #endif
 #include <AP_RCProtocol/AP_RCProtocol.h>
+#include <AP_Scheduler/CPUProfile.h>
 
 using namespace HALSITL;
 
@@ -43,6 +45,8 @@ bool Scheduler::_in_semaphore_take_wait = false;
 Scheduler::thread_attr *Scheduler::threads;
 HAL_Semaphore Scheduler::_thread_sem;
 
+volatile bool Scheduler::_snapshot_parking;
+
 Scheduler::Scheduler(SITL_State *sitlState) :
     _sitlState(sitlState),
     _stopped_clock_usec(0)
@@ -207,7 +211,13 @@ void Scheduler::_run_timer_procs()
     // now call the timer based drivers
     for (int i = 0; i < _num_timer_procs; i++) {
         if (_timer_proc[i]) {
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+            const uint64_t cpu_start_ns = AP::cpu_profile().start();
+            _timer_proc[i]();
+            AP::cpu_profile().timer_done(i, cpu_start_ns);
+#else
             _timer_proc[i]();
+#endif
         }
     }
 
@@ -229,12 +239,23 @@ void Scheduler::_run_io_procs()
     // now call the IO based drivers
     for (int i = 0; i < _num_io_procs; i++) {
         if (_io_proc[i]) {
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+            const uint64_t cpu_start_ns = AP::cpu_profile().start();
+            _io_proc[i]();
+            AP::cpu_profile().io_done(i, cpu_start_ns);
+#else
             _io_proc[i]();
+#endif
         }
     }
 
     _in_io_proc = false;
 
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+    // the HAL's own serial, storage, I2C and RC ticks
+    const uint64_t cpu_start_ns = AP::cpu_profile().start();
+#endif
+
     for (uint8_t i=0; i<hal.num_serial; i++) {
         hal.serial(i)->_timer_tick();
     }
@@ -252,6 +273,10 @@ void Scheduler::_run_io_procs()
 #ifndef HAL_BUILD_AP_PERIPH
     AP::RC().update();
 #endif
+
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+    AP::cpu_profile().hal_io_done(cpu_start_ns);
+#endif
 }
 
 /*
@@ -330,6 +355,8 @@ bool Scheduler::thread_create(AP_HAL::MemberProc proc, const char *name, uint32_
     a->stack_size = stack_size;
     a->f[0] = proc;
     a->name = name;
+    a->base = base;
+    a->priority = priority;
 
     if (pthread_attr_init(&a->attr) != 0) {
         goto failed;
@@ -340,8 +367,12 @@ bool Scheduler::thread_create(AP_HAL::MemberProc proc, const char *name, uint32_
     }
 #endif
     if (pthread_create(&thread, &a->attr, thread_create_trampoline, a) != 0) {
+        pthread_attr_destroy(&a->attr);
         goto failed;
     }
+    pthread_attr_destroy(&a->attr);
+    a->thread = thread;
+    a->parked = false;
     a->next = threads;
     threads = a;
     return true;
@@ -357,6 +388,97 @@ failed:
     return false;
 }
 
+/*
+  called by threads other than the main thread while they wait for
+  the clock. When a snapshot is being taken they stop here until it
+  is given up; when it is taken the process is only used to fork
+  restored copies, so they stay stopped. A thread holding a semaphore
+  carries on until it next waits without one, so that the semaphore
+  is free in the copies
+ */
+void Scheduler::snapshot_check_park(void)
+{
+    if (!_snapshot_parking || pthread_self() == _main_ctx ||
+        Semaphore::held_by_this_thread() != 0) {
+        return;
+    }
+    struct thread_attr *self = nullptr;
+    {
+        WITH_SEMAPHORE(_thread_sem);
+        for (struct thread_attr *a=threads; a; a=a->next) {
+            if (pthread_equal(a->thread, pthread_self())) {
+                self = a;
+                break;
+            }
+        }
+    }
+    if (self == nullptr) {
+        // not created with thread_create(), so it can't be restarted
+        // in a copy
+        return;
+    }
+    self->parked = true;
+    while (_snapshot_parking) {
+        usleep(1000);
+    }
+    self->parked = false;
+}
+
+/*
+  wait for all threads created with thread_create() to park, giving up
+  after timeout_ms of wall clock time. If any thread does not park the
+  others are released and false is returned
+ */
+bool Scheduler::snapshot_park_threads(uint32_t timeout_ms)
+{
+    _snapshot_parking = true;
+    for (uint32_t i=0; i<timeout_ms; i++) {
+        bool all_parked = true;
+        {
+            WITH_SEMAPHORE(_thread_sem);
+            for (struct thread_attr *a=threads; a; a=a->next) {
+                all_parked &= a->parked;
+            }
+        }
+        if (all_parked) {
+            return true;
+        }
+        usleep(1000);
+    }
+
+    WITH_SEMAPHORE(_thread_sem);
+    for (struct thread_attr *a=threads; a; a=a->next) {
+        if (!a->parked) {
+            ::fprintf(stderr, "Snapshot: thread %s did not stop\n", a->name);
+        }
+    }
+    _snapshot_parking = false;
+    return false;
+}
+
+/*
+  start the threads again in a forked child. Only the forking thread
+  exists in the child, so each thread is created afresh from its
+  entry point
+ */
+void Scheduler::snapshot_restart_threads(void)
+{
+    struct thread_attr *old_threads = threads;
+    threads = nullptr;
+    _snapshot_parking = false;
+
+    while (old_threads != nullptr) {
+        struct thread_attr *a = old_threads;
+        old_threads = a->next;
+        if (!thread_create(a->f[0], a->name, a->stack_size - 2300, a->base, a->priority)) {
+            ::fprintf(stderr, "Snapshot: failed to restart thread %s\n", a->name);
+        }
+        free(a->stack);
+        free(a->f);
+        delete a;
+    }
+}
+
 /*
   check for stack overflow
  */
@@ -68,6 +68,24 @@ public:
     // a couple of helper functions to cope with SITL's time stepping
     bool semaphore_wait_hack_required() const;
 
+    /*
+      support for SITL snapshots. Threads other than the main thread
+      are stopped where they wait for the clock while holding no
+      semaphores, so no lock is held when the process is forked, and
+      are started again in the child from their entry point.
+
+      Only threads created with thread_create() which wait through
+      delay(), delay_microseconds() or a semaphore take with a timeout
+      can be snapshotted, as those wait in SITL_State::wait_clock().
+      A thread which blocks anywhere else, such as on a socket, in
+      usleep() or in a semaphore take that blocks forever, never
+      stops, and then no snapshot is taken. Threads started with
+      pthread_create() directly are not restarted in the copies.
+     */
+    bool snapshot_park_threads(uint32_t timeout_ms);
+    void snapshot_restart_threads(void);
+    void snapshot_check_park(void);
+
 private:
     SITL_State *_sitlState;
     uint8_t _nested_atomic_ctr;
@@ -98,6 +116,8 @@ private:
     pthread_t _main_ctx;
 
     static HAL_Semaphore _thread_sem;
+
+    static volatile bool _snapshot_parking;
     struct thread_attr {
         struct thread_attr *next;
         AP_HAL::MemberProc *f;
@@ -106,6 +126,10 @@ private:
         void *stack;
         const uint8_t *stack_min;
         const char *name;
+        priority_base base;
+        int8_t priority;
+        pthread_t thread;
+        volatile bool parked;   // stopped for a snapshot
     };
     static struct thread_attr *threads;
     static const uint8_t stackfill = 0xEB;
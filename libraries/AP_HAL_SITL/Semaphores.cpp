@@ -9,6 +9,8 @@ extern const AP_HAL::HAL& hal;
 
 using namespace HALSITL;
 
+thread_local uint16_t Semaphore::_held_by_this_thread;
+
 // construct a semaphore
 Semaphore::Semaphore()
 {
@@ -22,6 +24,7 @@ Semaphore::Semaphore()
 bool Semaphore::give()
 {
     take_count--;
+    _held_by_this_thread--;
     if (pthread_mutex_unlock(&_lock) != 0) {
         AP_HAL::panic("Bad semaphore usage");
     }
@@ -45,6 +48,7 @@ bool Semaphore::take(uint32_t timeout_ms)
         if (pthread_mutex_lock(&_lock) == 0) {
             owner = pthread_self();
             take_count++;
+            _held_by_this_thread++;
             return true;
         }
         return false;
@@ -71,6 +75,7 @@ bool Semaphore::take_nonblocking()
     if (pthread_mutex_trylock(&_lock) == 0) {
         owner = pthread_self();
         take_count++;
+        _held_by_this_thread++;
         return true;
     }
     return false;
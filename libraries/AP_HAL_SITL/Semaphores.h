@@ -16,6 +16,9 @@ public:
 
     void check_owner() const;  // asserts that current thread owns semaphore
 
+    // number of semaphores the calling thread holds, counting each recursive take
+    static uint16_t held_by_this_thread(void) { return _held_by_this_thread; }
+
 protected:
     pthread_mutex_t _lock;
     pthread_t owner;
@@ -23,4 +26,6 @@ protected:
     // keep track the recursion level to ensure we only disown the
     // semaphore once we're done with it
     uint8_t take_count;
+
+    static thread_local uint16_t _held_by_this_thread;
 };
@@ -0,0 +1,239 @@
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+#include "Snapshot.h"
+
+#if AP_SIM_SNAPSHOT_ENABLED
+
+#include "AP_HAL_SITL.h"
+#include "HAL_SITL_Class.h"
+#include "Scheduler.h"
+#include "Storage.h"
+#include "UARTDriver.h"
+
+#include <AP_Logger/AP_Logger.h>
+#include <AP_Param/AP_Param.h>
+#include <SITL/SITL.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace HALSITL;
+
+extern HAL_SITL& hal;
+
+int Snapshot::listen_fd = -1;
+Snapshot::Copy Snapshot::copies[SNAPSHOT_MAX_COPIES];
+
+/*
+  check if a snapshot has been asked for
+ */
+void Snapshot::update(void)
+{
+    SITL::SIM *sitl = AP::sitl();
+    if (sitl == nullptr || sitl->snapshot == 0) {
+        return;
+    }
+    // clear and save the request first so that copies, and copies
+    // which reboot, do not take another snapshot
+    sitl->snapshot.set_and_save(0);
+    AP_Param::flush();
+
+    serve();
+}
+
+/*
+  stop running the vehicle and fork restored copies on request
+ */
+void Snapshot::serve(void)
+{
+    Scheduler *scheduler = Scheduler::from(hal.scheduler);
+
+    // the watchdog alarm would fire while we wait for clients
+    alarm(0);
+
+    // stop the other threads where they hold no locks
+    if (!scheduler->snapshot_park_threads(1000)) {
+        ::fprintf(stderr, "Snapshot: not taken\n");
+        return;
+    }
+
+    // clients connected to the snapshot are dropped so each copy
+    // starts with only listening sockets
+    for (uint8_t i=0; i<hal.num_serial; i++) {
+        ((UARTDriver *)hal.serial(i))->disconnect_client();
+    }
+    ((Storage *)hal.storage)->write_all();
+
+    char path[sizeof(sockaddr_un::sun_path)];
+    snprintf(path, sizeof(path), "snapshot-%u.sock", (unsigned)hal.get_instance());
+    unlink(path);
+
+    struct sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path)-1);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd == -1 ||
+        fcntl(listen_fd, F_SETFD, FD_CLOEXEC) == -1 ||
+        bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(listen_fd, SNAPSHOT_MAX_COPIES) != 0) {
+        ::fprintf(stderr, "Snapshot: unable to listen on %s - %s\n", path, strerror(errno));
+        exit(1);
+    }
+    ::fprintf(stderr, "Snapshot taken at %.3fs, restore via %s\n",
+              AP_HAL::micros64()*1.0e-6, path);
+
+    while (true) {
+        if (Scheduler::_should_exit) {
+            for (uint8_t i=0; i<SNAPSHOT_MAX_COPIES; i++) {
+                end_copy(i, SIGTERM);
+            }
+            unlink(path);
+            ::fprintf(stderr, "Exitting\n");
+            exit(0);
+        }
+
+        // wait for a new client, or for input or a hangup from the
+        // client of a running copy
+        struct pollfd pfd[SNAPSHOT_MAX_COPIES+1] {};
+        pfd[0].fd = listen_fd;
+        pfd[0].events = POLLIN;
+        for (uint8_t i=0; i<SNAPSHOT_MAX_COPIES; i++) {
+            pfd[i+1].fd = copies[i].pid != 0 ? copies[i].conn_fd : -1;
+            pfd[i+1].events = POLLIN;
+        }
+        if (poll(pfd, ARRAY_SIZE(pfd), 100) == -1) {
+            continue;
+        }
+
+        for (uint8_t i=0; i<SNAPSHOT_MAX_COPIES; i++) {
+            Copy &copy = copies[i];
+            if (copy.pid == 0) {
+                continue;
+            }
+            int status;
+            if (waitpid(copy.pid, &status, WNOHANG) == copy.pid) {
+                dprintf(copy.conn_fd, "EXIT %d\n",
+                        WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+                close(copy.conn_fd);
+                copy.pid = 0;
+            } else if (pfd[i+1].revents != 0) {
+                // any input or a hangup from the client ends the copy
+                end_copy(i, SIGKILL);
+            }
+        }
+
+        if (pfd[0].revents & POLLIN) {
+            const int conn_fd = accept(listen_fd, nullptr, nullptr);
+            if (conn_fd == -1) {
+                continue;
+            }
+            fcntl(conn_fd, F_SETFD, FD_CLOEXEC);
+            if (start_copy(conn_fd)) {
+                // we are the restored copy
+                return;
+            }
+        }
+    }
+}
+
+/*
+  fork a copy in a free slot. The server keeps the connection to
+  report on the copy
+ */
+bool Snapshot::start_copy(int conn_fd)
+{
+    uint8_t slot;
+    for (slot=0; slot<SNAPSHOT_MAX_COPIES; slot++) {
+        if (copies[slot].pid == 0) {
+            break;
+        }
+    }
+    if (slot == SNAPSHOT_MAX_COPIES) {
+        dprintf(conn_fd, "ERROR too many copies\n");
+        close(conn_fd);
+        return false;
+    }
+
+    const pid_t pid = fork();
+    if (pid == -1) {
+        dprintf(conn_fd, "ERROR %s\n", strerror(errno));
+        close(conn_fd);
+        return false;
+    }
+    if (pid == 0) {
+        // the copy has no use for the server's connections, and
+        // holding them would hide the copies ending from clients
+        close(conn_fd);
+        close(listen_fd);
+        listen_fd = -1;
+        for (Copy &copy : copies) {
+            if (copy.pid != 0) {
+                close(copy.conn_fd);
+                copy.pid = 0;
+            }
+        }
+        restore(slot);
+        return true;
+    }
+
+    dprintf(conn_fd, "PID %d PORT_OFFSET %u\n", (int)pid, (unsigned)((slot+1) * SNAPSHOT_PORT_OFFSET));
+    copies[slot].pid = pid;
+    copies[slot].conn_fd = conn_fd;
+    return false;
+}
+
+/*
+  kill a copy and wait for it to go
+ */
+void Snapshot::end_copy(uint8_t slot, int signal)
+{
+    Copy &copy = copies[slot];
+    if (copy.pid == 0) {
+        return;
+    }
+    kill(copy.pid, signal);
+    int status;
+    waitpid(copy.pid, &status, 0);
+    close(copy.conn_fd);
+    copy.pid = 0;
+}
+
+/*
+  prepare a copy to carry on from the snapshot
+ */
+void Snapshot::restore(uint8_t slot)
+{
+    // move to the copy's own ports and storage file before any other
+    // thread runs
+    const uint16_t port_offset = (slot+1) * SNAPSHOT_PORT_OFFSET;
+    for (uint8_t i=0; i<hal.num_serial; i++) {
+        ((UARTDriver *)hal.serial(i))->move_listen_port(port_offset);
+    }
+    char path[32];
+    snprintf(path, sizeof(path), "snapshot-%u-copy%u.bin", (unsigned)hal.get_instance(), (unsigned)slot+1);
+    ((Storage *)hal.storage)->use_file(path);
+
+    Scheduler::from(hal.scheduler)->snapshot_restart_threads();
+
+#if HAL_LOGGING_ENABLED
+    // the open log is shared with the snapshot, a copy starts a new
+    // one when it next needs to log
+    AP::logger().StopLogging();
+#endif
+
+    ::fprintf(stderr, "Snapshot restored in pid %d, ports offset by %u\n",
+              (int)getpid(), (unsigned)port_offset);
+}
+
+#endif  // AP_SIM_SNAPSHOT_ENABLED
+#endif  // CONFIG_HAL_BOARD == HAL_BOARD_SITL
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+#ifndef AP_SIM_SNAPSHOT_ENABLED
+#ifndef HAL_BUILD_AP_PERIPH
+#define AP_SIM_SNAPSHOT_ENABLED 1
+#else
+#define AP_SIM_SNAPSHOT_ENABLED 0
+#endif
+#endif
+
+#if AP_SIM_SNAPSHOT_ENABLED
+
+#include "AP_HAL_SITL_Namespace.h"
+
+#include <sys/types.h>
+
+// the number of restored copies which can run at once
+#ifndef SNAPSHOT_MAX_COPIES
+#define SNAPSHOT_MAX_COPIES 8
+#endif
+
+// TCP port offset between copies. SITL instances are 10 ports apart,
+// so copies of up to 100 instances don't overlap
+#define SNAPSHOT_PORT_OFFSET 1000
+
+/*
+  snapshot and restore of a warmed up SITL vehicle.
+
+  Setting SIM_SNAPSHOT to 1 turns the running process into a snapshot
+  of the vehicle. It stops running the vehicle and listens on a unix
+  socket, snapshot-N.sock where N is the instance number. Each client
+  connection forks a copy of the process which carries on from exactly
+  where the snapshot was taken: parameters, storage, the EKF, the
+  physics model and the sensor models are all part of the copied
+  process memory.
+
+  The server writes "PID <pid> PORT_OFFSET <offset>" when the copy has
+  started and "EXIT <status>" when it exits. Closing the connection
+  kills the copy. Up to SNAPSHOT_MAX_COPIES copies run at once. Each
+  listens on the TCP ports of the snapshot plus its offset, a multiple
+  of SNAPSHOT_PORT_OFFSET, and keeps its storage in its own file. RC
+  input over UDP is still shared with the snapshot.
+
+  See Scheduler::snapshot_park_threads() for the threads which allow a
+  snapshot to be taken.
+ */
+class HALSITL::Snapshot {
+public:
+    // called from the main loop between vehicle loops
+    static void update(void);
+
+private:
+    // run the snapshot server. Returns only in a restored copy, or
+    // if the snapshot could not be taken
+    static void serve(void);
+
+    // fork a restored copy, returning true in the copy
+    static bool start_copy(int conn_fd);
+
+    // kill a running copy
+    static void end_copy(uint8_t slot, int signal);
+
+    // prepare a freshly forked copy to carry on
+    static void restore(uint8_t slot);
+
+    static int listen_fd;
+
+    struct Copy {
+        pid_t pid;      // zero if the slot is free
+        int conn_fd;
+    };
+    static Copy copies[SNAPSHOT_MAX_COPIES];
+};
+
+#endif  // AP_SIM_SNAPSHOT_ENABLED
+#endif  // CONFIG_HAL_BOARD == HAL_BOARD_SITL
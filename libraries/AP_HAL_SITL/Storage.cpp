@@ -215,6 +215,44 @@ void Storage::_timer_tick(void)
 #endif
 }
 
+/*
+  write the whole buffer to the storage file. Used when a SITL
+  snapshot is taken, so the file matches the snapshot
+ */
+void Storage::write_all(void)
+{
+#if STORAGE_USE_POSIX
+    if (_initialisedType == StorageBackend::SDCard && log_fd != -1) {
+        if (pwrite(log_fd, _buffer, HAL_STORAGE_SIZE, 0) == HAL_STORAGE_SIZE) {
+            _dirty_mask.clearall();
+        }
+    }
+#endif
+}
+
+/*
+  switch to a new storage file, written from the buffer. Each restored
+  SITL snapshot copy has its own file, so that copies running together
+  don't change each other's storage
+ */
+void Storage::use_file(const char *path)
+{
+#if STORAGE_USE_POSIX
+    if (_initialisedType != StorageBackend::SDCard || log_fd == -1) {
+        return;
+    }
+    const int fd = open(path, O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if (fd == -1) {
+        hal.console->printf("open failed of %s\n", path);
+        return;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    close(log_fd);
+    log_fd = fd;
+    write_all();
+#endif
+}
+
 #if STORAGE_USE_FLASH
 
 /*
@@ -33,6 +33,12 @@ public:
     void _timer_tick(void) override;
     bool healthy(void) override;
 
+    // write the whole buffer to the storage file at once
+    void write_all(void);
+
+    // carry on with the storage in a new file
+    void use_file(const char *path);
+
 private:
     enum class StorageBackend: uint8_t {
         None,
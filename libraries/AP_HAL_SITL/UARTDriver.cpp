@@ -845,5 +845,38 @@ ssize_t UARTDriver::get_system_outqueue_length() const
 #endif
 }
 
+/*
+  drop a connected TCP client, leaving the port listening so the
+  next client is accepted as usual. Used when a SITL snapshot is
+  taken, so each restored copy of the vehicle gets fresh connections
+ */
+void UARTDriver::disconnect_client(void)
+{
+    if (_listen_fd == -1 || _fd == -1 || !_connected) {
+        return;
+    }
+    close(_fd);
+    _fd = -1;
+    _connected = false;
+    _readbuffer.clear();
+    _writebuffer.clear();
+}
+
+/*
+  close a listening TCP port and listen on the port offset from it
+  instead. Used by restored SITL snapshot copies, so that each copy
+  has its own ports
+ */
+void UARTDriver::move_listen_port(uint16_t offset)
+{
+    if (_listen_fd == -1 || _connected) {
+        return;
+    }
+    const uint16_t port = ntohs(_listen_sockaddr.sin_port) + offset;
+    close(_listen_fd);
+    _listen_fd = -1;
+    _tcp_start_connection(port, false);
+}
+
 #endif // CONFIG_HAL_BOARD
 
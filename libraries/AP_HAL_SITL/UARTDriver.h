@@ -37,6 +37,12 @@ public:
 
     ssize_t get_system_outqueue_length() const;
 
+    // drop a connected TCP client, leaving the port listening
+    void disconnect_client(void);
+
+    // listen on a TCP port offset from the current one
+    void move_listen_port(uint16_t offset);
+
     void set_blocking_writes(bool blocking) override
     {
         _nonblocking_writes = !blocking;
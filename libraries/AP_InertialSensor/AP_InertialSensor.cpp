@@ -1614,7 +1614,9 @@ void AP_InertialSensor::HarmonicNotch::update_params(uint8_t instance, bool conv
         last_center_freq_hz[instance] = center_freq;
         last_bandwidth_hz[instance] = params.bandwidth_hz();
         last_attenuation_dB[instance] = params.attenuation_dB();
-    } else if (!is_equal(last_center_freq_hz[instance], center_freq)) {
+    } else {
+        // the filter only recalculates notches that have moved, and
+        // finishes off any it had to leave last time
         if (num_calculated_notch_frequencies > 1) {
             filter[instance].update(num_calculated_notch_frequencies, calculated_notch_freq_hz);
         } else {
@@ -1838,7 +1840,8 @@ check_sample:
                 }
             }
 
-            hal.scheduler->delay_microseconds_boost(wait_per_loop);
+            // backends wake us as soon as they have new data
+            hal.scheduler->delay_microseconds_wakeable(wait_per_loop);
             wait_counter++;
         }
 
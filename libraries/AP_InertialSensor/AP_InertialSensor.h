@@ -28,6 +28,9 @@
 #define XYZ_AXIS_COUNT    3
 // The maximum we need to store is gyro-rate / loop-rate, worst case ArduCopter with BMI088 is 2000/400
 #define INS_MAX_GYRO_WINDOW_SAMPLES 8
+// samples processed together by the block sample functions of backends.
+// Kept small as each block is on the stack of the device thread
+#define INS_SAMPLE_BLOCK_LEN 4
 
 #define DEFAULT_IMU_LOG_BAT_MASK 0
 
@@ -287,6 +287,7 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
         }
 
         _imu._new_gyro_data[instance] = true;
+        hal.scheduler->wakeup_main_thread();
     }
 
     if (!_imu.batchsampler.doing_post_filter_logging()) {
@@ -406,6 +407,7 @@ void AP_InertialSensor_Backend::_notify_new_delta_angle(uint8_t instance, const
         }
 
         _imu._new_gyro_data[instance] = true;
+        hal.scheduler->wakeup_main_thread();
     }
 
     if (!_imu.batchsampler.doing_post_filter_logging()) {
@@ -530,6 +532,7 @@ void AP_InertialSensor_Backend::_notify_new_accel_raw_sample(uint8_t instance,
         _imu.set_accel_peak_hold(instance, _imu._accel_filtered[instance]);
 
         _imu._new_accel_data[instance] = true;
+        hal.scheduler->wakeup_main_thread();
     }
 
     if (!_imu.batchsampler.doing_post_filter_logging()) {
@@ -602,6 +605,7 @@ void AP_InertialSensor_Backend::_notify_new_delta_velocity(uint8_t instance, con
         _imu.set_accel_peak_hold(instance, _imu._accel_filtered[instance]);
 
         _imu._new_accel_data[instance] = true;
+        hal.scheduler->wakeup_main_thread();
     }
 
     if (!_imu.batchsampler.doing_post_filter_logging()) {
@@ -612,6 +616,344 @@ void AP_InertialSensor_Backend::_notify_new_delta_velocity(uint8_t instance, con
 }
 
 
+/*
+  rotate and correct a block of accel samples, see _rotate_and_correct_accel()
+ */
+void AP_InertialSensor_Backend::_rotate_and_correct_accel(uint8_t instance, Vector3f *accel, uint8_t n)
+{
+    const bool correct = !_imu._calibrating_accel && (_imu._acal == nullptr
+#if HAL_INS_ACCELCAL_ENABLED
+        || !_imu._acal->running()
+#endif
+    );
+#if HAL_INS_TEMPERATURE_CAL_ENABLE
+    const float temperature = _imu.get_temperature(instance);
+#endif
+    const Vector3f &accel_offset = _imu._accel_offset[instance].get();
+    const Vector3f &accel_scale = _imu._accel_scale[instance].get();
+
+    for (uint8_t i = 0; i < n; i++) {
+        Vector3f &a = accel[i];
+
+        // rotate for sensor orientation
+        a.rotate(_imu._accel_orientation[instance]);
+
+#if HAL_INS_TEMPERATURE_CAL_ENABLE
+        if (_imu.tcal_learning) {
+            _imu.tcal[instance].update_accel_learning(a, temperature);
+        }
+#endif
+
+        if (correct) {
+#if HAL_INS_TEMPERATURE_CAL_ENABLE
+            // apply temperature corrections
+            _imu.tcal[instance].correct_accel(temperature, _imu.caltemp_accel[instance], a);
+#endif
+
+            // apply offsets and scaling
+            a -= accel_offset;
+            a.x *= accel_scale.x;
+            a.y *= accel_scale.y;
+            a.z *= accel_scale.z;
+        }
+
+        // rotate to body frame
+        a.rotate(_imu._board_orientation);
+    }
+}
+
+/*
+  rotate and correct a block of gyro samples, see _rotate_and_correct_gyro()
+ */
+void AP_InertialSensor_Backend::_rotate_and_correct_gyro(uint8_t instance, Vector3f *gyro, uint8_t n)
+{
+    const bool correct = !_imu._calibrating_gyro;
+#if HAL_INS_TEMPERATURE_CAL_ENABLE
+    const float temperature = _imu.get_temperature(instance);
+#endif
+    const Vector3f &gyro_offset = _imu._gyro_offset[instance].get();
+
+    for (uint8_t i = 0; i < n; i++) {
+        Vector3f &g = gyro[i];
+
+        // rotate for sensor orientation
+        g.rotate(_imu._gyro_orientation[instance]);
+
+#if HAL_INS_TEMPERATURE_CAL_ENABLE
+        if (_imu.tcal_learning) {
+            _imu.tcal[instance].update_gyro_learning(g, temperature);
+        }
+#endif
+
+        if (correct) {
+#if HAL_INS_TEMPERATURE_CAL_ENABLE
+            // apply temperature corrections
+            _imu.tcal[instance].correct_gyro(temperature, _imu.caltemp_gyro[instance], g);
+#endif
+
+            // gyro calibration is always assumed to have been done in sensor frame
+            g -= gyro_offset;
+        }
+
+        g.rotate(_imu._board_orientation);
+    }
+}
+
+void AP_InertialSensor_Backend::_notify_new_gyro_raw_samples(uint8_t instance, Vector3f *gyro, uint8_t n)
+{
+    if ((1U<<instance) & _imu.imu_kill_mask) {
+        return;
+    }
+    while (n > 0) {
+        const uint8_t len = MIN(n, INS_SAMPLE_BLOCK_LEN);
+        notify_gyro_block(instance, gyro, len);
+        gyro += len;
+        n -= len;
+    }
+}
+
+/*
+  handle a block of gyro samples from a FIFO burst. This is
+  _notify_new_gyro_raw_sample() for FIFO sensors, with the semaphore
+  taken once, the time read once and the filters run over the block.
+  The samples are filtered in place
+ */
+void AP_InertialSensor_Backend::notify_gyro_block(uint8_t instance, Vector3f *gyro, uint8_t n)
+{
+    // dt of the samples accepted at the current sample rate, which are
+    // moved to the start of the block
+    float dt[INS_SAMPLE_BLOCK_LEN];
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < n; i++) {
+        _update_sensor_rate(_imu._sample_gyro_count[instance], _imu._sample_gyro_start_us[instance],
+                            _imu._gyro_raw_sample_rates[instance]);
+
+        // don't accept below 40Hz
+        if (_imu._gyro_raw_sample_rates[instance] < 40) {
+            continue;
+        }
+        gyro[count] = gyro[i];
+        dt[count] = 1.0f / _imu._gyro_raw_sample_rates[instance];
+
+#if AP_MODULE_SUPPORTED
+        // call gyro_sample hook if any
+        AP_Module::call_hook_gyro_sample(instance, dt[count], gyro[count]);
+#endif
+
+        // push gyros if optical flow present
+        if (hal.opticalflow) {
+            hal.opticalflow->push_gyro(gyro[count].x, gyro[count].y, dt[count]);
+        }
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    // the whole burst was read now, earlier samples are logged at
+    // their own times spaced back from it. Raw samples are logged
+    // before they are filtered
+    const uint64_t now_us = AP_HAL::micros64();
+    const bool post_filter = _imu.batchsampler.doing_post_filter_logging();
+    if (!post_filter) {
+        for (uint8_t i = 0; i < count; i++) {
+            log_gyro_raw(instance, block_sample_us(now_us, dt, count, i), gyro[i]);
+        }
+    }
+
+    {
+        WITH_SEMAPHORE(_sem);
+
+        for (uint8_t i = 0; i < count; i++) {
+            const Vector3f &g = gyro[i];
+            float sample_dt = dt[i];
+
+            // compute delta angle and coning correction as for a single sample
+            Vector3f delta_angle = (g + _imu._last_raw_gyro[instance]) * 0.5f * sample_dt;
+            Vector3f delta_coning = (_imu._delta_angle_acc[instance] +
+                                     _imu._last_delta_angle[instance] * (1.0f / 6.0f));
+            delta_coning = delta_coning % delta_angle;
+            delta_coning *= 0.5f;
+
+            if (now_us - _imu._gyro_last_sample_us[instance] > 100000U) {
+                // zero accumulator if sensor was unhealthy for 0.1s
+                _imu._delta_angle_acc[instance].zero();
+                _imu._delta_angle_acc_dt[instance] = 0;
+                sample_dt = 0;
+                delta_angle.zero();
+            }
+            _imu._gyro_last_sample_us[instance] = now_us;
+
+            // integrate delta angle accumulator
+            _imu._delta_angle_acc[instance] += delta_angle + delta_coning;
+            _imu._delta_angle_acc_dt[instance] += sample_dt;
+
+            // save previous delta angle for coning correction
+            _imu._last_delta_angle[instance] = delta_angle;
+            _imu._last_raw_gyro[instance] = g;
+#if HAL_WITH_DSP
+            // capture gyro window for FFT analysis
+            if (_imu._gyro_window_size > 0) {
+                const Vector3f& scaled_gyro = g * _imu._gyro_raw_sampling_multiplier[instance];
+                _imu._gyro_window[instance][0].push(scaled_gyro.x);
+                _imu._gyro_window[instance][1].push(scaled_gyro.y);
+                _imu._gyro_window[instance][2].push(scaled_gyro.z);
+            }
+#endif
+        }
+
+        // run the harmonic notches over the block then the low pass filter
+        for (auto &notch : _imu.harmonic_notches) {
+            if (notch.params.enabled()) {
+                notch.filter[instance].apply(gyro, count);
+            }
+        }
+        for (uint8_t i = 0; i < count; i++) {
+            const Vector3f gyro_filtered = _imu._gyro_filter[instance].apply(gyro[i]);
+            if (gyro_filtered.is_nan() || gyro_filtered.is_inf()) {
+                // reset the filters as for a single sample. The rest of
+                // the block has been through the failed notches, so it
+                // keeps the old value too
+                _imu._gyro_filter[instance].reset();
+                for (auto &notch : _imu.harmonic_notches) {
+                    notch.filter[instance].reset();
+                }
+                for (uint8_t j = i; j < count; j++) {
+                    gyro[j] = _imu._gyro_filtered[instance];
+                }
+                break;
+            }
+            _imu._gyro_filtered[instance] = gyro_filtered;
+            gyro[i] = gyro_filtered;
+        }
+
+        _imu._new_gyro_data[instance] = true;
+        hal.scheduler->wakeup_main_thread();
+    }
+
+    if (post_filter) {
+        for (uint8_t i = 0; i < count; i++) {
+            log_gyro_raw(instance, block_sample_us(now_us, dt, count, i), gyro[i]);
+        }
+    }
+}
+
+/*
+  return the time of sample i of a block. The last sample was read at
+  last_us and each earlier sample is one sample interval before the
+  one after it
+ */
+uint64_t AP_InertialSensor_Backend::block_sample_us(uint64_t last_us, const float *dt, uint8_t count, uint8_t i)
+{
+    uint64_t t = last_us;
+    for (uint8_t k = count - 1; k > i; k--) {
+        const uint64_t step_us = uint64_t(dt[k] * 1.0e6f);
+        t = t > step_us ? t - step_us : 0;
+    }
+    return t;
+}
+
+void AP_InertialSensor_Backend::_notify_new_accel_raw_samples(uint8_t instance, Vector3f *accel, uint8_t n, uint32_t fsync_mask)
+{
+    if ((1U<<instance) & _imu.imu_kill_mask) {
+        return;
+    }
+    while (n > 0) {
+        const uint8_t len = MIN(n, INS_SAMPLE_BLOCK_LEN);
+        notify_accel_block(instance, accel, len, fsync_mask);
+        accel += len;
+        n -= len;
+        fsync_mask >>= len;
+    }
+}
+
+/*
+  handle a block of accel samples from a FIFO burst, as
+  _notify_new_accel_raw_sample() does for each sample from a FIFO
+  sensor. The samples are filtered in place
+ */
+void AP_InertialSensor_Backend::notify_accel_block(uint8_t instance, Vector3f *accel, uint8_t n, uint32_t fsync_mask)
+{
+    // dt of the samples accepted at the current sample rate, which are
+    // moved to the start of the block
+    float dt[INS_SAMPLE_BLOCK_LEN];
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < n; i++) {
+        _update_sensor_rate(_imu._sample_accel_count[instance], _imu._sample_accel_start_us[instance],
+                            _imu._accel_raw_sample_rates[instance]);
+
+        // don't accept below 40Hz
+        if (_imu._accel_raw_sample_rates[instance] < 40) {
+            continue;
+        }
+        accel[count] = accel[i];
+        dt[count] = 1.0f / _imu._accel_raw_sample_rates[instance];
+
+#if AP_MODULE_SUPPORTED
+        // call accel_sample hook if any
+        AP_Module::call_hook_accel_sample(instance, dt[count], accel[count], (fsync_mask & (1U<<i)) != 0);
+#endif
+
+        _imu.calc_vibration_and_clipping(instance, accel[count], dt[count]);
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    // the whole burst was read now, earlier samples are logged at
+    // their own times spaced back from it. Raw samples are logged
+    // before they are filtered
+    const uint64_t now_us = AP_HAL::micros64();
+    const bool post_filter = _imu.batchsampler.doing_post_filter_logging();
+    if (!post_filter) {
+        for (uint8_t i = 0; i < count; i++) {
+            log_accel_raw(instance, block_sample_us(now_us, dt, count, i), accel[i]);
+        }
+    }
+
+    {
+        WITH_SEMAPHORE(_sem);
+
+        for (uint8_t i = 0; i < count; i++) {
+            const Vector3f &a = accel[i];
+            float sample_dt = dt[i];
+
+            if (now_us - _imu._accel_last_sample_us[instance] > 100000U) {
+                // zero accumulator if sensor was unhealthy for 0.1s
+                _imu._delta_velocity_acc[instance].zero();
+                _imu._delta_velocity_acc_dt[instance] = 0;
+                sample_dt = 0;
+            }
+            _imu._accel_last_sample_us[instance] = now_us;
+
+            // delta velocity
+            _imu._delta_velocity_acc[instance] += a * sample_dt;
+            _imu._delta_velocity_acc_dt[instance] += sample_dt;
+
+            _imu._accel_filtered[instance] = _imu._accel_filter[instance].apply(a);
+            if (_imu._accel_filtered[instance].is_nan() || _imu._accel_filtered[instance].is_inf()) {
+                _imu._accel_filter[instance].reset();
+            }
+            accel[i] = _imu._accel_filtered[instance];
+
+            _imu.set_accel_peak_hold(instance, _imu._accel_filtered[instance]);
+        }
+
+        _imu._new_accel_data[instance] = true;
+        hal.scheduler->wakeup_main_thread();
+    }
+
+    if (post_filter) {
+        for (uint8_t i = 0; i < count; i++) {
+            log_accel_raw(instance, block_sample_us(now_us, dt, count, i), accel[i]);
+        }
+    }
+}
+
+
 void AP_InertialSensor_Backend::_notify_new_accel_sensor_rate_sample(uint8_t instance, const Vector3f &accel)
 {
     if (!_imu.batchsampler.doing_sensor_rate_logging()) {
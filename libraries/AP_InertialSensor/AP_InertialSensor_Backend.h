@@ -164,6 +164,22 @@ protected:
 
     // alternative interface using delta-velocities. Rotation and correction is handled inside this function
     void _notify_new_delta_velocity(uint8_t instance, const Vector3f &dvelocity);
+
+    /*
+      block versions of the above for FIFO based sensors which read a
+      burst of samples at once. The per-call work is done once per
+      block and each filter runs over the whole block, with the same
+      results as passing each sample in turn. The samples are filtered
+      in place, so no copies of the block are needed on the device
+      thread stack. Bit i of fsync_mask is the fsync flag of sample i
+     */
+    void _rotate_and_correct_accel(uint8_t instance, Vector3f *accel, uint8_t n) __RAMFUNC__;
+    void _rotate_and_correct_gyro(uint8_t instance, Vector3f *gyro, uint8_t n) __RAMFUNC__;
+    void _notify_new_gyro_raw_samples(uint8_t instance, Vector3f *gyro, uint8_t n) __RAMFUNC__;
+    void _notify_new_accel_raw_samples(uint8_t instance, Vector3f *accel, uint8_t n, uint32_t fsync_mask=0) __RAMFUNC__;
+
+    // time of sample i of a block whose last sample was read at last_us
+    static uint64_t block_sample_us(uint64_t last_us, const float *dt, uint8_t count, uint8_t i);
     
     // set the amount of oversamping a accel is doing
     void _set_accel_oversampling(uint8_t instance, uint8_t n);
@@ -316,6 +332,10 @@ private:
     void log_accel_raw(uint8_t instance, const uint64_t sample_us, const Vector3f &accel) __RAMFUNC__;
     void log_gyro_raw(uint8_t instance, const uint64_t sample_us, const Vector3f &gryo) __RAMFUNC__;
 
+    // handle up to INS_SAMPLE_BLOCK_LEN samples for the block sample functions
+    void notify_gyro_block(uint8_t instance, Vector3f *gyro, uint8_t n) __RAMFUNC__;
+    void notify_accel_block(uint8_t instance, Vector3f *accel, uint8_t n, uint32_t fsync_mask) __RAMFUNC__;
+
     // logging
     void Write_ACC(const uint8_t instance, const uint64_t sample_us, const Vector3f &accel) const __RAMFUNC__; // Write ACC data packet: raw accel data
     void Write_GYR(const uint8_t instance, const uint64_t sample_us, const Vector3f &gyro) const __RAMFUNC__;  // Write GYR data packet: raw gyro data
@@ -531,42 +531,61 @@ void AP_InertialSensor_Invensense::_check_register_change(void)
 
 bool AP_InertialSensor_Invensense::_accumulate(uint8_t *samples, uint8_t n_samples)
 {
-    for (uint8_t i = 0; i < n_samples; i++) {
-        const uint8_t *data = samples + MPU_SAMPLE_SIZE * i;
-        Vector3f accel, gyro;
-        bool fsync_set = false;
+    Vector3f accel[INS_SAMPLE_BLOCK_LEN];
+    Vector3f gyro[INS_SAMPLE_BLOCK_LEN];
+
+    n_samples = MIN(n_samples, MPU_FIFO_BUFFER_LEN);
+
+    while (n_samples > 0) {
+        const uint8_t len = MIN(n_samples, INS_SAMPLE_BLOCK_LEN);
+        uint32_t fsync_mask = 0;
+        uint8_t n;
+        bool ret = true;
+
+        for (n = 0; n < len; n++) {
+            const uint8_t *data = samples + MPU_SAMPLE_SIZE * n;
 
 #if INVENSENSE_EXT_SYNC_ENABLE
-        fsync_set = (int16_val(data, 2) & 1U) != 0;
+            if ((int16_val(data, 2) & 1U) != 0) {
+                fsync_mask |= 1U<<n;
+            }
 #endif
-        
-        accel = Vector3f(int16_val(data, 1),
-                         int16_val(data, 0),
-                         -int16_val(data, 2));
-        accel *= _accel_scale;
 
-        int16_t t2 = int16_val(data, 3);
-        if (!_check_raw_temp(t2)) {
-            if (!hal.scheduler->in_expected_delay()) {
-                debug("temp reset IMU[%u] %d %d", _accel_instance, _raw_temp, t2);
+            int16_t t2 = int16_val(data, 3);
+            if (!_check_raw_temp(t2)) {
+                if (!hal.scheduler->in_expected_delay()) {
+                    debug("temp reset IMU[%u] %d %d", _accel_instance, _raw_temp, t2);
+                }
+                ret = false;
+                break;
             }
-            _fifo_reset(true);
-            return false;
+            float temp = t2 * temp_sensitivity + temp_zero;
+            _temp_filtered = _temp_filter.apply(temp);
+
+            accel[n] = Vector3f(int16_val(data, 1),
+                                int16_val(data, 0),
+                                -int16_val(data, 2));
+            accel[n] *= _accel_scale;
+
+            gyro[n] = Vector3f(int16_val(data, 5),
+                               int16_val(data, 4),
+                               -int16_val(data, 6));
+            gyro[n] *= _gyro_scale;
         }
-        float temp = t2 * temp_sensitivity + temp_zero;
-        
-        gyro = Vector3f(int16_val(data, 5),
-                        int16_val(data, 4),
-                        -int16_val(data, 6));
-        gyro *= _gyro_scale;
 
-        _rotate_and_correct_accel(_accel_instance, accel);
-        _rotate_and_correct_gyro(_gyro_instance, gyro);
+        // the samples before any corruption are passed on as one block
+        _rotate_and_correct_accel(_accel_instance, accel, n);
+        _rotate_and_correct_gyro(_gyro_instance, gyro, n);
 
-        _notify_new_accel_raw_sample(_accel_instance, accel, 0, fsync_set);
-        _notify_new_gyro_raw_sample(_gyro_instance, gyro);
+        _notify_new_accel_raw_samples(_accel_instance, accel, n, fsync_mask);
+        _notify_new_gyro_raw_samples(_gyro_instance, gyro, n);
 
-        _temp_filtered = _temp_filter.apply(temp);
+        if (!ret) {
+            _fifo_reset(true);
+            return false;
+        }
+        samples += MPU_SAMPLE_SIZE * len;
+        n_samples -= len;
     }
     return true;
 }
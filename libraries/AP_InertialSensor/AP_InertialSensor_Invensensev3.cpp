@@ -236,31 +236,47 @@ void AP_InertialSensor_Invensensev3::accumulate()
 
 bool AP_InertialSensor_Invensensev3::accumulate_samples(const FIFOData *data, uint8_t n_samples)
 {
-    for (uint8_t i = 0; i < n_samples; i++) {
-        const FIFOData &d = data[i];
+    Vector3f accel[INS_SAMPLE_BLOCK_LEN];
+    Vector3f gyro[INS_SAMPLE_BLOCK_LEN];
 
-        // we have a header to confirm we don't have FIFO corruption! no more mucking
-        // about with the temperature registers
-        if ((d.header & 0xF8) != 0x68) {
-            // no or bad data
-            return false;
-        }
+    while (n_samples > 0) {
+        const uint8_t len = MIN(n_samples, INS_SAMPLE_BLOCK_LEN);
+        uint8_t n;
+        bool ret = true;
+
+        for (n = 0; n < len; n++) {
+            const FIFOData &d = data[n];
 
-        Vector3f accel{float(d.accel[0]), float(d.accel[1]), float(d.accel[2])};
-        Vector3f gyro{float(d.gyro[0]), float(d.gyro[1]), float(d.gyro[2])};
+            // we have a header to confirm we don't have FIFO corruption! no more mucking
+            // about with the temperature registers
+            if ((d.header & 0xF8) != 0x68) {
+                // no or bad data
+                ret = false;
+                break;
+            }
 
-        accel *= accel_scale;
-        gyro *= GYRO_SCALE;
+            accel[n] = Vector3f{float(d.accel[0]), float(d.accel[1]), float(d.accel[2])};
+            gyro[n] = Vector3f{float(d.gyro[0]), float(d.gyro[1]), float(d.gyro[2])};
 
-        const float temp = d.temperature * temp_sensitivity + temp_zero;
+            accel[n] *= accel_scale;
+            gyro[n] *= GYRO_SCALE;
 
-        _rotate_and_correct_accel(accel_instance, accel);
-        _rotate_and_correct_gyro(gyro_instance, gyro);
+            const float temp = d.temperature * temp_sensitivity + temp_zero;
+            temp_filtered = temp_filter.apply(temp);
+        }
+
+        // the samples before any corruption are passed on as one block
+        _rotate_and_correct_accel(accel_instance, accel, n);
+        _rotate_and_correct_gyro(gyro_instance, gyro, n);
 
-        _notify_new_accel_raw_sample(accel_instance, accel, 0);
-        _notify_new_gyro_raw_sample(gyro_instance, gyro);
+        _notify_new_accel_raw_samples(accel_instance, accel, n);
+        _notify_new_gyro_raw_samples(gyro_instance, gyro, n);
 
-        temp_filtered = temp_filter.apply(temp);
+        if (!ret) {
+            return false;
+        }
+        data += len;
+        n_samples -= len;
     }
     return true;
 }
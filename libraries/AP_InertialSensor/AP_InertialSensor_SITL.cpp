@@ -7,6 +7,9 @@
 
 const extern AP_HAL::HAL& hal;
 
+// maximum sample backlog we will generate in a single timer call
+#define SITL_IMU_MAX_BACKLOG_US 100000U
+
 AP_InertialSensor_SITL::AP_InertialSensor_SITL(AP_InertialSensor &imu, const uint16_t sample_rates[]) :
     AP_InertialSensor_Backend(imu),
     gyro_sample_hz(sample_rates[0]),
@@ -67,216 +70,298 @@ float AP_InertialSensor_SITL::get_temperature(void)
 }
 
 /*
-  generate an accelerometer sample
+  set the per-sample rotation of each motor oscillator. The motor
+  frequency is smeared a little on each update to emulate the spread
+  of a physical motor peak
  */
-void AP_InertialSensor_SITL::generate_accel()
+void AP_InertialSensor_SITL::MotorOscillators::set_frequencies(const float *freq_hz, uint8_t _num_motors,
+                                                               uint8_t _num_harmonics, float sample_hz)
 {
-    Vector3f accel_accum;
-    uint8_t nsamples = enable_fast_sampling(accel_instance) ? 4 : 1;
+    // this smears the individual motor peaks somewhat emulating physical motors
+    const float freq_variation = 0.12f;
+
+    num_motors = MIN(_num_motors, ARRAY_SIZE(osc));
+    num_harmonics = constrain_int16(_num_harmonics, 1, 8);
+    for (uint8_t i = 0; i < num_motors; i++) {
+        const float motor_freq = calculate_noise(freq_hz[i], freq_variation);
+        const float phase_incr = motor_freq * 2 * M_PI / sample_hz;
+        osc[i].dre = cosf(phase_incr);
+        osc[i].dim = sinf(phase_incr);
+    }
+}
 
-    for (uint8_t j = 0; j < nsamples; j++) {
+/*
+  step the oscillator bank by one sample
+ */
+float AP_InertialSensor_SITL::MotorOscillators::step()
+{
+    float sum = 0;
+    for (uint8_t i = 0; i < num_motors; i++) {
+        auto &o = osc[i];
+        const float re = o.re * o.dre - o.im * o.dim;
+        const float im = o.re * o.dim + o.im * o.dre;
+        // one Newton step towards unit magnitude stops the phasor
+        // drifting due to rounding without needing a sqrt
+        const float gain = 0.5f * (3.0f - (re*re + im*im));
+        o.re = re * gain;
+        o.im = im * gain;
+
+        float hre = o.re;
+        float him = o.im;
+        sum += him;
+        for (uint8_t h = 2; h <= num_harmonics; h++) {
+            const float t = hre * o.re - him * o.im;
+            him = hre * o.im + him * o.re;
+            hre = t;
+            sum += him / h;
+        }
+    }
+    return sum;
+}
 
-        Vector3f accel = Vector3f(sitl->state.xAccel,
-                                  sitl->state.yAccel,
-                                  sitl->state.zAccel);
+/*
+  update the motor oscillator frequencies from the current physics state
+ */
+void AP_InertialSensor_SITL::update_motor_oscillators(void)
+{
+    if (is_zero(sitl->vibe_motor)) {
+        return;
+    }
+    float freq_hz[ARRAY_SIZE(sitl->state.rpm)];
+    const uint8_t num_motors = MIN(sitl->state.num_motors, ARRAY_SIZE(freq_hz) - sitl->state.vtol_motor_start);
+    for (uint8_t i = 0; i < num_motors; i++) {
+        freq_hz[i] = sitl->state.rpm[sitl->state.vtol_motor_start+i] / 60.0f;
+    }
+    const uint8_t gyro_nsamples = (gyro_raw_hz == 0 && enable_fast_sampling(gyro_instance)) ? 8 : 1;
+    const uint8_t accel_nsamples = (accel_raw_hz == 0 && enable_fast_sampling(accel_instance)) ? 4 : 1;
+    gyro_motor_osc.set_frequencies(freq_hz, num_motors, sitl->vibe_motor_harmonics,
+                                   (gyro_raw_hz ? gyro_raw_hz : gyro_sample_hz) * gyro_nsamples);
+    accel_motor_osc.set_frequencies(freq_hz, num_motors, sitl->vibe_motor_harmonics,
+                                    (accel_raw_hz ? accel_raw_hz : accel_sample_hz) * accel_nsamples);
+}
 
-        const Vector3f &accel_trim = sitl->accel_trim.get();
-        if (!accel_trim.is_zero()) {
-            Matrix3f trim_rotation;
-            trim_rotation.from_euler(accel_trim.x, accel_trim.y, 0);
-            accel = trim_rotation.transposed() * accel;
-        }
+/*
+  calculate one sensor rate accelerometer sample
+ */
+Vector3f AP_InertialSensor_SITL::sample_accel(uint16_t sample_hz)
+{
+    Vector3f accel = Vector3f(sitl->state.xAccel,
+                              sitl->state.yAccel,
+                              sitl->state.zAccel);
+
+    const Vector3f &accel_trim = sitl->accel_trim.get();
+    if (!accel_trim.is_zero()) {
+        Matrix3f trim_rotation;
+        trim_rotation.from_euler(accel_trim.x, accel_trim.y, 0);
+        accel = trim_rotation.transposed() * accel;
+    }
 
-        // add scaling
-        Vector3f accel_scale = sitl->accel_scale[accel_instance].get();
-        // note that we divide so the SIM_ACC values match the
-        // INS_ACCSCAL values
-        if (!is_zero(accel_scale.x)) {
-            accel.x /= accel_scale.x;
-        }
-        if (!is_zero(accel_scale.y)) {
-            accel.y /= accel_scale.y;
-        }
-        if (!is_zero(accel_scale.z)) {
-            accel.z /= accel_scale.z;
-        }
+    // add scaling
+    Vector3f accel_scale = sitl->accel_scale[accel_instance].get();
+    // note that we divide so the SIM_ACC values match the
+    // INS_ACCSCAL values
+    if (!is_zero(accel_scale.x)) {
+        accel.x /= accel_scale.x;
+    }
+    if (!is_zero(accel_scale.y)) {
+        accel.y /= accel_scale.y;
+    }
+    if (!is_zero(accel_scale.z)) {
+        accel.z /= accel_scale.z;
+    }
 
-        // apply bias
-        const Vector3f &accel_bias = sitl->accel_bias[accel_instance].get();
-        accel += accel_bias;
+    // apply bias
+    const Vector3f &accel_bias = sitl->accel_bias[accel_instance].get();
+    accel += accel_bias;
 
-        // minimum noise levels are 2 bits, but averaged over many
-        // samples, giving around 0.01 m/s/s
-        float accel_noise = 0.01f;
-        float noise_variation = 0.05f;
-        // this smears the individual motor peaks somewhat emulating physical motors
-        float freq_variation = 0.12f;
+    // minimum noise levels are 2 bits, but averaged over many
+    // samples, giving around 0.01 m/s/s
+    float accel_noise = 0.01f;
+    float noise_variation = 0.05f;
 
-        // add in sensor noise
-        accel += Vector3f{rand_float(), rand_float(), rand_float()} * accel_noise;
+    // add in sensor noise
+    accel += Vector3f{rand_float(), rand_float(), rand_float()} * accel_noise;
 
-        bool motors_on = sitl->throttle > sitl->ins_noise_throttle_min;
+    bool motors_on = sitl->throttle > sitl->ins_noise_throttle_min;
 
-        // on a real 180mm copter gyro noise varies between 0.8-4 m/s/s for throttle 0.2-0.8
-        // giving a accel noise variation of 5.33 m/s/s over the full throttle range
-        if (motors_on) {
-            // add extra noise when the motors are on
-            accel_noise = sitl->accel_noise[accel_instance];
-        }
+    // on a real 180mm copter gyro noise varies between 0.8-4 m/s/s for throttle 0.2-0.8
+    // giving a accel noise variation of 5.33 m/s/s over the full throttle range
+    if (motors_on) {
+        // add extra noise when the motors are on
+        accel_noise = sitl->accel_noise[accel_instance];
+    }
 
-        // VIB_FREQ is a static vibration applied to each axis
-        const Vector3f &vibe_freq = sitl->vibe_freq;
+    // VIB_FREQ is a static vibration applied to each axis
+    const Vector3f &vibe_freq = sitl->vibe_freq;
 
-        if (!vibe_freq.is_zero() && motors_on) {
-            accel.x += sinf(accel_time * 2 * M_PI * vibe_freq.x) * calculate_noise(accel_noise, noise_variation);
-            accel.y += sinf(accel_time * 2 * M_PI * vibe_freq.y) * calculate_noise(accel_noise, noise_variation);
-            accel.z += sinf(accel_time * 2 * M_PI * vibe_freq.z) * calculate_noise(accel_noise, noise_variation);
-            accel_time += 1.0f / (accel_sample_hz * nsamples);
-        }
+    if (!vibe_freq.is_zero() && motors_on) {
+        accel.x += sinf(accel_time * 2 * M_PI * vibe_freq.x) * calculate_noise(accel_noise, noise_variation);
+        accel.y += sinf(accel_time * 2 * M_PI * vibe_freq.y) * calculate_noise(accel_noise, noise_variation);
+        accel.z += sinf(accel_time * 2 * M_PI * vibe_freq.z) * calculate_noise(accel_noise, noise_variation);
+        accel_time += 1.0f / sample_hz;
+    }
 
-        // VIB_MOT_MAX is a rpm-scaled vibration applied to each axis
-        if (!is_zero(sitl->vibe_motor) && motors_on) {
-            for (uint8_t i = 0; i < sitl->state.num_motors; i++) {
-                float &phase = accel_motor_phase[i];
-                float motor_freq = calculate_noise(sitl->state.rpm[sitl->state.vtol_motor_start+i] / 60.0f, freq_variation);
-                float phase_incr = motor_freq * 2 * M_PI / (accel_sample_hz * nsamples);
-                phase += phase_incr;
-                if (phase_incr > M_PI) {
-                    phase -= 2 * M_PI;
-                }
-                else if (phase_incr < -M_PI) {
-                    phase += 2 * M_PI;
-                }
-                accel.x += sinf(phase) * calculate_noise(accel_noise * sitl->vibe_motor_scale, noise_variation);
-                accel.y += sinf(phase) * calculate_noise(accel_noise * sitl->vibe_motor_scale, noise_variation);
-                accel.z += sinf(phase) * calculate_noise(accel_noise * sitl->vibe_motor_scale, noise_variation);
-            }
-        }
+    // VIB_MOT_MAX is a rpm-scaled vibration applied to each axis
+    if (!is_zero(sitl->vibe_motor) && motors_on) {
+        const float vibe = accel_motor_osc.step();
+        const float motor_noise = accel_noise * sitl->vibe_motor_scale;
+        accel.x += vibe * calculate_noise(motor_noise, noise_variation);
+        accel.y += vibe * calculate_noise(motor_noise, noise_variation);
+        accel.z += vibe * calculate_noise(motor_noise, noise_variation);
+    }
 
-        // correct for the acceleration due to the IMU position offset and angular acceleration
-        // correct for the centripetal acceleration
-        // only apply corrections to first accelerometer
-        Vector3f pos_offset = sitl->imu_pos_offset;
-        if (!pos_offset.is_zero()) {
-            // calculate sensed acceleration due to lever arm effect
-            // Note: the % operator has been overloaded to provide a cross product
-            Vector3f angular_accel = Vector3f(radians(sitl->state.angAccel.x), radians(sitl->state.angAccel.y), radians(sitl->state.angAccel.z));
-            Vector3f lever_arm_accel = angular_accel % pos_offset;
-
-            // calculate sensed acceleration due to centripetal acceleration
-            Vector3f angular_rate = Vector3f(radians(sitl->state.rollRate), radians(sitl->state.pitchRate), radians(sitl->state.yawRate));
-            Vector3f centripetal_accel = angular_rate % (angular_rate % pos_offset);
-
-            // apply corrections
-            accel += lever_arm_accel + centripetal_accel;
-        }
+    // correct for the acceleration due to the IMU position offset and angular acceleration
+    // correct for the centripetal acceleration
+    // only apply corrections to first accelerometer
+    Vector3f pos_offset = sitl->imu_pos_offset;
+    if (!pos_offset.is_zero()) {
+        // calculate sensed acceleration due to lever arm effect
+        // Note: the % operator has been overloaded to provide a cross product
+        Vector3f angular_accel = Vector3f(radians(sitl->state.angAccel.x), radians(sitl->state.angAccel.y), radians(sitl->state.angAccel.z));
+        Vector3f lever_arm_accel = angular_accel % pos_offset;
+
+        // calculate sensed acceleration due to centripetal acceleration
+        Vector3f angular_rate = Vector3f(radians(sitl->state.rollRate), radians(sitl->state.pitchRate), radians(sitl->state.yawRate));
+        Vector3f centripetal_accel = angular_rate % (angular_rate % pos_offset);
+
+        // apply corrections
+        accel += lever_arm_accel + centripetal_accel;
+    }
 
-        if (fabsf(sitl->accel_fail[accel_instance]) > 1.0e-6f) {
-            accel.x = accel.y = accel.z = sitl->accel_fail[accel_instance];
-        }
+    if (fabsf(sitl->accel_fail[accel_instance]) > 1.0e-6f) {
+        accel.x = accel.y = accel.z = sitl->accel_fail[accel_instance];
+    }
 
 #if HAL_INS_TEMPERATURE_CAL_ENABLE
-        const float T = get_temperature();
-        sitl->imu_tcal[gyro_instance].sitl_apply_accel(T, accel);
+    const float T = get_temperature();
+    sitl->imu_tcal[gyro_instance].sitl_apply_accel(T, accel);
 #endif
 
+    return accel;
+}
+
+/*
+  generate an accelerometer sample
+ */
+void AP_InertialSensor_SITL::generate_accel(uint64_t sample_us)
+{
+    if (accel_raw_hz != 0) {
+        // pass every sensor sample through the raw sample path
+        Vector3f accel = sample_accel(accel_raw_hz);
         _notify_new_accel_sensor_rate_sample(accel_instance, accel);
+        _rotate_and_correct_accel(accel_instance, accel);
+        _notify_new_accel_raw_sample(accel_instance, accel, sample_us);
+        _publish_temperature(accel_instance, get_temperature());
+        return;
+    }
+
+    Vector3f accel_accum;
+    uint8_t nsamples = enable_fast_sampling(accel_instance) ? 4 : 1;
 
+    for (uint8_t j = 0; j < nsamples; j++) {
+        const Vector3f accel = sample_accel(accel_sample_hz * nsamples);
+        _notify_new_accel_sensor_rate_sample(accel_instance, accel);
         accel_accum += accel;
     }
 
     accel_accum /= nsamples;
     _rotate_and_correct_accel(accel_instance, accel_accum);
-    _notify_new_accel_raw_sample(accel_instance, accel_accum, AP_HAL::micros64());
+    _notify_new_accel_raw_sample(accel_instance, accel_accum, sample_us);
 
     _publish_temperature(accel_instance, get_temperature());
 }
 
 /*
-  generate a gyro sample
+  calculate one sensor rate gyro sample
  */
-void AP_InertialSensor_SITL::generate_gyro()
+Vector3f AP_InertialSensor_SITL::sample_gyro(uint16_t sample_hz)
 {
-    Vector3f gyro_accum;
-    uint8_t nsamples = enable_fast_sampling(gyro_instance) ? 8 : 1;
+    float p = radians(sitl->state.rollRate) + gyro_drift();
+    float q = radians(sitl->state.pitchRate) + gyro_drift();
+    float r = radians(sitl->state.yawRate) + gyro_drift();
+
+    // minimum gyro noise is less than 1 bit
+    float gyro_noise = ToRad(0.04f);
+    float noise_variation = 0.05f;
+    // add in sensor noise
+    p += gyro_noise * rand_float();
+    q += gyro_noise * rand_float();
+    r += gyro_noise * rand_float();
+
+    bool motors_on = sitl->throttle > sitl->ins_noise_throttle_min;
+    // on a real 180mm copter gyro noise varies between 0.2-0.4 rad/s for throttle 0.2-0.8
+    // giving a gyro noise variation of 0.33 rad/s or 20deg/s over the full throttle range
+    if (motors_on) {
+        // add extra noise when the motors are on
+        gyro_noise = ToRad(sitl->gyro_noise[gyro_instance]) * sitl->throttle;
+    }
 
-    for (uint8_t j = 0; j < nsamples; j++) {
-        float p = radians(sitl->state.rollRate) + gyro_drift();
-        float q = radians(sitl->state.pitchRate) + gyro_drift();
-        float r = radians(sitl->state.yawRate) + gyro_drift();
-
-        // minimum gyro noise is less than 1 bit
-        float gyro_noise = ToRad(0.04f);
-        float noise_variation = 0.05f;
-        // this smears the individual motor peaks somewhat emulating physical motors
-        float freq_variation = 0.12f;
-        // add in sensor noise
+    // VIB_FREQ is a static vibration applied to each axis
+    const Vector3f &vibe_freq = sitl->vibe_freq;
+
+    if (vibe_freq.is_zero() && is_zero(sitl->vibe_motor)) {
+        // no rpm noise, so add in background noise if any
         p += gyro_noise * rand_float();
         q += gyro_noise * rand_float();
         r += gyro_noise * rand_float();
+    }
 
-        bool motors_on = sitl->throttle > sitl->ins_noise_throttle_min;
-        // on a real 180mm copter gyro noise varies between 0.2-0.4 rad/s for throttle 0.2-0.8
-        // giving a gyro noise variation of 0.33 rad/s or 20deg/s over the full throttle range
-        if (motors_on) {
-            // add extra noise when the motors are on
-            gyro_noise = ToRad(sitl->gyro_noise[gyro_instance]) * sitl->throttle;
-        }
+    if (!vibe_freq.is_zero() && motors_on) {
+        p += sinf(gyro_time * 2 * M_PI * vibe_freq.x) * calculate_noise(gyro_noise, noise_variation);
+        q += sinf(gyro_time * 2 * M_PI * vibe_freq.y) * calculate_noise(gyro_noise, noise_variation);
+        r += sinf(gyro_time * 2 * M_PI * vibe_freq.z) * calculate_noise(gyro_noise, noise_variation);
+        gyro_time += 1.0f / sample_hz;
+    }
 
-        // VIB_FREQ is a static vibration applied to each axis
-        const Vector3f &vibe_freq = sitl->vibe_freq;
+    // VIB_MOT_MAX is a rpm-scaled vibration applied to each axis
+    if (!is_zero(sitl->vibe_motor) && motors_on) {
+        const float vibe = gyro_motor_osc.step();
+        const float motor_noise = gyro_noise * sitl->vibe_motor_scale;
+        p += vibe * calculate_noise(motor_noise, noise_variation);
+        q += vibe * calculate_noise(motor_noise, noise_variation);
+        r += vibe * calculate_noise(motor_noise, noise_variation);
+    }
 
-        if (vibe_freq.is_zero() && is_zero(sitl->vibe_motor)) {
-            // no rpm noise, so add in background noise if any
-            p += gyro_noise * rand_float();
-            q += gyro_noise * rand_float();
-            r += gyro_noise * rand_float();
-        }
+    Vector3f gyro = Vector3f(p, q, r);
 
-        if (!vibe_freq.is_zero() && motors_on) {
-            p += sinf(gyro_time * 2 * M_PI * vibe_freq.x) * calculate_noise(gyro_noise, noise_variation);
-            q += sinf(gyro_time * 2 * M_PI * vibe_freq.y) * calculate_noise(gyro_noise, noise_variation);
-            r += sinf(gyro_time * 2 * M_PI * vibe_freq.z) * calculate_noise(gyro_noise, noise_variation);
-            gyro_time += 1.0f / (gyro_sample_hz * nsamples);
-        }
+#if HAL_INS_TEMPERATURE_CAL_ENABLE
+    sitl->imu_tcal[gyro_instance].sitl_apply_gyro(get_temperature(), gyro);
+#endif
 
-        // VIB_MOT_MAX is a rpm-scaled vibration applied to each axis
-        if (!is_zero(sitl->vibe_motor) && motors_on) {
-            for (uint8_t i = 0; i < sitl->state.num_motors; i++) {
-                float motor_freq = calculate_noise(sitl->state.rpm[sitl->state.vtol_motor_start+i] / 60.0f, freq_variation);
-                float phase_incr = motor_freq * 2 * M_PI / (gyro_sample_hz * nsamples);
-                float &phase = gyro_motor_phase[i];
-                phase += phase_incr;
-                if (phase_incr > M_PI) {
-                    phase -= 2 * M_PI;
-                }
-                else if (phase_incr < -M_PI) {
-                    phase += 2 * M_PI;
-                }
-                p += sinf(phase) * calculate_noise(gyro_noise * sitl->vibe_motor_scale, noise_variation);
-                q += sinf(phase) * calculate_noise(gyro_noise * sitl->vibe_motor_scale, noise_variation);
-                r += sinf(phase) * calculate_noise(gyro_noise * sitl->vibe_motor_scale, noise_variation);
-            }
-        }
+    // add in gyro scaling
+    Vector3f scale = sitl->gyro_scale[gyro_instance];
+    gyro.x *= (1 + scale.x * 0.01f);
+    gyro.y *= (1 + scale.y * 0.01f);
+    gyro.z *= (1 + scale.z * 0.01f);
 
-        Vector3f gyro = Vector3f(p, q, r);
+    return gyro;
+}
 
-#if HAL_INS_TEMPERATURE_CAL_ENABLE
-        sitl->imu_tcal[gyro_instance].sitl_apply_gyro(get_temperature(), gyro);
-#endif
+/*
+  generate a gyro sample
+ */
+void AP_InertialSensor_SITL::generate_gyro(uint64_t sample_us)
+{
+    if (gyro_raw_hz != 0) {
+        // pass every sensor sample through the raw sample path
+        Vector3f gyro = sample_gyro(gyro_raw_hz);
+        _notify_new_gyro_sensor_rate_sample(gyro_instance, gyro);
+        _rotate_and_correct_gyro(gyro_instance, gyro);
+        _notify_new_gyro_raw_sample(gyro_instance, gyro, sample_us);
+        return;
+    }
 
-        // add in gyro scaling
-        Vector3f scale = sitl->gyro_scale[gyro_instance];
-        gyro.x *= (1 + scale.x * 0.01f);
-        gyro.y *= (1 + scale.y * 0.01f);
-        gyro.z *= (1 + scale.z * 0.01f);
+    Vector3f gyro_accum;
+    uint8_t nsamples = enable_fast_sampling(gyro_instance) ? 8 : 1;
 
+    for (uint8_t j = 0; j < nsamples; j++) {
+        const Vector3f gyro = sample_gyro(gyro_sample_hz * nsamples);
         gyro_accum += gyro;
         _notify_new_gyro_sensor_rate_sample(gyro_instance, gyro);
     }
     gyro_accum /= nsamples;
     _rotate_and_correct_gyro(gyro_instance, gyro_accum);
-    _notify_new_gyro_raw_sample(gyro_instance, gyro_accum, AP_HAL::micros64());
+    _notify_new_gyro_raw_sample(gyro_instance, gyro_accum, sample_us);
 }
 
 void AP_InertialSensor_SITL::timer_update(void)
@@ -292,26 +377,57 @@ void AP_InertialSensor_SITL::timer_update(void)
     if (sitl == nullptr) {
         return;
     }
+
+    // the physics state only changes between timer calls, so the
+    // motor frequencies are only updated once per call
+    update_motor_oscillators();
+
     if (now >= next_accel_sample) {
         if (((1U << accel_instance) & sitl->accel_fail_mask) == 0) {
-            generate_accel();
-            if (next_accel_sample == 0) {
-                next_accel_sample = now + 1000000UL / accel_sample_hz;
-            } else {
+            if (accel_raw_hz != 0) {
+                const uint32_t interval_us = 1000000UL / accel_raw_hz;
+                if (now - next_accel_sample > SITL_IMU_MAX_BACKLOG_US) {
+                    // we have been paused, don't try to catch up
+                    next_accel_sample = now;
+                }
+                // generate every sample that is due, each with its
+                // own timestamp, as a FIFO sensor would
                 while (now >= next_accel_sample) {
-                    next_accel_sample += 1000000UL / accel_sample_hz;
+                    generate_accel(next_accel_sample);
+                    next_accel_sample += interval_us;
+                }
+            } else {
+                generate_accel(now);
+                if (next_accel_sample == 0) {
+                    next_accel_sample = now + 1000000UL / accel_sample_hz;
+                } else {
+                    while (now >= next_accel_sample) {
+                        next_accel_sample += 1000000UL / accel_sample_hz;
+                    }
                 }
             }
         }
     }
     if (now >= next_gyro_sample) {
         if (((1U << gyro_instance) & sitl->gyro_fail_mask) == 0) {
-            generate_gyro();
-            if (next_gyro_sample == 0) {
-                next_gyro_sample = now + 1000000UL / gyro_sample_hz;
-            } else {
+            if (gyro_raw_hz != 0) {
+                const uint32_t interval_us = 1000000UL / gyro_raw_hz;
+                if (now - next_gyro_sample > SITL_IMU_MAX_BACKLOG_US) {
+                    // we have been paused, don't try to catch up
+                    next_gyro_sample = now;
+                }
                 while (now >= next_gyro_sample) {
-                    next_gyro_sample += 1000000UL / gyro_sample_hz;
+                    generate_gyro(next_gyro_sample);
+                    next_gyro_sample += interval_us;
+                }
+            } else {
+                generate_gyro(now);
+                if (next_gyro_sample == 0) {
+                    next_gyro_sample = now + 1000000UL / gyro_sample_hz;
+                } else {
+                    while (now >= next_gyro_sample) {
+                        next_gyro_sample += 1000000UL / gyro_sample_hz;
+                    }
                 }
             }
         }
@@ -351,6 +467,20 @@ void AP_InertialSensor_SITL::start()
         return;
     }
     bus_id++;
+
+    /*
+      with SIM_IMU_FAST_RAW set behave like a FIFO sensor with fast
+      sampling, delivering every sample at the INS_GYRO_RATE rate
+      rather than averaging down to the backend rate
+     */
+    if (sitl->imu_fast_raw && enable_fast_sampling(gyro_instance)) {
+        const uint8_t fast_sampling_rate = constrain_int16(get_fast_sampling_rate(), 1, 8);
+        gyro_raw_hz = 1000U * fast_sampling_rate;
+        accel_raw_hz = 1000U * MIN(fast_sampling_rate, 4);
+        _set_gyro_raw_sample_rate(gyro_instance, gyro_raw_hz);
+        _set_accel_raw_sample_rate(accel_instance, accel_raw_hz);
+    }
+
     hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_InertialSensor_SITL::timer_update, void));
 }
 
@@ -25,11 +25,38 @@ public:
     static AP_InertialSensor_Backend *detect(AP_InertialSensor &imu, const uint16_t sample_rates[]);
 
 private:
+    /*
+      bank of motor-locked oscillators. Each motor is a unit phasor
+      rotated once per sample, with harmonics derived from the
+      fundamental by complex multiplication, so no trig is needed per
+      sample. Frequencies are updated once per physics step.
+     */
+    class MotorOscillators {
+    public:
+        // set per-sample rotation from motor frequencies in Hz
+        void set_frequencies(const float *freq_hz, uint8_t num_motors, uint8_t num_harmonics, float sample_hz);
+
+        // advance all oscillators by one sample, returning the summed
+        // vibration, with harmonic N weighted by 1/N
+        float step();
+
+    private:
+        struct {
+            float re = 1, im = 0;   // current phasor
+            float dre = 1, dim = 0; // per-sample rotation
+        } osc[ARRAY_SIZE(SITL::sitl_fdm::rpm)];
+        uint8_t num_motors = 0;
+        uint8_t num_harmonics = 1;
+    };
+
     bool init_sensor(void);
     void timer_update();
     float gyro_drift(void);
-    void generate_accel();
-    void generate_gyro();
+    void generate_accel(uint64_t sample_us);
+    void generate_gyro(uint64_t sample_us);
+    Vector3f sample_accel(uint16_t sample_hz);
+    Vector3f sample_gyro(uint16_t sample_hz);
+    void update_motor_oscillators(void);
     float get_temperature(void);
 
     SITL::SIM *sitl;
@@ -37,14 +64,20 @@ private:
     const uint16_t gyro_sample_hz;
     const uint16_t accel_sample_hz;
 
+    // when SIM_IMU_FAST_RAW is set and fast sampling is enabled these
+    // are the rates at which every sensor sample is passed to the
+    // frontend, otherwise zero
+    uint16_t gyro_raw_hz;
+    uint16_t accel_raw_hz;
+
     uint8_t gyro_instance;
     uint8_t accel_instance;
     uint64_t next_gyro_sample;
     uint64_t next_accel_sample;
     float gyro_time;
     float accel_time;
-    float gyro_motor_phase[12];
-    float accel_motor_phase[12];
+    MotorOscillators gyro_motor_osc;
+    MotorOscillators accel_motor_osc;
     uint32_t temp_start_ms;
 
     static uint8_t bus_id;
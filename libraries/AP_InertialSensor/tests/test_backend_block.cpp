@@ -0,0 +1,117 @@
+#include <AP_gtest.h>
+
+#include <AP_InertialSensor/AP_InertialSensor.h>
+#include <AP_InertialSensor/AP_InertialSensor_Backend.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const uint16_t sample_rate_hz = 1000;
+
+// expose the protected backend interfaces
+class AP_InertialSensor_Dummy : public AP_InertialSensor_Backend
+{
+public:
+    AP_InertialSensor_Dummy(AP_InertialSensor &imu) : AP_InertialSensor_Backend(imu) {}
+    bool update() override { return true; }
+
+    using AP_InertialSensor_Backend::block_sample_us;
+    using AP_InertialSensor_Backend::_notify_new_gyro_raw_sample;
+    using AP_InertialSensor_Backend::_notify_new_gyro_raw_samples;
+    using AP_InertialSensor_Backend::_notify_new_accel_raw_sample;
+    using AP_InertialSensor_Backend::_notify_new_accel_raw_samples;
+    using AP_InertialSensor_Backend::update_gyro;
+    using AP_InertialSensor_Backend::update_accel;
+};
+
+static AP_InertialSensor ins;
+static AP_InertialSensor_Dummy backend{ins};
+
+// the last sample of a block takes the block time and earlier
+// samples are one sample interval apart before it
+TEST(InertialSensorBackendTest, BlockSampleTimes)
+{
+    float dt[INS_SAMPLE_BLOCK_LEN];
+    for (uint8_t i = 0; i < INS_SAMPLE_BLOCK_LEN; i++) {
+        dt[i] = 1.0f / sample_rate_hz;
+    }
+    for (uint8_t i = 0; i < INS_SAMPLE_BLOCK_LEN; i++) {
+        const uint64_t expected_us = 5000000 - (INS_SAMPLE_BLOCK_LEN - 1 - i) * 1000;
+        EXPECT_NEAR(expected_us, backend.block_sample_us(5000000, dt, INS_SAMPLE_BLOCK_LEN, i), INS_SAMPLE_BLOCK_LEN);
+    }
+
+    // times never go back past zero
+    EXPECT_EQ(0U, backend.block_sample_us(2500, dt, INS_SAMPLE_BLOCK_LEN, 0));
+    EXPECT_EQ(2500U, backend.block_sample_us(2500, dt, INS_SAMPLE_BLOCK_LEN, INS_SAMPLE_BLOCK_LEN-1));
+}
+
+// pushing a FIFO burst through the block path gives the same filtered
+// values and delta angles and velocities as pushing each sample in turn
+TEST(InertialSensorBackendTest, BlockMatchesSamples)
+{
+    uint8_t gyro_block, gyro_single, accel_block, accel_single;
+    ASSERT_TRUE(ins.register_gyro(gyro_block, sample_rate_hz, 1));
+    ASSERT_TRUE(ins.register_gyro(gyro_single, sample_rate_hz, 2));
+    ASSERT_TRUE(ins.register_accel(accel_block, sample_rate_hz, 1));
+    ASSERT_TRUE(ins.register_accel(accel_single, sample_rate_hz, 2));
+
+    // bursts of different lengths, including longer than one block
+    const uint8_t burst_len[] { 1, 3, INS_SAMPLE_BLOCK_LEN, INS_SAMPLE_BLOCK_LEN+5, 7 };
+    uint16_t step = 0;
+    for (uint8_t b = 0; b < 40; b++) {
+        const uint8_t n = burst_len[b % ARRAY_SIZE(burst_len)];
+        Vector3f gyro[16];
+        Vector3f accel[16];
+        for (uint8_t i = 0; i < n; i++, step++) {
+            const float t = step / float(sample_rate_hz);
+            gyro[i] = Vector3f(sinf(2 * M_PI * 45 * t), 0.2 * cosf(2 * M_PI * 80 * t), 0.1 - sinf(2 * M_PI * 3 * t));
+            accel[i] = Vector3f(cosf(2 * M_PI * 30 * t), sinf(2 * M_PI * 12 * t), -GRAVITY_MSS + sinf(2 * M_PI * 70 * t));
+        }
+
+        // the block path filters in place
+        Vector3f gyro_copy[ARRAY_SIZE(gyro)];
+        Vector3f accel_copy[ARRAY_SIZE(accel)];
+        memcpy(gyro_copy, gyro, sizeof(gyro));
+        memcpy(accel_copy, accel, sizeof(accel));
+        backend._notify_new_gyro_raw_samples(gyro_block, gyro_copy, n);
+        backend._notify_new_accel_raw_samples(accel_block, accel_copy, n);
+        for (uint8_t i = 0; i < n; i++) {
+            backend._notify_new_gyro_raw_sample(gyro_single, gyro[i]);
+            backend._notify_new_accel_raw_sample(accel_single, accel[i]);
+        }
+
+        backend.update_gyro(gyro_block);
+        backend.update_gyro(gyro_single);
+        backend.update_accel(accel_block);
+        backend.update_accel(accel_single);
+
+        const Vector3f &g1 = ins.get_gyro(gyro_block);
+        const Vector3f &g2 = ins.get_gyro(gyro_single);
+        EXPECT_NEAR(g2.x, g1.x, 1.0e-5);
+        EXPECT_NEAR(g2.y, g1.y, 1.0e-5);
+        EXPECT_NEAR(g2.z, g1.z, 1.0e-5);
+
+        const Vector3f &a1 = ins.get_accel(accel_block);
+        const Vector3f &a2 = ins.get_accel(accel_single);
+        EXPECT_NEAR(a2.x, a1.x, 1.0e-5);
+        EXPECT_NEAR(a2.y, a1.y, 1.0e-5);
+        EXPECT_NEAR(a2.z, a1.z, 1.0e-5);
+
+        Vector3f da1, da2, dv1, dv2;
+        float da1_dt, da2_dt, dv1_dt, dv2_dt;
+        ASSERT_TRUE(ins.get_delta_angle(gyro_block, da1, da1_dt));
+        ASSERT_TRUE(ins.get_delta_angle(gyro_single, da2, da2_dt));
+        EXPECT_FLOAT_EQ(da2_dt, da1_dt);
+        EXPECT_NEAR(da2.x, da1.x, 1.0e-6);
+        EXPECT_NEAR(da2.y, da1.y, 1.0e-6);
+        EXPECT_NEAR(da2.z, da1.z, 1.0e-6);
+
+        ASSERT_TRUE(ins.get_delta_velocity(accel_block, dv1, dv1_dt));
+        ASSERT_TRUE(ins.get_delta_velocity(accel_single, dv2, dv2_dt));
+        EXPECT_FLOAT_EQ(dv2_dt, dv1_dt);
+        EXPECT_NEAR(dv2.x, dv1.x, 1.0e-6);
+        EXPECT_NEAR(dv2.y, dv1.y, 1.0e-6);
+        EXPECT_NEAR(dv2.z, dv1.z, 1.0e-6);
+    }
+}
+
+AP_GTEST_MAIN()
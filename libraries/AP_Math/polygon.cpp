@@ -26,6 +26,54 @@
  */
 
 
+/*
+ *  returns true if the edge from Vi to Vj crosses the horizontal line
+ *  through P on the side that toggles the point in polygon test
+ */
+template <typename T>
+static inline bool Polygon_edge_crossing(const Vector2<T> &P, const Vector2<T> &Vi, const Vector2<T> &Vj)
+{
+    if ((Vi.y > P.y) == (Vj.y > P.y)) {
+        return false;
+    }
+    const T dx1 = P.x - Vi.x;
+    const T dx2 = Vj.x - Vi.x;
+    const T dy1 = P.y - Vi.y;
+    const T dy2 = Vj.y - Vi.y;
+    const int8_t dx1s = (dx1 < 0) ? -1 : 1;
+    const int8_t dx2s = (dx2 < 0) ? -1 : 1;
+    const int8_t dy1s = (dy1 < 0) ? -1 : 1;
+    const int8_t dy2s = (dy2 < 0) ? -1 : 1;
+    const int8_t m1 = dx1s * dy2s;
+    const int8_t m2 = dx2s * dy1s;
+    // we avoid the 64 bit multiplies if we can based on sign checks.
+    if (dy2 < 0) {
+        if (m1 > m2) {
+            return true;
+        } else if (m1 < m2) {
+            return false;
+        } else {
+            if (std::is_floating_point<T>::value) {
+                return ( dx1 * dy2 > dx2 * dy1 );
+            } else {
+                return ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 );
+            }
+        }
+    } else {
+        if (m1 < m2) {
+            return true;
+        } else if (m1 > m2) {
+            return false;
+        } else {
+            if (std::is_floating_point<T>::value) {
+                return ( dx1 * dy2 < dx2 * dy1 );
+            } else {
+                return ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 );
+            }
+        }
+    }
+}
+
 /*
  *  Polygon_outside(): test for a point in a polygon
  *     Input:   P = a point,
@@ -54,52 +102,8 @@ bool Polygon_outside(const Vector2<T> &P, const Vector2<T> *V, unsigned n)
         if (j >= n) {
             j = 0;
         }
-        if ((V[i].y > P.y) == (V[j].y > P.y)) {
-            continue;
-        }
-        const T dx1 = P.x - V[i].x;
-        const T dx2 = V[j].x - V[i].x;
-        const T dy1 = P.y - V[i].y;
-        const T dy2 = V[j].y - V[i].y;
-        const int8_t dx1s = (dx1 < 0) ? -1 : 1;
-        const int8_t dx2s = (dx2 < 0) ? -1 : 1;
-        const int8_t dy1s = (dy1 < 0) ? -1 : 1;
-        const int8_t dy2s = (dy2 < 0) ? -1 : 1;
-        const int8_t m1 = dx1s * dy2s;
-        const int8_t m2 = dx2s * dy1s;
-        // we avoid the 64 bit multiplies if we can based on sign checks.
-        if (dy2 < 0) {
-            if (m1 > m2) {
-                outside = !outside;
-            } else if (m1 < m2) {
-                continue;
-            } else {
-                if (std::is_floating_point<T>::value) {
-                    if ( dx1 * dy2 > dx2 * dy1 ) {
-                        outside = !outside;
-                    }
-                } else {
-                    if ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 ) {
-                        outside = !outside;
-                    }
-                }
-            }
-        } else {
-            if (m1 < m2) {
-                outside = !outside;
-            } else if (m1 > m2) {
-                continue;
-            } else {
-                if (std::is_floating_point<T>::value) {
-                    if ( dx1 * dy2 < dx2 * dy1 ) {
-                        outside = !outside;
-                    }
-                } else {
-                    if ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 ) {
-                        outside = !outside;
-                    }
-                }
-            }
+        if (Polygon_edge_crossing(P, V[i], V[j])) {
+            outside = !outside;
         }
     }
     return outside;
@@ -118,11 +122,130 @@ bool Polygon_complete(const Vector2<T> *V, unsigned n)
     return (n >= 4 && V[n-1] == V[0]);
 }
 
+#define POLYGON_EDGE_BOX_EDGES 16  // number of consecutive edges in each box
+
+// build boxes for polygon V of n points
+template <typename T>
+void PolygonEdgeBoxes<T>::init(const Vector2<T> *V, uint16_t n)
+{
+    clear();
+    _points = V;
+    _num_points = n;
+    if ((V == nullptr) || (n == 0)) {
+        return;
+    }
+
+    const uint16_t num_boxes = (n + POLYGON_EDGE_BOX_EDGES - 1) / POLYGON_EDGE_BOX_EDGES;
+    _boxes = new Box[num_boxes];
+    if (_boxes == nullptr) {
+        return;
+    }
+
+    // each box holds both ends of its edges
+    for (uint16_t b = 0; b < num_boxes; b++) {
+        Box &box = _boxes[b];
+        const uint32_t first = b * POLYGON_EDGE_BOX_EDGES;
+        const uint32_t last = MIN(first + POLYGON_EDGE_BOX_EDGES, n);
+        box.min = box.max = V[first];
+        for (uint32_t i = first + 1; i <= last; i++) {
+            const Vector2<T> &point = V[(i < n) ? i : 0];
+            box.min.x = MIN(box.min.x, point.x);
+            box.min.y = MIN(box.min.y, point.y);
+            box.max.x = MAX(box.max.x, point.x);
+            box.max.y = MAX(box.max.y, point.y);
+        }
+        if (b == 0) {
+            _bounds = box;
+        } else {
+            _bounds.min.x = MIN(_bounds.min.x, box.min.x);
+            _bounds.min.y = MIN(_bounds.min.y, box.min.y);
+            _bounds.max.x = MAX(_bounds.max.x, box.max.x);
+            _bounds.max.y = MAX(_bounds.max.y, box.max.y);
+        }
+    }
+}
+
+// free memory and forget the polygon
+template <typename T>
+void PolygonEdgeBoxes<T>::clear()
+{
+    delete[] _boxes;
+    _boxes = nullptr;
+    _points = nullptr;
+    _num_points = 0;
+}
+
+/*
+  returns true if P is outside the polygon. Only edges which cross the
+  horizontal line through P affect the result so boxes entirely above
+  or below it are skipped.  The closing edge of a complete polygon has
+  no length so never crosses the line, giving the same result as
+  Polygon_outside()
+ */
+template <typename T>
+bool PolygonEdgeBoxes<T>::outside(const Vector2<T> &P) const
+{
+    if (_boxes == nullptr) {
+        return Polygon_outside(P, _points, _num_points);
+    }
+    if ((_bounds.min.y > P.y) || (_bounds.max.y <= P.y)) {
+        return true;
+    }
+
+    bool outside = true;
+    for (uint32_t first = 0; first < _num_points; first += POLYGON_EDGE_BOX_EDGES) {
+        const Box &box = _boxes[first / POLYGON_EDGE_BOX_EDGES];
+        if ((box.min.y > P.y) || (box.max.y <= P.y)) {
+            continue;
+        }
+        const uint32_t last = MIN(first + POLYGON_EDGE_BOX_EDGES, _num_points);
+        for (uint32_t i = first; i < last; i++) {
+            const uint16_t j = (i + 1 < _num_points) ? i + 1 : 0;
+            if (Polygon_edge_crossing(P, _points[i], _points[j])) {
+                outside = !outside;
+            }
+        }
+    }
+    return outside;
+}
+
+// returns true if P is within dist of box
+template <typename T>
+bool PolygonEdgeBoxes<T>::box_near(const Box &box, const Vector2<T> &P, T dist)
+{
+    return (P.x >= box.min.x - dist) && (P.x <= box.max.x + dist) &&
+           (P.y >= box.min.y - dist) && (P.y <= box.max.y + dist);
+}
+
+// returns the index of the first edge from index start onwards which
+// may come within dist of P or the number of edges if there are none
+template <typename T>
+uint16_t PolygonEdgeBoxes<T>::next_edge_near(const Vector2<T> &P, T dist, uint16_t start) const
+{
+    if (start >= _num_points) {
+        return _num_points;
+    }
+    if (_boxes == nullptr) {
+        return start;
+    }
+    if (!box_near(_bounds, P, dist)) {
+        return _num_points;
+    }
+    for (uint32_t i = start; i < _num_points; i = (i / POLYGON_EDGE_BOX_EDGES + 1) * POLYGON_EDGE_BOX_EDGES) {
+        if (box_near(_boxes[i / POLYGON_EDGE_BOX_EDGES], P, dist)) {
+            return i;
+        }
+    }
+    return _num_points;
+}
+
 // Necessary to avoid linker errors
 template bool Polygon_outside<int32_t>(const Vector2l &P, const Vector2l *V, unsigned n);
 template bool Polygon_complete<int32_t>(const Vector2l *V, unsigned n);
 template bool Polygon_outside<float>(const Vector2f &P, const Vector2f *V, unsigned n);
 template bool Polygon_complete<float>(const Vector2f *V, unsigned n);
+template class PolygonEdgeBoxes<int32_t>;
+template class PolygonEdgeBoxes<float>;
 
 
 /*
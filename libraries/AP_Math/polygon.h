@@ -44,3 +44,48 @@ float Polygon_closest_distance_line(const Vector2f *V, unsigned N, const Vector2
   closed polygon V, defined by N points
  */
 float Polygon_closest_distance_point(const Vector2f *V, unsigned N, const Vector2f &p);
+
+/*
+  bounding boxes of runs of consecutive edges of a polygon, built once
+  when the polygon is loaded so that point in polygon and nearest edge
+  queries on polygons with many points only look closely at the edges
+  near the query point. Edges are still visited in order. Edge i runs
+  from V[i] to V[i+1], the last edge runs back to V[0]
+ */
+template <typename T>
+class PolygonEdgeBoxes {
+public:
+    PolygonEdgeBoxes() {}
+    ~PolygonEdgeBoxes() { clear(); }
+
+    CLASS_NO_COPY(PolygonEdgeBoxes);
+
+    // build boxes for polygon V of n points, which must not change or
+    // be freed while the boxes are in use. If memory cannot be
+    // allocated the queries check every edge
+    void init(const Vector2<T> *V, uint16_t n);
+
+    // free memory and forget the polygon
+    void clear();
+
+    // returns true if P is outside the polygon, the same as Polygon_outside()
+    bool outside(const Vector2<T> &P) const WARN_IF_UNUSED;
+
+    // returns the index of the first edge from index start onwards which
+    // may come within dist of P or the number of edges if there are none
+    uint16_t next_edge_near(const Vector2<T> &P, T dist, uint16_t start) const WARN_IF_UNUSED;
+
+private:
+    struct Box {
+        Vector2<T> min;
+        Vector2<T> max;
+    };
+
+    // returns true if P is within dist of box
+    static bool box_near(const Box &box, const Vector2<T> &P, T dist);
+
+    const Vector2<T> *_points = nullptr;    // polygon points
+    uint16_t _num_points = 0;               // number of points and edges
+    Box _bounds;                            // box around the whole polygon
+    Box *_boxes = nullptr;                  // box around each run of edges
+};
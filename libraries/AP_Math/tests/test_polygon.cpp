@@ -1,4 +1,5 @@
 #include <AP_gtest.h>
+#include <AP_gtest_random.h>
 #include <AP_Common/AP_Common.h>
 
 #include <AP_Math/AP_Math.h>
@@ -356,6 +357,68 @@ TEST(Polygon, simple)
     TEST_POLYGON_POINTS(SIMPLE_boundary, SIMPLE_test_points);
 }
 
+TEST(Polygon, edge_boxes_outside)
+{
+    Vector2f points[201];
+    Vector2l points_int[201];
+    for (uint8_t closed = 0; closed < 2; closed++) {
+        for (uint16_t num_points : { 3, 16, 17, 200 }) {
+            const uint16_t n = make_star_polygon(points, num_points, Vector2f(), 3000, 10000, closed);
+            for (uint16_t i = 0; i < n; i++) {
+                points_int[i] = Vector2l(points[i].x, points[i].y);
+            }
+            PolygonEdgeBoxes<float> boxes;
+            boxes.init(points, n);
+            PolygonEdgeBoxes<int32_t> boxes_int;
+            boxes_int.init(points_int, n);
+            for (uint16_t k = 0; k < 2000; k++) {
+                const Vector2f P(test_rand(12000), test_rand(12000));
+                EXPECT_EQ(boxes.outside(P), Polygon_outside(P, points, n));
+                const Vector2l P_int(P.x, P.y);
+                EXPECT_EQ(boxes_int.outside(P_int), Polygon_outside(P_int, points_int, n));
+            }
+            // the polygon points themselves
+            for (uint16_t i = 0; i < n; i++) {
+                EXPECT_EQ(boxes.outside(points[i]), Polygon_outside(points[i], points, n));
+            }
+        }
+    }
+}
+
+TEST(Polygon, edge_boxes_next_edge_near)
+{
+    Vector2f points[200];
+    const uint16_t n = make_star_polygon(points, 200, Vector2f(), 3000, 10000, false);
+    PolygonEdgeBoxes<float> boxes;
+    boxes.init(points, n);
+    for (uint16_t k = 0; k < 500; k++) {
+        const Vector2f P(test_rand(12000), test_rand(12000));
+        const float dist = fabsf(test_rand(3000));
+        // every edge within dist must be visited
+        uint16_t visited = 0;
+        for (uint16_t i = 0; i < n; i++) {
+            const uint16_t next = boxes.next_edge_near(P, dist, i);
+            EXPECT_GE(next, i);
+            for (uint16_t j = i; (j < next) && (j < n); j++) {
+                const Vector2f &start = points[j];
+                const Vector2f &end = points[(j + 1 < n) ? j + 1 : 0];
+                EXPECT_GT((Vector2f::closest_point(P, start, end) - P).length_squared(), sq(dist));
+            }
+            if (next >= n) {
+                break;
+            }
+            visited++;
+            i = next;
+        }
+        EXPECT_LE(visited, n);
+    }
+
+    // an empty polygon has no edges
+    PolygonEdgeBoxes<float> empty;
+    EXPECT_EQ(empty.next_edge_near(Vector2f(), 1.0f, 0), 0);
+    EXPECT_TRUE(empty.outside(Vector2f()));
+}
+
 AP_GTEST_MAIN()
 
 
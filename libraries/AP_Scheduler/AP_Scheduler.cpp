@@ -63,7 +63,7 @@ const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
     // @Param: OPTIONS
     // @DisplayName: Scheduling options
     // @Description: This controls optional aspects of the scheduler.
-    // @Bitmask: 0:Enable per-task perf info
+    // @Bitmask: 0:Enable per-task perf info, 1:Enable per-task thread CPU time profiling (SITL only), 2:Run thread safe tasks on worker threads (Linux only)
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  2, AP_Scheduler, _options, 0),
 
@@ -120,6 +120,26 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks, uint
    _last_run = new uint16_t[_num_tasks];
     _tick_counter = 0;
 
+    // merge the task lists in priority order. In case of a tie the
+    // vehicle-specific entry wins
+    _task_order = new const Task *[_num_tasks];
+    uint8_t vehicle_tasks_offset = 0;
+    uint8_t common_tasks_offset = 0;
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        if (common_tasks_offset >= _num_common_tasks ||
+            (vehicle_tasks_offset < _num_vehicle_tasks &&
+             _vehicle_tasks[vehicle_tasks_offset].priority <= _common_tasks[common_tasks_offset].priority)) {
+            _task_order[i] = &_vehicle_tasks[vehicle_tasks_offset++];
+        } else {
+            _task_order[i] = &_common_tasks[common_tasks_offset++];
+        }
+    }
+
+    _interval_ticks = new uint16_t[_num_tasks];
+    _queue = new uint8_t[_num_tasks];
+    _due_mask = new uint32_t[(_num_tasks+31)/32];
+    rebuild_task_queue();
+
     // setup initial performance counters
     perf_info.set_loop_rate(get_loop_rate_hz());
     perf_info.reset();
@@ -128,6 +148,13 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks, uint
         perf_info.allocate_task_info(_num_tasks);
     }
 
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+    update_cpu_profile();
+#endif
+#if AP_SCHEDULER_OFFLOAD_ENABLED
+    update_offload();
+#endif
+
     _log_performance_bit = log_performance_bit;
 
     // sanity check the task lists to ensure the priorities are
@@ -156,6 +183,99 @@ void AP_Scheduler::tick(void)
     _tick_counter++;
 }
 
+/*
+  calculate the interval of each task in ticks and put each task
+  either in the due mask or the queue
+ */
+void AP_Scheduler::rebuild_task_queue(void)
+{
+    _queue_loop_rate_hz = _loop_rate_hz;
+    _queue_len = 0;
+    memset(_due_mask, 0, ((_num_tasks+31)/32) * sizeof(uint32_t));
+
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        const Task &task = *_task_order[i];
+        if (task.priority <= MAX_FAST_TASK_PRIORITIES) {
+            _interval_ticks[i] = 1;
+            _due_mask[i/32] |= 1U<<(i%32);
+            continue;
+        }
+        // we allow 0 to mean loop rate
+        uint32_t interval_ticks = (is_zero(task.rate_hz) ? 1 : _loop_rate_hz / task.rate_hz);
+        _interval_ticks[i] = constrain_uint32(interval_ticks, 1, INT16_MAX);
+        if (uint16_t(_tick_counter - _last_run[i]) >= _interval_ticks[i]) {
+            _due_mask[i/32] |= 1U<<(i%32);
+        } else {
+            queue_push(i);
+        }
+    }
+}
+
+// add a waiting task to the queue
+void AP_Scheduler::queue_push(uint8_t i)
+{
+    uint8_t pos = _queue_len++;
+    while (pos > 0) {
+        const uint8_t parent = (pos-1)/2;
+        if (!due_before(i, _queue[parent])) {
+            break;
+        }
+        _queue[pos] = _queue[parent];
+        pos = parent;
+    }
+    _queue[pos] = i;
+}
+
+// remove the first task due from the queue
+void AP_Scheduler::queue_pop(void)
+{
+    const uint8_t last = _queue[--_queue_len];
+    uint8_t pos = 0;
+    while (true) {
+        uint8_t child = 2*pos + 1;
+        if (child >= _queue_len) {
+            break;
+        }
+        if (child+1 < _queue_len && due_before(_queue[child+1], _queue[child])) {
+            child++;
+        }
+        if (!due_before(_queue[child], last)) {
+            break;
+        }
+        _queue[pos] = _queue[child];
+        pos = child;
+    }
+    _queue[pos] = last;
+}
+
+// return the first due task from index from, or _num_tasks if none
+uint8_t AP_Scheduler::next_due_task(uint16_t from) const
+{
+    while (from < _num_tasks) {
+        const uint32_t due = _due_mask[from/32] >> (from%32);
+        if (due != 0) {
+            return from + __builtin_ctz(due);
+        }
+        from = (from/32 + 1) * 32;
+    }
+    return _num_tasks;
+}
+
+void AP_Scheduler::update_due_tasks(void)
+{
+    if (_queue_loop_rate_hz != _loop_rate_hz) {
+        // the intervals depend on the loop rate
+        rebuild_task_queue();
+        return;
+    }
+    while (_queue_len > 0 &&
+           int16_t(_tick_counter - next_due_tick(_queue[0])) >= 0) {
+        const uint8_t i = _queue[0];
+        queue_pop();
+        _due_mask[i/32] |= 1U<<(i%32);
+    }
+}
+
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
 /*
   fill stack with NaN so we can catch use of uninitialised stack
@@ -177,52 +297,25 @@ void AP_Scheduler::run(uint32_t time_available)
     uint32_t run_started_usec = AP_HAL::micros();
     uint32_t now = run_started_usec;
 
-    uint8_t vehicle_tasks_offset = 0;
-    uint8_t common_tasks_offset = 0;
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+    AP::CPUProfile &cpu_profile = AP::cpu_profile();
+    uint64_t fast_loop_ns = 0;
+#endif
 
-    for (uint8_t i=0; i<_num_tasks; i++) {
-        // determine which of the common task / vehicle task to run
-        bool run_vehicle_task = false;
-        if (vehicle_tasks_offset < _num_vehicle_tasks &&
-            common_tasks_offset < _num_common_tasks) {
-            // still have entries on both lists; compare the
-            // priorities.  In case of a tie the vehicle-specific
-            // entry wins.
-            const Task &vehicle_task = _vehicle_tasks[vehicle_tasks_offset];
-            const Task &common_task = _common_tasks[common_tasks_offset];
-            if (vehicle_task.priority <= common_task.priority) {
-                run_vehicle_task = true;
-            }
-        } else if (vehicle_tasks_offset < _num_vehicle_tasks) {
-            // out of common tasks to run
-            run_vehicle_task = true;
-        } else if (common_tasks_offset < _num_common_tasks) {
-            // out of vehicle tasks to run
-            run_vehicle_task = false;
-        } else {
-            // this is an error; the outside loop should have terminated
-            INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
-            break;
-        }
+#if AP_SCHEDULER_OFFLOAD_ENABLED
+    collect_offloaded_tasks();
+    const bool offload = _offload != nullptr && (_options & uint8_t(Options::OFFLOAD_TASKS));
+#endif
 
-        const AP_Scheduler::Task &task = run_vehicle_task ? _vehicle_tasks[vehicle_tasks_offset] : _common_tasks[common_tasks_offset];
-        if (run_vehicle_task) {
-            vehicle_tasks_offset++;
-        } else {
-            common_tasks_offset++;
-        }
+    update_due_tasks();
+
+    // visit the due tasks in priority order
+    for (uint8_t i = next_due_task(0); i < _num_tasks; i = next_due_task(i+1)) {
+        const AP_Scheduler::Task &task = *_task_order[i];
 
         if (task.priority > MAX_FAST_TASK_PRIORITIES) {
             const uint16_t dt = _tick_counter - _last_run[i];
-            // we allow 0 to mean loop rate
-            uint32_t interval_ticks = (is_zero(task.rate_hz) ? 1 : _loop_rate_hz / task.rate_hz);
-            if (interval_ticks < 1) {
-                interval_ticks = 1;
-            }
-            if (dt < interval_ticks) {
-                // this task is not yet scheduled to run again
-                continue;
-            }
+            const uint32_t interval_ticks = _interval_ticks[i];
             // this task is due to run. Do we have enough time to run it?
             _task_time_allowed = task.max_time_micros;
 
@@ -236,6 +329,23 @@ void AP_Scheduler::run(uint32_t time_available)
                 task_not_achieved++;
             }
 
+#if AP_SCHEDULER_OFFLOAD_ENABLED
+            if (offload && (task.flags & TASK_FLAG_OFFLOAD)) {
+                if (_offload->running(i)) {
+                    // still running from last time, so stays due
+                    continue;
+                }
+                if (_offload->dispatch(i, task.function)) {
+                    // the main thread time is not used
+                    _last_run[i] = _tick_counter;
+                    _due_mask[i/32] &= ~(1U<<(i%32));
+                    queue_push(i);
+                    continue;
+                }
+                // all workers are busy, run it here
+            }
+#endif
+
             if (_task_time_allowed > time_available) {
                 // not enough time to run this task.  Continue loop -
                 // maybe another task will fit into time remaining
@@ -250,13 +360,26 @@ void AP_Scheduler::run(uint32_t time_available)
         hal.util->persistent_data.scheduler_task = i;
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
         fill_nanf_stack();
+#endif
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+        const uint64_t cpu_start_ns = cpu_profile.start();
 #endif
         task.function();
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+        const uint64_t cpu_ns = cpu_profile.task_done(i, task.name, cpu_start_ns);
+        if (task.priority <= MAX_FAST_TASK_PRIORITIES) {
+            fast_loop_ns += cpu_ns;
+        }
+#endif
         hal.util->persistent_data.scheduler_task = -1;
 
         // record the tick counter when we ran. This drives
         // when we next run the event
         _last_run[i] = _tick_counter;
+        if (task.priority > MAX_FAST_TASK_PRIORITIES) {
+            _due_mask[i/32] &= ~(1U<<(i%32));
+            queue_push(i);
+        }
 
         // work out how long the event actually took
         now = AP_HAL::micros();
@@ -281,6 +404,12 @@ void AP_Scheduler::run(uint32_t time_available)
         time_available -= time_taken;
     }
 
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+    if (fast_loop_ns > 0) {
+        cpu_profile.fast_loop_done(fast_loop_ns);
+    }
+#endif
+
     // update number of spare microseconds
     _spare_micros += time_available;
 
@@ -325,6 +454,10 @@ void AP_Scheduler::loop()
     _rsem.take_blocking();
     hal.util->persistent_data.scheduler_task = -1;
 
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+    const uint64_t cpu_start_ns = AP::cpu_profile().start();
+#endif
+
     const uint32_t sample_time_us = AP_HAL::micros();
     
     if (_loop_timer_start_us == 0) {
@@ -395,6 +528,10 @@ void AP_Scheduler::loop()
         
     _loop_timer_start_us = sample_time_us;
 
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+    AP::cpu_profile().loop_done(cpu_start_ns);
+#endif
+
 #if AP_SIM_ENABLED && CONFIG_HAL_BOARD != HAL_BOARD_SITL
     hal.simstate->update();
 #endif
@@ -417,8 +554,67 @@ void AP_Scheduler::update_logging()
     } else if ((_options & uint8_t(Options::RECORD_TASK_INFO)) && !perf_info.has_task_info()) {
         perf_info.allocate_task_info(_num_tasks);
     }
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+    update_cpu_profile();
+#endif
+#if AP_SCHEDULER_OFFLOAD_ENABLED
+    update_offload();
+#endif
+}
+
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+/*
+  CPU profiling can be turned on and off at runtime. The histograms
+  are kept when it is turned off so they are still reported at exit
+ */
+void AP_Scheduler::update_cpu_profile()
+{
+    AP::CPUProfile &cpu_profile = AP::cpu_profile();
+    const bool want = (_options & uint8_t(Options::CPU_PROFILE)) != 0;
+    if (want && !cpu_profile.enabled()) {
+        cpu_profile.enable(_num_tasks);
+    } else if (!want && cpu_profile.enabled()) {
+        cpu_profile.disable();
+    }
+}
+#endif
+
+#if AP_SCHEDULER_OFFLOAD_ENABLED
+/*
+  the worker threads are started the first time offloading is
+  enabled. They are kept when it is disabled, with no tasks given to them
+ */
+void AP_Scheduler::update_offload()
+{
+    if (_offload != nullptr || _offload_failed || !(_options & uint8_t(Options::OFFLOAD_TASKS))) {
+        return;
+    }
+    _offload = new AP::TaskOffload();
+    if (_offload == nullptr) {
+        return;
+    }
+    if (!_offload->init()) {
+        DEV_PRINTF("Unable to start scheduler worker threads\n");
+        delete _offload;
+        _offload = nullptr;
+        // don't try again, tasks stay on the main thread
+        _offload_failed = true;
+    }
 }
 
+void AP_Scheduler::collect_offloaded_tasks()
+{
+    if (_offload == nullptr) {
+        return;
+    }
+    uint8_t i;
+    uint32_t time_taken;
+    while (_offload->collect(i, time_taken)) {
+        perf_info.update_task_info(i, time_taken, time_taken > _task_order[i]->max_time_micros);
+    }
+}
+#endif
+
 // Write a performance monitoring packet
 void AP_Scheduler::Log_Write_Performance()
 {
@@ -444,6 +640,18 @@ void AP_Scheduler::Log_Write_Performance()
 
 // display task statistics as text buffer for @SYS/tasks.txt
 void AP_Scheduler::task_info(ExpandingString &str)
+{
+    perf_task_info(str);
+
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+    // thread CPU time histograms follow the PerfInfo statistics
+    if (_options & uint8_t(Options::CPU_PROFILE)) {
+        AP::cpu_profile().print(str);
+    }
+#endif
+}
+
+void AP_Scheduler::perf_task_info(ExpandingString &str)
 {
     // a header to allow for machine parsers to determine format
     str.printf("TasksV2\n");
@@ -467,42 +675,9 @@ void AP_Scheduler::task_info(ExpandingString &str)
         }
     }
 
-    uint8_t vehicle_tasks_offset = 0;
-    uint8_t common_tasks_offset = 0;
-
     for (uint8_t i = 0; i < _num_tasks; i++) {
         const AP::PerfInfo::TaskInfo* ti = perf_info.get_task_info(i);
-        const char *task_name;
-
-        // determine which of the common task / vehicle task to run
-        bool run_vehicle_task = false;
-        if (vehicle_tasks_offset < _num_vehicle_tasks &&
-            common_tasks_offset < _num_common_tasks) {
-            // still have entries on both lists; compare the
-            // priorities.  In case of a tie the vehicle-specific
-            // entry wins.
-            const Task &vehicle_task = _vehicle_tasks[vehicle_tasks_offset];
-            const Task &common_task = _common_tasks[common_tasks_offset];
-            if (vehicle_task.priority <= common_task.priority) {
-                run_vehicle_task = true;
-            }
-        } else if (vehicle_tasks_offset < _num_vehicle_tasks) {
-            // out of common tasks to run
-            run_vehicle_task = true;
-        } else if (common_tasks_offset < _num_common_tasks) {
-            // out of vehicle tasks to run
-            run_vehicle_task = false;
-        } else {
-            // this is an error; the outside loop should have terminated
-            INTERNAL_ERROR(AP_InternalError::error_t::flow_of_control);
-            return;
-        }
-
-        if (run_vehicle_task) {
-            task_name = _vehicle_tasks[vehicle_tasks_offset++].name;
-        } else {
-            task_name = _common_tasks[common_tasks_offset++].name;
-        }
+        const char *task_name = _task_order[i]->name;
 
         ti->print(task_name, total_time, str);
     }
@@ -31,6 +31,8 @@
 #include <AP_HAL/Util.h>
 #include <AP_Math/AP_Math.h>
 #include "PerfInfo.h"       // loop perf monitoring
+#include "CPUProfile.h"     // thread CPU time profiling
+#include "TaskOffload.h"    // worker threads for offloaded tasks
 
 #if HAL_MINIMIZE_FEATURES
 #define AP_SCHEDULER_NAME_INITIALIZER(_clazz,_name) .name = #_name,
@@ -52,6 +54,19 @@
     .priority = _priority \
 }
 
+/*
+  as SCHED_TASK_CLASS, for a task which is thread safe and may be run
+  on a worker thread when the OFFLOAD_TASKS option is set
+ */
+#define SCHED_TASK_CLASS_OFFLOAD(classname, classptr, func, _rate_hz, _max_time_micros, _priority) { \
+    .function = FUNCTOR_BIND(classptr, &classname::func, void),\
+    AP_SCHEDULER_NAME_INITIALIZER(classname, func)\
+    .rate_hz = _rate_hz,\
+    .max_time_micros = _max_time_micros,        \
+    .priority = _priority, \
+    .flags = AP_Scheduler::TASK_FLAG_OFFLOAD \
+}
+
 /*
   useful macro for creating the fastloop task table
  */
@@ -93,10 +108,17 @@ public:
         float rate_hz;
         uint16_t max_time_micros;
         uint8_t priority; // task priority
+        uint8_t flags; // TaskFlags
+    };
+
+    enum TaskFlags {
+        TASK_FLAG_OFFLOAD = 1 << 0,
     };
 
     enum class Options : uint8_t {
-        RECORD_TASK_INFO = 1 << 0
+        RECORD_TASK_INFO = 1 << 0,
+        CPU_PROFILE = 1 << 1,
+        OFFLOAD_TASKS = 1 << 2,
     };
 
     enum FastTaskPriorities {
@@ -223,6 +245,41 @@ private:
     // tick counter at the time we last ran each task
     uint16_t *_last_run;
 
+    // tasks of both lists merged in priority order, indexed as for
+    // _last_run
+    const struct Task **_task_order;
+
+    /*
+      run() only visits tasks which are due. Tasks which have run wait
+      in a binary heap ordered by the tick they are next due, and are
+      moved to _due_mask when that tick arrives. Fast tasks are always
+      in _due_mask. A due task which is not run stays in _due_mask
+     */
+    uint16_t *_interval_ticks;
+    uint8_t *_queue;
+    uint8_t _queue_len;
+    uint32_t *_due_mask;
+
+    // loop rate used for _interval_ticks
+    int16_t _queue_loop_rate_hz;
+
+    // tick at which a waiting task is next due
+    uint16_t next_due_tick(uint8_t i) const {
+        return _last_run[i] + _interval_ticks[i];
+    }
+    // true if waiting task a is due before waiting task b
+    bool due_before(uint8_t a, uint8_t b) const {
+        return int16_t(next_due_tick(a) - next_due_tick(b)) < 0;
+    }
+    void queue_push(uint8_t i);
+    void queue_pop(void);
+    // calculate task intervals and rebuild the queue
+    void rebuild_task_queue(void);
+    // move tasks which are now due from the queue to _due_mask
+    void update_due_tasks(void);
+    // return the first due task from index from, or _num_tasks if none
+    uint8_t next_due_task(uint16_t from) const;
+
     // number of microseconds allowed for the current task
     uint32_t _task_time_allowed;
 
@@ -258,6 +315,24 @@ private:
     uint32_t extra_loop_us;
 
 
+    // display PerfInfo task statistics, as part of task_info()
+    void perf_task_info(ExpandingString &str);
+
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+    // enable or disable CPU profiling based on options
+    void update_cpu_profile();
+#endif
+
+#if AP_SCHEDULER_OFFLOAD_ENABLED
+    // start the worker threads if offloading is enabled in options
+    void update_offload();
+    // record the time taken by offloaded tasks which have finished
+    void collect_offloaded_tasks();
+    AP::TaskOffload *_offload;
+    // the worker threads could not be started
+    bool _offload_failed;
+#endif
+
     // semaphore that is held while not waiting for ins samples
     HAL_Semaphore _rsem;
 };
@@ -0,0 +1,269 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  thread CPU time profiling of scheduler tasks and HAL callbacks
+ */
+#include "CPUProfile.h"
+
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+extern const AP_HAL::HAL& hal;
+
+static AP::CPUProfile _cpu_profile;
+
+namespace AP {
+
+CPUProfile &cpu_profile()
+{
+    return _cpu_profile;
+}
+
+};
+
+/*
+  map a time to its bucket. Values below 4ns get their own buckets,
+  above that each power of two is split into 4
+ */
+uint8_t AP::CPUProfile::Histogram::bucket_index(uint32_t ns)
+{
+    if (ns < (1U<<sub_bits)) {
+        return ns;
+    }
+    const uint8_t msb = 31 - __builtin_clz(ns);
+    const uint8_t sub = (ns >> (msb - sub_bits)) & ((1U<<sub_bits)-1);
+    return ((msb - sub_bits + 1) << sub_bits) + sub;
+}
+
+/*
+  return the largest value which maps to a bucket
+ */
+uint32_t AP::CPUProfile::Histogram::bucket_upper(uint8_t idx)
+{
+    if (idx < (1U<<sub_bits)) {
+        return idx;
+    }
+    const uint8_t msb = (idx >> sub_bits) + sub_bits - 1;
+    const uint32_t sub = idx & ((1U<<sub_bits)-1);
+    const uint64_t lower = uint64_t((1U<<sub_bits) + sub) << (msb - sub_bits);
+    const uint64_t width = 1ULL << (msb - sub_bits);
+    return MIN(lower + width - 1, UINT32_MAX);
+}
+
+void AP::CPUProfile::Histogram::add(uint32_t ns)
+{
+    if (count == 0 || ns < min_ns) {
+        min_ns = ns;
+    }
+    max_ns = MAX(max_ns, ns);
+    total_ns += ns;
+    count++;
+    bucket[bucket_index(ns)]++;
+}
+
+uint32_t AP::CPUProfile::Histogram::percentile(float pct) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    const uint32_t target = MAX(1U, uint32_t(ceilf(count * pct * 0.01f)));
+    uint32_t sum = 0;
+    for (uint8_t i=0; i<num_buckets; i++) {
+        sum += bucket[i];
+        if (sum >= target) {
+            return MIN(bucket_upper(i), max_ns);
+        }
+    }
+    return max_ns;
+}
+
+void AP::CPUProfile::Histogram::print(const char *name, uint64_t grand_total_ns, ExpandingString &str) const
+{
+    if (count == 0) {
+        return;
+    }
+    const float pct = grand_total_ns > 0 ? total_ns * 100.0f / grand_total_ns : 0.0f;
+    str.printf("%-32.32s N=%8lu MIN=%7.1f P50=%7.1f P90=%7.1f P99=%7.1f MAX=%8.1f AVG=%7.1f TOT=%5.1f%%\n",
+               name, (unsigned long)count,
+               min_ns*1.0e-3f,
+               percentile(50)*1.0e-3f,
+               percentile(90)*1.0e-3f,
+               percentile(99)*1.0e-3f,
+               max_ns*1.0e-3f,
+               (total_ns / count)*1.0e-3f,
+               pct);
+}
+
+uint64_t AP::CPUProfile::thread_ns()
+{
+    return clock_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+/*
+  return the time of a clock in nanoseconds, or zero if it cannot be
+  read, such as when its thread has exited
+ */
+uint64_t AP::CPUProfile::clock_ns(clockid_t clock)
+{
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+    return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+void AP::CPUProfile::enable(uint8_t num_tasks)
+{
+    if (_tasks == nullptr && num_tasks > 0) {
+        _tasks = new TaskSlot[num_tasks];
+        if (_tasks == nullptr) {
+            DEV_PRINTF("Unable to allocate CPU profile\n");
+            return;
+        }
+        _num_tasks = num_tasks;
+    }
+    if (!_exit_registered) {
+        _exit_registered = true;
+        if (pthread_getcpuclockid(pthread_self(), &_main_clock) != 0) {
+            _main_clock = CLOCK_THREAD_CPUTIME_ID;
+        }
+        _enable_ns = clock_ns(_main_clock);
+        atexit(exit_handler);
+    }
+    _enabled = true;
+}
+
+uint64_t AP::CPUProfile::start() const
+{
+    if (!_enabled) {
+        return 0;
+    }
+    return thread_ns();
+}
+
+uint64_t AP::CPUProfile::record(Histogram &hist, uint64_t start_ns)
+{
+    // a zero start means profiling was enabled part way through
+    if (!_enabled || start_ns == 0) {
+        return 0;
+    }
+    const uint64_t elapsed_ns = thread_ns() - start_ns;
+    hist.add(MIN(elapsed_ns, UINT32_MAX));
+    return elapsed_ns;
+}
+
+uint64_t AP::CPUProfile::task_done(uint8_t task_index, const char *name, uint64_t start_ns)
+{
+    if (_tasks == nullptr || task_index >= _num_tasks) {
+        return 0;
+    }
+    _tasks[task_index].name = name;
+    return record(_tasks[task_index].hist, start_ns);
+}
+
+void AP::CPUProfile::timer_done(uint8_t proc_index, uint64_t start_ns)
+{
+    if (proc_index < ARRAY_SIZE(_timer)) {
+        record(_timer[proc_index], start_ns);
+    }
+}
+
+void AP::CPUProfile::io_done(uint8_t proc_index, uint64_t start_ns)
+{
+    if (proc_index < ARRAY_SIZE(_io)) {
+        record(_io[proc_index], start_ns);
+    }
+}
+
+void AP::CPUProfile::hal_io_done(uint64_t start_ns)
+{
+    record(_hal_io, start_ns);
+}
+
+void AP::CPUProfile::loop_done(uint64_t start_ns)
+{
+    record(_loop, start_ns);
+}
+
+void AP::CPUProfile::fast_loop_done(uint64_t elapsed_ns)
+{
+    if (_enabled) {
+        _fast_loop.add(MIN(elapsed_ns, UINT32_MAX));
+    }
+}
+
+/*
+  report all histograms. Times are in microseconds of thread CPU time
+  and TOT is the share of the main thread CPU time since profiling
+  started. Timer and IO callbacks run inside the loop in SITL, so the
+  shares overlap
+ */
+void AP::CPUProfile::print(ExpandingString &str) const
+{
+    str.printf("CPUV1\n");
+
+    // read the main thread's clock, as this may be called from the
+    // thread serving the report
+    const uint64_t now_ns = clock_ns(_main_clock);
+    const uint64_t total = now_ns > _enable_ns ? now_ns - _enable_ns : 0;
+    _loop.print("loop", total, str);
+    _fast_loop.print("fast loop", total, str);
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        const TaskSlot &t = _tasks[i];
+        t.hist.print(t.name != nullptr ? t.name : "task", total, str);
+    }
+
+    char name[16];
+    for (uint8_t i=0; i<ARRAY_SIZE(_timer); i++) {
+        hal.util->snprintf(name, sizeof(name), "timer[%u]", unsigned(i));
+        _timer[i].print(name, total, str);
+    }
+    for (uint8_t i=0; i<ARRAY_SIZE(_io); i++) {
+        hal.util->snprintf(name, sizeof(name), "io[%u]", unsigned(i));
+        _io[i].print(name, total, str);
+    }
+    _hal_io.print("io[hal]", total, str);
+}
+
+void AP::CPUProfile::dump(const char *filename) const
+{
+    ExpandingString *str = new ExpandingString();
+    if (str == nullptr) {
+        return;
+    }
+    print(*str);
+    if (!str->has_failed_allocation()) {
+        FILE *f = fopen(filename, "w");
+        if (f != nullptr) {
+            fwrite(str->get_string(), 1, str->get_length(), f);
+            fclose(f);
+            ::fprintf(stderr, "Wrote CPU profile to %s\n", filename);
+        }
+    }
+    delete str;
+}
+
+void AP::CPUProfile::exit_handler()
+{
+    _cpu_profile.dump("cpu_profile.txt");
+}
+
+#endif  // AP_SCHEDULER_CPU_PROFILE_ENABLED
@@ -0,0 +1,139 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  thread CPU time profiling of scheduler tasks and HAL callbacks.
+
+  PerfInfo measures with AP_HAL::micros(), which in SITL is simulated
+  time and says nothing about real CPU cost when running with a
+  speedup. This records the CPU time of the calling thread instead,
+  into log-linear histograms, so the cost of each task can be compared
+  against the budget of a slower board.
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL_Boards.h>
+
+#ifndef AP_SCHEDULER_CPU_PROFILE_ENABLED
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && !defined(HAL_BUILD_AP_PERIPH)
+#define AP_SCHEDULER_CPU_PROFILE_ENABLED 1
+#else
+#define AP_SCHEDULER_CPU_PROFILE_ENABLED 0
+#endif
+#endif
+
+#if AP_SCHEDULER_CPU_PROFILE_ENABLED
+
+#include <stdint.h>
+#include <time.h>
+#include <AP_Common/ExpandingString.h>
+
+// maximum number of HAL timer or IO callbacks tracked
+#define AP_CPU_PROFILE_MAX_PROCS 8
+
+namespace AP {
+
+class CPUProfile {
+public:
+    CPUProfile() {}
+
+    /* Do not allow copies */
+    CLASS_NO_COPY(CPUProfile);
+
+    /*
+      histogram of CPU times in nanoseconds. Buckets are a power of two
+      wide split into 4 linear sub-buckets, so any percentile is within
+      25% of the true value
+     */
+    struct Histogram {
+        static const uint8_t sub_bits = 2;
+        static const uint8_t num_buckets = (32 - sub_bits + 1) << sub_bits;
+
+        uint32_t count;
+        uint32_t min_ns;
+        uint32_t max_ns;
+        uint64_t total_ns;
+        uint32_t bucket[num_buckets];
+
+        void add(uint32_t ns);
+        // return an upper bound on the given percentile (0 to 100)
+        uint32_t percentile(float pct) const;
+        void print(const char *name, uint64_t grand_total_ns, ExpandingString &str) const;
+
+        static uint8_t bucket_index(uint32_t ns);
+        static uint32_t bucket_upper(uint8_t idx);
+    };
+
+    // start recording, with histograms for num_tasks scheduler tasks
+    void enable(uint8_t num_tasks);
+    // stop recording, keeping the histograms for reporting
+    void disable() { _enabled = false; }
+    bool enabled() const { return _enabled; }
+
+    // return the current thread CPU time in nanoseconds, or zero
+    // if profiling is not enabled
+    uint64_t start() const;
+
+    // record time since a start() call. task_done() returns the
+    // recorded time so the scheduler can total the fast tasks
+    uint64_t task_done(uint8_t task_index, const char *name, uint64_t start_ns);
+    void timer_done(uint8_t proc_index, uint64_t start_ns);
+    void io_done(uint8_t proc_index, uint64_t start_ns);
+    void hal_io_done(uint64_t start_ns);
+    void loop_done(uint64_t start_ns);
+
+    // record the combined time of the fast tasks in one loop
+    void fast_loop_done(uint64_t elapsed_ns);
+
+    // append a report of all histograms to a string
+    void print(ExpandingString &str) const;
+
+    // write a report to a file, called at exit
+    void dump(const char *filename) const;
+
+private:
+    struct TaskSlot {
+        const char *name;
+        Histogram hist;
+    };
+
+    bool _enabled;
+    bool _exit_registered;
+
+    // CPU time clock of the thread which enabled profiling, normally
+    // the main thread, and its time when profiling was first enabled.
+    // Reports may be printed from other threads
+    clockid_t _main_clock;
+    uint64_t _enable_ns;
+
+    TaskSlot *_tasks;
+    uint8_t _num_tasks;
+
+    Histogram _loop;
+    Histogram _fast_loop;
+    Histogram _timer[AP_CPU_PROFILE_MAX_PROCS];
+    Histogram _io[AP_CPU_PROFILE_MAX_PROCS];
+    Histogram _hal_io;
+
+    static uint64_t thread_ns();
+    static uint64_t clock_ns(clockid_t clock);
+    uint64_t record(Histogram &hist, uint64_t start_ns);
+    static void exit_handler();
+};
+
+CPUProfile &cpu_profile();
+
+};
+
+#endif  // AP_SCHEDULER_CPU_PROFILE_ENABLED
@@ -22,6 +22,9 @@ void AP::PerfInfo::reset()
     long_running = 0;
     sigma_time = 0;
     sigmasquared_time = 0;
+    max_jitter = 0;
+    sigma_jitter = 0;
+    jitter_count = 0;
     if (_task_info != nullptr) {
         memset(_task_info, 0, (_num_tasks) * sizeof(TaskInfo));
     }
@@ -138,6 +141,14 @@ void AP::PerfInfo::check_loop_time(uint32_t time_in_micros)
     last_check_us = now;
     if (loop_time_us < overtime_threshold_micros + 10000UL) {
         filtered_loop_time = 0.99f * filtered_loop_time + 0.01f * loop_time_us * 1.0e-6f;
+
+        // jitter is how far the start of this loop was from where
+        // the loop rate says it should be
+        const uint32_t period_us = loop_rate_hz > 0 ? 1000000UL / loop_rate_hz : loop_time_us;
+        const uint32_t jitter = loop_time_us > period_us ? loop_time_us - period_us : period_us - loop_time_us;
+        max_jitter = MAX(max_jitter, jitter);
+        sigma_jitter += jitter;
+        jitter_count++;
     }
 }
 
@@ -183,17 +194,34 @@ float AP::PerfInfo::get_filtered_time() const
     return filtered_loop_time;
 }
 
+// get_max_jitter - return maximum deviation of loop period (in microseconds)
+uint32_t AP::PerfInfo::get_max_jitter() const
+{
+    return max_jitter;
+}
+
+// get_avg_jitter - return average deviation of loop period (in microseconds)
+uint32_t AP::PerfInfo::get_avg_jitter() const
+{
+    if (jitter_count == 0) {
+        return 0;
+    }
+    return sigma_jitter / jitter_count;
+}
+
 void AP::PerfInfo::update_logging() const
 {
     gcs().send_text(MAV_SEVERITY_INFO,
-                    "PERF: %u/%u [%lu:%lu] F=%uHz sd=%lu Ex=%lu",
+                    "PERF: %u/%u [%lu:%lu] F=%uHz sd=%lu Ex=%lu J=%lu/%lu",
                     (unsigned)get_num_long_running(),
                     (unsigned)get_num_loops(),
                     (unsigned long)get_max_time(),
                     (unsigned long)get_min_time(),
                     (unsigned)(0.5+(1.0f/get_filtered_time())),
                     (unsigned long)get_stddev_time(),
-                    (unsigned long)AP::scheduler().get_extra_loop_us());
+                    (unsigned long)AP::scheduler().get_extra_loop_us(),
+                    (unsigned long)get_avg_jitter(),
+                    (unsigned long)get_max_jitter());
 }
 
 void AP::PerfInfo::set_loop_rate(uint16_t rate_hz)
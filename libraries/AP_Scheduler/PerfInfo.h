@@ -36,6 +36,8 @@ public:
     uint32_t get_avg_time() const;
     uint32_t get_stddev_time() const;
     float    get_filtered_time() const;
+    uint32_t get_max_jitter() const;
+    uint32_t get_avg_jitter() const;
     void set_loop_rate(uint16_t rate_hz);
 
     void update_logging() const;
@@ -68,6 +70,10 @@ private:
     uint64_t sigmasquared_time;
     uint16_t long_running;
     uint32_t last_check_us;
+    // deviation of the loop start from the loop period, in microseconds
+    uint32_t max_jitter;
+    uint64_t sigma_jitter;
+    uint16_t jitter_count;
     float filtered_loop_time;
     bool ignore_loop;
     // performance monitoring
@@ -0,0 +1,107 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  worker threads for scheduler tasks run off the main thread
+ */
+#include "TaskOffload.h"
+
+#if AP_SCHEDULER_OFFLOAD_ENABLED
+
+extern const AP_HAL::HAL& hal;
+
+bool AP::TaskOffload::init(void)
+{
+    for (uint8_t i=0; i<ARRAY_SIZE(_workers); i++) {
+        Worker &w = _workers[i];
+        w.task_index = -1;
+        if (!hal.scheduler->thread_create(FUNCTOR_BIND(&w, &Worker::thread_main, void),
+                                          "sched_worker",
+                                          16384, AP_HAL::Scheduler::PRIORITY_IO, 0)) {
+            break;
+        }
+        _num_workers++;
+    }
+    return _num_workers > 0;
+}
+
+void AP::TaskOffload::Worker::thread_main(void)
+{
+    while (true) {
+        wake.wait_blocking();
+        AP_HAL::MemberProc fn;
+        {
+            WITH_SEMAPHORE(sem);
+            if (!pending) {
+                continue;
+            }
+            pending = false;
+            fn = function;
+        }
+
+        const uint32_t start_us = AP_HAL::micros();
+        fn();
+        const uint32_t elapsed_us = AP_HAL::micros() - start_us;
+
+        WITH_SEMAPHORE(sem);
+        time_taken_us = elapsed_us;
+        done = true;
+    }
+}
+
+bool AP::TaskOffload::running(uint8_t task_index)
+{
+    for (uint8_t i=0; i<_num_workers; i++) {
+        Worker &w = _workers[i];
+        WITH_SEMAPHORE(w.sem);
+        if (w.task_index == task_index) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AP::TaskOffload::dispatch(uint8_t task_index, AP_HAL::MemberProc function)
+{
+    for (uint8_t i=0; i<_num_workers; i++) {
+        Worker &w = _workers[i];
+        WITH_SEMAPHORE(w.sem);
+        if (w.task_index == -1) {
+            w.task_index = task_index;
+            w.function = function;
+            w.pending = true;
+            w.wake.signal();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AP::TaskOffload::collect(uint8_t &task_index, uint32_t &time_taken_us)
+{
+    for (uint8_t i=0; i<_num_workers; i++) {
+        Worker &w = _workers[i];
+        WITH_SEMAPHORE(w.sem);
+        if (w.done) {
+            task_index = w.task_index;
+            time_taken_us = w.time_taken_us;
+            w.done = false;
+            w.task_index = -1;
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif  // AP_SCHEDULER_OFFLOAD_ENABLED
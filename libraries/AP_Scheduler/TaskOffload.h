@@ -0,0 +1,82 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL_Boards.h>
+
+#ifndef AP_SCHEDULER_OFFLOAD_ENABLED
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define AP_SCHEDULER_OFFLOAD_ENABLED 1
+#else
+#define AP_SCHEDULER_OFFLOAD_ENABLED 0
+#endif
+#endif
+
+#if AP_SCHEDULER_OFFLOAD_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+
+#ifndef AP_SCHEDULER_OFFLOAD_THREADS
+#define AP_SCHEDULER_OFFLOAD_THREADS 3
+#endif
+
+namespace AP {
+
+/*
+  a pool of worker threads for scheduler tasks which are marked as
+  safe to run off the main thread. Each worker runs one task at a
+  time. The main thread hands a task over with dispatch() and picks up
+  how long it took with collect() once it has finished
+ */
+class TaskOffload {
+public:
+    // create the worker threads
+    bool init(void);
+
+    // true if the task is waiting for or running on a worker
+    bool running(uint8_t task_index);
+
+    // start the task on an idle worker. Returns false if all are busy
+    bool dispatch(uint8_t task_index, AP_HAL::MemberProc function);
+
+    // get a finished task and its run time. Returns false if none
+    bool collect(uint8_t &task_index, uint32_t &time_taken_us);
+
+private:
+    class Worker {
+    public:
+        void thread_main(void);
+
+        // protects the state below
+        HAL_Semaphore sem;
+        // signalled when a function is given to the worker
+        HAL_BinarySemaphore wake;
+        AP_HAL::MemberProc function;
+        // task being run, or -1 when idle
+        int16_t task_index;
+        // function is waiting to start
+        bool pending;
+        // function has finished, waiting for collect()
+        bool done;
+        uint32_t time_taken_us;
+    };
+
+    Worker _workers[AP_SCHEDULER_OFFLOAD_THREADS];
+    uint8_t _num_workers;
+};
+
+};
+
+#endif  // AP_SCHEDULER_OFFLOAD_ENABLED
@@ -0,0 +1,109 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Scheduler/AP_Scheduler.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+/*
+  time AP_Scheduler::run() with the rates, time budgets and priorities
+  of the Copter task table and tasks which do nothing
+ */
+class BenchTasks {
+public:
+    void nop() {}
+};
+
+static BenchTasks bench;
+
+#define BENCH_FAST_TASK() FAST_TASK_CLASS(BenchTasks, &bench, nop)
+#define BENCH_TASK(rate_hz, max_time_micros, prio) SCHED_TASK_CLASS(BenchTasks, &bench, nop, rate_hz, max_time_micros, prio)
+
+static const AP_Scheduler::Task copter_tasks[] = {
+    BENCH_FAST_TASK(),
+    BENCH_FAST_TASK(),
+    BENCH_FAST_TASK(),
+    BENCH_FAST_TASK(),
+    BENCH_FAST_TASK(),
+    BENCH_FAST_TASK(),
+    BENCH_FAST_TASK(),
+    BENCH_FAST_TASK(),
+    BENCH_FAST_TASK(),
+    BENCH_FAST_TASK(),
+    BENCH_TASK(100,    130,  3),
+    BENCH_TASK( 50,     75,  6),
+    BENCH_TASK( 50,    200,  9),
+    BENCH_TASK(200,    160, 12),
+    BENCH_TASK( 10,    120, 15),
+    BENCH_TASK( 10,     50, 18),
+    BENCH_TASK( 10,     50, 21),
+    BENCH_TASK( 10,     50, 24),
+    BENCH_TASK( 10,     50, 27),
+    BENCH_TASK( 10,     75, 30),
+    BENCH_TASK( 20,    100, 33),
+    BENCH_TASK(200,     50, 36),
+    BENCH_TASK(400,     50, 39),
+    BENCH_TASK( 10,    100, 42),
+    BENCH_TASK( 50,    100, 45),
+    BENCH_TASK(100,     90, 48),
+    BENCH_TASK(  3,    100, 51),
+    BENCH_TASK(  3,     90, 54),
+    BENCH_TASK(  3,     75, 57),
+    BENCH_TASK( 50,     75, 60),
+    BENCH_TASK( 50,     90, 63),
+    BENCH_TASK( 10,    100, 66),
+    BENCH_TASK(400,     50, 69),
+    BENCH_TASK( 50,     75, 72),
+    BENCH_TASK(400,     50, 75),
+    BENCH_TASK( 50,     90, 78),
+    BENCH_TASK(  1,    100, 81),
+    BENCH_TASK( 10,     75, 84),
+    BENCH_TASK( 10,     50, 87),
+    BENCH_TASK( 10,     50, 90),
+    BENCH_TASK( 10,     75, 93),
+    BENCH_TASK(100,     75, 96),
+    BENCH_TASK( 10,     50, 99),
+    BENCH_TASK(400,    180, 102),
+    BENCH_TASK(400,    550, 105),
+    BENCH_TASK( 50,     75, 108),
+    BENCH_TASK( 50,     75, 111),
+    BENCH_TASK( 10,    350, 114),
+    BENCH_TASK( 25,    110, 117),
+    BENCH_TASK(400,    300, 120),
+    BENCH_TASK(400,     50, 123),
+    BENCH_TASK(0.1,     75, 126),
+    BENCH_TASK( 40,    200, 129),
+    BENCH_TASK(100,    100, 132),
+    BENCH_TASK( 10,    100, 135),
+    BENCH_TASK( 10,    100, 138),
+    BENCH_TASK( 10,    100, 141),
+    BENCH_TASK( 10,    100, 144),
+    BENCH_TASK( 10,     75, 147),
+    BENCH_TASK( 50,     50, 150),
+    BENCH_TASK(100,     75, 153),
+    BENCH_TASK( 50,     75, 156),
+    BENCH_TASK( 10,     75, 159),
+    BENCH_TASK(3.3,     75, 162),
+    BENCH_TASK(  1,     75, 165),
+    BENCH_TASK(  5,    100, 168),
+    BENCH_TASK(  1,    100, 171),
+};
+
+static AP_Scheduler scheduler;
+
+static void BM_SchedulerRunCopter(benchmark::State& state)
+{
+    static bool initialised;
+    if (!initialised) {
+        scheduler.init(copter_tasks, ARRAY_SIZE(copter_tasks), 0);
+        initialised = true;
+    }
+
+    while (state.KeepRunning()) {
+        scheduler.tick();
+        scheduler.run(2500);
+    }
+}
+
+BENCHMARK(BM_SchedulerRunCopter);
+
+BENCHMARK_MAIN();
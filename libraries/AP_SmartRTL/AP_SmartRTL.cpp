@@ -30,8 +30,8 @@ const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
 
     // @Param: POINTS
     // @DisplayName: SmartRTL maximum number of points on path
-    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL.  100 points consumes about 3k of memory.
-    // @Range: 0 500
+    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL.  100 points consumes about 2.5k of memory.  Boards with 1MB of memory or more use up to 1.6k more per 100 points to find loops in the path quickly, and allow 1000 points rather than 500.
+    // @Range: 0 1000
     // @User: Advanced
     // @RebootRequired: True
     AP_GROUPINFO("POINTS", 1, AP_SmartRTL, _points_max, SMARTRTL_POINTS_DEFAULT),
@@ -67,6 +67,13 @@ const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
 *    2. Simplification uses the Ramer-Douglas-Peucker algorithm. See Wikipedia
 *    for a more complete description.
 *
+*    As points are added, the last point on the path is moved to the new point
+*    instead of adding one, for as long as the points passed over stay close to
+*    the line from the point before it.  This removes most points on straight
+*    runs at a small constant cost per point, so the simplification and pruning
+*    have fewer points to work on.  Pruning places the path segments in a grid
+*    so each new segment is only checked against segments close to it.
+*
 *    The simplification and pruning algorithms run in the background and do not
 *    alter the path in memory.  Two definitions, SMARTRTL_SIMPLIFY_TIME_US and
 *    SMARTRTL_PRUNING_LOOP_TIME_US are used to limit how long each algorithm will
@@ -115,6 +122,26 @@ void AP_SmartRTL::init()
     _simplify.stack_max = _points_max * SMARTRTL_SIMPLIFY_STACK_LEN_MULT;
     _simplify.stack = (simplify_start_finish_t*)calloc(_simplify.stack_max, sizeof(simplify_start_finish_t));
 
+#if AP_SMARTRTL_PRUNING_GRID_ENABLED
+    // allocate the loop finding grid with at least twice as many buckets as points.  Pruning checks every segment
+    // if this fails so we carry on without it
+    uint16_t num_buckets = 16;
+    while (num_buckets < _points_max * 2) {
+        num_buckets *= 2;
+    }
+    _prune.grid_buckets = (uint16_t*)calloc(num_buckets, sizeof(uint16_t));
+    _prune.grid_entries_max = _points_max * SMARTRTL_PRUNING_GRID_LEN_MULT;
+    _prune.grid_entries = (prune_grid_entry_t*)calloc(_prune.grid_entries_max, sizeof(prune_grid_entry_t));
+    if (_prune.grid_buckets == nullptr || _prune.grid_entries == nullptr) {
+        free(_prune.grid_buckets);
+        free(_prune.grid_entries);
+        _prune.grid_buckets = nullptr;
+        _prune.grid_entries = nullptr;
+    }
+    _prune.grid_buckets_mask = num_buckets - 1;
+    _prune.grid_cell_size = _accuracy * SMARTRTL_PRUNING_GRID_CELL_MULT;
+#endif
+
     // check if memory allocation failed
     if (_path == nullptr || _prune.loops == nullptr || _simplify.stack == nullptr) {
         log_action(SRTL_DEACTIVATED_INIT_FAILED);
@@ -122,10 +149,15 @@ void AP_SmartRTL::init()
         free(_path);
         free(_prune.loops);
         free(_simplify.stack);
+        free(_prune.grid_buckets);
+        free(_prune.grid_entries);
+        _path = nullptr;
+        _prune.grid_buckets = nullptr;
         return;
     }
 
     _path_points_max = _points_max;
+    reset_pruning_grid();
 
     // when running the example sketch, we want the cleanup tasks to run when we tell them to, not in the background (so that they can be timed.)
     if (!_example_mode){
@@ -289,6 +321,8 @@ bool AP_SmartRTL::request_thorough_cleanup(ThoroughCleanupType clean_type)
 
     // request thorough cleanup
     if (_thorough_clean_request_ms == 0) {
+        // stop moving the last point so the cleanup can include it
+        _merge.path_points_count = 0;
         _thorough_clean_request_ms = AP_HAL::millis();
         if (clean_type != THOROUGH_CLEAN_DEFAULT) {
             _thorough_clean_type = clean_type;
@@ -311,6 +345,16 @@ void AP_SmartRTL::cancel_request_for_thorough_cleanup()
     _thorough_clean_request_ms = 0;
 }
 
+// find loops by checking every segment, as boards without the loop finding grid do.  The background thread will not
+// be using the grid because no points have been added yet
+void AP_SmartRTL::disable_pruning_grid()
+{
+    free(_prune.grid_buckets);
+    free(_prune.grid_entries);
+    _prune.grid_buckets = nullptr;
+    _prune.grid_entries = nullptr;
+}
+
 //
 // Private methods
 //
@@ -333,6 +377,13 @@ bool AP_SmartRTL::add_point(const Vector3f& point)
         }
     }
 
+    // move the last point to the new point if it lies on a straight enough line
+    if (merge_point(point)) {
+        _path_sem.give();
+        log_action(SRTL_POINT_SIMPLIFY, point);
+        return true;
+    }
+
     // check we have space in the path
     if (_path_points_count >= _path_points_max) {
         _path_sem.give();
@@ -342,12 +393,43 @@ bool AP_SmartRTL::add_point(const Vector3f& point)
 
     // add point to path
     _path[_path_points_count++] = point;
+    _merge.path_points_count = _path_points_count;
+    _merge.count = 0;
     log_action(SRTL_POINT_ADD, point);
 
     _path_sem.give();
     return true;
 }
 
+// move the last point on the path to a newly added point if the last point and the points merged into it before
+// are all within SMARTRTL_SIMPLIFY_EPSILON of the line from the point before it to the new point.  This gives the
+// same guarantee as the Ramer-Douglas-Peucker simplification but only looks at a few points.
+// the path semaphore must be held
+bool AP_SmartRTL::merge_point(const Vector3f& point)
+{
+    // home is never moved, the window no longer applies once points have been removed from the path and the last
+    // point is left alone while a thorough cleanup may be using it
+    if ((_path_points_count < 2) || (_merge.path_points_count != _path_points_count) ||
+        (_merge.count >= SMARTRTL_SIMPLIFY_WINDOW) || (_thorough_clean_request_ms != 0)) {
+        return false;
+    }
+
+    const Vector3f& start = _path[_path_points_count-2];
+    Vector3f& last = _path[_path_points_count-1];
+    if (last.distance_to_segment(start, point) > SMARTRTL_SIMPLIFY_EPSILON) {
+        return false;
+    }
+    for (uint8_t i = 0; i < _merge.count; i++) {
+        if (_merge.points[i].distance_to_segment(start, point) > SMARTRTL_SIMPLIFY_EPSILON) {
+            return false;
+        }
+    }
+
+    _merge.points[_merge.count++] = last;
+    last = point;
+    return true;
+}
+
 // run background cleanup - should be run regularly from the IO thread
 void AP_SmartRTL::run_background_cleanup()
 {
@@ -360,7 +442,9 @@ void AP_SmartRTL::run_background_cleanup()
         return;
     }
     // local copy of _path_points_count and _path_points_completed_limit
-    const uint16_t path_points_count = _path_points_count;
+    // the last point is left out of routine cleanup as it may be moved by merge_point while the cleanup runs
+    const bool include_last_point = (_thorough_clean_request_ms > 0) || (_path_points_count == 0);
+    const uint16_t path_points_count = include_last_point ? _path_points_count : _path_points_count - 1;
     const uint16_t path_points_completed_limit = _path_points_completed_limit;
     _path_points_completed_limit = SMARTRTL_POINTS_MAX;
     _path_sem.give();
@@ -429,6 +513,9 @@ void AP_SmartRTL::routine_cleanup(uint16_t path_points_count, uint16_t path_poin
     if (_prune.path_points_completed > path_points_completed_limit) {
         _prune.path_points_completed = path_points_completed_limit;
     }
+    if (_prune.grid_next_segment > path_points_completed_limit) {
+        reset_pruning_grid();
+    }
 
     // calculate the number of points we could simplify
     const uint16_t points_to_simplify = (path_points_count > _simplify.path_points_completed) ? (path_points_count - _simplify.path_points_completed) : 0 ;
@@ -560,6 +647,8 @@ void AP_SmartRTL::detect_simplifications()
 *   This method runs for the allotted time, and detects loops in a path. Any detected loops are added to _prune.loops,
 *   this function does not alter the path in memory. It works by comparing the line segment between any two sequential points
 *   to the line segment between any other two sequential points. If they get close enough, anything between them could be pruned.
+*   Each new segment is checked against the earlier segments near it in the pruning grid, or against every earlier segment
+*   if the grid is not available or the new segment is too long to look up in it.
 *
 *   reset_pruning should have been called at least once before this function is called to setup the indexes (_prune.i, etc)
 */
@@ -577,19 +666,43 @@ void AP_SmartRTL::detect_loops()
     // run for defined amount of time
     while (AP_HAL::micros() - start_time_us < SMARTRTL_PRUNING_LOOP_TIME_US) {
 
-        // advance inner loop
+        // complete when outer loop has run out of new points to check
+        if (_prune.i >= _prune.path_points_count) {
+            _prune.complete = true;
+            _prune.path_points_completed = _prune.path_points_count;
+            return;
+        }
+
+        // the segment ending at i may form a loop with any segment ending at or before i-2
+        const bool grid_ok = (_prune.grid_buckets != nullptr) && !_prune.grid_full;
+        if (grid_ok && (_prune.j == 0)) {
+            // fill in the grid up to the last segment which could form a loop
+            if (_prune.grid_next_segment <= _prune.i - 2) {
+                add_segment_to_pruning_grid(_prune.grid_next_segment++);
+                continue;
+            }
+            uint16_t loop_segment;
+            dist_point dp;
+            if (find_loop_in_pruning_grid(_prune.i, loop_segment, dp)) {
+                // if there is a loop here, add to loop array
+                if ((loop_segment != _prune.i) && !add_loop(loop_segment, _prune.i-1, dp.midpoint)) {
+                    // if the buffer is full, stop trying to prune
+                    _prune.complete = true;
+                }
+                _prune.i++;
+                continue;
+            }
+            // segment is too long to look up in the grid
+        }
+
+        // check against every earlier segment, from the start of the path
         _prune.j++;
         if (_prune.j > _prune.i - 2) {
             // set inner loop back to first point
-            _prune.j = 1;
-            // reduce outer loop
-            _prune.i--;
-            // complete when outer loop has run out of new points to check
-            if (_prune.i < 4 || _prune.i < _prune.path_points_completed) {
-                _prune.complete = true;
-                _prune.path_points_completed = _prune.path_points_count;
-                return;
-            }
+            _prune.j = 0;
+            // advance outer loop
+            _prune.i++;
+            continue;
         }
 
         // find the closest distance between two line segments and the mid-point
@@ -600,8 +713,9 @@ void AP_SmartRTL::detect_loops()
                 // if the buffer is full, stop trying to prune
                 _prune.complete = true;
             }
-            // set inner loop forward to trigger outer loop move to next segment
-            _prune.j = _prune.i;
+            // move to next segment
+            _prune.j = 0;
+            _prune.i++;
         }
     }
 }
@@ -646,7 +760,7 @@ void AP_SmartRTL::reset_simplification()
 void AP_SmartRTL::restart_pruning(uint16_t path_points_count)
 {
     _prune.complete = false;
-    _prune.i = (path_points_count > 0) ? path_points_count - 1 : 0;
+    _prune.i = MAX(_prune.path_points_completed, 3);
     _prune.j = 0;
     _prune.path_points_count = path_points_count;
 }
@@ -654,9 +768,113 @@ void AP_SmartRTL::restart_pruning(uint16_t path_points_count)
 // reset pruning algorithm so that it will re-check all points in the path
 void AP_SmartRTL::reset_pruning()
 {
+    _prune.path_points_completed = 0;
     restart_pruning(0);
     _prune.loops_count = 0; // clear the loops that we've recorded
-    _prune.path_points_completed = 0;
+    reset_pruning_grid();
+}
+
+// empty the pruning grid.  It is refilled by detect_loops
+void AP_SmartRTL::reset_pruning_grid()
+{
+    if (_prune.grid_buckets != nullptr) {
+        memset(_prune.grid_buckets, 0xFF, (_prune.grid_buckets_mask + 1) * sizeof(uint16_t));
+    }
+    _prune.grid_entries_count = 0;
+    _prune.grid_long_head = UINT16_MAX;
+    _prune.grid_next_segment = 1;
+    _prune.grid_full = false;
+
+    // restart any segment being checked against every other segment
+    _prune.j = 0;
+}
+
+// range of grid cells covered by the line segment from p1 to p2 expanded by margin
+void AP_SmartRTL::pruning_grid_cells(const Vector3f& p1, const Vector3f& p2, float margin, int32_t& x_lo, int32_t& x_hi, int32_t& y_lo, int32_t& y_hi) const
+{
+    x_lo = floorf((MIN(p1.x, p2.x) - margin) / _prune.grid_cell_size);
+    x_hi = floorf((MAX(p1.x, p2.x) + margin) / _prune.grid_cell_size);
+    y_lo = floorf((MIN(p1.y, p2.y) - margin) / _prune.grid_cell_size);
+    y_hi = floorf((MAX(p1.y, p2.y) + margin) / _prune.grid_cell_size);
+}
+
+// hash bucket for a grid cell
+uint16_t AP_SmartRTL::pruning_grid_bucket(int32_t x, int32_t y) const
+{
+    return ((uint32_t)x * 73856093U ^ (uint32_t)y * 19349663U) & _prune.grid_buckets_mask;
+}
+
+// add a segment to the front of a list of grid entries.  returns false if there are no entries left
+bool AP_SmartRTL::pruning_grid_push(uint16_t& head, uint16_t segment)
+{
+    if (_prune.grid_entries_count >= _prune.grid_entries_max) {
+        _prune.grid_full = true;
+        return false;
+    }
+    _prune.grid_entries[_prune.grid_entries_count] = {segment, head};
+    head = _prune.grid_entries_count++;
+    return true;
+}
+
+// add the segment ending at the given point to the cells it passes within SMARTRTL_PRUNING_DELTA of
+// returns false if the grid is full
+bool AP_SmartRTL::add_segment_to_pruning_grid(uint16_t segment)
+{
+    int32_t x_lo, x_hi, y_lo, y_hi;
+    pruning_grid_cells(_path[segment-1], _path[segment], SMARTRTL_PRUNING_DELTA, x_lo, x_hi, y_lo, y_hi);
+    if ((x_hi - x_lo + 1) * (y_hi - y_lo + 1) > SMARTRTL_PRUNING_GRID_CELLS_MAX) {
+        return pruning_grid_push(_prune.grid_long_head, segment);
+    }
+    for (int32_t x = x_lo; x <= x_hi; x++) {
+        for (int32_t y = y_lo; y <= y_hi; y++) {
+            if (!pruning_grid_push(_prune.grid_buckets[pruning_grid_bucket(x, y)], segment)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// check a list of grid entries for a segment earlier than loop_segment which comes within SMARTRTL_PRUNING_DELTA
+// of the given segment
+void AP_SmartRTL::check_pruning_grid_list(uint16_t idx, uint16_t segment, uint16_t& loop_segment, dist_point& loop_dp) const
+{
+    while (idx != UINT16_MAX) {
+        const prune_grid_entry_t& entry = _prune.grid_entries[idx];
+        idx = entry.next;
+        // buckets may hold segments from other cells and segments may be in more than one cell, so only
+        // check segments earlier than the best found so far
+        if (entry.segment >= loop_segment || entry.segment + 2 > segment) {
+            continue;
+        }
+        const dist_point dp = segment_segment_dist(_path[segment], _path[segment-1], _path[entry.segment-1], _path[entry.segment]);
+        if (dp.distance < SMARTRTL_PRUNING_DELTA) {
+            loop_segment = entry.segment;
+            loop_dp = dp;
+        }
+    }
+}
+
+// find the earliest segment in the grid which comes within SMARTRTL_PRUNING_DELTA of the given segment, which
+// is the segment found by checking every earlier segment in order.  loop_segment is set to the given segment if
+// there is none.  The grid must hold every segment up to two before the given segment.
+// returns false if the segment is too long to look up in the grid
+bool AP_SmartRTL::find_loop_in_pruning_grid(uint16_t segment, uint16_t& loop_segment, dist_point& loop_dp) const
+{
+    int32_t x_lo, x_hi, y_lo, y_hi;
+    pruning_grid_cells(_path[segment-1], _path[segment], 0.0f, x_lo, x_hi, y_lo, y_hi);
+    if ((x_hi - x_lo + 1) * (y_hi - y_lo + 1) > SMARTRTL_PRUNING_GRID_CELLS_MAX) {
+        return false;
+    }
+
+    loop_segment = segment;
+    for (int32_t x = x_lo; x <= x_hi; x++) {
+        for (int32_t y = y_lo; y <= y_hi; y++) {
+            check_pruning_grid_list(_prune.grid_buckets[pruning_grid_bucket(x, y)], segment, loop_segment, loop_dp);
+        }
+    }
+    check_pruning_grid_list(_prune.grid_long_head, segment, loop_segment, loop_dp);
+    return true;
 }
 
 // remove all simplify-able points from the path
@@ -690,6 +908,11 @@ void AP_SmartRTL::remove_points_by_simplify_bitmask()
 
     _path_sem.give();
 
+    // segment indices in the pruning grid have changed
+    if (removed > 0) {
+        reset_pruning_grid();
+    }
+
     // flag point removal is complete
     _simplify.bitmask.setall();
     _simplify.removal_required = false;
@@ -753,6 +976,11 @@ bool AP_SmartRTL::remove_points_by_loops(uint16_t num_points_to_remove)
     }
 
     _path_sem.give();
+
+    // segment indices in the pruning grid have changed
+    if (removed_points > 0) {
+        reset_pruning_grid();
+    }
     return true;
 }
 
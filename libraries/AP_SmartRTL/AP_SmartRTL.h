@@ -6,8 +6,15 @@
 
 // definitions and macros
 #define SMARTRTL_ACCURACY_DEFAULT        2.0f   // default _ACCURACY parameter value.  Points will be no closer than this distance (in meters) together.
-#define SMARTRTL_POINTS_DEFAULT          300    // default _POINTS parameter value.  High numbers improve path pruning but use more memory and CPU for cleanup. Memory used will be 20bytes * this number.
-#define SMARTRTL_POINTS_MAX              500    // the absolute maximum number of points this library can support.
+#define SMARTRTL_POINTS_DEFAULT          300    // default _POINTS parameter value.  High numbers improve path pruning but use more memory and CPU for cleanup. Memory used will be about 24bytes * this number, plus up to 16bytes * this number if AP_SMARTRTL_PRUNING_GRID_ENABLED.
+#ifndef AP_SMARTRTL_PRUNING_GRID_ENABLED
+#define AP_SMARTRTL_PRUNING_GRID_ENABLED (HAL_MEM_CLASS >= HAL_MEM_CLASS_1000)  // find loops using a grid of path segments.  Only boards with plenty of memory can spare it
+#endif
+#if AP_SMARTRTL_PRUNING_GRID_ENABLED
+#define SMARTRTL_POINTS_MAX              1000   // the absolute maximum number of points this library can support.
+#else
+#define SMARTRTL_POINTS_MAX              500    // the absolute maximum number of points this library can support.  Pruning checks every segment without the grid so longer paths take too long
+#endif
 #define SMARTRTL_TIMEOUT                 15000  // the time in milliseconds with no points saved to the path (for whatever reason), before SmartRTL is disabled for the flight
 #define SMARTRTL_CLEANUP_POINT_TRIGGER   50     // simplification will trigger when this many points are added to the path
 #define SMARTRTL_CLEANUP_START_MARGIN    10     // routine cleanup algorithms begin when the path array has only this many empty slots remaining
@@ -17,9 +24,13 @@
                                                 // The minimum is int((s/2-1)+min(s/2, SMARTRTL_POINTS_MAX-s)), where s = pow(2, floor(log(SMARTRTL_POINTS_MAX)/log(2)))
                                                 // To avoid this annoying math, a good-enough overestimate is ceil(SMARTRTL_POINTS_MAX*2.0f/3.0f)
 #define SMARTRTL_SIMPLIFY_TIME_US        200    // maximum time (in microseconds) the simplification algorithm will run before returning
+#define SMARTRTL_SIMPLIFY_WINDOW         16     // maximum number of points merged into the last point of the path as they are added, before a new point must be kept
 #define SMARTRTL_PRUNING_DELTA (_accuracy * 0.99)   // How many meters apart must two points be, such that we can assume that there is no obstacle between them.  must be smaller than _ACCURACY parameter
 #define SMARTRTL_PRUNING_LOOP_BUFFER_LEN_MULT 0.25f // pruning loop buffer size as compared to maximum number of points
 #define SMARTRTL_PRUNING_LOOP_TIME_US    200    // maximum time (in microseconds) that the loop finding algorithm will run before returning
+#define SMARTRTL_PRUNING_GRID_CELL_MULT  25.0f  // size of the loop finding grid cells as a multiple of the _ACCURACY parameter
+#define SMARTRTL_PRUNING_GRID_CELLS_MAX  16     // segments covering more grid cells than this are checked against every other segment
+#define SMARTRTL_PRUNING_GRID_LEN_MULT   2      // loop finding grid entries as compared to maximum number of points
 
 class AP_SmartRTL {
 
@@ -78,6 +89,10 @@ public:
     // run background cleanup - should be run regularly from the IO thread
     void run_background_cleanup();
 
+    // find loops by checking every segment, as boards without the loop finding grid do.  Should be called
+    // after init and before any points are added.  Used by the unit tests to check the grid finds the same loops
+    void disable_pruning_grid();
+
     // returns true if pilot's yaw input should be used to adjust vehicle's heading
     bool use_pilot_yaw(void) const;
 
@@ -111,6 +126,10 @@ private:
     // add point to end of path
     bool add_point(const Vector3f& point);
 
+    // move the last point on the path to a newly added point if the points merged into it stay close enough to
+    // the line from the point before it.  returns true if the point was merged, false if it should be added
+    bool merge_point(const Vector3f& point);
+
     // routine cleanup attempts to remove 10 points (see SMARTRTL_CLEANUP_POINT_MIN definition) by simplification or loop pruning
     void routine_cleanup(uint16_t path_points_count, uint16_t path_points_complete_limit);
 
@@ -169,6 +188,15 @@ private:
     // get the closest distance between 2 line segments and the point midway between the closest points
     static dist_point segment_segment_dist(const Vector3f& p1, const Vector3f& p2, const Vector3f& p3, const Vector3f& p4);
 
+    // loop finding grid.  Segments are identified by the index of their end point
+    void reset_pruning_grid();
+    void pruning_grid_cells(const Vector3f& p1, const Vector3f& p2, float margin, int32_t& x_lo, int32_t& x_hi, int32_t& y_lo, int32_t& y_hi) const;
+    uint16_t pruning_grid_bucket(int32_t x, int32_t y) const;
+    bool pruning_grid_push(uint16_t& head, uint16_t segment);
+    bool add_segment_to_pruning_grid(uint16_t segment);
+    void check_pruning_grid_list(uint16_t idx, uint16_t segment, uint16_t& loop_segment, dist_point& loop_dp) const;
+    bool find_loop_in_pruning_grid(uint16_t segment, uint16_t& loop_segment, dist_point& loop_dp) const;
+
     // de-activate SmartRTL, send warning to GCS and logger
     void deactivate(SRTL_Actions action, const char *reason);
 
@@ -215,6 +243,13 @@ private:
         Bitmask<SMARTRTL_POINTS_MAX> bitmask;  // simplify algorithm clears bits for each point that can be removed
     } _simplify;
 
+    // points merged into the last point on the path as they were added
+    struct {
+        uint16_t path_points_count; // _path_points_count after the last point was added.  The window only applies while they match
+        uint8_t count;              // number of points in the window
+        Vector3f points[SMARTRTL_SIMPLIFY_WINDOW];  // points merged since the point before the last point was kept
+    } _merge;
+
     // Pruning
     typedef struct {
         uint16_t start_index;   // index of the first point in the loop
@@ -222,6 +257,10 @@ private:
         Vector3f midpoint;      // midpoint which should replace the first point when the loop is removed
         float length_squared;   // length squared (in meters) of the loop (used so we can remove the longest loops)
     } prune_loop_t;
+    typedef struct {
+        uint16_t segment;       // index of the end point of the segment
+        uint16_t next;          // index of the next entry in the same bucket
+    } prune_grid_entry_t;
     struct {
         bool complete;
         uint16_t path_points_count;  // copy of _path_points_count taken when the prune algorithm started
@@ -231,6 +270,16 @@ private:
         prune_loop_t* loops;// the result of the pruning algorithm
         uint16_t loops_max; // maximum number of elements in the _prunable_loops array
         uint16_t loops_count;   // number of elements in the _prunable_loops array
+        // grid of path segments so loops are found by checking only nearby segments
+        uint16_t* grid_buckets = nullptr; // first grid entry in each hash bucket.  nullptr if the grid could not be allocated
+        uint16_t grid_buckets_mask; // number of buckets minus one
+        prune_grid_entry_t* grid_entries = nullptr;
+        uint16_t grid_entries_max;  // maximum number of elements in the grid_entries array
+        uint16_t grid_entries_count;// number of elements in the grid_entries array
+        uint16_t grid_long_head;    // first grid entry of segments covering too many cells to place in the grid
+        uint16_t grid_next_segment; // segments before this have been added to the grid
+        float grid_cell_size;       // width of each grid cell in meters
+        bool grid_full;             // true if the grid ran out of entries, loops are found by checking every segment until it is reset
     } _prune;
 
     // returns true if the two loops overlap (used within add_loop to determine which loops to keep or throw away)
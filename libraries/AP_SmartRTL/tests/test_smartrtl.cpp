@@ -0,0 +1,135 @@
+#include <AP_gtest.h>
+#include <AP_gtest_random.h>
+
+#include <AP_SmartRTL/AP_SmartRTL.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+// random wandering path which stays near home, so it crosses itself
+static void make_path(Vector3f *points, uint16_t count, float noise)
+{
+    Vector3f pos, vel(2.5f, 0, 0);
+    for (uint16_t i = 0; i < count; i++) {
+        vel += Vector3f(test_rand(1.5f), test_rand(1.5f), test_rand(0.1f));
+        if (vel.length() > 8) {
+            vel *= 8 / vel.length();
+        }
+        vel -= pos * 0.002f;
+        pos += vel;
+        points[i] = pos + Vector3f(test_rand(noise), test_rand(noise), 0);
+    }
+}
+
+static const float accuracy = 2.0f;
+
+// SmartRTL in example mode, so cleanup only runs when called
+class SmartRTL : public AP_SmartRTL
+{
+public:
+    SmartRTL() : AP_SmartRTL(true)
+    {
+        AP_Param::set_object_value(this, var_info, "ACCURACY", accuracy);
+        AP_Param::set_object_value(this, var_info, "POINTS", SMARTRTL_POINTS_MAX);
+        init();
+    }
+
+    // start a new path at home and add points to it as the vehicle would
+    void set_path(const Vector3f *points, uint16_t count)
+    {
+        set_home(true, Vector3f());
+        for (uint16_t i = 0; i < count; i++) {
+            update(true, points[i]);
+        }
+    }
+
+    // run a thorough cleanup to completion, as the vehicle does before returning home
+    void thorough_cleanup(ThoroughCleanupType clean_type)
+    {
+        // requests are matched to their completion by millisecond timestamps so must not be made in the same
+        // millisecond as the last one
+        const uint32_t last_ms = AP_HAL::millis();
+        while (AP_HAL::millis() == last_ms) {
+        }
+        while (!request_thorough_cleanup(clean_type)) {
+            run_background_cleanup();
+        }
+    }
+
+    // distance from a point to the closest segment of the path
+    float distance_to_path(const Vector3f &point) const
+    {
+        float dist = (point - get_point(0)).length();
+        for (uint16_t i = 1; i < get_num_points(); i++) {
+            dist = MIN(dist, point.distance_to_segment(get_point(i-1), get_point(i)));
+        }
+        return dist;
+    }
+};
+
+// points merged into the last point as they are added stay within SMARTRTL_SIMPLIFY_EPSILON of the path
+TEST(AP_SmartRTL, merged_path_within_epsilon)
+{
+    static SmartRTL srtl;
+    const uint16_t count = 400;
+    static Vector3f points[count];
+    const float epsilon = accuracy * 0.5f;
+
+    for (const float noise : { 0.0f, 0.3f, 1.0f }) {
+        make_path(points, count, noise);
+        srtl.set_home(true, Vector3f());
+        bool saved[count];
+        uint16_t num_saved = 0;
+        for (uint16_t i = 0; i < count; i++) {
+            // points too close to the last point are not saved
+            const Vector3f &last = srtl.get_point(srtl.get_num_points() - 1);
+            saved[i] = last.distance_squared(points[i]) >= sq(accuracy);
+            num_saved += saved[i];
+            srtl.update(true, points[i]);
+        }
+        EXPECT_LT(srtl.get_num_points(), num_saved);
+        for (uint16_t i = 0; i < count; i++) {
+            if (saved[i]) {
+                EXPECT_LE(srtl.distance_to_path(points[i]), epsilon + 1e-4f);
+            }
+        }
+    }
+}
+
+// the grid finds the same loops as checking every earlier segment, so the paths are the same after cleanup
+TEST(AP_SmartRTL, grid_loops_match_linear_scan)
+{
+    static SmartRTL grid;
+    static SmartRTL linear;
+    static SmartRTL simplified;
+    linear.disable_pruning_grid();
+
+    static Vector3f points[SMARTRTL_POINTS_MAX-1];
+    uint32_t total_pruned = 0;
+    // noisy paths have many loops close together, so finding a loop other than the earliest one changes the path
+    for (uint8_t trial = 0; trial < 60; trial++) {
+        const uint16_t count = 50 + get_random16() % (SMARTRTL_POINTS_MAX-50);
+        make_path(points, count, 1.0f);
+        grid.set_path(points, count);
+        linear.set_path(points, count);
+        simplified.set_path(points, count);
+        grid.thorough_cleanup(AP_SmartRTL::THOROUGH_CLEAN_ALL);
+        linear.thorough_cleanup(AP_SmartRTL::THOROUGH_CLEAN_ALL);
+        simplified.thorough_cleanup(AP_SmartRTL::THOROUGH_CLEAN_SIMPLIFY_ONLY);
+
+        ASSERT_EQ(grid.get_num_points(), linear.get_num_points());
+        for (uint16_t i = 0; i < grid.get_num_points(); i++) {
+            EXPECT_EQ(grid.get_point(i), linear.get_point(i)) << "trial " << (int)trial << " point " << i;
+        }
+        total_pruned += simplified.get_num_points() - grid.get_num_points();
+    }
+    // check loops were found and removed
+    EXPECT_GT(total_pruned, 0U);
+}
+
+AP_GTEST_MAIN()
@@ -123,6 +123,8 @@ void AP_Stats::update()
 
 void AP_Stats::set_flying(const bool is_flying)
 {
+    // update() may run on another thread
+    WITH_SEMAPHORE(sem);
     if (is_flying) {
         if (!_flying_ms) {
             _flying_ms = AP_HAL::millis();
@@ -138,6 +140,7 @@ void AP_Stats::set_flying(const bool is_flying)
  */
 uint32_t AP_Stats::get_flight_time_s(void)
 {
+    WITH_SEMAPHORE(sem);
     update_flighttime();
     return flttime - flttime_boot;
 }
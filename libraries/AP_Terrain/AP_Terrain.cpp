@@ -36,6 +36,9 @@ AP_Terrain *AP_Terrain::singleton;
 #define TERRAIN_ENABLE_DEFAULT 1
 #endif
 
+// number of locations interpolated together by heights_amsl()
+#define TERRAIN_HEIGHT_BATCH 16
+
 // table of user settable parameters
 const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @Param: ENABLE
@@ -47,7 +50,7 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
 
     // @Param: SPACING
     // @DisplayName: Terrain grid spacing
-    // @Description: Distance between terrain grid points in meters. This controls the horizontal resolution of the terrain data that is stored on te SD card and requested from the ground station. If your GCS is using the ArduPilot SRTM database like Mission Planner or MAVProxy, then a resolution of 100 meters is appropriate. Grid spacings lower than 100 meters waste SD card space if the GCS cannot provide that resolution. The grid spacing also controls how much data is kept in memory during flight. A larger grid spacing will allow for a larger amount of data in memory. A grid spacing of 100 meters results in the vehicle keeping 12 grid squares in memory with each grid square having a size of 2.7 kilometers by 3.2 kilometers. Any additional grid squares are stored on the SD once they are fetched from the GCS and will be loaded as needed.
+    // @Description: Distance between terrain grid points in meters. This controls the horizontal resolution of the terrain data that is stored on te SD card and requested from the ground station. If your GCS is using the ArduPilot SRTM database like Mission Planner or MAVProxy, then a resolution of 100 meters is appropriate. Grid spacings lower than 100 meters waste SD card space if the GCS cannot provide that resolution. The grid spacing also controls how much data is kept in memory during flight. A larger grid spacing will allow for a larger amount of data in memory. A grid spacing of 100 meters results in each grid square held in memory having a size of 2.7 kilometers by 3.2 kilometers, and TERRAIN_CACHE_SZ sets how many grid squares are kept. Any additional grid squares are stored on the SD once they are fetched from the GCS and will be loaded as needed.
     // @Units: m
     // @Increment: 1
     // @User: Advanced
@@ -75,6 +78,14 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
     // @Range: 0 50
     // @User: Advanced
     AP_GROUPINFO("OFS_MAX",  4, AP_Terrain, offset_max, 15),
+
+    // @Param: CACHE_SZ
+    // @DisplayName: Terrain cache size
+    // @Description: The number of terrain grid squares kept in memory. Each grid square uses about 2 kilobytes. A larger cache allows more of the terrain along a fast flight or a survey to be kept in memory, and allows the grid squares ahead of the vehicle to be loaded before they are needed.
+    // @Range: 1 128
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("CACHE_SZ", 5, AP_Terrain, config_cache_size, TERRAIN_GRID_BLOCK_CACHE_SIZE),
     
     AP_GROUPEND
 };
@@ -175,6 +186,113 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
     return true;
 }
 
+/*
+  find the terrain heights in meters above sea level for an array of
+  locations. Heights which are not available are set to zero. Returns
+  the number of heights found
+ */
+uint16_t AP_Terrain::heights_amsl(const Location *locs, uint16_t count, float *heights, bool *valid, bool corrected)
+{
+    if (!allocate()) {
+        for (uint16_t i=0; i<count; i++) {
+            heights[i] = 0;
+            if (valid != nullptr) {
+                valid[i] = false;
+            }
+        }
+        return 0;
+    }
+
+    const float offset = (corrected && have_reference_offset) ? reference_offset : 0;
+    uint16_t found = 0;
+
+    struct grid_info info {}, last_info {};
+    const struct grid_block *grid = nullptr;
+
+    for (uint16_t start=0; start<count; start += TERRAIN_HEIGHT_BATCH) {
+        const uint8_t n = MIN(count - start, TERRAIN_HEIGHT_BATCH);
+
+        // the four surrounding heights and the position within the
+        // grid square of each location
+        float h00[TERRAIN_HEIGHT_BATCH], h01[TERRAIN_HEIGHT_BATCH];
+        float h10[TERRAIN_HEIGHT_BATCH], h11[TERRAIN_HEIGHT_BATCH];
+        float frac_x[TERRAIN_HEIGHT_BATCH], frac_y[TERRAIN_HEIGHT_BATCH];
+        bool have[TERRAIN_HEIGHT_BATCH];
+
+        for (uint8_t i=0; i<n; i++) {
+            calculate_grid_info(locs[start+i], info, grid != nullptr ? &last_info : nullptr);
+
+            // only look up the block when we move into a new one
+            if (grid == nullptr ||
+                info.grid_lat != last_info.grid_lat ||
+                info.grid_lon != last_info.grid_lon) {
+                grid = &find_grid_cache(info).grid;
+            }
+            last_info = info;
+
+            ASSERT_RANGE(info.idx_x, 0, TERRAIN_GRID_BLOCK_SIZE_X-2);
+            ASSERT_RANGE(info.idx_y, 0, TERRAIN_GRID_BLOCK_SIZE_Y-2);
+
+            have[i] = check_bitmap(*grid, info.idx_x,   info.idx_y) &&
+                      check_bitmap(*grid, info.idx_x,   info.idx_y+1) &&
+                      check_bitmap(*grid, info.idx_x+1, info.idx_y) &&
+                      check_bitmap(*grid, info.idx_x+1, info.idx_y+1);
+            h00[i] = grid->height[info.idx_x+0][info.idx_y+0];
+            h01[i] = grid->height[info.idx_x+0][info.idx_y+1];
+            h10[i] = grid->height[info.idx_x+1][info.idx_y+0];
+            h11[i] = grid->height[info.idx_x+1][info.idx_y+1];
+            frac_x[i] = info.frac_x;
+            frac_y[i] = info.frac_y;
+        }
+
+        // the same dual linear interpolation as height_amsl(), kept
+        // free of branches so the compiler can vectorise it
+        float *h = &heights[start];
+        for (uint8_t i=0; i<n; i++) {
+            const float avg1 = (1.0f-frac_x[i]) * h00[i] + frac_x[i] * h10[i];
+            const float avg2 = (1.0f-frac_x[i]) * h01[i] + frac_x[i] * h11[i];
+            h[i] = (1.0f-frac_y[i]) * avg1 + frac_y[i] * avg2 + offset;
+        }
+
+        for (uint8_t i=0; i<n; i++) {
+            if (have[i]) {
+                found++;
+            } else {
+                h[i] = 0;
+            }
+            if (valid != nullptr) {
+                valid[start+i] = have[i];
+            }
+        }
+    }
+
+    return found;
+}
+
+/*
+  find the terrain heights in meters above sea level at count points
+  spaced evenly along the line from start to end
+ */
+uint16_t AP_Terrain::heights_amsl_along(const Location &start, const Location &end, uint16_t count, float *heights, bool *valid, bool corrected)
+{
+    const int64_t dlat = end.lat - start.lat;
+    const int64_t dlng = Location::diff_longitude(end.lng, start.lng);
+    const uint16_t steps = MAX(count, 2) - 1;
+
+    uint16_t found = 0;
+    Location locs[TERRAIN_HEIGHT_BATCH];
+    for (uint16_t s=0; s<count; s += TERRAIN_HEIGHT_BATCH) {
+        const uint8_t n = MIN(count - s, TERRAIN_HEIGHT_BATCH);
+        for (uint8_t i=0; i<n; i++) {
+            const uint16_t k = s + i;
+            locs[i].lat = start.lat + dlat * k / steps;
+            locs[i].lng = Location::wrap_longitude(start.lng + dlng * k / steps);
+        }
+        found += heights_amsl(locs, n, &heights[s], valid != nullptr ? &valid[s] : nullptr, corrected);
+    }
+    return found;
+}
+
 
 /* 
    find difference between home terrain height and the terrain
@@ -344,6 +462,9 @@ void AP_Terrain::update(void)
     // check for pending mission data
     update_mission_data();
 
+    // load the grids ahead of the vehicle
+    update_prefetch();
+
     // check for pending rally data
     update_rally_data();
 
@@ -410,13 +531,42 @@ bool AP_Terrain::allocate(void)
     if (cache != nullptr) {
         return true;
     }
-    cache = (struct grid_cache *)calloc(TERRAIN_GRID_BLOCK_CACHE_SIZE, sizeof(cache[0]));
-    if (cache == nullptr) {
+    const uint8_t size = constrain_int16(config_cache_size.get(), 1, TERRAIN_GRID_BLOCK_CACHE_SIZE_MAX);
+
+    // at least two hash buckets per block keeps the chains short
+    uint16_t num_buckets = 16;
+    while (num_buckets < 2U*size) {
+        num_buckets <<= 1;
+    }
+
+    // reading blocks in batches helps a large cache fill quickly, but
+    // the buffer is kept small next to the cache
+    const uint8_t num_disk_blocks = constrain_int16(size / 16, 1, TERRAIN_DISK_READ_BLOCKS_MAX);
+
+    cache = (struct grid_cache *)calloc(size, sizeof(cache[0]));
+    cache_hash = (uint8_t *)calloc(num_buckets, sizeof(cache_hash[0]));
+    disk_blocks = (union grid_io_block *)calloc(num_disk_blocks, sizeof(disk_blocks[0]));
+    if (cache == nullptr || cache_hash == nullptr || disk_blocks == nullptr) {
+        free(cache);
+        free(cache_hash);
+        free(disk_blocks);
+        cache = nullptr;
+        cache_hash = nullptr;
+        disk_blocks = nullptr;
         gcs().send_text(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
         memory_alloc_failed = true;
         return false;
     }
-    cache_size = TERRAIN_GRID_BLOCK_CACHE_SIZE;
+    memset(cache_hash, cache_none, num_buckets);
+    cache_hash_mask = num_buckets - 1;
+    disk_blocks_max = num_disk_blocks;
+
+    // all entries start unused in the LRU list
+    for (uint8_t i=0; i<size; i++) {
+        cache[i].hash_next = cache_none;
+        lru_push_front(i);
+    }
+    cache_size = size;
     return true;
 }
 
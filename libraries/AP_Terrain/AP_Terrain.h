@@ -53,12 +53,37 @@
 #define TERRAIN_GRID_BLOCK_SIZE_X (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_X)
 #define TERRAIN_GRID_BLOCK_SIZE_Y (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_Y)
 
-// number of grid_blocks in the LRU memory cache
+// default number of grid_blocks in the LRU memory cache, set with
+// TERRAIN_CACHE_SZ. Linux boards and SITL have plenty of memory so
+// keep enough blocks to cover a fast survey flight
+#ifndef TERRAIN_GRID_BLOCK_CACHE_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE 64
+#else
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
+#endif
+#endif
+
+// largest allowed cache. Cache indexes are held in a uint8_t
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE_MAX 128
+
+// most grid_blocks read from disk at once when they are next to each
+// other in the file
+#define TERRAIN_DISK_READ_BLOCKS_MAX 4
 
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
 
+// on boards with a posix filesystem the IO thread reads and writes
+// blocks through memory mapped degree files, without a seek and a
+// system call for each read
+#ifndef AP_TERRAIN_MMAP_ENABLED
+#define AP_TERRAIN_MMAP_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+
+// number of degree files kept mapped at once
+#define TERRAIN_MMAP_MAX_FILES 4
+
 // we allow for a 2cm discrepancy in the grid corners. This is to
 // account for different rounding in terrain DAT file generators using
 // different programming languages
@@ -101,6 +126,10 @@ public:
     // update terrain state. Should be called at 1Hz or more
     void update(void);
 
+    // disk IO, run by the IO thread once update() has registered it.
+    // Tests without a running scheduler call it directly
+    void io_timer(void);
+
     bool enabled() const { return enable; }
     void set_enabled(bool _enable) { enable = _enable; }
 
@@ -124,6 +153,26 @@ public:
      */
     bool height_amsl(const Location &loc, float &height, bool corrected = true);
 
+    /*
+      find the terrain heights in meters above sea level for an array
+      of locations, such as points sampled along a path. Neighbouring
+      locations are expected to be close together, as the grid
+      calculations and block lookup are shared between locations in
+      the same grid block
+
+      heights which are not available are set to zero, and valid[i]
+      is set false if valid is not nullptr. Returns the number of
+      heights found
+     */
+    uint16_t heights_amsl(const Location *locs, uint16_t count, float *heights, bool *valid = nullptr, bool corrected = true);
+
+    /*
+      find the terrain heights in meters above sea level at count
+      points spaced evenly along the line from start to end, including
+      both ends. Heights are returned as for heights_amsl()
+     */
+    uint16_t heights_amsl_along(const Location &start, const Location &end, uint16_t count, float *heights, bool *valid = nullptr, bool corrected = true);
+
     /* 
        find difference between home terrain height and the terrain
        height at the current location in meters. A positive result
@@ -257,8 +306,15 @@ private:
 
         volatile enum GridCacheState state;
 
-        // the last time access was requested to this block, used for LRU
-        uint32_t last_access_ms;
+        // neighbours in the LRU list, which runs from most to least
+        // recently used
+        uint8_t lru_prev;
+        uint8_t lru_next;
+
+        // hash bucket this block is in and the next block in the
+        // same bucket
+        uint8_t hash_bucket;
+        uint8_t hash_next;
     };
 
     /*
@@ -293,11 +349,25 @@ private:
     // given a location, fill a grid_info structure
     void calculate_grid_info(const Location &loc, struct grid_info &info) const;
 
+    // fill a grid_info structure, taking the grid corner from the
+    // grid_info of a neighbouring location if they share a grid
+    void calculate_grid_info(const Location &loc, struct grid_info &info, const struct grid_info *neighbour) const;
+
     /*
       find a grid structure given a grid_info
     */
     struct grid_cache &find_grid_cache(const struct grid_info &info);
 
+    /*
+      LRU list and hash index of the cache
+    */
+    void lru_unlink(uint8_t idx);
+    void lru_push_front(uint8_t idx);
+    void lru_touch(uint8_t idx);
+    uint8_t lru_victim(void) const;
+    uint8_t hash_bucket(const struct grid_info &info) const;
+    void hash_remove(uint8_t idx);
+
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
       bit representing a 4x4 mavlink transmitted block
@@ -329,22 +399,40 @@ private:
     /*
       disk IO functions
      */
-    int16_t find_io_idx(enum GridCacheState state);
+    int16_t find_io_idx(const struct grid_block &block, enum GridCacheState state);
     uint16_t get_block_crc(struct grid_block &block);
     void check_disk_read(void);
+    bool is_next_disk_block(const struct grid_block &block, const struct grid_block &next) const;
     void check_disk_write(void);
-    void io_timer(void);
     void open_file(void);
     void seek_offset(void);
-    uint32_t east_blocks(struct grid_block &block) const;
+    uint32_t east_blocks(const struct grid_block &block) const;
     void write_block(void);
     void read_block(void);
 
+#if AP_TERRAIN_MMAP_ENABLED
+    /*
+      memory mapped file functions
+     */
+    struct mmap_file;
+    mmap_file *mmap_find_file(const struct grid_block &block);
+    bool mmap_map_file(mmap_file &f, uint32_t min_blocks);
+    void mmap_unmap_file(mmap_file &f);
+    bool mmap_read_blocks(void);
+    bool mmap_write_block(void);
+#endif
+
     /*
       check for missing mission terrain data
      */
     void update_mission_data(void);
 
+    /*
+      load blocks ahead of the vehicle into the cache
+     */
+    void update_prefetch(void);
+    bool prefetch_line(const Location &start, const Location &end, uint8_t &budget);
+
     /*
       check for missing rally data
      */
@@ -362,6 +450,7 @@ private:
     AP_Int16 grid_spacing; // meters between grid points
     AP_Int16 options; // option bits
     AP_Float offset_max;
+    AP_Int16 config_cache_size;
 
     enum class Options {
         DisableDownload = (1U<<0),
@@ -371,6 +460,18 @@ private:
     uint8_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+    // marks the end of the LRU list and hash chains
+    static const uint8_t cache_none = 0xFF;
+
+    // most and least recently used cache entries
+    uint8_t lru_head = cache_none;
+    uint8_t lru_tail = cache_none;
+
+    // first cache entry in each hash bucket, found from the grid
+    // indices of a block
+    uint8_t *cache_hash = nullptr;
+    uint16_t cache_hash_mask = 0;
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -380,7 +481,45 @@ private:
         DiskIoDoneWrite = 4
     };
     volatile enum DiskIoState disk_io_state;
-    union grid_io_block disk_block;
+
+    // blocks being read or written. A read may be of several blocks
+    // which follow each other in the file
+    union grid_io_block *disk_blocks = nullptr;
+    uint8_t disk_blocks_max = 0;
+    uint8_t disk_io_count = 0;
+
+#if AP_TERRAIN_MMAP_ENABLED
+    enum class MMapBlockState : uint8_t {
+        UNCHECKED = 0,
+        VALID = 1,
+        INVALID = 2,
+    };
+
+    /*
+      a memory mapped degree file. The CRC of each block is checked
+      once, when it is first read
+     */
+    struct mmap_file {
+        int8_t lat_degrees = 0;
+        int16_t lon_degrees = 0;
+        bool in_use = false;
+
+        // nullptr if the file is empty or could not be mapped
+        uint8_t *data = nullptr;
+        uint32_t num_blocks = 0;
+        MMapBlockState *block_state = nullptr;
+
+        // kept open so the file can be grown for writes
+        int fd = -1;
+
+        // number of blocks in an east stride at this latitude
+        uint32_t east_blocks = 0;
+
+        uint32_t last_access_ms = 0;
+        uint32_t last_map_ms = 0;
+    };
+    mmap_file mmap_files[TERRAIN_MMAP_MAX_FILES];
+#endif
 
     // last time we asked for more grids
     uint32_t last_request_time_ms[MAVLINK_COMM_NUM_BUFFERS];
@@ -435,6 +574,9 @@ private:
     // grid spacing during mission check
     uint16_t last_mission_spacing;
 
+    // last time blocks ahead of the vehicle were loaded
+    uint32_t last_prefetch_ms;
+
     // next rally command to check
     uint16_t next_rally_index;
 
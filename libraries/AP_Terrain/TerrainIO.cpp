@@ -31,17 +31,69 @@
 extern const AP_HAL::HAL& hal;
 
 /*
-  check for blocks that need to be read from disk
+  return true if next is the block after block in the same file
+ */
+bool AP_Terrain::is_next_disk_block(const struct grid_block &block, const struct grid_block &next) const
+{
+    return next.lat_degrees == block.lat_degrees &&
+           next.lon_degrees == block.lon_degrees &&
+           next.spacing == block.spacing &&
+           next.grid_idx_x == block.grid_idx_x &&
+           next.grid_idx_y == block.grid_idx_y + 1;
+}
+
+/*
+  check for blocks that need to be read from disk. The most recently
+  used block is read first, along with any blocks waiting to be read
+  which are next to it in the file
  */
 void AP_Terrain::check_disk_read(void)
 {
-    for (uint16_t i=0; i<cache_size; i++) {
+    uint8_t idx = cache_none;
+    for (uint8_t i=lru_head; i!=cache_none; i=cache[i].lru_next) {
         if (cache[i].state == GRID_CACHE_DISKWAIT) {
-            disk_block.block = cache[i].grid;
-            disk_io_state = DiskIoWaitRead;
-            return;
+            idx = i;
+            break;
         }
-    }    
+    }
+    if (idx == cache_none) {
+        return;
+    }
+
+    // blocks loaded ahead of the vehicle are most recently used at
+    // the far end, so step back to the first waiting block which
+    // still leaves this one in the read
+    for (uint8_t n=1; n<disk_blocks_max; n++) {
+        uint16_t i;
+        for (i=0; i<cache_size; i++) {
+            if (cache[i].state == GRID_CACHE_DISKWAIT &&
+                is_next_disk_block(cache[i].grid, cache[idx].grid)) {
+                break;
+            }
+        }
+        if (i == cache_size) {
+            break;
+        }
+        idx = i;
+    }
+
+    disk_blocks[0].block = cache[idx].grid;
+    disk_io_count = 1;
+    while (disk_io_count < disk_blocks_max) {
+        const struct grid_block &last = disk_blocks[disk_io_count-1].block;
+        uint16_t i;
+        for (i=0; i<cache_size; i++) {
+            if (cache[i].state == GRID_CACHE_DISKWAIT &&
+                is_next_disk_block(last, cache[i].grid)) {
+                break;
+            }
+        }
+        if (i == cache_size) {
+            break;
+        }
+        disk_blocks[disk_io_count++].block = cache[i].grid;
+    }
+    disk_io_state = DiskIoWaitRead;
 }
 
 /*
@@ -51,7 +103,8 @@ void AP_Terrain::check_disk_write(void)
 {
     for (uint16_t i=0; i<cache_size; i++) {
         if (cache[i].state == GRID_CACHE_DIRTY) {
-            disk_block.block = cache[i].grid;
+            disk_blocks[0].block = cache[i].grid;
+            disk_io_count = 1;
             disk_io_state = DiskIoWaitWrite;
             return;
         }
@@ -84,14 +137,18 @@ void AP_Terrain::schedule_disk_io(void)
         
     case DiskIoDoneRead: {
         // a read has completed
-        int16_t cache_idx = find_io_idx(GRID_CACHE_DISKWAIT);
-        if (cache_idx != -1) {
-            if (disk_block.block.bitmap != 0) {
-                // when bitmap is zero we read an empty block
-                cache[cache_idx].grid = disk_block.block;
+        for (uint8_t i=0; i<disk_io_count; i++) {
+            const struct grid_block &block = disk_blocks[i].block;
+            int16_t cache_idx = find_io_idx(block, GRID_CACHE_DISKWAIT);
+            // a block which got data from the GCS during the read is
+            // newer than the disk copy
+            if (cache_idx != -1 && cache[cache_idx].state == GRID_CACHE_DISKWAIT) {
+                if (block.bitmap != 0) {
+                    // when bitmap is zero we read an empty block
+                    cache[cache_idx].grid = block;
+                }
+                cache[cache_idx].state = GRID_CACHE_VALID;
             }
-            cache[cache_idx].state = GRID_CACHE_VALID;
-            cache[cache_idx].last_access_ms = AP_HAL::millis();
         }
         disk_io_state = DiskIoIdle;
         break;
@@ -99,9 +156,9 @@ void AP_Terrain::schedule_disk_io(void)
 
     case DiskIoDoneWrite: {
         // a write has completed
-        int16_t cache_idx = find_io_idx(GRID_CACHE_DIRTY);
+        int16_t cache_idx = find_io_idx(disk_blocks[0].block, GRID_CACHE_DIRTY);
         if (cache_idx != -1) {
-            if (cache[cache_idx].grid.bitmap == disk_block.block.bitmap) {
+            if (cache[cache_idx].grid.bitmap == disk_blocks[0].block.bitmap) {
                 // only mark valid if more grids haven't been added
                 cache[cache_idx].state = GRID_CACHE_VALID;
             }
@@ -128,7 +185,8 @@ The IO timer context owns the data when disk_io_state is
 DiskIoWaitWrite or DiskIoWaitRead. The main thread owns the data when
 disk_io_state is DiskIoIdle, DiskIoDoneWrite or DiskIoDoneRead
 
-All file operations are done by the IO thread.
+All file operations are done by the IO thread, including those on
+memory mapped files.
 *********************************************************/
 
 
@@ -137,7 +195,7 @@ All file operations are done by the IO thread.
  */
 void AP_Terrain::open_file(void)
 {
-    struct grid_block &block = disk_block.block;
+    struct grid_block &block = disk_blocks[0].block;
     if (fd != -1 && 
         block.lat_degrees == file_lat_degrees &&
         block.lon_degrees == file_lon_degrees) {
@@ -219,7 +277,7 @@ void AP_Terrain::open_file(void)
 /*
   work out how many blocks needed in a stride for a given location
  */
-uint32_t AP_Terrain::east_blocks(struct grid_block &block) const
+uint32_t AP_Terrain::east_blocks(const struct grid_block &block) const
 {
     Location loc1, loc2;
     loc1.lat = block.lat_degrees*10*1000*1000L;
@@ -234,11 +292,11 @@ uint32_t AP_Terrain::east_blocks(struct grid_block &block) const
 }
 
 /*
-  seek to the right offset for disk_block
+  seek to the right offset for the first of disk_blocks
  */
 void AP_Terrain::seek_offset(void)
 {
-    struct grid_block &block = disk_block.block;
+    struct grid_block &block = disk_blocks[0].block;
     // work out how many longitude blocks there are at this latitude
     uint32_t blocknum = east_blocks(block) * block.grid_idx_x + block.grid_idx_y;
     uint32_t file_offset = blocknum * sizeof(union grid_io_block);
@@ -254,7 +312,7 @@ void AP_Terrain::seek_offset(void)
 }
 
 /*
-  write out disk_block
+  write out the first of disk_blocks
  */
 void AP_Terrain::write_block(void)
 {
@@ -263,6 +321,7 @@ void AP_Terrain::write_block(void)
         return;
     }
 
+    union grid_io_block &disk_block = disk_blocks[0];
     disk_block.block.crc = get_block_crc(disk_block.block);
 
     ssize_t ret = AP::FS().write(fd, &disk_block, sizeof(disk_block));
@@ -287,7 +346,8 @@ void AP_Terrain::write_block(void)
 }
 
 /*
-  read in disk_block
+  read in disk_blocks. The blocks follow each other in the file so
+  are read with a single read
  */
 void AP_Terrain::read_block(void)
 {
@@ -295,43 +355,50 @@ void AP_Terrain::read_block(void)
     if (io_failure) {
         return;
     }
-    int32_t lat = disk_block.block.lat;
-    int32_t lon = disk_block.block.lon;
-
-    ssize_t ret = AP::FS().read(fd, &disk_block, sizeof(disk_block));
-    if (ret != sizeof(disk_block) || 
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lat,lat) ||
-        !TERRAIN_LATLON_EQUAL(disk_block.block.lon,lon) ||
-        disk_block.block.bitmap == 0 ||
-        disk_block.block.spacing != grid_spacing ||
-        disk_block.block.version != TERRAIN_GRID_FORMAT_VERSION ||
-        disk_block.block.crc != get_block_crc(disk_block.block)) {
+    int32_t lat[TERRAIN_DISK_READ_BLOCKS_MAX];
+    int32_t lon[TERRAIN_DISK_READ_BLOCKS_MAX];
+    for (uint8_t i=0; i<disk_io_count; i++) {
+        lat[i] = disk_blocks[i].block.lat;
+        lon[i] = disk_blocks[i].block.lon;
+    }
+
+    ssize_t ret = AP::FS().read(fd, disk_blocks, disk_io_count * sizeof(disk_blocks[0]));
+    for (uint8_t i=0; i<disk_io_count; i++) {
+        union grid_io_block &disk_block = disk_blocks[i];
+        if (ret < (ssize_t)((i+1) * sizeof(disk_block)) ||
+            !TERRAIN_LATLON_EQUAL(disk_block.block.lat,lat[i]) ||
+            !TERRAIN_LATLON_EQUAL(disk_block.block.lon,lon[i]) ||
+            disk_block.block.bitmap == 0 ||
+            disk_block.block.spacing != grid_spacing ||
+            disk_block.block.version != TERRAIN_GRID_FORMAT_VERSION ||
+            disk_block.block.crc != get_block_crc(disk_block.block)) {
 #if TERRAIN_DEBUG
-        printf("read empty block at %ld %ld ret=%d (%ld %ld %u 0x%08lx) 0x%04x:0x%04x\n",
-               (long)lat,
-               (long)lon,
-               (int)ret,
-               (long)disk_block.block.lat,
-               (long)disk_block.block.lon,
-               (unsigned)disk_block.block.spacing,
-               (unsigned long)disk_block.block.bitmap,
-               (unsigned)disk_block.block.crc,
-               (unsigned)get_block_crc(disk_block.block));
+            printf("read empty block at %ld %ld ret=%d (%ld %ld %u 0x%08lx) 0x%04x:0x%04x\n",
+                   (long)lat[i],
+                   (long)lon[i],
+                   (int)ret,
+                   (long)disk_block.block.lat,
+                   (long)disk_block.block.lon,
+                   (unsigned)disk_block.block.spacing,
+                   (unsigned long)disk_block.block.bitmap,
+                   (unsigned)disk_block.block.crc,
+                   (unsigned)get_block_crc(disk_block.block));
 #endif
-        // a short read or bad data is not an IO failure, just a
-        // missing block on disk
-        memset(&disk_block, 0, sizeof(disk_block));
-        disk_block.block.lat = lat;
-        disk_block.block.lon = lon;
-        disk_block.block.bitmap = 0;
-    } else {
+            // a short read or bad data is not an IO failure, just a
+            // missing block on disk
+            memset(&disk_block, 0, sizeof(disk_block));
+            disk_block.block.lat = lat[i];
+            disk_block.block.lon = lon[i];
+            disk_block.block.bitmap = 0;
+        } else {
 #if TERRAIN_DEBUG
-        printf("read block at %ld %ld ret=%d mask=%07llx\n",
-               (long)lat,
-               (long)lon,
-               (int)ret,
-               (unsigned long long)disk_block.block.bitmap);
+            printf("read block at %ld %ld ret=%d mask=%07llx\n",
+                   (long)lat[i],
+                   (long)lon[i],
+                   (int)ret,
+                   (unsigned long long)disk_block.block.bitmap);
 #endif
+        }
     }
     disk_io_state = DiskIoDoneRead;
 }
@@ -362,6 +429,12 @@ void AP_Terrain::io_timer(void)
         
     case DiskIoWaitWrite:
         // need to write out the block
+#if AP_TERRAIN_MMAP_ENABLED
+        if (mmap_write_block()) {
+            disk_io_state = DiskIoDoneWrite;
+            break;
+        }
+#endif
         open_file();
         if (fd == -1) {
             return;
@@ -371,6 +444,12 @@ void AP_Terrain::io_timer(void)
 
     case DiskIoWaitRead:
         // need to read in the block
+#if AP_TERRAIN_MMAP_ENABLED
+        if (mmap_read_blocks()) {
+            disk_io_state = DiskIoDoneRead;
+            break;
+        }
+#endif
         open_file();
         if (fd == -1) {
             return;
@@ -0,0 +1,287 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  memory mapped terrain files for boards with a posix filesystem.
+
+  These run in the IO thread in place of read_block() and
+  write_block(), copying disk_blocks to and from the mapped degree
+  files. If a file cannot be mapped the blocks in it are read and
+  written with the file functions
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_AVAILABLE && AP_TERRAIN_MMAP_ENABLED
+
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern const AP_HAL::HAL& hal;
+
+// files are grown by at least this many blocks at a time when
+// writing, so they are not remapped for every new block
+#define TERRAIN_MMAP_GROW_BLOCKS 64
+
+// how often a file which could not be mapped is retried
+#define TERRAIN_MMAP_RETRY_MS 5000
+
+void AP_Terrain::mmap_unmap_file(mmap_file &f)
+{
+    if (f.data != nullptr) {
+        munmap(f.data, f.num_blocks * sizeof(union grid_io_block));
+        f.data = nullptr;
+    }
+    delete[] f.block_state;
+    f.block_state = nullptr;
+    f.num_blocks = 0;
+    if (f.fd != -1) {
+        AP::FS().close(f.fd);
+        f.fd = -1;
+    }
+}
+
+/*
+  allocate disk space for part of a file, growing the file if need
+  be. Stores to a mapped page with no disk space behind it raise
+  SIGBUS when the disk is full, so space is reserved before writing
+ */
+static bool mmap_reserve(int fd, off_t offset, off_t len)
+{
+    return posix_fallocate(fd, offset, len) == 0;
+}
+
+/*
+  map a degree file, growing it to at least min_blocks blocks. The
+  CRC state of blocks already checked is kept. Returns false if the
+  whole file could not be mapped. A file which is not mapped yet is
+  then closed, so it is retried later
+ */
+bool AP_Terrain::mmap_map_file(mmap_file &f, uint32_t min_blocks)
+{
+    f.last_map_ms = AP_HAL::millis();
+
+    if (f.fd == -1) {
+        const char *terrain_dir = hal.util->get_custom_terrain_directory();
+        if (terrain_dir == nullptr) {
+            terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
+        }
+        if (AP::FS().mkdir(terrain_dir) != 0 && errno != EEXIST) {
+            return false;
+        }
+        char path[128];
+        hal.util->snprintf(path, sizeof(path), "%s/%c%02u%c%03u.DAT",
+                           terrain_dir,
+                           f.lat_degrees<0?'S':'N',
+                           (unsigned)MIN(abs((int32_t)f.lat_degrees), 99),
+                           f.lon_degrees<0?'W':'E',
+                           (unsigned)MIN(abs((int32_t)f.lon_degrees), 999));
+        // the local filesystem gives posix file descriptors on these
+        // boards, so the file can be mapped
+        f.fd = AP::FS().open(path, O_RDWR|O_CREAT);
+        if (f.fd == -1) {
+            return false;
+        }
+    }
+
+    struct stat st;
+    if (fstat(f.fd, &st) != 0) {
+        mmap_unmap_file(f);
+        return false;
+    }
+    uint32_t num_blocks = st.st_size / sizeof(union grid_io_block);
+    if (num_blocks < min_blocks) {
+        num_blocks = MAX(min_blocks, num_blocks + TERRAIN_MMAP_GROW_BLOCKS);
+        if (!mmap_reserve(f.fd, st.st_size, num_blocks * sizeof(union grid_io_block) - st.st_size)) {
+            // the block is left for the IO thread
+            return false;
+        }
+    }
+    if (num_blocks == f.num_blocks) {
+        // nothing new in the file
+        return true;
+    }
+    if (num_blocks == 0) {
+        // an empty file reads as empty blocks
+        return true;
+    }
+
+    void *data = mmap(nullptr, num_blocks * sizeof(union grid_io_block), PROT_READ|PROT_WRITE, MAP_SHARED, f.fd, 0);
+    if (data == MAP_FAILED) {
+        if (f.data == nullptr) {
+            mmap_unmap_file(f);
+        }
+        return false;
+    }
+    MMapBlockState *block_state = new MMapBlockState[num_blocks];
+    if (block_state == nullptr) {
+        munmap(data, num_blocks * sizeof(union grid_io_block));
+        if (f.data == nullptr) {
+            mmap_unmap_file(f);
+        }
+        return false;
+    }
+    for (uint32_t i=0; i<num_blocks; i++) {
+        block_state[i] = i < f.num_blocks ? f.block_state[i] : MMapBlockState::UNCHECKED;
+    }
+    if (f.data != nullptr) {
+        munmap(f.data, f.num_blocks * sizeof(union grid_io_block));
+    }
+    delete[] f.block_state;
+    f.data = (uint8_t *)data;
+    f.num_blocks = num_blocks;
+    f.block_state = block_state;
+    return true;
+}
+
+/*
+  find the mapped degree file for a block, replacing the least
+  recently used file if need be. Returns nullptr if the file cannot be
+  opened
+ */
+AP_Terrain::mmap_file *AP_Terrain::mmap_find_file(const struct grid_block &block)
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    mmap_file *f = nullptr;
+    uint8_t oldest = 0;
+    for (uint8_t i=0; i<ARRAY_SIZE(mmap_files); i++) {
+        if (mmap_files[i].in_use &&
+            mmap_files[i].lat_degrees == block.lat_degrees &&
+            mmap_files[i].lon_degrees == block.lon_degrees) {
+            f = &mmap_files[i];
+            break;
+        }
+        if (!mmap_files[i].in_use ||
+            (mmap_files[oldest].in_use && mmap_files[i].last_access_ms < mmap_files[oldest].last_access_ms)) {
+            oldest = i;
+        }
+    }
+    if (f == nullptr) {
+        f = &mmap_files[oldest];
+        mmap_unmap_file(*f);
+        f->in_use = true;
+        f->lat_degrees = block.lat_degrees;
+        f->lon_degrees = block.lon_degrees;
+        f->east_blocks = east_blocks(block);
+        mmap_map_file(*f, 0);
+    } else if (f->fd == -1 && now_ms - f->last_map_ms > TERRAIN_MMAP_RETRY_MS) {
+        mmap_map_file(*f, 0);
+    }
+    f->last_access_ms = now_ms;
+
+    if (f->fd == -1) {
+        return nullptr;
+    }
+    return f;
+}
+
+/*
+  read disk_blocks from the mapped file, as read_block() does. Returns
+  false if the file is not available
+ */
+bool AP_Terrain::mmap_read_blocks(void)
+{
+    // the blocks of a read follow each other in one file
+    mmap_file *f = mmap_find_file(disk_blocks[0].block);
+    if (f == nullptr) {
+        return false;
+    }
+
+    const uint32_t first = f->east_blocks * disk_blocks[0].block.grid_idx_x + disk_blocks[0].block.grid_idx_y;
+    if (first + disk_io_count > f->num_blocks) {
+        // the file may have been written by write_block(), or grown
+        // by another process, since it was mapped
+        if (!mmap_map_file(*f, 0)) {
+            return false;
+        }
+    }
+
+    for (uint8_t i=0; i<disk_io_count; i++) {
+        struct grid_block &block = disk_blocks[i].block;
+        const int32_t lat = block.lat;
+        const int32_t lon = block.lon;
+        const uint32_t blocknum = first + i;
+        bool valid = false;
+        if (blocknum < f->num_blocks) {
+            const struct grid_block &fblock = *(const struct grid_block *)&f->data[blocknum * sizeof(union grid_io_block)];
+            if (fblock.bitmap != 0 &&
+                TERRAIN_LATLON_EQUAL(fblock.lat,lat) &&
+                TERRAIN_LATLON_EQUAL(fblock.lon,lon) &&
+                fblock.spacing == grid_spacing &&
+                fblock.version == TERRAIN_GRID_FORMAT_VERSION) {
+                block = fblock;
+                MMapBlockState &state = f->block_state[blocknum];
+                if (state == MMapBlockState::UNCHECKED) {
+                    state = block.crc == get_block_crc(block) ? MMapBlockState::VALID : MMapBlockState::INVALID;
+                }
+                valid = state == MMapBlockState::VALID;
+            }
+        }
+        if (!valid) {
+            // a block which is missing or bad in the file is read as
+            // empty, and will be requested from the GCS
+            memset(&disk_blocks[i], 0, sizeof(disk_blocks[i]));
+            block.lat = lat;
+            block.lon = lon;
+        }
+    }
+    return true;
+}
+
+/*
+  write the first of disk_blocks into the mapped file, as
+  write_block() does. Returns false if the file is not available
+ */
+bool AP_Terrain::mmap_write_block(void)
+{
+    struct grid_block &grid = disk_blocks[0].block;
+    mmap_file *f = mmap_find_file(grid);
+    if (f == nullptr) {
+        return false;
+    }
+
+    const uint32_t blocknum = f->east_blocks * grid.grid_idx_x + grid.grid_idx_y;
+    if (blocknum >= f->num_blocks) {
+        if (!mmap_map_file(*f, blocknum+1) || blocknum >= f->num_blocks) {
+            return false;
+        }
+    }
+
+    // the block may be in a hole left by a write past the end of the file
+    if (!mmap_reserve(f->fd, blocknum * sizeof(union grid_io_block), sizeof(union grid_io_block))) {
+        return false;
+    }
+
+    grid.crc = get_block_crc(grid);
+    uint8_t *b = &f->data[blocknum * sizeof(union grid_io_block)];
+    memset(b, 0, sizeof(union grid_io_block));
+    memcpy(b, &grid, sizeof(grid));
+    f->block_state[blocknum] = MMapBlockState::VALID;
+
+    // start writing the pages holding the block back to disk
+    const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    const uintptr_t start = uintptr_t(b) & ~(page_size-1);
+    const uintptr_t end = uintptr_t(b) + sizeof(union grid_io_block);
+    msync((void *)start, end - start, MS_ASYNC);
+    return true;
+}
+
+#endif // AP_TERRAIN_AVAILABLE && AP_TERRAIN_MMAP_ENABLED
@@ -16,6 +16,7 @@
   handle checking mission points for terrain data
  */
 
+#include <AP_AHRS/AP_AHRS.h>
 #include <AP_HAL/AP_HAL.h>
 #include <AP_Common/AP_Common.h>
 #include <AP_Math/AP_Math.h>
@@ -30,6 +31,19 @@
 
 extern const AP_HAL::HAL& hal;
 
+// how often blocks ahead of the vehicle are loaded
+#define TERRAIN_PREFETCH_INTERVAL_MS 1000
+
+// how far ahead along the velocity vector blocks are loaded
+#define TERRAIN_PREFETCH_TIME_S 60
+
+// number of mission legs ahead of the vehicle that blocks are loaded for
+#define TERRAIN_PREFETCH_MISSION_LEGS 3
+
+// cache entries left for the current block and the 9 around it which
+// are requested from the GCS
+#define TERRAIN_PREFETCH_RESERVED_BLOCKS 10
+
 /*
   check that we have fetched all mission terrain data
  */
@@ -172,4 +186,105 @@ void AP_Terrain::update_rally_data(void)
     }
 }
 
+/*
+  load the blocks along a line into the cache, stopping when budget
+  blocks have been loaded. Returns false if the budget has run out
+ */
+bool AP_Terrain::prefetch_line(const Location &start, const Location &end, uint8_t &budget)
+{
+    // half block steps only miss blocks the line clips the corner of
+    const float step = 0.5f * MIN(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y) * grid_spacing;
+    const float distance = start.get_distance(end);
+    const float bearing = start.get_bearing_to(end) * 0.01f;
+
+    int32_t last_grid_lat = 0;
+    int32_t last_grid_lon = 0;
+    for (float d=0; ; d+=step) {
+        Location loc = start;
+        if (d >= distance) {
+            loc = end;
+        } else {
+            loc.offset_bearing(bearing, d);
+        }
+        struct grid_info info;
+        calculate_grid_info(loc, info);
+        if (d == 0 || info.grid_lat != last_grid_lat || info.grid_lon != last_grid_lon) {
+            if (budget == 0) {
+                return false;
+            }
+            // finding the block starts a disk read if it is not in
+            // the cache, and makes it recently used if it is
+            find_grid_cache(info);
+            budget--;
+            last_grid_lat = info.grid_lat;
+            last_grid_lon = info.grid_lon;
+        }
+        if (d >= distance) {
+            break;
+        }
+    }
+    return true;
+}
+
+/*
+  load the blocks the vehicle is about to fly over into the cache, so
+  terrain following does not wait for disk IO when crossing into a new
+  block. Blocks along the velocity vector are loaded first, then those
+  along the next mission legs
+ */
+void AP_Terrain::update_prefetch(void)
+{
+    if (cache_size <= TERRAIN_PREFETCH_RESERVED_BLOCKS || grid_spacing <= 0) {
+        return;
+    }
+    const uint32_t now_ms = AP_HAL::millis();
+    if (now_ms - last_prefetch_ms < TERRAIN_PREFETCH_INTERVAL_MS) {
+        return;
+    }
+    last_prefetch_ms = now_ms;
+
+    AP_AHRS &ahrs = AP::ahrs();
+    Location loc;
+    if (!ahrs.get_location(loc)) {
+        return;
+    }
+
+    // leave half of the remaining cache for blocks being downloaded
+    // for the mission and rally points
+    uint8_t budget = (cache_size - TERRAIN_PREFETCH_RESERVED_BLOCKS) / 2;
+
+    const Vector2f velocity = ahrs.groundspeed_vector();
+    if (!velocity.is_zero()) {
+        Location ahead = loc;
+        ahead.offset(velocity.x * TERRAIN_PREFETCH_TIME_S, velocity.y * TERRAIN_PREFETCH_TIME_S);
+        if (!prefetch_line(loc, ahead, budget)) {
+            return;
+        }
+    }
+
+#if HAL_MISSION_ENABLED
+    AP_Mission *mission = AP::mission();
+    if (mission == nullptr || mission->state() != AP_Mission::MISSION_RUNNING) {
+        return;
+    }
+    AP_Mission::Mission_Command cmd = mission->get_current_nav_cmd();
+    if (cmd.index == AP_MISSION_CMD_INDEX_NONE) {
+        return;
+    }
+    for (uint8_t leg=0; leg<TERRAIN_PREFETCH_MISSION_LEGS; leg++) {
+        // commands without a location, such as a delay, keep the
+        // vehicle where it is
+        if (cmd.content.location.lat != 0 || cmd.content.location.lng != 0) {
+            if (!prefetch_line(loc, cmd.content.location, budget)) {
+                return;
+            }
+            loc = cmd.content.location;
+        }
+        if (!mission->get_next_nav_cmd(cmd.index+1, cmd)) {
+            break;
+        }
+    }
+#endif  // HAL_MISSION_ENABLED
+}
+
 #endif // AP_TERRAIN_AVAILABLE
@@ -59,6 +59,16 @@ bool AP_Terrain::check_bitmap(const struct grid_block &grid, uint8_t idx_x, uint
   grid indices
 */
 void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info) const
+{
+    calculate_grid_info(loc, info, nullptr);
+}
+
+/*
+  given a location, calculate the 32x28 grid SW corner, plus the
+  grid indices. The SW corner is taken from neighbour if it is in the
+  same grid, saving the Location::offset() call
+ */
+void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info, const struct grid_info *neighbour) const
 {
     // grids start on integer degrees. This makes storing terrain data
     // on the SD card a bit easier
@@ -92,10 +102,19 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
     info.frac_y = (offset.y - idx_y * grid_spacing) / grid_spacing;
 
     // calculate lat/lon of SW corner of 32*28 grid_block
-    ref.offset(info.grid_idx_x * TERRAIN_GRID_BLOCK_SPACING_X * (float)grid_spacing,
-               info.grid_idx_y * TERRAIN_GRID_BLOCK_SPACING_Y * (float)grid_spacing);
-    info.grid_lat = ref.lat;
-    info.grid_lon = ref.lng;
+    if (neighbour != nullptr &&
+        neighbour->lat_degrees == info.lat_degrees &&
+        neighbour->lon_degrees == info.lon_degrees &&
+        neighbour->grid_idx_x == info.grid_idx_x &&
+        neighbour->grid_idx_y == info.grid_idx_y) {
+        info.grid_lat = neighbour->grid_lat;
+        info.grid_lon = neighbour->grid_lon;
+    } else {
+        ref.offset(info.grid_idx_x * TERRAIN_GRID_BLOCK_SPACING_X * (float)grid_spacing,
+                   info.grid_idx_y * TERRAIN_GRID_BLOCK_SPACING_Y * (float)grid_spacing);
+        info.grid_lat = ref.lat;
+        info.grid_lon = ref.lng;
+    }
 
     ASSERT_RANGE(info.idx_x,0,TERRAIN_GRID_BLOCK_SPACING_X-1);
     ASSERT_RANGE(info.idx_y,0,TERRAIN_GRID_BLOCK_SPACING_Y-1);
@@ -104,30 +123,123 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
 }
 
 
+/*
+  remove a cache entry from the LRU list
+ */
+void AP_Terrain::lru_unlink(uint8_t idx)
+{
+    struct grid_cache &c = cache[idx];
+    if (c.lru_prev != cache_none) {
+        cache[c.lru_prev].lru_next = c.lru_next;
+    } else {
+        lru_head = c.lru_next;
+    }
+    if (c.lru_next != cache_none) {
+        cache[c.lru_next].lru_prev = c.lru_prev;
+    } else {
+        lru_tail = c.lru_prev;
+    }
+    c.lru_prev = cache_none;
+    c.lru_next = cache_none;
+}
+
+/*
+  add a cache entry to the front of the LRU list
+ */
+void AP_Terrain::lru_push_front(uint8_t idx)
+{
+    struct grid_cache &c = cache[idx];
+    c.lru_prev = cache_none;
+    c.lru_next = lru_head;
+    if (lru_head != cache_none) {
+        cache[lru_head].lru_prev = idx;
+    } else {
+        lru_tail = idx;
+    }
+    lru_head = idx;
+}
+
+/*
+  mark a cache entry as the most recently used
+ */
+void AP_Terrain::lru_touch(uint8_t idx)
+{
+    if (idx == lru_head) {
+        return;
+    }
+    lru_unlink(idx);
+    lru_push_front(idx);
+}
+
+/*
+  choose the cache entry to replace. This is the least recently used
+  entry which does not have data waiting to be written to disk, or the
+  least recently used entry if they all do
+ */
+uint8_t AP_Terrain::lru_victim(void) const
+{
+    for (uint8_t i=lru_tail; i!=cache_none; i=cache[i].lru_prev) {
+        if (cache[i].state != GRID_CACHE_DIRTY) {
+            return i;
+        }
+    }
+    return lru_tail;
+}
+
+/*
+  hash bucket for a grid. The grid indices and degrees identify a grid
+  exactly, unlike the corner lat/lon which may differ by the margin
+ */
+uint8_t AP_Terrain::hash_bucket(const struct grid_info &info) const
+{
+    uint32_t h = info.grid_idx_x * 73856093U;
+    h ^= info.grid_idx_y * 19349663U;
+    h ^= uint32_t(int32_t(info.lat_degrees)) * 83492791U;
+    h ^= uint32_t(int32_t(info.lon_degrees)) * 50331653U;
+    return (h ^ (h >> 16)) & cache_hash_mask;
+}
+
+/*
+  remove a cache entry from its hash bucket
+ */
+void AP_Terrain::hash_remove(uint8_t idx)
+{
+    uint8_t *link = &cache_hash[cache[idx].hash_bucket];
+    while (*link != cache_none) {
+        if (*link == idx) {
+            *link = cache[idx].hash_next;
+            break;
+        }
+        link = &cache[*link].hash_next;
+    }
+    cache[idx].hash_next = cache_none;
+}
+
 /*
   find a grid structure given a grid_info
  */
 AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
 {
-    uint16_t oldest_i = 0;
+    const uint8_t bucket = hash_bucket(info);
 
     // see if we have that grid
-    for (uint16_t i=0; i<cache_size; i++) {
+    for (uint8_t i=cache_hash[bucket]; i!=cache_none; i=cache[i].hash_next) {
         if (TERRAIN_LATLON_EQUAL(cache[i].grid.lat,info.grid_lat) &&
             TERRAIN_LATLON_EQUAL(cache[i].grid.lon,info.grid_lon) &&
             cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = AP_HAL::millis();
+            lru_touch(i);
             return cache[i];
         }
-        if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
-            oldest_i = i;
-        }
     }
 
     // Not found. Use the oldest grid and make it this grid,
     // initially unpopulated
-    struct grid_cache &grid = cache[oldest_i];
-    memset(&grid, 0, sizeof(grid));
+    const uint8_t idx = lru_victim();
+    struct grid_cache &grid = cache[idx];
+    if (grid.state != GRID_CACHE_INVALID) {
+        hash_remove(idx);
+    }
+    memset(&grid.grid, 0, sizeof(grid.grid));
 
     grid.grid.lat = info.grid_lat;
     grid.grid.lon = info.grid_lon;
@@ -137,31 +249,35 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.lat_degrees = info.lat_degrees;
     grid.grid.lon_degrees = info.lon_degrees;
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
-    grid.last_access_ms = AP_HAL::millis();
 
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
 
+    grid.hash_bucket = bucket;
+    grid.hash_next = cache_hash[bucket];
+    cache_hash[bucket] = idx;
+    lru_touch(idx);
+
     return grid;
 }
 
 /*
-  find cache index of disk_block
+  find cache index of a block that has been read or written
  */
-int16_t AP_Terrain::find_io_idx(enum GridCacheState state)
+int16_t AP_Terrain::find_io_idx(const struct grid_block &block, enum GridCacheState state)
 {
     // try first with given state
     for (uint16_t i=0; i<cache_size; i++) {
-        if (TERRAIN_LATLON_EQUAL(disk_block.block.lat,cache[i].grid.lat) &&
-            TERRAIN_LATLON_EQUAL(disk_block.block.lon,cache[i].grid.lon) &&
+        if (TERRAIN_LATLON_EQUAL(block.lat,cache[i].grid.lat) &&
+            TERRAIN_LATLON_EQUAL(block.lon,cache[i].grid.lon) &&
             cache[i].state == state) {
             return i;
         }
     }    
     // then any state
     for (uint16_t i=0; i<cache_size; i++) {
-        if (TERRAIN_LATLON_EQUAL(disk_block.block.lat,cache[i].grid.lat) &&
-            TERRAIN_LATLON_EQUAL(disk_block.block.lon,cache[i].grid.lon)) {
+        if (TERRAIN_LATLON_EQUAL(block.lat,cache[i].grid.lat) &&
+            TERRAIN_LATLON_EQUAL(block.lon,cache[i].grid.lon)) {
             return i;
         }
     }    
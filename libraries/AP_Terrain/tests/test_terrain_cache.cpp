@@ -0,0 +1,278 @@
+#include <AP_gtest.h>
+
+#include <AP_AHRS/AP_AHRS.h>
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Terrain/AP_Terrain.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+// update() needs the home position from AHRS
+static AP_AHRS ahrs{AP_AHRS::FLAG_ALWAYS_USE_EKF};
+
+static AP_Terrain terrain;
+
+static const uint16_t grid_spacing = 100;
+
+// large enough for reads of 3 blocks at a time
+static const uint8_t cache_size = 48;
+
+// the degree square used by these tests, and its file
+static const int8_t test_lat_degrees = -38;
+static const int16_t test_lon_degrees = 147;
+static const char *test_file = HAL_BOARD_TERRAIN_DIRECTORY "/S38E147.DAT";
+
+// each block in a degree file takes 2048 bytes, and starts with
+static const uint32_t disk_block_size = 2048;
+struct PACKED disk_block_start {
+    uint64_t bitmap;
+    int32_t lat;
+    int32_t lon;
+};
+
+// configure the terrain before its cache is allocated, and remove
+// any file left by an earlier run
+static void setup_terrain()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    done = true;
+    AP::FS().unlink(test_file);
+    terrain.set_enabled(true);
+    AP_Param::set_object_value(&terrain, AP_Terrain::var_info, "SPACING", grid_spacing);
+    AP_Param::set_object_value(&terrain, AP_Terrain::var_info, "CACHE_SZ", cache_size);
+}
+
+// south west corner of a grid block, counting blocks north and east
+// from the corner of the test degree square, as a GCS works it out
+static Location block_corner(uint16_t north, uint16_t east)
+{
+    Location loc;
+    loc.lat = test_lat_degrees * 10 * 1000 * 1000L;
+    loc.lng = test_lon_degrees * 10 * 1000 * 1000L;
+    loc.offset(north * TERRAIN_GRID_BLOCK_SPACING_X * (float)grid_spacing,
+               east * TERRAIN_GRID_BLOCK_SPACING_Y * (float)grid_spacing);
+    return loc;
+}
+
+// a location in the middle of a grid block
+static Location block_middle(uint16_t north, uint16_t east)
+{
+    Location loc = block_corner(north, east);
+    loc.offset(0.5 * TERRAIN_GRID_BLOCK_SPACING_X * grid_spacing,
+               0.5 * TERRAIN_GRID_BLOCK_SPACING_Y * grid_spacing);
+    return loc;
+}
+
+// send all of a grid block from the GCS, at a single height
+static void send_block(uint16_t north, uint16_t east, int16_t height)
+{
+    const Location corner = block_corner(north, east);
+    int16_t data[TERRAIN_GRID_MAVLINK_SIZE * TERRAIN_GRID_MAVLINK_SIZE];
+    for (auto &d : data) {
+        d = height;
+    }
+    for (uint8_t gridbit=0; gridbit<TERRAIN_GRID_BLOCK_MUL_X*TERRAIN_GRID_BLOCK_MUL_Y; gridbit++) {
+        mavlink_message_t msg;
+        mavlink_msg_terrain_data_pack(1, 1, &msg, corner.lat, corner.lng, grid_spacing, gridbit, data);
+        terrain.handle_terrain_data(msg);
+    }
+}
+
+// height in the middle of a block, which also makes it the most
+// recently used block
+static bool block_height(uint16_t north, uint16_t east, float &height)
+{
+    return terrain.height_amsl(block_middle(north, east), height, false);
+}
+
+// run the main thread and IO thread sides of the disk IO until all
+// reads and writes are done
+static void run_disk_io()
+{
+    for (uint8_t i=0; i<100; i++) {
+        terrain.update();
+        terrain.io_timer();
+    }
+}
+
+// put a row of blocks in the degree file, a few at a time so none
+// are pushed out of the cache before they are written
+static void write_row(uint16_t north, uint8_t count, int16_t height)
+{
+    float h;
+    for (uint8_t east=0; east<count; east++) {
+        block_height(north, east, h);
+        send_block(north, east, height + east);
+        if (east % 8 == 7) {
+            run_disk_io();
+        }
+    }
+    run_disk_io();
+}
+
+// make a block in the degree file bad, by changing its latitude
+static void corrupt_block(uint16_t north, uint16_t east)
+{
+    const Location corner = block_corner(north, east);
+    const int fd = AP::FS().open(test_file, O_RDWR);
+    ASSERT_NE(-1, fd);
+    struct disk_block_start start;
+    bool found = false;
+    for (uint32_t ofs=0; AP::FS().lseek(fd, ofs, SEEK_SET) == (int32_t)ofs &&
+             AP::FS().read(fd, &start, sizeof(start)) == sizeof(start); ofs += disk_block_size) {
+        if (labs(start.lat - corner.lat) < 100 && labs(start.lon - corner.lng) < 100) {
+            start.lat += 1000000;
+            AP::FS().lseek(fd, ofs, SEEK_SET);
+            EXPECT_EQ((int32_t)sizeof(start), AP::FS().write(fd, &start, sizeof(start)));
+            found = true;
+            break;
+        }
+    }
+    AP::FS().close(fd);
+    EXPECT_TRUE(found);
+}
+
+// fill the cache with rows of blocks which have no data, in a known
+// order
+static void fill_cache(uint16_t north)
+{
+    float height;
+    for (uint8_t i=0; i<cache_size; i++) {
+        block_height(north + i / 8, i % 8, height);
+    }
+    run_disk_io();
+}
+
+// blocks which stay in the cache are those a least recently used
+// cache would keep
+TEST(AP_Terrain, cache_is_least_recently_used)
+{
+    setup_terrain();
+
+    // a pool of blocks larger than the cache, all in the degree file
+    static const uint8_t pool_rows = 8;
+    static const uint8_t pool_size = pool_rows * 8;
+    for (uint8_t north=0; north<pool_rows; north++) {
+        write_row(north, 8, 100 * north);
+    }
+
+    // the cached blocks from least to most recently used, and whether
+    // they have been read from disk
+    uint16_t lru[cache_size];
+    bool loaded[cache_size];
+    fill_cache(10);
+    for (uint8_t i=0; i<cache_size; i++) {
+        lru[i] = 1000 + i;
+        loaded[i] = true;
+    }
+
+    for (uint16_t step=0; step<5000; step++) {
+        if (get_random16() % 16 == 0) {
+            run_disk_io();
+            for (auto &l : loaded) {
+                l = true;
+            }
+            continue;
+        }
+
+        const uint16_t block = get_random16() % pool_size;
+        uint8_t i;
+        for (i=0; i<cache_size && lru[i] != block; i++) {
+        }
+        bool expected;
+        if (i == cache_size) {
+            // a miss pushes out the least recently used block
+            i = 0;
+            loaded[0] = false;
+            expected = false;
+        } else {
+            expected = loaded[i];
+        }
+        const bool was_loaded = loaded[i];
+        memmove(&lru[i], &lru[i+1], (cache_size-1-i) * sizeof(lru[0]));
+        memmove(&loaded[i], &loaded[i+1], (cache_size-1-i) * sizeof(loaded[0]));
+        lru[cache_size-1] = block;
+        loaded[cache_size-1] = was_loaded;
+
+        const uint16_t north = block / 8;
+        const uint16_t east = block % 8;
+        float height;
+        ASSERT_EQ(expected, block_height(north, east, height)) << "step " << step << " block " << block;
+        if (expected) {
+            EXPECT_FLOAT_EQ(100 * north + east, height);
+        }
+    }
+    run_disk_io();
+}
+
+// blocks with data waiting to be written are kept while other blocks
+// can be pushed out instead
+TEST(AP_Terrain, dirty_blocks_not_evicted)
+{
+    setup_terrain();
+    fill_cache(16);
+
+    float height;
+    for (uint8_t east=0; east<8; east++) {
+        block_height(22, east, height);
+        send_block(22, east, 300 + east);
+    }
+
+    // twice the cache size of lookups with no disk IO
+    for (uint8_t i=0; i<2*cache_size; i++) {
+        block_height(23 + i / 8, i % 8, height);
+    }
+    for (uint8_t east=0; east<8; east++) {
+        ASSERT_TRUE(block_height(22, east, height));
+        EXPECT_FLOAT_EQ(300 + east, height);
+    }
+
+    // and once written they read back
+    run_disk_io();
+    fill_cache(16);
+    for (uint8_t east=0; east<8; east++) {
+        EXPECT_FALSE(block_height(22, east, height));
+    }
+    run_disk_io();
+    for (uint8_t east=0; east<8; east++) {
+        ASSERT_TRUE(block_height(22, east, height));
+        EXPECT_FLOAT_EQ(300 + east, height);
+    }
+}
+
+// blocks next to each other in the degree file are read together, and
+// a bad block among them is read as empty without losing the others
+TEST(AP_Terrain, batched_read_with_bad_block)
+{
+    setup_terrain();
+    write_row(36, 3, 500);
+    corrupt_block(36, 1);
+    fill_cache(16);
+
+    float height;
+    for (uint8_t east=0; east<3; east++) {
+        EXPECT_FALSE(block_height(36, east, height));
+    }
+
+    // a single read
+    terrain.update();
+    terrain.io_timer();
+    terrain.update();
+
+    ASSERT_TRUE(block_height(36, 0, height));
+    EXPECT_FLOAT_EQ(500, height);
+    EXPECT_FALSE(block_height(36, 1, height));
+    ASSERT_TRUE(block_height(36, 2, height));
+    EXPECT_FLOAT_EQ(502, height);
+}
+
+AP_GTEST_MAIN()
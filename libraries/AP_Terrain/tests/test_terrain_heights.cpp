@@ -0,0 +1,173 @@
+#include <AP_gtest.h>
+#include <AP_gtest_random.h>
+
+#include <AP_AHRS/AP_AHRS.h>
+#include <AP_Terrain/AP_Terrain.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+// update() needs the home position from AHRS
+static AP_AHRS ahrs{AP_AHRS::FLAG_ALWAYS_USE_EKF};
+
+static AP_Terrain terrain;
+
+static const uint16_t grid_spacing = 100;
+static const uint8_t cache_size = 16;
+
+// the degree square used by these tests. The test area is 2 by 2
+// blocks, starting this many blocks from its south west corner
+static const int8_t test_lat_degrees = -36;
+static const int16_t test_lon_degrees = 149;
+static const uint16_t area_north = 10;
+static const uint16_t area_east = 10;
+static const uint8_t area_blocks = 2;
+
+// configure the terrain before its cache is allocated
+static void setup_terrain()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    done = true;
+    terrain.set_enabled(true);
+    AP_Param::set_object_value(&terrain, AP_Terrain::var_info, "SPACING", grid_spacing);
+    AP_Param::set_object_value(&terrain, AP_Terrain::var_info, "CACHE_SZ", cache_size);
+}
+
+// south west corner of a grid block, counting blocks north and east
+// from the corner of the test degree square, as a GCS works it out
+static Location block_corner(uint16_t north, uint16_t east)
+{
+    Location loc;
+    loc.lat = test_lat_degrees * 10 * 1000 * 1000L;
+    loc.lng = test_lon_degrees * 10 * 1000 * 1000L;
+    loc.offset(north * TERRAIN_GRID_BLOCK_SPACING_X * (float)grid_spacing,
+               east * TERRAIN_GRID_BLOCK_SPACING_Y * (float)grid_spacing);
+    return loc;
+}
+
+// location north and east of the south west corner of the test area
+static Location test_location(float north_m, float east_m)
+{
+    Location loc = block_corner(area_north, area_east);
+    loc.offset(north_m, east_m);
+    return loc;
+}
+
+// send a grid block from the GCS with made up heights, leaving out
+// the southern row of 4x4 squares so some of the heights are missing
+static void send_block(uint16_t north, uint16_t east)
+{
+    const Location corner = block_corner(north, east);
+
+    // the terrain only takes data for blocks it has looked up
+    Location middle = corner;
+    middle.offset(0.5 * TERRAIN_GRID_BLOCK_SPACING_X * grid_spacing,
+                  0.5 * TERRAIN_GRID_BLOCK_SPACING_Y * grid_spacing);
+    float height;
+    terrain.height_amsl(middle, height, false);
+
+    for (uint8_t gridbit=TERRAIN_GRID_BLOCK_MUL_Y; gridbit<TERRAIN_GRID_BLOCK_MUL_X*TERRAIN_GRID_BLOCK_MUL_Y; gridbit++) {
+        int16_t data[TERRAIN_GRID_MAVLINK_SIZE * TERRAIN_GRID_MAVLINK_SIZE];
+        for (uint8_t x=0; x<TERRAIN_GRID_MAVLINK_SIZE; x++) {
+            for (uint8_t y=0; y<TERRAIN_GRID_MAVLINK_SIZE; y++) {
+                const int32_t gx = north * TERRAIN_GRID_BLOCK_SPACING_X + (gridbit / TERRAIN_GRID_BLOCK_MUL_Y) * TERRAIN_GRID_MAVLINK_SIZE + x;
+                const int32_t gy = east * TERRAIN_GRID_BLOCK_SPACING_Y + (gridbit % TERRAIN_GRID_BLOCK_MUL_Y) * TERRAIN_GRID_MAVLINK_SIZE + y;
+                data[x*TERRAIN_GRID_MAVLINK_SIZE + y] = 300 + (gx * 37 + gy * 11) % 250;
+            }
+        }
+        mavlink_message_t msg;
+        mavlink_msg_terrain_data_pack(1, 1, &msg, corner.lat, corner.lng, grid_spacing, gridbit, data);
+        terrain.handle_terrain_data(msg);
+    }
+}
+
+// send all the blocks of the test area
+static void fill_area()
+{
+    setup_terrain();
+    for (uint8_t north=0; north<area_blocks; north++) {
+        for (uint8_t east=0; east<area_blocks; east++) {
+            send_block(area_north + north, area_east + east);
+        }
+    }
+}
+
+// check each batch height against a height_amsl() call for the same point
+static void check_heights(const Location *locs, uint16_t count, const float *heights, const bool *valid, bool corrected)
+{
+    for (uint16_t i=0; i<count; i++) {
+        float height;
+        const bool have = terrain.height_amsl(locs[i], height, corrected);
+        EXPECT_EQ(valid[i], have);
+        if (have) {
+            EXPECT_FLOAT_EQ(heights[i], height);
+        } else {
+            EXPECT_EQ(heights[i], 0);
+        }
+    }
+}
+
+// size of the test area in meters
+static const float area_north_m = area_blocks * TERRAIN_GRID_BLOCK_SPACING_X * grid_spacing;
+static const float area_east_m = area_blocks * TERRAIN_GRID_BLOCK_SPACING_Y * grid_spacing;
+
+// heights for a scattered set of points match height_amsl() one at a time
+TEST(AP_Terrain, heights_amsl_matches_height_amsl)
+{
+    fill_area();
+
+    const uint16_t count = 50;
+    Location locs[count];
+    for (uint16_t i=0; i<count; i++) {
+        locs[i] = test_location(area_north_m * 0.5f * (1 + test_rand(0.99f)),
+                                area_east_m * 0.5f * (1 + test_rand(0.99f)));
+    }
+
+    for (const bool corrected : { false, true }) {
+        float heights[count];
+        bool valid[count];
+        const uint16_t found = terrain.heights_amsl(locs, count, heights, valid, corrected);
+        uint16_t num_valid = 0;
+        for (uint16_t i=0; i<count; i++) {
+            num_valid += valid[i];
+        }
+        EXPECT_EQ(found, num_valid);
+        EXPECT_GT(found, 0);
+        EXPECT_LT(found, count);
+        check_heights(locs, count, heights, valid, corrected);
+    }
+}
+
+// heights along a line crossing several blocks match height_amsl()
+// at each of the evenly spaced points
+TEST(AP_Terrain, heights_amsl_along_matches_height_amsl)
+{
+    fill_area();
+
+    const Location start = test_location(100, 50);
+    const Location end = test_location(area_north_m - 100, area_east_m - 50);
+    const uint16_t count = 40;
+    float heights[count];
+    bool valid[count];
+    const uint16_t found = terrain.heights_amsl_along(start, end, count, heights, valid);
+    EXPECT_GT(found, 0);
+
+    Location locs[count];
+    for (uint16_t i=0; i<count; i++) {
+        locs[i].lat = start.lat + int64_t(end.lat - start.lat) * i / (count-1);
+        locs[i].lng = start.lng + int64_t(end.lng - start.lng) * i / (count-1);
+    }
+    EXPECT_EQ(locs[0].lat, start.lat);
+    EXPECT_EQ(locs[count-1].lng, end.lng);
+    check_heights(locs, count, heights, valid, true);
+}
+
+AP_GTEST_MAIN()
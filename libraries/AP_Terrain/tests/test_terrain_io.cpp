@@ -0,0 +1,172 @@
+#include <AP_gtest.h>
+
+#include <AP_AHRS/AP_AHRS.h>
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <AP_Terrain/AP_Terrain.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+const struct AP_Param::GroupInfo        GCS_MAVLINK_Parameters::var_info[] = {
+    AP_GROUPEND
+};
+GCS_Dummy _gcs;
+
+// update() needs the home position from AHRS
+static AP_AHRS ahrs{AP_AHRS::FLAG_ALWAYS_USE_EKF};
+
+static AP_Terrain terrain;
+
+static const uint16_t grid_spacing = 100;
+static const uint8_t cache_size = 16;
+
+// the degree square used by these tests, and its file
+static const int8_t test_lat_degrees = -37;
+static const int16_t test_lon_degrees = 148;
+static const char *test_file = HAL_BOARD_TERRAIN_DIRECTORY "/S37E148.DAT";
+
+// configure the terrain before its cache is allocated, and remove
+// any file left by an earlier run
+static void setup_terrain()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    done = true;
+    AP::FS().unlink(test_file);
+    terrain.set_enabled(true);
+    AP_Param::set_object_value(&terrain, AP_Terrain::var_info, "SPACING", grid_spacing);
+    AP_Param::set_object_value(&terrain, AP_Terrain::var_info, "CACHE_SZ", cache_size);
+}
+
+// south west corner of a grid block, counting blocks north and east
+// from the corner of the test degree square, as a GCS works it out
+static Location block_corner(uint16_t north, uint16_t east)
+{
+    Location loc;
+    loc.lat = test_lat_degrees * 10 * 1000 * 1000L;
+    loc.lng = test_lon_degrees * 10 * 1000 * 1000L;
+    loc.offset(north * TERRAIN_GRID_BLOCK_SPACING_X * (float)grid_spacing,
+               east * TERRAIN_GRID_BLOCK_SPACING_Y * (float)grid_spacing);
+    return loc;
+}
+
+// a location in the middle of a grid block
+static Location block_middle(uint16_t north, uint16_t east)
+{
+    Location loc = block_corner(north, east);
+    loc.offset(0.5 * TERRAIN_GRID_BLOCK_SPACING_X * grid_spacing,
+               0.5 * TERRAIN_GRID_BLOCK_SPACING_Y * grid_spacing);
+    return loc;
+}
+
+// send all of a grid block from the GCS, at a single height
+static void send_block(uint16_t north, uint16_t east, int16_t height)
+{
+    const Location corner = block_corner(north, east);
+    int16_t data[TERRAIN_GRID_MAVLINK_SIZE * TERRAIN_GRID_MAVLINK_SIZE];
+    for (auto &d : data) {
+        d = height;
+    }
+    for (uint8_t gridbit=0; gridbit<TERRAIN_GRID_BLOCK_MUL_X*TERRAIN_GRID_BLOCK_MUL_Y; gridbit++) {
+        mavlink_message_t msg;
+        mavlink_msg_terrain_data_pack(1, 1, &msg, corner.lat, corner.lng, grid_spacing, gridbit, data);
+        terrain.handle_terrain_data(msg);
+    }
+}
+
+// height in the middle of a block, which also makes it the most
+// recently used block
+static bool block_height(uint16_t north, uint16_t east, float &height)
+{
+    return terrain.height_amsl(block_middle(north, east), height, false);
+}
+
+// run the main thread and IO thread sides of the disk IO until all
+// reads and writes are done
+static void run_disk_io()
+{
+    for (uint8_t i=0; i<100; i++) {
+        terrain.update();
+        terrain.io_timer();
+    }
+}
+
+// push blocks out of the cache by looking up a full cache of others,
+// starting at a row of blocks not used before
+static void evict_blocks(uint16_t north)
+{
+    float height;
+    for (uint8_t i=0; i<cache_size; i++) {
+        block_height(north + i / 8, i % 8, height);
+    }
+}
+
+// blocks from the GCS are written to the degree file and read back
+// from it once they have left the cache
+TEST(AP_Terrain, blocks_written_and_read_back)
+{
+    setup_terrain();
+    float height;
+    for (uint8_t east=0; east<3; east++) {
+        EXPECT_FALSE(block_height(0, east, height));
+    }
+    run_disk_io();
+    for (uint8_t east=0; east<3; east++) {
+        // nothing on disk yet
+        EXPECT_FALSE(block_height(0, east, height));
+        send_block(0, east, 100 + east);
+        ASSERT_TRUE(block_height(0, east, height));
+        EXPECT_FLOAT_EQ(100 + east, height);
+    }
+    run_disk_io();
+
+    struct stat st;
+    ASSERT_EQ(0, AP::FS().stat(test_file, &st));
+    EXPECT_GE(st.st_size, 3 * 2048);
+
+    evict_blocks(10);
+    for (uint8_t east=0; east<3; east++) {
+        EXPECT_FALSE(block_height(0, east, height));
+    }
+    run_disk_io();
+    for (uint8_t east=0; east<3; east++) {
+        ASSERT_TRUE(block_height(0, east, height));
+        EXPECT_FLOAT_EQ(100 + east, height);
+    }
+}
+
+// data which arrives from the GCS while a block is being read is
+// newer than the copy on disk, and is kept
+TEST(AP_Terrain, gcs_data_during_read_is_kept)
+{
+    setup_terrain();
+    float height;
+    block_height(2, 0, height);
+    run_disk_io();
+    send_block(2, 0, 50);
+    run_disk_io();
+    evict_blocks(12);
+    run_disk_io();
+
+    // start the read of the old block, then get new data for it
+    EXPECT_FALSE(block_height(2, 0, height));
+    terrain.update();
+    send_block(2, 0, 70);
+    terrain.io_timer();
+    terrain.update();
+    ASSERT_TRUE(block_height(2, 0, height));
+    EXPECT_FLOAT_EQ(70, height);
+
+    // and the new data is written out
+    run_disk_io();
+    evict_blocks(14);
+    run_disk_io();
+    EXPECT_FALSE(block_height(2, 0, height));
+    run_disk_io();
+    ASSERT_TRUE(block_height(2, 0, height));
+    EXPECT_FLOAT_EQ(70, height);
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,316 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HAL_DEBUG_BUILD
+#define AP_INLINE_VECTOR_OPS
+#pragma GCC optimize("O2")
+#endif
+
+#include "BiquadCascade.h"
+
+#if AP_FILTER_BIQUAD_SIMD
+#if defined(__SSE__)
+#include <xmmintrin.h>
+typedef __m128 v4f;
+static inline v4f v4f_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void v4f_store(float *p, v4f v) { _mm_storeu_ps(p, v); }
+static inline v4f v4f_set(float x, float y, float z) { return _mm_set_ps(0, z, y, x); }
+static inline v4f v4f_mul(v4f a, float b) { return _mm_mul_ps(a, _mm_set1_ps(b)); }
+static inline v4f v4f_add(v4f a, v4f b) { return _mm_add_ps(a, b); }
+static inline v4f v4f_sub(v4f a, v4f b) { return _mm_sub_ps(a, b); }
+#else
+#include <arm_neon.h>
+typedef float32x4_t v4f;
+static inline v4f v4f_load(const float *p) { return vld1q_f32(p); }
+static inline void v4f_store(float *p, v4f v) { vst1q_f32(p, v); }
+static inline v4f v4f_set(float x, float y, float z) { const float v[4] { x, y, z, 0 }; return vld1q_f32(v); }
+static inline v4f v4f_mul(v4f a, float b) { return vmulq_n_f32(a, b); }
+static inline v4f v4f_add(v4f a, v4f b) { return vaddq_f32(a, b); }
+static inline v4f v4f_sub(v4f a, v4f b) { return vsubq_f32(a, b); }
+#endif
+#endif // AP_FILTER_BIQUAD_SIMD
+
+// floats per stage: the previous value then the one before, 4 lanes each
+#define STAGE_FLOATS 8
+
+BiquadCascadeVector3f::~BiquadCascadeVector3f()
+{
+    delete[] _sections;
+    delete[] _state;
+}
+
+bool BiquadCascadeVector3f::allocate(uint8_t max_sections)
+{
+    delete[] _sections;
+    delete[] _state;
+    _num_sections = 0;
+    _max_sections = 0;
+
+    _sections = new section[max_sections];
+    _state = new float[(max_sections+1) * STAGE_FLOATS];
+    if (_sections == nullptr || _state == nullptr) {
+        delete[] _sections;
+        delete[] _state;
+        _sections = nullptr;
+        _state = nullptr;
+        return false;
+    }
+    _max_sections = max_sections;
+    reset();
+    return true;
+}
+
+/*
+  sin(k*pi/64) for k from 0 to 32, the first quarter of a sine wave
+ */
+static const float quarter_sine[33] = {
+    0.000000000f, 0.049067674f, 0.098017140f, 0.146730474f, 0.195090322f,
+    0.242980180f, 0.290284677f, 0.336889853f, 0.382683432f, 0.427555093f,
+    0.471396737f, 0.514102744f, 0.555570233f, 0.595699304f, 0.634393284f,
+    0.671558955f, 0.707106781f, 0.740951125f, 0.773010453f, 0.803207531f,
+    0.831469612f, 0.857728610f, 0.881921264f, 0.903989293f, 0.923879533f,
+    0.941544065f, 0.956940336f, 0.970031253f, 0.980785280f, 0.989176510f,
+    0.995184727f, 0.998795456f, 1.000000000f,
+};
+
+/*
+  sine and cosine of an angle from 0 to pi. The nearest table entry
+  below the angle is rotated by the remaining angle, less than pi/64,
+  using short Taylor series, which is within a few parts in 10^7 of
+  sinf() and cosf() for far fewer cycles on an MCU
+ */
+static void notch_sincos(float omega, float &s, float &c)
+{
+    const float step = M_PI / 64;
+    const uint8_t k = MIN(uint8_t(omega * (1.0f / step)), 63U);
+    const float d = omega - k * step;
+    const float d2 = d * d;
+    const float sin_d = d * (1.0f - d2 * (1.0f / 6));
+    const float cos_d = 1.0f - d2 * (0.5f - d2 * (1.0f / 24));
+    const float sin_k = k <= 32 ? quarter_sine[k] : quarter_sine[64 - k];
+    const float cos_k = k <= 32 ? quarter_sine[32 - k] : -quarter_sine[k - 32];
+    s = sin_k * cos_d + cos_k * sin_d;
+    c = cos_k * cos_d - sin_k * sin_d;
+}
+
+/*
+  set a section to a notch. This is the design from
+  NotchFilter::init_with_A_and_Q() with the coefficients divided by a0
+ */
+bool BiquadCascadeVector3f::set_notch(uint8_t idx, float sample_freq_hz, float center_freq_hz, float A, float Q)
+{
+    if (idx >= _max_sections ||
+        !(center_freq_hz > 0.0) || !(center_freq_hz < 0.5 * sample_freq_hz) || !(Q > 0.0)) {
+        return false;
+    }
+    // all in single precision, this runs for every notch that moves
+    const float omega = float(2 * M_PI) * center_freq_hz / sample_freq_hz;
+    float sin_omega, cos_omega;
+    notch_sincos(omega, sin_omega, cos_omega);
+    const float alpha = sin_omega / (2 * Q);
+    const float a0_inv = 1.0f / (1.0f + alpha);
+    const float alpha_A2 = alpha * sq(A);
+    section &s = _sections[idx];
+    s.b0 = (1.0f + alpha_A2) * a0_inv;
+    s.b1 = -2.0f * cos_omega * a0_inv;
+    s.b2 = (1.0f - alpha_A2) * a0_inv;
+    s.a1 = s.b1;
+    s.a2 = (1.0f - alpha) * a0_inv;
+    return true;
+}
+
+void BiquadCascadeVector3f::set_num_sections(uint8_t num_sections)
+{
+    _num_sections = MIN(num_sections, _max_sections);
+}
+
+void BiquadCascadeVector3f::reset(void)
+{
+    if (_state != nullptr) {
+        memset(_state, 0, (_max_sections+1) * STAGE_FLOATS * sizeof(float));
+    }
+}
+
+/*
+  run the sample through each section in turn. The delayed outputs of
+  section n are the delayed inputs of section n+1, so they are loaded
+  once and carried into the next section
+ */
+Vector3f BiquadCascadeVector3f::apply(const Vector3f &sample)
+{
+    if (_num_sections == 0) {
+        return sample;
+    }
+
+#if AP_FILTER_BIQUAD_SIMD
+    float *stage = _state;
+    v4f x = v4f_set(sample.x, sample.y, sample.z);
+    v4f x1 = v4f_load(&stage[0]);
+    v4f x2 = v4f_load(&stage[4]);
+    for (uint8_t i = 0; i < _num_sections; i++) {
+        const section &s = _sections[i];
+        float *next = stage + STAGE_FLOATS;
+        const v4f y1 = v4f_load(&next[0]);
+        const v4f y2 = v4f_load(&next[4]);
+        v4f y = v4f_mul(x, s.b0);
+        y = v4f_add(y, v4f_mul(x1, s.b1));
+        y = v4f_add(y, v4f_mul(x2, s.b2));
+        y = v4f_sub(y, v4f_mul(y1, s.a1));
+        y = v4f_sub(y, v4f_mul(y2, s.a2));
+        v4f_store(&stage[4], x1);
+        v4f_store(&stage[0], x);
+        x = y;
+        x1 = y1;
+        x2 = y2;
+        stage = next;
+    }
+    v4f_store(&stage[4], x1);
+    v4f_store(&stage[0], x);
+
+    // the output is now the latest value of the last stage
+    return Vector3f(stage[0], stage[1], stage[2]);
+#else
+    Vector3f output;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        float *stage = &_state[axis];
+        float x = sample[axis];
+        float x1 = stage[0];
+        float x2 = stage[4];
+        for (uint8_t i = 0; i < _num_sections; i++) {
+            const section &s = _sections[i];
+            float *next = stage + STAGE_FLOATS;
+            const float y1 = next[0];
+            const float y2 = next[4];
+            const float y = x*s.b0 + x1*s.b1 + x2*s.b2 - y1*s.a1 - y2*s.a2;
+            stage[4] = x1;
+            stage[0] = x;
+            x = y;
+            x1 = y1;
+            x2 = y2;
+            stage = next;
+        }
+        stage[4] = x1;
+        stage[0] = x;
+        output[axis] = x;
+    }
+    return output;
+#endif
+}
+
+void BiquadCascadeVector3f::apply(Vector3f *samples, uint16_t n)
+{
+    if (_num_sections == 0) {
+        return;
+    }
+    while (n > 0) {
+        const uint8_t len = MIN(n, uint16_t(block_len));
+        apply_block(samples, len);
+        samples += len;
+        n -= len;
+    }
+}
+
+/*
+  run a block through one section at a time, keeping the section
+  coefficients and delayed values in registers. The arithmetic is the
+  same as apply() so the results match sample by sample
+ */
+void BiquadCascadeVector3f::apply_block(Vector3f *samples, uint8_t n)
+{
+#if AP_FILTER_BIQUAD_SIMD
+    v4f buf[block_len];
+    for (uint8_t k = 0; k < n; k++) {
+        buf[k] = v4f_set(samples[k].x, samples[k].y, samples[k].z);
+    }
+    float *stage = _state;
+    v4f x1 = v4f_load(&stage[0]);
+    v4f x2 = v4f_load(&stage[4]);
+    v4f y1 = x1;
+    v4f y2 = x2;
+    for (uint8_t i = 0; i < _num_sections; i++) {
+        const section &s = _sections[i];
+        float *next = stage + STAGE_FLOATS;
+        y1 = v4f_load(&next[0]);
+        y2 = v4f_load(&next[4]);
+        // the delayed outputs from before the block are the delayed
+        // inputs of the next section
+        const v4f next_x1 = y1;
+        const v4f next_x2 = y2;
+        for (uint8_t k = 0; k < n; k++) {
+            v4f y = v4f_mul(buf[k], s.b0);
+            y = v4f_add(y, v4f_mul(x1, s.b1));
+            y = v4f_add(y, v4f_mul(x2, s.b2));
+            y = v4f_sub(y, v4f_mul(y1, s.a1));
+            y = v4f_sub(y, v4f_mul(y2, s.a2));
+            x2 = x1;
+            x1 = buf[k];
+            y2 = y1;
+            y1 = y;
+            buf[k] = y;
+        }
+        v4f_store(&stage[0], x1);
+        v4f_store(&stage[4], x2);
+        x1 = next_x1;
+        x2 = next_x2;
+        stage = next;
+    }
+    v4f_store(&stage[0], y1);
+    v4f_store(&stage[4], y2);
+
+    float out[4];
+    for (uint8_t k = 0; k < n; k++) {
+        v4f_store(out, buf[k]);
+        samples[k] = Vector3f(out[0], out[1], out[2]);
+    }
+#else
+    float buf[block_len];
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        for (uint8_t k = 0; k < n; k++) {
+            buf[k] = samples[k][axis];
+        }
+        float *stage = &_state[axis];
+        float x1 = stage[0];
+        float x2 = stage[4];
+        float y1 = x1;
+        float y2 = x2;
+        for (uint8_t i = 0; i < _num_sections; i++) {
+            const section &s = _sections[i];
+            float *next = stage + STAGE_FLOATS;
+            y1 = next[0];
+            y2 = next[4];
+            const float next_x1 = y1;
+            const float next_x2 = y2;
+            for (uint8_t k = 0; k < n; k++) {
+                const float y = buf[k]*s.b0 + x1*s.b1 + x2*s.b2 - y1*s.a1 - y2*s.a2;
+                x2 = x1;
+                x1 = buf[k];
+                y2 = y1;
+                y1 = y;
+                buf[k] = y;
+            }
+            stage[0] = x1;
+            stage[4] = x2;
+            x1 = next_x1;
+            x2 = next_x2;
+            stage = next;
+        }
+        stage[0] = y1;
+        stage[4] = y2;
+        for (uint8_t k = 0; k < n; k++) {
+            samples[k][axis] = buf[k];
+        }
+    }
+#endif
+}
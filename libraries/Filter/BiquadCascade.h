@@ -0,0 +1,89 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  a cascade of biquad sections applied to all three axes of a vector
+  at once.
+
+  The sections use the same direct form I arithmetic as NotchFilter,
+  which copes well with the coefficients changing every loop as a
+  dynamic notch tracks. Because the output of one section is the input
+  of the next, the cascade only keeps one pair of delayed values per
+  stage rather than two per section. Each stage is stored as 4 floats
+  (x, y, z and a pad) so the axes are filtered together with SSE or
+  NEON where available, falling back to scalar code elsewhere
+ */
+
+#include <AP_Math/AP_Math.h>
+
+#ifndef AP_FILTER_BIQUAD_SIMD
+#if defined(__SSE__) || defined(__ARM_NEON)
+#define AP_FILTER_BIQUAD_SIMD 1
+#else
+#define AP_FILTER_BIQUAD_SIMD 0
+#endif
+#endif
+
+class BiquadCascadeVector3f {
+public:
+    BiquadCascadeVector3f() {}
+    ~BiquadCascadeVector3f();
+
+    CLASS_NO_COPY(BiquadCascadeVector3f);
+
+    // allocate space for up to max_sections sections
+    bool allocate(uint8_t max_sections);
+
+    // set a section to a notch, using the same design as NotchFilter
+    // returns false if the notch is not valid for the sample rate
+    bool set_notch(uint8_t idx, float sample_freq_hz, float center_freq_hz, float A, float Q);
+
+    // set the number of sections applied, from the first
+    void set_num_sections(uint8_t num_sections);
+    uint8_t num_sections(void) const { return _num_sections; }
+
+    // apply a new input sample, returning the output of the last section
+    Vector3f apply(const Vector3f &sample);
+
+    // apply a block of samples in place, one section at a time. The
+    // results are the same as applying each sample in turn
+    void apply(Vector3f *samples, uint16_t n);
+
+    // zero all delayed values
+    void reset(void);
+
+private:
+    // samples run through all sections per call of apply_block(). The
+    // block is buffered on the stack, which may be a small IMU thread
+    static const uint8_t block_len = 8;
+    void apply_block(Vector3f *samples, uint8_t n);
+
+    // coefficients normalised so that a0 is 1
+    struct section {
+        float b0, b1, b2, a1, a2;
+    };
+
+    section *_sections = nullptr;
+    uint8_t _max_sections = 0;
+    uint8_t _num_sections = 0;
+
+    /*
+      delayed values for each stage, where stage 0 is the input and
+      stage n is the output of section n-1. Each stage is the previous
+      value then the one before that, each as x, y, z and a pad
+     */
+    float *_state = nullptr;
+};
@@ -98,7 +98,9 @@ const AP_Param::GroupInfo HarmonicNotchFilterParams::var_info[] = {
  */
 template <class T>
 HarmonicNotchFilter<T>::~HarmonicNotchFilter() {
-    delete[] _filters;
+    delete[] _section_freq_hz;
+    delete[] _target_freq_hz;
+    delete[] _section_notch;
     _num_filters = 0;
     _num_enabled_filters = 0;
 }
@@ -111,7 +113,7 @@ template <class T>
 void HarmonicNotchFilter<T>::init(float sample_freq_hz, float center_freq_hz, float bandwidth_hz, float attenuation_dB)
 {
     // sanity check the input
-    if (_filters == nullptr || is_zero(sample_freq_hz) || isnan(sample_freq_hz)) {
+    if (_num_filters == 0 || is_zero(sample_freq_hz) || isnan(sample_freq_hz)) {
         return;
     }
 
@@ -133,6 +135,9 @@ void HarmonicNotchFilter<T>::init(float sample_freq_hz, float center_freq_hz, fl
         NotchFilter<T>::calculate_A_and_Q(center_freq_hz, bandwidth_hz, attenuation_dB, _A, _Q);
     }
 
+    // every filter needs new coefficients for the new A & Q
+    memset(_section_freq_hz, 0, sizeof(float) * _num_filters);
+
     _initialised = true;
     update(center_freq_hz);
 }
@@ -149,9 +154,15 @@ void HarmonicNotchFilter<T>::allocate_filters(uint8_t num_notches, uint8_t harmo
     _harmonics = harmonics;
 
     if (_num_filters > 0) {
-        _filters = new NotchFilter<T>[_num_filters];
-        if (_filters == nullptr) {
-            GCS_SEND_TEXT(MAV_SEVERITY_ERROR, "Failed to allocate %u bytes for notch filter", (unsigned int)(_num_filters * sizeof(NotchFilter<T>)));
+        delete[] _section_freq_hz;
+        delete[] _target_freq_hz;
+        delete[] _section_notch;
+        _section_freq_hz = new float[_num_filters];
+        _target_freq_hz = new float[_num_filters];
+        _section_notch = new uint8_t[_num_filters];
+        if (!_filters.allocate(_num_filters) || _section_freq_hz == nullptr || _target_freq_hz == nullptr ||
+            _section_notch == nullptr) {
+            GCS_SEND_TEXT(MAV_SEVERITY_ERROR, "Failed to allocate %u notch filters", (unsigned int)_num_filters);
             _num_filters = 0;
         }
     }
@@ -173,30 +184,23 @@ void HarmonicNotchFilter<T>::update(float center_freq_hz)
     center_freq_hz = constrain_float(center_freq_hz, 1.0f, nyquist_limit);
 
     _num_enabled_filters = 0;
+    _num_notches_set = 0;
+    _num_pending_sections = 0;
+
     // update all of the filters using the new center frequency and existing A & Q
     for (uint8_t i = 0; i < HNF_MAX_HARMONICS && _num_enabled_filters < _num_filters; i++) {
         if ((1U<<i) & _harmonics) {
             const float notch_center = center_freq_hz * (i+1);
             if (!_double_notch) {
-                // only enable the filter if its center frequency is below the nyquist frequency
-                if (notch_center < nyquist_limit) {
-                    _filters[_num_enabled_filters++].init_with_A_and_Q(_sample_freq_hz, notch_center, _A, _Q);
-                }
+                set_next_filter(notch_center, nyquist_limit);
             } else {
-                float notch_center_double;
-                // only enable the filter if its center frequency is below the nyquist frequency
-                notch_center_double = notch_center * (1.0 - _notch_spread);
-                if (notch_center_double < nyquist_limit) {
-                    _filters[_num_enabled_filters++].init_with_A_and_Q(_sample_freq_hz, notch_center_double, _A, _Q);
-                }
-                // only enable the filter if its center frequency is below the nyquist frequency
-                notch_center_double = notch_center * (1.0 + _notch_spread);
-                if (notch_center_double < nyquist_limit) {
-                    _filters[_num_enabled_filters++].init_with_A_and_Q(_sample_freq_hz, notch_center_double, _A, _Q);
-                }
+                set_next_filter(notch_center * (1.0 - _notch_spread), nyquist_limit);
+                set_next_filter(notch_center * (1.0 + _notch_spread), nyquist_limit);
             }
         }
     }
+
+    update_sections();
 }
 
 /*
@@ -214,35 +218,98 @@ void HarmonicNotchFilter<T>::update(uint8_t num_centers, const float center_freq
     const float nyquist_limit = _sample_freq_hz * 0.48f;
 
     _num_enabled_filters = 0;
+    _num_notches_set = 0;
+    _num_pending_sections = 0;
 
     // update all of the filters using the new center frequencies and existing A & Q
-    for (uint8_t i = 0; i < num_centers * HNF_MAX_HARMONICS && _num_enabled_filters < _num_filters; i++) {
-        const uint8_t harmonic_n = i / num_centers;
-        const uint8_t center_n = i % num_centers;
-        // the filters are ordered by center and then harmonic so
-        // f1h1, f2h1, f3h1, f4h1, f1h2, f2h2, etc
+    // the filters are ordered by center and then harmonic so
+    // f1h1, f2h1, f3h1, f4h1, f1h2, f2h2, etc
+    for (uint8_t harmonic_n = 0; harmonic_n < HNF_MAX_HARMONICS && _num_enabled_filters < _num_filters; harmonic_n++) {
         if (!((1U<<harmonic_n) & _harmonics)) {
             continue;
         }
-
-        const float notch_center = constrain_float(center_freq_hz[center_n] * (harmonic_n+1), 1.0f, nyquist_limit);
-        if (!_double_notch) {
-            // only enable the filter if its center frequency is below the nyquist frequency
-            if (notch_center < nyquist_limit) {
-                _filters[_num_enabled_filters++].init_with_A_and_Q(_sample_freq_hz, notch_center, _A, _Q);
-            }
-        } else {
-            float notch_center_double;
-            // only enable the filter if its center frequency is below the nyquist frequency
-            notch_center_double = notch_center * (1.0 - _notch_spread);
-            if (notch_center_double < nyquist_limit) {
-                _filters[_num_enabled_filters++].init_with_A_and_Q(_sample_freq_hz, notch_center_double, _A, _Q);
+        for (uint8_t center_n = 0; center_n < num_centers && _num_enabled_filters < _num_filters; center_n++) {
+            const float notch_center = constrain_float(center_freq_hz[center_n] * (harmonic_n+1), 1.0f, nyquist_limit);
+            if (!_double_notch) {
+                set_next_filter(notch_center, nyquist_limit);
+            } else {
+                set_next_filter(notch_center * (1.0 - _notch_spread), nyquist_limit);
+                set_next_filter(notch_center * (1.0 + _notch_spread), nyquist_limit);
             }
-            // only enable the filter if its center frequency is below the nyquist frequency
-            notch_center_double = notch_center * (1.0 + _notch_spread);
-            if (notch_center_double < nyquist_limit) {
-                _filters[_num_enabled_filters++].init_with_A_and_Q(_sample_freq_hz, notch_center_double, _A, _Q);
+        }
+    }
+
+    update_sections();
+}
+
+/*
+  set the next filter of the cascade. Only enable the filter if its center
+  frequency is below the nyquist frequency. Filters which already have
+  coefficients for the same notch are only given their new center
+  frequency here, they are recalculated in update_sections(). When a
+  notch drops out the later notches move to other filters, and those
+  are recalculated at once
+ */
+template <class T>
+void HarmonicNotchFilter<T>::set_next_filter(float notch_center, float nyquist_limit)
+{
+    const uint8_t notch = _num_notches_set++;
+    if (notch_center < nyquist_limit && _num_enabled_filters < _num_filters) {
+        const uint8_t idx = _num_enabled_filters;
+        if (!is_zero(_section_freq_hz[idx]) && _section_notch[idx] == notch) {
+            _target_freq_hz[idx] = notch_center;
+            if (fabsf(notch_center - _section_freq_hz[idx]) > notch_center * HNF_UPDATE_THRESHOLD) {
+                _num_pending_sections++;
             }
+            _num_enabled_filters++;
+        } else if (_filters.set_notch(idx, _sample_freq_hz, notch_center, _A, _Q)) {
+            _section_freq_hz[idx] = notch_center;
+            _target_freq_hz[idx] = notch_center;
+            _section_notch[idx] = notch;
+            _num_enabled_filters++;
+        }
+    }
+}
+
+/*
+  recalculate the coefficients of the filters whose notch has moved by
+  more than HNF_UPDATE_THRESHOLD of its frequency. With a notch per
+  motor most barely move between updates, so most updates recalculate
+  few filters. At most HNF_MAX_SECTION_UPDATES filters are done per
+  call, carrying on from where the last call stopped, so a large bank
+  that has all moved catches up over a few updates rather than in one
+  loop
+ */
+template <class T>
+void HarmonicNotchFilter<T>::update_sections()
+{
+    // filters which are no longer used are recalculated when they are
+    // next enabled, rather than starting from old coefficients
+    for (uint8_t i = _num_enabled_filters; i < _filters.num_sections(); i++) {
+        _section_freq_hz[i] = 0;
+    }
+    _filters.set_num_sections(_num_enabled_filters);
+    if (_num_pending_sections == 0) {
+        return;
+    }
+
+    const uint8_t start = _next_section_update < _num_enabled_filters ? _next_section_update : 0;
+    uint8_t updates = 0;
+    for (uint8_t n = 0; n < _num_enabled_filters; n++) {
+        uint8_t i = start + n;
+        if (i >= _num_enabled_filters) {
+            i -= _num_enabled_filters;
+        }
+        const float target = _target_freq_hz[i];
+        if (fabsf(target - _section_freq_hz[i]) <= target * HNF_UPDATE_THRESHOLD) {
+            continue;
+        }
+        if (_filters.set_notch(i, _sample_freq_hz, target, _A, _Q)) {
+            _section_freq_hz[i] = target;
+        }
+        if (++updates >= HNF_MAX_SECTION_UPDATES) {
+            _next_section_update = i + 1;
+            return;
         }
     }
 }
@@ -257,11 +324,20 @@ T HarmonicNotchFilter<T>::apply(const T &sample)
         return sample;
     }
 
-    T output = sample;
-    for (uint8_t i = 0; i < _num_enabled_filters; i++) {
-        output = _filters[i].apply(output);
+    return _filters.apply(sample);
+}
+
+/*
+  apply a block of samples to the underlying filters, in place
+ */
+template <class T>
+void HarmonicNotchFilter<T>::apply(T *samples, uint16_t n)
+{
+    if (!_initialised) {
+        return;
     }
-    return output;
+
+    _filters.apply(samples, n);
 }
 
 /*
@@ -274,9 +350,7 @@ void HarmonicNotchFilter<T>::reset()
         return;
     }
 
-    for (uint8_t i = 0; i < _num_filters; i++) {
-        _filters[i].reset();
-    }
+    _filters.reset();
 }
 
 /*
@@ -18,12 +18,26 @@
 #include <cmath>
 #include <AP_Param/AP_Param.h>
 #include "NotchFilter.h"
+#include "BiquadCascade.h"
 
 #define HNF_MAX_HARMONICS 8
 
+// notches that have moved by less than this fraction of their frequency
+// keep their coefficients
+#ifndef HNF_UPDATE_THRESHOLD
+#define HNF_UPDATE_THRESHOLD 0.001f
+#endif
+
+// most notch coefficients recalculated per update, the rest are done
+// on the following updates
+#ifndef HNF_MAX_SECTION_UPDATES
+#define HNF_MAX_SECTION_UPDATES 16
+#endif
+
 /*
   a filter that manages a set of notch filters targetted at a fundamental center frequency
-  and multiples of that fundamental frequency
+  and multiples of that fundamental frequency. The notches are applied as one
+  cascade, see BiquadCascade.h
  */
 template <class T>
 class HarmonicNotchFilter {
@@ -39,12 +53,34 @@ public:
     void update(uint8_t num_centers, const float center_freq_hz[]);
     // apply a sample to each of the underlying filters in turn
     T apply(const T &sample);
+    // apply a block of samples in place, the same as applying each in turn
+    void apply(T *samples, uint16_t n);
     // reset each of the underlying filters
     void reset();
 
 private:
-    // underlying bank of notch filters
-    NotchFilter<T>*  _filters;
+    // underlying cascade of notch filters
+    BiquadCascadeVector3f _filters;
+    // set the next filter of the cascade, if it is below the nyquist limit
+    void set_next_filter(float notch_center, float nyquist_limit);
+    // recalculate the coefficients of filters whose notch has moved
+    void update_sections();
+    // center frequency the coefficients of each filter were calculated
+    // for, zero if they never have been
+    float *_section_freq_hz = nullptr;
+    // center frequency each filter should be moved to
+    float *_target_freq_hz = nullptr;
+    // notch each filter's coefficients were calculated for, counting
+    // the notches above the nyquist limit, so a filter is not left
+    // with another notch's coefficients when one drops out
+    uint8_t *_section_notch = nullptr;
+    // number of notches set so far in this update
+    uint8_t _num_notches_set = 0;
+    // number of filters whose notch has moved since their coefficients
+    // were calculated
+    uint8_t _num_pending_sections = 0;
+    // filter the next round of coefficient updates starts from
+    uint8_t _next_section_update = 0;
     // sample frequency for each filter
     float _sample_freq_hz;
     // base double notch bandwidth for each filter
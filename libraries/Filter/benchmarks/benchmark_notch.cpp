@@ -0,0 +1,141 @@
+#include <AP_gbenchmark.h>
+
+#include <Filter/NotchFilter.h>
+#include <Filter/BiquadCascade.h>
+#include <Filter/HarmonicNotchFilter.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const float sample_rate_hz = 2000;
+static const float A = 0.1;
+static const float Q = 2.5;
+
+static void BM_NotchFilterChain(benchmark::State& state)
+{
+    const uint8_t n = state.range(0);
+    NotchFilterVector3f *filters = new NotchFilterVector3f[n];
+    for (uint8_t i = 0; i < n; i++) {
+        filters[i].init_with_A_and_Q(sample_rate_hz, 40 + 50 * i, A, Q);
+    }
+    Vector3f sample(1.0f, -2.0f, 3.0f);
+
+    while (state.KeepRunning()) {
+        Vector3f output = sample;
+        for (uint8_t i = 0; i < n; i++) {
+            output = filters[i].apply(output);
+        }
+        sample.x = -sample.x;
+        gbenchmark_escape(&output);
+    }
+    delete[] filters;
+}
+
+static void BM_BiquadCascade(benchmark::State& state)
+{
+    const uint8_t n = state.range(0);
+    BiquadCascadeVector3f cascade;
+    cascade.allocate(n);
+    for (uint8_t i = 0; i < n; i++) {
+        cascade.set_notch(i, sample_rate_hz, 40 + 50 * i, A, Q);
+    }
+    cascade.set_num_sections(n);
+    Vector3f sample(1.0f, -2.0f, 3.0f);
+
+    while (state.KeepRunning()) {
+        Vector3f output = cascade.apply(sample);
+        sample.x = -sample.x;
+        gbenchmark_escape(&output);
+    }
+}
+
+/*
+  an octa with a double notch on the first three harmonics of each
+  motor from ESC telemetry, on three IMUs, so 144 notches in all
+ */
+static const uint8_t octa_motors = 8;
+static const uint8_t octa_imus = 3;
+static const uint8_t octa_notches = octa_motors * 3 * 2;
+
+// the coefficient calculation of every notch with sinf() and cosf(),
+// as each update did before notches that barely moved were skipped
+static void BM_OctaNotchTrigUpdate(benchmark::State& state)
+{
+    NotchFilterVector3f *filters = new NotchFilterVector3f[octa_imus * octa_notches];
+    float freq_hz = 80;
+
+    while (state.KeepRunning()) {
+        for (uint16_t i = 0; i < octa_imus * octa_notches; i++) {
+            filters[i].init_with_A_and_Q(sample_rate_hz, freq_hz + (i % octa_notches), A, Q);
+        }
+        freq_hz = freq_hz > 120 ? 80 : freq_hz + 0.5;
+        gbenchmark_escape(filters);
+    }
+    delete[] filters;
+}
+
+/*
+  one update of the three harmonic notches from new motor frequencies.
+  With an argument of 0 the motors wander by a few hundredths of a
+  percent, as in a hover, and with 1 they all ramp by 1% per update
+ */
+static void BM_OctaHarmonicNotchUpdate(benchmark::State& state)
+{
+    const bool ramp = state.range(0);
+    HarmonicNotchFilterVector3f notches[octa_imus];
+    for (uint8_t i = 0; i < octa_imus; i++) {
+        notches[i].allocate_filters(octa_motors, 0x07, true);
+        notches[i].init(sample_rate_hz, 80, 40, 40);
+    }
+    float freq_hz[octa_motors];
+    for (uint8_t m = 0; m < octa_motors; m++) {
+        freq_hz[m] = 100 + m;
+    }
+    uint32_t step = 0;
+
+    while (state.KeepRunning()) {
+        for (uint8_t m = 0; m < octa_motors; m++) {
+            if (ramp) {
+                freq_hz[m] = freq_hz[m] > 150 ? 100 + m : freq_hz[m] * 1.01;
+            } else {
+                freq_hz[m] = (100 + m) * (1.0 + 0.0003 * ((step + m) % 3));
+            }
+        }
+        for (uint8_t i = 0; i < octa_imus; i++) {
+            notches[i].update(octa_motors, freq_hz);
+        }
+        step++;
+        gbenchmark_escape(notches);
+    }
+}
+
+// filtering one gyro sample on each IMU, for comparison
+static void BM_OctaHarmonicNotchApply(benchmark::State& state)
+{
+    HarmonicNotchFilterVector3f notches[octa_imus];
+    float freq_hz[octa_motors];
+    for (uint8_t m = 0; m < octa_motors; m++) {
+        freq_hz[m] = 100 + m;
+    }
+    for (uint8_t i = 0; i < octa_imus; i++) {
+        notches[i].allocate_filters(octa_motors, 0x07, true);
+        notches[i].init(sample_rate_hz, 80, 40, 40);
+        notches[i].update(octa_motors, freq_hz);
+    }
+    Vector3f sample(1.0f, -2.0f, 3.0f);
+
+    while (state.KeepRunning()) {
+        for (uint8_t i = 0; i < octa_imus; i++) {
+            Vector3f output = notches[i].apply(sample);
+            gbenchmark_escape(&output);
+        }
+        sample.x = -sample.x;
+    }
+}
+
+BENCHMARK(BM_NotchFilterChain)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK(BM_BiquadCascade)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK(BM_OctaNotchTrigUpdate);
+BENCHMARK(BM_OctaHarmonicNotchUpdate)->Arg(0)->Arg(1);
+BENCHMARK(BM_OctaHarmonicNotchApply);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,97 @@
+#include <AP_gtest.h>
+
+#include <Filter/NotchFilter.h>
+#include <Filter/BiquadCascade.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const float sample_rate_hz = 1000;
+
+// check the cascade against a chain of notch filters, including
+// changing the notch frequencies part way through
+TEST(BiquadCascadeTest, MatchesNotchFilters)
+{
+    const uint8_t n = 6;
+    NotchFilterVector3f filters[n];
+    BiquadCascadeVector3f cascade;
+    ASSERT_TRUE(cascade.allocate(n));
+
+    for (uint16_t step = 0; step < 2000; step++) {
+        if (step % 500 == 0) {
+            const float base_hz = 40 + step * 0.02;
+            for (uint8_t i = 0; i < n; i++) {
+                filters[i].init_with_A_and_Q(sample_rate_hz, base_hz * (i+1), 0.1, 2.5);
+                EXPECT_TRUE(cascade.set_notch(i, sample_rate_hz, base_hz * (i+1), 0.1, 2.5));
+            }
+            cascade.set_num_sections(n);
+        }
+        const float t = step / sample_rate_hz;
+        const Vector3f sample(sinf(2 * M_PI * 45 * t) + 0.3 * cosf(2 * M_PI * 130 * t),
+                              cosf(2 * M_PI * 80 * t),
+                              0.5 - sinf(2 * M_PI * 210 * t));
+        Vector3f expected = sample;
+        for (uint8_t i = 0; i < n; i++) {
+            expected = filters[i].apply(expected);
+        }
+        const Vector3f output = cascade.apply(sample);
+        EXPECT_NEAR(expected.x, output.x, 1.0e-4);
+        EXPECT_NEAR(expected.y, output.y, 1.0e-4);
+        EXPECT_NEAR(expected.z, output.z, 1.0e-4);
+    }
+}
+
+TEST(BiquadCascadeTest, SectionsAndReset)
+{
+    BiquadCascadeVector3f cascade;
+    ASSERT_TRUE(cascade.allocate(2));
+
+    // nothing to apply passes the sample through
+    const Vector3f sample(1, 2, 3);
+    EXPECT_EQ(sample, cascade.apply(sample));
+
+    // notches at or above nyquist are refused
+    EXPECT_FALSE(cascade.set_notch(0, sample_rate_hz, 500, 0.1, 2.5));
+    EXPECT_FALSE(cascade.set_notch(2, sample_rate_hz, 100, 0.1, 2.5));
+    EXPECT_TRUE(cascade.set_notch(0, sample_rate_hz, 100, 0.1, 2.5));
+    cascade.set_num_sections(3);
+    EXPECT_EQ(2, cascade.num_sections());
+
+    // a reset cascade starts from zero history again
+    cascade.set_num_sections(1);
+    const Vector3f first = cascade.apply(sample);
+    cascade.apply(-sample);
+    cascade.reset();
+    EXPECT_EQ(first, cascade.apply(sample));
+}
+
+// applying a block gives the same results as each sample in turn
+TEST(BiquadCascadeTest, BlockMatchesSamples)
+{
+    const uint8_t n = 4;
+    BiquadCascadeVector3f single, block;
+    ASSERT_TRUE(single.allocate(n));
+    ASSERT_TRUE(block.allocate(n));
+    for (uint8_t i = 0; i < n; i++) {
+        single.set_notch(i, sample_rate_hz, 60 * (i+1), 0.1, 2.5);
+        block.set_notch(i, sample_rate_hz, 60 * (i+1), 0.1, 2.5);
+    }
+    single.set_num_sections(n);
+    block.set_num_sections(n);
+
+    uint16_t step = 0;
+    for (uint8_t len = 1; len < 40; len++) {
+        Vector3f samples[40];
+        Vector3f expected[40];
+        for (uint8_t k = 0; k < len; k++, step++) {
+            const float t = step / sample_rate_hz;
+            samples[k] = Vector3f(sinf(2 * M_PI * 60 * t), cosf(2 * M_PI * 95 * t), sinf(2 * M_PI * 170 * t));
+            expected[k] = single.apply(samples[k]);
+        }
+        block.apply(samples, len);
+        for (uint8_t k = 0; k < len; k++) {
+            EXPECT_EQ(expected[k], samples[k]);
+        }
+    }
+}
+
+AP_GTEST_MAIN()
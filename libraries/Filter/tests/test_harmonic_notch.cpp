@@ -0,0 +1,152 @@
+#include <AP_gtest.h>
+
+#include <Filter/NotchFilter.h>
+#include <Filter/HarmonicNotchFilter.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+static const float sample_rate_hz = 2000;
+static const uint8_t num_motors = 8;
+// 1st, 2nd and 3rd harmonics
+static const uint8_t harmonics = 0x07;
+
+static Vector3f test_sample(uint16_t step)
+{
+    const float t = step / sample_rate_hz;
+    return Vector3f(sinf(2 * M_PI * 95 * t) + 0.3 * cosf(2 * M_PI * 210 * t),
+                    cosf(2 * M_PI * 180 * t),
+                    0.5 - sinf(2 * M_PI * 330 * t));
+}
+
+// an octa bank of double notches, checked against a chain of notch
+// filters at the same frequencies once the bank has caught up with a
+// change of every motor frequency
+TEST(HarmonicNotchFilterTest, OctaBankCatchesUp)
+{
+    HarmonicNotchFilterVector3f notch;
+    notch.allocate_filters(num_motors, harmonics, true);
+    notch.init(sample_rate_hz, 80, 40, 40);
+
+    float freq_hz[num_motors];
+    for (uint8_t m = 0; m < num_motors; m++) {
+        freq_hz[m] = 70 + 3 * m;
+    }
+    notch.update(num_motors, freq_hz);
+
+    // all 48 notches move, so take several updates to catch up
+    for (uint8_t m = 0; m < num_motors; m++) {
+        freq_hz[m] += 20;
+    }
+    for (uint8_t i = 0; i < (48 + HNF_MAX_SECTION_UPDATES - 1) / HNF_MAX_SECTION_UPDATES; i++) {
+        notch.update(num_motors, freq_hz);
+    }
+
+    // the same notches, from the same design
+    float A, Q;
+    NotchFilter<Vector3f>::calculate_A_and_Q(80, 20, 40, A, Q);
+    const float spread = 40.0f / (32 * 80);
+    NotchFilterVector3f filters[48];
+    uint8_t n = 0;
+    for (uint8_t h = 1; h <= 3; h++) {
+        for (uint8_t m = 0; m < num_motors; m++) {
+            filters[n++].init_with_A_and_Q(sample_rate_hz, freq_hz[m] * h * (1.0 - spread), A, Q);
+            filters[n++].init_with_A_and_Q(sample_rate_hz, freq_hz[m] * h * (1.0 + spread), A, Q);
+        }
+    }
+
+    notch.reset();
+    for (uint16_t step = 0; step < 1000; step++) {
+        const Vector3f sample = test_sample(step);
+        Vector3f expected = sample;
+        for (uint8_t i = 0; i < n; i++) {
+            expected = filters[i].apply(expected);
+        }
+        const Vector3f output = notch.apply(sample);
+        EXPECT_NEAR(expected.x, output.x, 1.0e-3);
+        EXPECT_NEAR(expected.y, output.y, 1.0e-3);
+        EXPECT_NEAR(expected.z, output.z, 1.0e-3);
+    }
+}
+
+// moving the notches by less than the threshold keeps the coefficients
+TEST(HarmonicNotchFilterTest, SmallChangesSkipped)
+{
+    HarmonicNotchFilterVector3f moved, fixed;
+    float freq_hz[num_motors];
+    for (uint8_t m = 0; m < num_motors; m++) {
+        freq_hz[m] = 90 + 3 * m;
+    }
+    moved.allocate_filters(num_motors, harmonics, true);
+    fixed.allocate_filters(num_motors, harmonics, true);
+    moved.init(sample_rate_hz, 80, 40, 40);
+    fixed.init(sample_rate_hz, 80, 40, 40);
+    moved.update(num_motors, freq_hz);
+    fixed.update(num_motors, freq_hz);
+
+    for (uint8_t m = 0; m < num_motors; m++) {
+        freq_hz[m] *= 1.0f + 0.5f * HNF_UPDATE_THRESHOLD;
+    }
+    moved.update(num_motors, freq_hz);
+
+    for (uint16_t step = 0; step < 200; step++) {
+        const Vector3f sample = test_sample(step);
+        EXPECT_EQ(fixed.apply(sample), moved.apply(sample));
+    }
+}
+
+// when a notch goes above the nyquist limit the later notches move to
+// other filters. Those filters get the right coefficients at once, even
+// when other notches have moved too far to all be updated in one go
+TEST(HarmonicNotchFilterTest, NotchDropOutMovesSections)
+{
+    HarmonicNotchFilterVector3f notch;
+    notch.allocate_filters(num_motors, harmonics, true);
+    notch.init(sample_rate_hz, 80, 40, 40);
+
+    float A, Q;
+    NotchFilter<Vector3f>::calculate_A_and_Q(80, 20, 40, A, Q);
+    const float spread = 40.0f / (32 * 80);
+    const float nyquist_limit = sample_rate_hz * 0.48f;
+
+    float freq_hz[num_motors];
+    for (uint8_t m = 0; m < num_motors; m++) {
+        freq_hz[m] = 90 + 3 * m;
+    }
+    notch.update(num_motors, freq_hz);
+
+    // the first motor's third harmonic goes above the nyquist limit and
+    // comes back. More filters change each time than are updated per call
+    for (const float first_hz : { 330.0f, 90.0f }) {
+        freq_hz[0] = first_hz;
+        notch.update(num_motors, freq_hz);
+
+        NotchFilterVector3f filters[48];
+        uint8_t n = 0;
+        for (uint8_t h = 1; h <= 3; h++) {
+            for (uint8_t m = 0; m < num_motors; m++) {
+                const float center = MIN(freq_hz[m] * h, nyquist_limit);
+                for (const float f : { center * (1.0f - spread), center * (1.0f + spread) }) {
+                    if (f < nyquist_limit) {
+                        filters[n++].init_with_A_and_Q(sample_rate_hz, f, A, Q);
+                    }
+                }
+            }
+        }
+        EXPECT_EQ(n, first_hz > 300 ? 47 : 48);
+
+        notch.reset();
+        for (uint16_t step = 0; step < 1000; step++) {
+            const Vector3f sample = test_sample(step);
+            Vector3f expected = sample;
+            for (uint8_t i = 0; i < n; i++) {
+                expected = filters[i].apply(expected);
+            }
+            const Vector3f output = notch.apply(sample);
+            EXPECT_NEAR(expected.x, output.x, 1.0e-3);
+            EXPECT_NEAR(expected.y, output.y, 1.0e-3);
+            EXPECT_NEAR(expected.z, output.z, 1.0e-3);
+        }
+    }
+}
+
+AP_GTEST_MAIN()
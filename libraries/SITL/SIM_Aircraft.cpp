@@ -105,18 +105,13 @@ void Aircraft::set_start_location(const Location &start_loc, const float start_y
 */
 float Aircraft::ground_height_difference() const
 {
-#if AP_TERRAIN_AVAILABLE
-    AP_Terrain *terrain = AP::terrain();
     float h1, h2;
     if (sitl &&
-        terrain != nullptr &&
-        sitl->terrain_enable &&
-        terrain->height_amsl(home, h1, false) &&
-        terrain->height_amsl(location, h2, false)) {
+        sitl->terrain_height_amsl(home, h1) &&
+        sitl->terrain_height_amsl(location, h2)) {
         h2 += local_ground_level;
         return h2 - h1;
     }
-#endif
     return local_ground_level;
 }
 
@@ -0,0 +1,207 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulator connection over a shared memory ring
+*/
+
+#include "SIM_SHM.h"
+
+#if HAL_SIM_SHM_ENABLED
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <AP_HAL/AP_HAL.h>
+
+// time to wait for the simulator before printing a message
+#define SHM_TIMEOUT_MS 1000
+
+using namespace SITL;
+
+SHMSim::SHMSim(const char *frame_str) :
+    Aircraft(frame_str)
+{
+    printf("Starting SITL: shared memory\n");
+
+    const char *colon = strchr(frame_str, ':');
+    if (colon) {
+        shm_name = colon+1;
+    }
+}
+
+SHMSim::~SHMSim()
+{
+    if (shm != nullptr) {
+        munmap(shm, sizeof(*shm));
+        shm_unlink(shm_name);
+    }
+    free(default_name);
+}
+
+/*
+  create and initialise the shared memory object
+ */
+bool SHMSim::open_shm(void)
+{
+    if (shm_name == nullptr) {
+        if (asprintf(&default_name, SIM_SHM_DEFAULT_NAME, unsigned(instance)) <= 0) {
+            return false;
+        }
+        shm_name = default_name;
+    }
+    const int fd = shm_open(shm_name, O_RDWR|O_CREAT|O_CLOEXEC, 0600);
+    if (fd == -1) {
+        printf("SHM: shm_open(%s) failed - %s\n", shm_name, strerror(errno));
+        return false;
+    }
+    if (ftruncate(fd, sizeof(SHM::layout)) != 0) {
+        printf("SHM: ftruncate(%s) failed - %s\n", shm_name, strerror(errno));
+        close(fd);
+        return false;
+    }
+    void *p = mmap(nullptr, sizeof(SHM::layout), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        printf("SHM: mmap(%s) failed - %s\n", shm_name, strerror(errno));
+        return false;
+    }
+    shm = (SHM::layout *)p;
+
+    // a new session: reset the rings, then publish the magic so a
+    // waiting simulator knows the object is ready
+    shm->magic = 0;
+    shm->servos.reset();
+    shm->fdm.reset();
+    shm->version = SHM::VERSION;
+    shm->ring_size = SIM_SHM_RING_SIZE;
+    shm->session.fetch_add(1);
+    __atomic_store_n(&shm->magic, SHM::MAGIC, __ATOMIC_RELEASE);
+
+    printf("SHM: simulator interface on %s\n", shm_name);
+    return true;
+}
+
+/*
+  send servo outputs to the simulator
+ */
+void SHMSim::output_servos(const struct sitl_input &input)
+{
+    SHM::servo_frame frame;
+    frame.frame_count = frame_counter;
+    frame.frame_rate = rate_hz;
+    memcpy(frame.pwm, input.servos, sizeof(frame.pwm));
+    if (!shm->servos.push(frame)) {
+        // the simulator is not consuming frames. Only the simulator
+        // may advance the ring tail, so drop this frame
+        if (servo_frames_dropped++ % 1000 == 0) {
+            printf("SHM: simulator not reading servo frames, %u dropped\n", unsigned(servo_frames_dropped));
+        }
+    }
+}
+
+/*
+  wait for new FDM state from the simulator
+  This is a blocking function
+ */
+void SHMSim::recv_fdm(const struct sitl_input &input)
+{
+    SHM::fdm_frame pkt;
+    uint32_t wait_ms = 0;
+    while (!shm->fdm.pop_latest(pkt)) {
+        if (!shm->fdm.wait(100)) {
+            wait_ms += 100;
+            if (wait_ms >= SHM_TIMEOUT_MS) {
+                wait_ms = 0;
+                printf("No SHM FDM frame received on %s\n", shm_name);
+            }
+        }
+    }
+
+    accel_body = Vector3f(pkt.accel_body[0], pkt.accel_body[1], pkt.accel_body[2]);
+    gyro = Vector3f(pkt.gyro[0], pkt.gyro[1], pkt.gyro[2]);
+    velocity_ef = Vector3f(pkt.velocity[0], pkt.velocity[1], pkt.velocity[2]);
+    position = Vector3d(pkt.position[0], pkt.position[1], pkt.position[2]);
+    position.xy() += origin.get_distance_NE_double(home);
+    use_time_sync = (pkt.flags & SHM::fdm_frame::NO_TIME_SYNC) == 0;
+
+    Quaternion quat(pkt.quaternion[0], pkt.quaternion[1], pkt.quaternion[2], pkt.quaternion[3]);
+    quat.rotation_matrix(dcm);
+
+    if (pkt.flags & SHM::fdm_frame::HAVE_AIRSPEED) {
+        airspeed = pkt.airspeed;
+        airspeed_pitot = pkt.airspeed;
+    } else {
+        // velocity relative to airmass in body frame
+        velocity_air_bf = dcm.transposed() * velocity_ef;
+
+        // airspeed
+        airspeed = velocity_air_bf.length();
+
+        // airspeed as seen by a fwd pitot tube (limited to 120m/s)
+        airspeed_pitot = constrain_float(velocity_air_bf * Vector3f(1.0f, 0.0f, 0.0f), 0.0f, 120.0f);
+    }
+
+    if (pkt.flags & SHM::fdm_frame::HAVE_RANGEFINDER) {
+        for (uint8_t i=0; i<MIN(ARRAY_SIZE(pkt.rangefinder_m), ARRAY_SIZE(rangefinder_m)); i++) {
+            rangefinder_m[i] = pkt.rangefinder_m[i];
+        }
+    }
+
+    // Convert from a meters from origin physics to a lat long alt
+    update_position();
+
+    double deltat;
+    if (pkt.timestamp_s < last_timestamp_s) {
+        // Physics time has gone backwards, don't reset AP
+        printf("Detected physics reset\n");
+        deltat = 0;
+    } else {
+        deltat = pkt.timestamp_s - last_timestamp_s;
+    }
+    time_now_us += deltat * 1.0e6;
+
+    if (is_positive(deltat) && deltat < 0.1) {
+        // time in us to hz
+        if (use_time_sync) {
+            adjust_frame_time(1.0 / deltat);
+        }
+        // match actual frame rate with desired speedup
+        time_advance();
+    }
+    last_timestamp_s = pkt.timestamp_s;
+    frame_counter++;
+}
+
+/*
+  update the simulation by one time step
+ */
+void SHMSim::update(const struct sitl_input &input)
+{
+    if (shm == nullptr && !open_shm()) {
+        fprintf(stderr, "Aborting launch...\n");
+        exit(1);
+    }
+
+    output_servos(input);
+    recv_fdm(input);
+
+    // update magnetic field
+    update_mag_field_bf();
+}
+
+#endif  // HAL_SIM_SHM_ENABLED
@@ -0,0 +1,72 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulator connection over a shared memory ring, see SIM_SHM_Protocol.h
+*/
+
+#pragma once
+
+#include <AP_HAL/AP_HAL_Boards.h>
+
+#ifndef HAL_SIM_SHM_ENABLED
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL && defined(__linux__)
+#define HAL_SIM_SHM_ENABLED 1
+#else
+#define HAL_SIM_SHM_ENABLED 0
+#endif
+#endif
+
+#if HAL_SIM_SHM_ENABLED
+
+#include "SIM_Aircraft.h"
+#include "SIM_SHM_Protocol.h"
+
+namespace SITL {
+
+/*
+  lockstep shared memory simulator interface. The frame string is
+  "shm" to use the default object name for this instance, or
+  "shm:/name" to give the name
+ */
+class SHMSim : public Aircraft {
+public:
+    SHMSim(const char *frame_str);
+    ~SHMSim();
+
+    /* update model by one time step */
+    void update(const struct sitl_input &input) override;
+
+    /* static object creator */
+    static Aircraft *create(const char *frame_str) {
+        return new SHMSim(frame_str);
+    }
+
+private:
+    bool open_shm(void);
+    void output_servos(const struct sitl_input &input);
+    void recv_fdm(const struct sitl_input &input);
+
+    const char *shm_name;
+    char *default_name;
+    SHM::layout *shm;
+
+    uint32_t frame_counter;
+    uint32_t servo_frames_dropped;
+    double last_timestamp_s;
+};
+
+}  // namespace SITL
+
+#endif  // HAL_SIM_SHM_ENABLED
@@ -0,0 +1,236 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  shared memory transport between SITL and an external physics
+  simulator.
+
+  This header has no ArduPilot dependencies so that simulators can
+  include it directly. See examples/SHM for a reference peer.
+
+  The shared memory object holds two single producer, single consumer
+  rings: servo frames written by ArduPilot and FDM frames written by
+  the simulator. Each ring has a head counter written only by the
+  producer and a tail counter written only by the consumer. A consumer
+  with nothing to read spins briefly and then sleeps with a futex on
+  the head counter; a producer only makes the wake syscall if the
+  consumer has flagged that it is sleeping. In lockstep with a busy
+  peer on another CPU a physics step usually costs no syscalls at
+  all. On a single CPU the peer can only run once the consumer
+  sleeps, so the spin is skipped.
+
+  Only the consumer advances the tail counter. A producer which finds
+  the ring full must drop its new frame or wait; it must never pop.
+ */
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/sysinfo.h>
+#include <sys/syscall.h>
+
+namespace SITL {
+namespace SHM {
+
+static const uint32_t MAGIC = 0x4D485341; // "ASHM"
+static const uint16_t VERSION = 1;
+
+// default object name, "%u" is the SITL instance number
+#define SIM_SHM_DEFAULT_NAME "/ardupilot-sitl-%u"
+
+// number of frames in each ring, must be a power of 2
+#define SIM_SHM_RING_SIZE 8
+
+// iterations to spin before sleeping on the futex, when there is more
+// than one CPU
+#define SIM_SHM_SPIN_COUNT 2000
+
+/*
+  hint to the CPU that we are spinning, so a sibling hardware thread
+  running the peer gets the core
+ */
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || (defined(__arm__) && __ARM_ARCH >= 7)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/*
+  number of iterations to spin before sleeping. Spinning on a single
+  CPU only delays the peer we are waiting for
+ */
+static inline uint32_t spin_count(void)
+{
+    static const uint32_t count = get_nprocs() > 1 ? SIM_SHM_SPIN_COUNT : 0;
+    return count;
+}
+
+/*
+  servo outputs from ArduPilot, matching the JSON backend
+ */
+struct servo_frame {
+    uint64_t frame_count;
+    float frame_rate;
+    uint16_t pwm[16];
+};
+
+/*
+  FDM state from the simulator. Units and frames match the JSON backend:
+  body frame gyro (rad/s) and accel (m/s/s), NED velocity (m/s) and
+  position (m) relative to the home location
+ */
+struct fdm_frame {
+    enum : uint32_t {
+        HAVE_AIRSPEED = (1U<<0),
+        HAVE_RANGEFINDER = (1U<<1),
+        NO_TIME_SYNC = (1U<<2),
+    };
+    double timestamp_s;
+    double gyro[3];
+    double accel_body[3];
+    double quaternion[4]; // w, x, y, z
+    double velocity[3];
+    double position[3];
+    double airspeed;
+    double rangefinder_m[6]; // negative for no reading
+    uint32_t flags;
+};
+
+template <typename T>
+struct ring {
+    std::atomic<uint32_t> head;     // frames written, futex word
+    std::atomic<uint32_t> tail;     // frames read
+    std::atomic<uint32_t> sleeping; // consumer is waiting on the futex
+    T frames[SIM_SHM_RING_SIZE];
+
+    void reset() {
+        head.store(0);
+        tail.store(0);
+        sleeping.store(0);
+    }
+
+    /*
+      push a frame, returning false if the consumer has fallen a full
+      ring behind
+     */
+    bool push(const T &frame) {
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= SIM_SHM_RING_SIZE) {
+            return false;
+        }
+        frames[h % SIM_SHM_RING_SIZE] = frame;
+        // seq_cst pairs with the consumer setting sleeping before
+        // re-reading head, so one side always sees the other
+        head.store(h+1, std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_seq_cst)) {
+            syscall(SYS_futex, (uint32_t *)&head, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+        }
+        return true;
+    }
+
+    /*
+      pop the oldest frame if one is available
+     */
+    bool pop(T &frame) {
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == t) {
+            return false;
+        }
+        frame = frames[t % SIM_SHM_RING_SIZE];
+        tail.store(t+1, std::memory_order_release);
+        return true;
+    }
+
+    /*
+      pop the newest frame, discarding any older ones
+     */
+    bool pop_latest(T &frame) {
+        const uint32_t h = head.load(std::memory_order_acquire);
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        if (h == t) {
+            return false;
+        }
+        frame = frames[(h-1) % SIM_SHM_RING_SIZE];
+        tail.store(h, std::memory_order_release);
+        return true;
+    }
+
+    /*
+      wait for a frame to be available, returning false on timeout
+     */
+    bool wait(uint32_t timeout_ms) {
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        const uint32_t spins = spin_count();
+        for (uint32_t i=0; i<spins; i++) {
+            if (head.load(std::memory_order_acquire) != t) {
+                return true;
+            }
+            cpu_relax();
+        }
+        // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC
+        // deadline, so spurious wakeups don't extend the wait
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000UL;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (true) {
+            sleeping.store(1, std::memory_order_seq_cst);
+            const uint32_t h = head.load(std::memory_order_seq_cst);
+            if (h != t) {
+                sleeping.store(0, std::memory_order_relaxed);
+                return true;
+            }
+            const long ret = syscall(SYS_futex, (uint32_t *)&head, FUTEX_WAIT_BITSET, h, &deadline, nullptr, FUTEX_BITSET_MATCH_ANY);
+            sleeping.store(0, std::memory_order_relaxed);
+            if (head.load(std::memory_order_acquire) != t) {
+                return true;
+            }
+            if (ret == -1 && errno == ETIMEDOUT) {
+                return false;
+            }
+            // spurious wakeup or EINTR, go around again
+        }
+    }
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32 bits");
+
+/*
+  layout of the shared memory object, created by ArduPilot
+ */
+struct layout {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t ring_size;
+    // incremented each time ArduPilot (re)initialises the object so
+    // the simulator can detect a restart
+    std::atomic<uint32_t> session;
+    ring<servo_frame> servos;
+    ring<fdm_frame> fdm;
+};
+
+}  // namespace SHM
+}  // namespace SITL
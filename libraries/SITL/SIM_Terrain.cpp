@@ -0,0 +1,328 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulator terrain height source using memory mapped DAT files
+*/
+
+#include "SIM_Terrain.h"
+
+#if AP_SIM_TERRAIN_ENABLED
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/crc.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern const AP_HAL::HAL& hal;
+
+using namespace SITL;
+
+Terrain::~Terrain()
+{
+    for (auto &f : files) {
+        unmap_file(f);
+    }
+    free(directory);
+}
+
+/*
+  check a block is valid, with a CRC check. A spacing of zero accepts
+  any grid spacing
+ */
+bool Terrain::check_block(const grid_block &block, uint16_t spacing) const
+{
+    if (block.bitmap == 0 ||
+        block.version != TERRAIN_GRID_FORMAT_VERSION ||
+        (spacing != 0 && block.spacing != spacing)) {
+        return false;
+    }
+    // the CRC is taken with the crc field zeroed
+    const uint8_t *b = (const uint8_t *)&block;
+    const uint8_t zero[2] {};
+    const uint32_t crc_ofs = offsetof(grid_block, crc);
+    uint16_t crc = crc16_ccitt(b, crc_ofs, 0);
+    crc = crc16_ccitt(zero, sizeof(zero), crc);
+    crc = crc16_ccitt(&b[crc_ofs+2], sizeof(grid_block) - (crc_ofs+2), crc);
+    return crc == block.crc;
+}
+
+void Terrain::unmap_file(tile_file &f)
+{
+    if (f.data != nullptr) {
+        munmap((void *)f.data, f.length);
+        f.data = nullptr;
+        f.length = 0;
+    }
+    delete[] f.block_state;
+    f.block_state = nullptr;
+    f.num_blocks = 0;
+}
+
+/*
+  map a degree file, or remap it if it has grown. Blocks which
+  previously failed their check are rechecked as they may have been
+  written since
+ */
+void Terrain::map_file(tile_file &f)
+{
+    f.last_map_ms = AP_HAL::millis();
+
+    if (directory == nullptr) {
+        const char *terrain_dir = hal.util->get_custom_terrain_directory();
+        if (terrain_dir == nullptr) {
+            terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
+        }
+        directory = strdup(terrain_dir);
+        if (directory == nullptr) {
+            return;
+        }
+    }
+
+    char *path = nullptr;
+    if (asprintf(&path, "%s/%c%02u%c%03u.DAT",
+                 directory,
+                 f.lat_degrees<0?'S':'N',
+                 (unsigned)MIN(abs((int32_t)f.lat_degrees), 99),
+                 f.lon_degrees<0?'W':'E',
+                 (unsigned)MIN(abs((int32_t)f.lon_degrees), 999)) <= 0) {
+        return;
+    }
+    const int fd = open(path, O_RDONLY|O_CLOEXEC);
+    free(path);
+    if (fd == -1) {
+        unmap_file(f);
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < block_size) {
+        close(fd);
+        unmap_file(f);
+        return;
+    }
+    if (f.data != nullptr && size_t(st.st_size) == f.length) {
+        // unchanged size, just recheck failed blocks
+        close(fd);
+        for (uint32_t i=0; i<f.num_blocks; i++) {
+            if (f.block_state[i] == BlockState::INVALID) {
+                f.block_state[i] = BlockState::UNCHECKED;
+            }
+        }
+    } else {
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            unmap_file(f);
+            return;
+        }
+
+        const uint32_t num_blocks = st.st_size / block_size;
+        BlockState *block_state = new BlockState[num_blocks];
+        if (block_state == nullptr) {
+            munmap(data, st.st_size);
+            unmap_file(f);
+            return;
+        }
+        // keep the state of blocks we have already checked
+        for (uint32_t i=0; i<MIN(num_blocks, f.num_blocks); i++) {
+            block_state[i] = f.block_state[i]==BlockState::VALID?BlockState::VALID:BlockState::UNCHECKED;
+        }
+        unmap_file(f);
+        f.data = (const uint8_t *)data;
+        f.length = st.st_size;
+        f.block_state = block_state;
+        f.num_blocks = num_blocks;
+    }
+
+    if (f.spacing == 0) {
+        find_spacing(f);
+    }
+}
+
+/*
+  find the grid spacing of a file from the first valid block, and
+  work out how many blocks are in an east stride at this latitude
+ */
+bool Terrain::find_spacing(tile_file &f)
+{
+    for (uint32_t i=0; i<f.num_blocks; i++) {
+        const grid_block *block = get_block(f, i);
+        if (block == nullptr) {
+            continue;
+        }
+        f.spacing = block->spacing;
+
+        // this must match AP_Terrain::east_blocks()
+        Location loc1, loc2;
+        loc1.lat = f.lat_degrees*10*1000*1000L;
+        loc1.lng = f.lon_degrees*10*1000*1000L;
+        loc2.lat = f.lat_degrees*10*1000*1000L;
+        loc2.lng = (f.lon_degrees+1)*10*1000*1000L;
+        loc2.offset(0, 2*f.spacing*TERRAIN_GRID_BLOCK_SIZE_Y);
+        const Vector2f offset = loc1.get_distance_NE(loc2);
+        f.east_blocks = offset.y / (f.spacing*TERRAIN_GRID_BLOCK_SPACING_Y);
+        return true;
+    }
+    return false;
+}
+
+/*
+  get a block from a mapped file, checking its CRC on first use
+ */
+const Terrain::grid_block *Terrain::get_block(tile_file &f, uint32_t blocknum)
+{
+    if (blocknum >= f.num_blocks) {
+        return nullptr;
+    }
+    switch (f.block_state[blocknum]) {
+    case BlockState::VALID:
+        break;
+    case BlockState::INVALID:
+        return nullptr;
+    case BlockState::UNCHECKED: {
+        const grid_block &block = *(const grid_block *)&f.data[blocknum*block_size];
+        if (!check_block(block, f.spacing)) {
+            f.block_state[blocknum] = BlockState::INVALID;
+            return nullptr;
+        }
+        f.block_state[blocknum] = BlockState::VALID;
+        break;
+    }
+    }
+    return (const grid_block *)&f.data[blocknum*block_size];
+}
+
+/*
+  find a mapped degree file, mapping it if needed, evicting the least
+  recently used file
+ */
+Terrain::tile_file *Terrain::find_file(int8_t lat_degrees, int16_t lon_degrees)
+{
+    const uint32_t now_ms = AP_HAL::millis();
+    tile_file *f = nullptr;
+
+    tile_file &last = files[last_file_idx];
+    if (last.in_use && last.lat_degrees == lat_degrees && last.lon_degrees == lon_degrees) {
+        f = &last;
+    } else {
+        uint8_t oldest = 0;
+        for (uint8_t i=0; i<ARRAY_SIZE(files); i++) {
+            if (files[i].in_use &&
+                files[i].lat_degrees == lat_degrees &&
+                files[i].lon_degrees == lon_degrees) {
+                f = &files[i];
+                last_file_idx = i;
+                break;
+            }
+            if (!files[i].in_use ||
+                (files[oldest].in_use && files[i].last_access_ms < files[oldest].last_access_ms)) {
+                oldest = i;
+            }
+        }
+        if (f == nullptr) {
+            f = &files[oldest];
+            unmap_file(*f);
+            f->in_use = true;
+            f->lat_degrees = lat_degrees;
+            f->lon_degrees = lon_degrees;
+            f->spacing = 0;
+            f->east_blocks = 0;
+            last_file_idx = oldest;
+            map_file(*f);
+        }
+    }
+
+    f->last_access_ms = now_ms;
+
+    // retry missing files and pick up new blocks every few seconds,
+    // as the vehicle may be writing the files while we fly
+    if ((f->data == nullptr || f->spacing == 0) && now_ms - f->last_map_ms > 5000) {
+        map_file(*f);
+    }
+    return f;
+}
+
+/*
+  return terrain height in meters above sea level
+ */
+bool Terrain::height_amsl(const Location &loc, float &height)
+{
+    // files start on integer degrees, matching AP_Terrain
+    const int8_t lat_degrees = (loc.lat<0?(loc.lat-9999999L):loc.lat) / (10*1000*1000L);
+    const int16_t lon_degrees = (loc.lng<0?(loc.lng-9999999L):loc.lng) / (10*1000*1000L);
+
+    tile_file *f = find_file(lat_degrees, lon_degrees);
+    if (f == nullptr || f->data == nullptr || f->spacing == 0) {
+        return false;
+    }
+
+    // find offset from the reference position of this degree file
+    Location ref;
+    ref.lat = lat_degrees*10*1000*1000L;
+    ref.lng = lon_degrees*10*1000*1000L;
+    const Vector2f offset = ref.get_distance_NE(loc);
+    const uint16_t spacing = f->spacing;
+
+    const uint32_t idx_x = offset.x / spacing;
+    const uint32_t idx_y = offset.y / spacing;
+    const uint16_t grid_idx_x = idx_x / TERRAIN_GRID_BLOCK_SPACING_X;
+    const uint16_t grid_idx_y = idx_y / TERRAIN_GRID_BLOCK_SPACING_Y;
+    const uint8_t x = idx_x % TERRAIN_GRID_BLOCK_SPACING_X;
+    const uint8_t y = idx_y % TERRAIN_GRID_BLOCK_SPACING_Y;
+    const float frac_x = (offset.x - idx_x * spacing) / spacing;
+    const float frac_y = (offset.y - idx_y * spacing) / spacing;
+
+    uint32_t blocknum = f->east_blocks * grid_idx_x + grid_idx_y;
+    const grid_block *block = get_block(*f, blocknum);
+    if (block == nullptr && blocknum >= f->num_blocks &&
+        AP_HAL::millis() - f->last_map_ms > 1000) {
+        // the file may have grown since we mapped it
+        map_file(*f);
+        block = get_block(*f, blocknum);
+    }
+    if (block == nullptr ||
+        block->grid_idx_x != grid_idx_x ||
+        block->grid_idx_y != grid_idx_y) {
+        return false;
+    }
+
+    // check we have all 4 required heights, using the 4x4 subgrid bitmap
+    const uint64_t bit00 = 1ULL << ((y/TERRAIN_GRID_MAVLINK_SIZE) + TERRAIN_GRID_BLOCK_MUL_Y*(x/TERRAIN_GRID_MAVLINK_SIZE));
+    const uint64_t bit01 = 1ULL << (((y+1)/TERRAIN_GRID_MAVLINK_SIZE) + TERRAIN_GRID_BLOCK_MUL_Y*(x/TERRAIN_GRID_MAVLINK_SIZE));
+    const uint64_t bit10 = 1ULL << ((y/TERRAIN_GRID_MAVLINK_SIZE) + TERRAIN_GRID_BLOCK_MUL_Y*((x+1)/TERRAIN_GRID_MAVLINK_SIZE));
+    const uint64_t bit11 = 1ULL << (((y+1)/TERRAIN_GRID_MAVLINK_SIZE) + TERRAIN_GRID_BLOCK_MUL_Y*((x+1)/TERRAIN_GRID_MAVLINK_SIZE));
+    const uint64_t needed = bit00 | bit01 | bit10 | bit11;
+    if ((block->bitmap & needed) != needed) {
+        return false;
+    }
+
+    // bilinear interpolation between the 4 surrounding grid points
+    const int16_t h00 = block->height[x+0][y+0];
+    const int16_t h01 = block->height[x+0][y+1];
+    const int16_t h10 = block->height[x+1][y+0];
+    const int16_t h11 = block->height[x+1][y+1];
+
+    const float avg1 = (1.0f-frac_x) * h00  + frac_x * h10;
+    const float avg2 = (1.0f-frac_x) * h01  + frac_x * h11;
+    height = (1.0f-frac_y) * avg1 + frac_y * avg2;
+
+    return true;
+}
+
+#endif  // AP_SIM_TERRAIN_ENABLED
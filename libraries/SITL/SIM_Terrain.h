@@ -0,0 +1,126 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulator terrain height source, reading the AP_Terrain DAT files
+  directly through memory mapped files so the simulated ground does
+  not depend on what the vehicle has been sent by a GCS
+*/
+
+#pragma once
+
+#include <AP_HAL/AP_HAL_Boards.h>
+#include <AP_Terrain/AP_Terrain.h>
+
+#ifndef AP_SIM_TERRAIN_ENABLED
+#define AP_SIM_TERRAIN_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_SITL && AP_TERRAIN_AVAILABLE)
+#endif
+
+#if AP_SIM_TERRAIN_ENABLED
+
+#include <AP_Common/Location.h>
+
+// number of degree files we keep mapped at once
+#define SIM_TERRAIN_MAX_FILES 8
+
+namespace SITL {
+
+class Terrain {
+public:
+    Terrain() {}
+    ~Terrain();
+
+    /* Do not allow copies */
+    CLASS_NO_COPY(Terrain);
+
+    /*
+      return terrain height in meters above sea level for a location,
+      or false if the DAT files have no data there. This is cheap
+      enough to be called for every physics step
+     */
+    bool height_amsl(const Location &loc, float &height);
+
+private:
+    /*
+      on-disk layout of a grid block. This must match
+      AP_Terrain::grid_block
+     */
+    struct PACKED grid_block {
+        uint64_t bitmap;
+        int32_t lat;
+        int32_t lon;
+        uint16_t crc;
+        uint16_t version;
+        uint16_t spacing;
+        int16_t height[TERRAIN_GRID_BLOCK_SIZE_X][TERRAIN_GRID_BLOCK_SIZE_Y];
+        uint16_t grid_idx_x;
+        uint16_t grid_idx_y;
+        int16_t lon_degrees;
+        int8_t lat_degrees;
+    };
+
+    static const uint16_t block_size = 2048;
+    static_assert(sizeof(grid_block) <= block_size, "grid_block must fit in a disk block");
+
+    enum class BlockState : uint8_t {
+        UNCHECKED = 0,
+        VALID = 1,
+        INVALID = 2,
+    };
+
+    /*
+      a memory mapped degree file
+     */
+    struct tile_file {
+        int8_t lat_degrees;
+        int16_t lon_degrees;
+        bool in_use;
+
+        // nullptr if the file could not be mapped
+        const uint8_t *data;
+        size_t length;
+
+        // grid spacing of the blocks in this file, zero if no valid
+        // block has been found yet
+        uint16_t spacing;
+
+        // number of blocks in an east stride at this latitude
+        uint32_t east_blocks;
+
+        // CRC state of each block, so CRCs are checked once per session
+        BlockState *block_state;
+        uint32_t num_blocks;
+
+        uint32_t last_access_ms;
+        uint32_t last_map_ms;
+    };
+
+    tile_file files[SIM_TERRAIN_MAX_FILES];
+
+    // index of the file used for the last lookup
+    uint8_t last_file_idx;
+
+    char *directory;
+
+    tile_file *find_file(int8_t lat_degrees, int16_t lon_degrees);
+    void map_file(tile_file &f);
+    void unmap_file(tile_file &f);
+    const grid_block *get_block(tile_file &f, uint32_t blocknum);
+    bool find_spacing(tile_file &f);
+    bool check_block(const grid_block &block, uint16_t spacing) const;
+};
+
+}  // namespace SITL
+
+#endif  // AP_SIM_TERRAIN_ENABLED
@@ -63,6 +63,10 @@ const AP_Param::GroupInfo SIM::var_info[] = {
     AP_GROUPINFO("FLOAT_EXCEPT",  28, SIM,  float_exception, 1),
     AP_GROUPINFO("SONAR_SCALE",   32, SIM,  sonar_scale, 12.1212f),
     AP_GROUPINFO("FLOW_ENABLE",   33, SIM,  flow_enable, 0),
+    // @Param: TERRAIN
+    // @DisplayName: Simulated terrain source
+    // @Description: source of terrain heights for the simulated ground. The vehicle terrain library only has data the GCS has sent, while the DAT files option reads the terrain DAT files directly
+    // @Values: 0:Flat,1:Vehicle terrain library,2:Terrain DAT files
     AP_GROUPINFO("TERRAIN",       34, SIM,  terrain_enable, 1),
     AP_GROUPINFO("FLOW_RATE",     35, SIM,  flow_rate, 10),
     AP_GROUPINFO("FLOW_DELAY",    36, SIM,  flow_delay, 0),
@@ -220,6 +224,13 @@ const AP_Param::GroupInfo SIM::var_info3[] = {
     // count of simulated IMUs
     AP_GROUPINFO("IMU_COUNT",    23, SIM,  imu_count,  2),
 
+    // @Param: SNAPSHOT
+    // @DisplayName: Take snapshot
+    // @Description: Setting this to 1 turns the running simulation into a snapshot of the vehicle. The process stops flying and instead forks a copy of the vehicle, carrying on from that moment, for each connection to the snapshot-N.sock unix socket. Used to skip boot and EKF alignment in tests
+    // @Values: 0:Disabled,1:Take snapshot
+    // @User: Advanced
+    AP_GROUPINFO("SNAPSHOT",     24, SIM,  snapshot,  0),
+
     // @Path: ./SIM_FETtecOneWireESC.cpp
     AP_SUBGROUPINFO(fetteconewireesc_sim, "FTOWESC_", 30, SIM, FETtecOneWireESC),
 
@@ -498,6 +509,20 @@ const AP_Param::GroupInfo SIM::var_ins[] = {
     // @Description: the instance number to  take servos from
     AP_GROUPINFO("JSON_MASTER",     27, SIM, ride_along_master, 0),
 
+    // @Param: VIB_MOT_HMNC
+    // @DisplayName: Motor vibration harmonics
+    // @Description: number of harmonics of the motor rotation frequency added as vibration when SIM_VIB_MOT_MAX is set. Harmonic N has amplitude 1/N of the fundamental
+    // @Range: 1 8
+    // @User: Advanced
+    AP_GROUPINFO("VIB_MOT_HMNC",    28, SIM, vibe_motor_harmonics, 1),
+
+    // @Param: IMU_FAST_RAW
+    // @DisplayName: Deliver fast sampled IMU data at sensor rate
+    // @Description: when set and INS_FAST_SAMPLE is enabled for an IMU, every simulated sample is delivered to the INS frontend at the INS_GYRO_RATE rate, as a FIFO sensor would, rather than being averaged down to 1kHz
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("IMU_FAST_RAW",    29, SIM, imu_fast_raw, 0),
+
     // the IMUT parameters must be last due to the enable parameters
 #if HAL_INS_TEMPERATURE_CAL_ENABLE
     AP_SUBGROUPINFO(imu_tcal[0], "IMUT1_", 61, SIM, AP_InertialSensor::TCal),
@@ -650,6 +675,33 @@ Vector3f SIM::convert_earth_frame(const Matrix3f &dcm, const Vector3f &gyro)
     return Vector3f(phiDot, thetaDot, psiDot);
 }
 
+/*
+  get terrain height in meters above sea level from the source
+  selected by SIM_TERRAIN
+ */
+bool SIM::terrain_height_amsl(const Location &loc, float &height)
+{
+    switch (TerrainSource(terrain_enable.get())) {
+    case TerrainSource::NONE:
+        break;
+    case TerrainSource::VEHICLE: {
+#if AP_TERRAIN_AVAILABLE
+        AP_Terrain *terrain = AP::terrain();
+        if (terrain != nullptr) {
+            return terrain->height_amsl(loc, height, false);
+        }
+#endif
+        break;
+    }
+    case TerrainSource::DAT_FILES:
+#if AP_SIM_TERRAIN_ENABLED
+        return terrain_sim.height_amsl(loc, height);
+#endif
+        break;
+    }
+    return false;
+}
+
 // get the rangefinder reading for the desired rotation, returns -1 for no data
 float SIM::get_rangefinder(uint8_t instance) {
     if (instance < RANGEFINDER_MAX_INSTANCES) {
@@ -26,6 +26,7 @@
 #include "SIM_IntelligentEnergy24.h"
 #include "SIM_Ship.h"
 #include "SIM_GPS.h"
+#include "SIM_Terrain.h"
 #include <AP_RangeFinder/AP_RangeFinder.h>
 
 namespace SITL {
@@ -215,7 +216,7 @@ public:
     AP_Int8  flow_enable; // enable simulated optflow
     AP_Int16 flow_rate; // optflow data rate (Hz)
     AP_Int8  flow_delay; // optflow data delay
-    AP_Int8  terrain_enable; // enable using terrain for height
+    AP_Int8  terrain_enable; // enable using terrain for height, see TerrainSource
     AP_Int16 pin_mask; // for GPIO emulation
     AP_Float speedup; // simulation speedup
     AP_Int8  odom_enable; // enable visual odometry data
@@ -224,6 +225,7 @@ public:
     AP_Int8  baro_count; // number of simulated baros to create
     AP_Int8  imu_count; // number of simulated IMUs to create
     AP_Int32 loop_delay; // extra delay to add to every loop
+    AP_Int8  snapshot; // take a snapshot of the running vehicle
     AP_Float mag_scaling[MAX_CONNECTED_MAGS]; // scaling factor
     AP_Int32 mag_devid[MAX_CONNECTED_MAGS]; // Mag devid
     AP_Float buoyancy; // submarine buoyancy in Newtons
@@ -329,6 +331,8 @@ public:
     AP_Float vibe_motor;
     // amplitude scaling of motor noise relative to gyro/accel noise
     AP_Float vibe_motor_scale;
+    // number of motor harmonics to add as vibration
+    AP_Int8 vibe_motor_harmonics;
     // minimum throttle for addition of ins noise
     AP_Float ins_noise_throttle_min;
 
@@ -418,6 +422,21 @@ public:
     ShipSim shipsim;
 #endif
 
+    // terrain height sources selectable with SIM_TERRAIN
+    enum class TerrainSource {
+        NONE = 0,
+        VEHICLE = 1, // the vehicle's own AP_Terrain
+        DAT_FILES = 2, // terrain DAT files read directly by the simulator
+    };
+
+    // get terrain height in meters above sea level from the source
+    // selected by SIM_TERRAIN, returning false if not available
+    bool terrain_height_amsl(const Location &loc, float &height);
+
+#if AP_SIM_TERRAIN_ENABLED
+    Terrain terrain_sim;
+#endif
+
     Gripper_Servo gripper_sim;
     Gripper_EPM gripper_epm_sim;
 
@@ -482,6 +501,8 @@ public:
     // gyro and accel fail masks
     AP_Int8 gyro_fail_mask;
     AP_Int8 accel_fail_mask;
+    // deliver every fast sampled IMU sample to the frontend
+    AP_Int8 imu_fast_raw;
 
     // Sailboat sim only
     AP_Int8 sail_type;
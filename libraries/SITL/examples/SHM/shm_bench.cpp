@@ -0,0 +1,146 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+  Benchmark of lockstep steps per second, comparing the shared memory
+  rings against a UDP loopback exchange like the JSON and Gazebo
+  backends use. A child process plays the simulator, echoing one FDM
+  frame for each servo frame.
+
+  Usage: shm_bench [steps]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <new>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <SIM_SHM_Protocol.h>
+
+using namespace SITL::SHM;
+
+static double now_s()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double bench_shm(uint32_t steps)
+{
+    void *p = mmap(nullptr, sizeof(layout), PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    layout *shm = new (p) layout;
+    shm->servos.reset();
+    shm->fdm.reset();
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        // simulator side
+        for (uint32_t i=0; i<steps; i++) {
+            servo_frame servos;
+            while (!shm->servos.pop(servos)) {
+                shm->servos.wait(1000);
+            }
+            fdm_frame fdm {};
+            fdm.timestamp_s = servos.frame_count * 0.001;
+            shm->fdm.push(fdm);
+        }
+        _exit(0);
+    }
+
+    const double t0 = now_s();
+    for (uint32_t i=0; i<steps; i++) {
+        servo_frame servos {};
+        servos.frame_count = i;
+        shm->servos.push(servos);
+        fdm_frame fdm;
+        while (!shm->fdm.pop(fdm)) {
+            shm->fdm.wait(1000);
+        }
+    }
+    const double t1 = now_s();
+    waitpid(pid, nullptr, 0);
+    munmap(p, sizeof(layout));
+    return steps / (t1 - t0);
+}
+
+static double bench_udp(uint32_t steps)
+{
+    // use UDP loopback sockets to match the existing backends
+    int sock_ap = socket(AF_INET, SOCK_DGRAM, 0);
+    int sock_sim = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr_ap {}, addr_sim {};
+    addr_ap.sin_family = addr_sim.sin_family = AF_INET;
+    addr_ap.sin_addr.s_addr = addr_sim.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr_ap);
+    if (bind(sock_ap, (struct sockaddr *)&addr_ap, sizeof(addr_ap)) != 0 ||
+        bind(sock_sim, (struct sockaddr *)&addr_sim, sizeof(addr_sim)) != 0 ||
+        getsockname(sock_ap, (struct sockaddr *)&addr_ap, &len) != 0 ||
+        getsockname(sock_sim, (struct sockaddr *)&addr_sim, &len) != 0) {
+        perror("bind");
+        exit(1);
+    }
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        for (uint32_t i=0; i<steps; i++) {
+            servo_frame servos;
+            if (recv(sock_sim, &servos, sizeof(servos), 0) != sizeof(servos)) {
+                _exit(1);
+            }
+            fdm_frame fdm {};
+            fdm.timestamp_s = servos.frame_count * 0.001;
+            sendto(sock_sim, &fdm, sizeof(fdm), 0, (struct sockaddr *)&addr_ap, sizeof(addr_ap));
+        }
+        _exit(0);
+    }
+
+    const double t0 = now_s();
+    for (uint32_t i=0; i<steps; i++) {
+        servo_frame servos {};
+        servos.frame_count = i;
+        sendto(sock_ap, &servos, sizeof(servos), 0, (struct sockaddr *)&addr_sim, sizeof(addr_sim));
+        fdm_frame fdm;
+        if (recv(sock_ap, &fdm, sizeof(fdm), 0) != sizeof(fdm)) {
+            perror("recv");
+            exit(1);
+        }
+    }
+    const double t1 = now_s();
+    waitpid(pid, nullptr, 0);
+    close(sock_ap);
+    close(sock_sim);
+    return steps / (t1 - t0);
+}
+
+int main(int argc, const char *argv[])
+{
+    const uint32_t steps = argc > 1 ? strtoul(argv[1], nullptr, 0) : 200000;
+
+    printf("lockstep steps/sec over %u steps\n", (unsigned)steps);
+    printf("  UDP loopback:  %10.0f\n", bench_udp(steps));
+    printf("  shared memory: %10.0f\n", bench_shm(steps));
+    return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+  Reference peer for the SITL shared memory interface. It attaches to
+  the object created by SITL and steps a 1-D vertical model of a quad
+  in lockstep with ArduPilot: one FDM frame for every servo frame.
+
+  Usage: shm_peer [name]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <SIM_SHM_Protocol.h>
+
+using namespace SITL::SHM;
+
+static layout *attach(const char *name)
+{
+    while (true) {
+        const int fd = shm_open(name, O_RDWR, 0);
+        if (fd != -1) {
+            struct stat st;
+            if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(layout)) {
+                void *p = mmap(nullptr, sizeof(layout), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+                close(fd);
+                if (p != MAP_FAILED) {
+                    layout *shm = (layout *)p;
+                    if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) == MAGIC &&
+                        shm->version == VERSION &&
+                        shm->ring_size == SIM_SHM_RING_SIZE) {
+                        return shm;
+                    }
+                    munmap(p, sizeof(layout));
+                }
+            } else {
+                close(fd);
+            }
+        }
+        usleep(100000);
+    }
+}
+
+int main(int argc, const char *argv[])
+{
+    char name[64];
+    if (argc > 1) {
+        snprintf(name, sizeof(name), "%s", argv[1]);
+    } else {
+        snprintf(name, sizeof(name), SIM_SHM_DEFAULT_NAME, 0U);
+    }
+
+    printf("Waiting for SITL on %s\n", name);
+    layout *shm = attach(name);
+    uint32_t session = shm->session.load();
+    printf("Attached to session %u\n", (unsigned)session);
+
+    const double dt = 1.0 / 1000;
+    const double mass = 1.5;
+    const double max_thrust = 2.5 * mass * 9.80665;
+    double t = 0, alt = 0, climb_rate = 0;
+
+    while (true) {
+        if (shm->session.load() != session) {
+            // SITL restarted, reset the model
+            session = shm->session.load();
+            t = alt = climb_rate = 0;
+            printf("New session %u\n", (unsigned)session);
+        }
+        if (!shm->servos.wait(1000)) {
+            continue;
+        }
+        servo_frame servos;
+        if (!shm->servos.pop(servos)) {
+            continue;
+        }
+
+        // thrust from the first four motors
+        double thrust = 0;
+        for (uint8_t i=0; i<4; i++) {
+            double throttle = (servos.pwm[i] - 1000) / 1000.0;
+            throttle = throttle < 0 ? 0 : (throttle > 1 ? 1 : throttle);
+            thrust += throttle * max_thrust * 0.25;
+        }
+        double accel_up = thrust / mass - 9.80665;
+        if (alt <= 0 && accel_up < 0) {
+            // sitting on the ground
+            accel_up = 0;
+            climb_rate = 0;
+        }
+        climb_rate += accel_up * dt;
+        alt += climb_rate * dt;
+        if (alt < 0) {
+            alt = 0;
+        }
+        t += dt;
+
+        fdm_frame fdm {};
+        fdm.timestamp_s = t;
+        fdm.accel_body[2] = -(accel_up + 9.80665);
+        fdm.quaternion[0] = 1;
+        fdm.velocity[2] = -climb_rate;
+        fdm.position[2] = -alt;
+        shm->fdm.push(fdm);
+    }
+    return 0;
+}
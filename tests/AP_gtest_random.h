@@ -0,0 +1,31 @@
+/*
+ * Repeatable random test data for unit tests with gtest.
+ */
+#pragma once
+
+#include <AP_Math/AP_Math.h>
+
+// pseudo random number between -range and range. The numbers come
+// from get_random16(), so are the same on every run
+static inline float test_rand(float range)
+{
+    return (get_random16() / 32767.5f - 1.0f) * range;
+}
+
+// star shaped polygon of num_corners points around centre, each
+// between min_radius and radius from it. If closed a last point
+// repeating the first is added. Returns the number of points
+static inline uint16_t make_star_polygon(Vector2f *points, uint16_t num_corners, const Vector2f &centre,
+                                         float min_radius, float radius, bool closed)
+{
+    for (uint16_t i = 0; i < num_corners; i++) {
+        const float angle = M_2PI * i / num_corners;
+        const float r = min_radius + (radius - min_radius) * fabsf(test_rand(1.0f));
+        points[i] = centre + Vector2f(cosf(angle), sinf(angle)) * r;
+    }
+    if (closed) {
+        points[num_corners] = points[0];
+        return num_corners + 1;
+    }
+    return num_corners;
+}